@@ -77,14 +77,19 @@ enum PIXEL_FORMAT {
 	PIXEL_FORMAT_RGBA = 4,
 	PIXEL_FORMAT_RGB = 5,
 	PIXEL_FORMAT_RGB565 = 6,
-	PIXEL_FORMAT_LUM = 7
+	PIXEL_FORMAT_LUM = 7,
+	PIXEL_FORMAT_UYVY = 8,			// packed YUV 4:2:2, luminance in every second byte starting at 1
+	PIXEL_FORMAT_YUYV = 9,			// packed YUV 4:2:2, luminance in every second byte starting at 0
+	PIXEL_FORMAT_YUV422 = PIXEL_FORMAT_UYVY		// the IIDC (1394) YUV 4:2:2 byte order
 };
 
 
 enum UNDIST_MODE {
 	UNDIST_NONE,
 	UNDIST_STD,
-	UNDIST_LUT
+	UNDIST_LUT,
+	UNDIST_SAMPLED,			// undistorts only a few averaged points per marker edge, no LUT
+	UNDIST_GRID				// bilinear interpolation in a coarse grid (every AR_UNDIST_GRID_STEP pixels)
 };
 
 
@@ -94,6 +99,18 @@ enum IMAGE_PROC_MODE {
 };
 
 
+enum THRESHOLD_MODE {
+	THRESH_GLOBAL,				// one threshold for the whole image (plus vignetting compensation)
+	THRESH_ADAPTIVE_LOCAL		// compare each pixel against the mean of its neighbourhood (LUM/YUV422 only)
+};
+
+
+enum LABELING_MODE {
+	LABELING_STD,				// per-pixel labeling with equivalence table
+	LABELING_RLE				// run-length labeling with union-find (LUM/YUV422 only)
+};
+
+
 // ARToolKitPlus versioning
 //
 enum ARTKP_VERSION {
@@ -117,7 +134,8 @@ enum MARKER_MODE {
 enum POSE_ESTIMATOR {
 	POSE_ESTIMATOR_ORIGINAL,			// original "normal" pose estimator
 	POSE_ESTIMATOR_ORIGINAL_CONT,		// original "cont" pose estimator
-	POSE_ESTIMATOR_RPP					// new "Robust Planar Pose" estimator
+	POSE_ESTIMATOR_RPP,					// new "Robust Planar Pose" estimator
+	POSE_ESTIMATOR_IPPE					// closed form "Infinitesimal Plane-based Pose Estimation"
 };
 
 
@@ -63,6 +63,14 @@ public:
 	virtual bool changeFrameSize(const int frameWidth, const int frameHeight) = 0;
 	virtual void logSettings(Logger* p_log) = 0;
 
+	// undistorts nNum points at once. the default implementation
+	// simply calls observ2Ideal() for each of them.
+	virtual void observ2IdealBatch(int nNum, const ARFloat *ox, const ARFloat *oy, ARFloat *ix, ARFloat *iy)
+	{
+		for(int i=0; i<nNum; i++)
+			observ2Ideal(ox[i], oy[i], ix+i, iy+i);
+	}
+
 	char* getFileName() const  {  return fileName;  }
 
 protected:
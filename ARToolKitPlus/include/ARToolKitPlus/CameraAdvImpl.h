@@ -57,6 +57,7 @@ public:
 
 	virtual void observ2Ideal(ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy);
 	virtual void ideal2Observ(ARFloat ix, ARFloat iy, ARFloat *ox, ARFloat *oy);
+	virtual void observ2IdealBatch(int nNum, const ARFloat *ox, const ARFloat *oy, ARFloat *ix, ARFloat *iy);
 	virtual bool loadFromFile(const char* filename);
 	virtual Camera* clone();
 	virtual bool changeFrameSize(const int frameWidth, const int frameHeight);
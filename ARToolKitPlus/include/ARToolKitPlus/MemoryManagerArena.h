@@ -0,0 +1,141 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#ifndef __ARTOOLKITPLUS_MEMORYMANAGERARENA_HEADERFILE__
+#define __ARTOOLKITPLUS_MEMORYMANAGERARENA_HEADERFILE__
+
+
+#include "MemoryManager.h"
+#include <stddef.h>
+
+
+namespace ARToolKitPlus
+{
+
+
+/// A bump pointer MemoryManager for memory that only lives during one call
+/**
+ *  getMemory() just advances a pointer inside a block. releaseMemory() only
+ *  gives memory back if it was the most recent allocation, everything else is
+ *  released at once by reset(). If a block runs full another one is allocated,
+ *  and the next reset() merges all blocks into a single one that is large enough
+ *  for the whole frame. After a few frames no more system allocations happen.
+ *
+ *  Each detection context of a tracker owns an arena and makes it the current
+ *  arena of the calling thread with a Scope while it detects markers or estimates poses.
+ *  Temporary matrices and vectors (see matrix.cxx and vector.cxx) are taken
+ *  from the current arena via artkp_FrameAlloc(). Memory taken from an arena
+ *  must therefore never be kept beyond the outermost Scope.
+ */
+class ARTOOLKITPLUS_API MemoryManagerArena : public MemoryManager
+{
+public:
+	/// Makes an arena the current arena of the calling thread
+	/**
+	 *  Scopes can be nested. If the thread already has a current arena a Scope
+	 *  keeps using that one instead of nArena, so the outermost Scope decides
+	 *  which arena serves the thread. The arena is reset when that Scope ends.
+	 */
+	class ARTOOLKITPLUS_API Scope
+	{
+	public:
+		Scope(MemoryManagerArena& nArena);
+		~Scope();
+
+	protected:
+		MemoryManagerArena	*arena, *prevArena;
+	};
+
+
+	MemoryManagerArena();
+	~MemoryManagerArena();
+
+	bool init(size_t nNumInitialBytes, size_t nNumGrowBytes=0);
+	bool deinit();
+	bool didInit();
+
+	unsigned int getBytesAllocated()  {  return (unsigned int)fullSize;  }
+
+	void* getMemory(size_t nNumBytes);
+	void releaseMemory(void* nMemoryBlock);
+
+	/// Releases all memory reserved via getMemory(), the blocks are kept
+	void reset();
+
+	/// Returns true if nMemoryBlock lies in one of the arena's blocks
+	bool owns(const void* nMemoryBlock) const;
+
+	/// Returns how often a block was allocated from the system
+	unsigned int getNumSystemAllocs() const  {  return numSystemAllocs;  }
+
+	/// Returns the current arena of the calling thread or NULL
+	static MemoryManagerArena* getCurrent();
+
+protected:
+	struct Block
+	{
+		Block			*next;
+		size_t			size, used;
+		unsigned char	*data;
+	};
+
+	Block* allocBlock(size_t nNumBytes);
+	void freeBlocks();
+
+	bool			_didInit;
+	Block			*blocks;		// the block getMemory() currently uses is the first one
+	void			*lastMemory;	// result of the most recent getMemory()
+	size_t			fullSize, growSize;
+	int				scopeDepth;
+	unsigned int	numSystemAllocs;
+};
+
+
+/// Allocates from the calling thread's current arena or with malloc() if there is none
+void* artkp_FrameAlloc(size_t nNumBytes);
+
+/// Releases memory allocated via artkp_FrameAlloc()
+void artkp_FrameFree(void* nMemoryBlock);
+
+
+}  // namespace ARToolKitPlus
+
+
+#endif //__ARTOOLKITPLUS_MEMORYMANAGERARENA_HEADERFILE__
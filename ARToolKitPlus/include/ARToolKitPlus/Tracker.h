@@ -53,6 +53,27 @@
 namespace ARToolKitPlus {
 
 
+/// Holds the per-thread state of marker detection
+/**
+ *  A DetectionContext owns the label image, the work tables, the candidate
+ *  buffers and the tracking history which arDetectMarker() needs. The Tracker
+ *  that created it acts as the shared, read-only configuration: several threads
+ *  can detect markers with the same Tracker at the same time as long as each one
+ *  uses its own context and the Tracker's settings are not changed meanwhile.
+ *  Contexts are created with Tracker::createDetectionContext() and deleted by
+ *  the application (before the Tracker).
+ */
+class DetectionContext
+{
+public:
+	virtual ~DetectionContext()
+	{}
+
+	/// Returns the threshold the automatic threshold calculation chose for the next frame of this context
+	virtual int getThreshold() const = 0;
+};
+
+
 /// Tracker is the vision core of ARToolKit.
 /**
  * Almost all original ARToolKit methods are included here.
@@ -100,11 +121,21 @@ public:
 	 *  On slow platforms (e.g. Smartphone) creation of the undistortion lookup-table
 	 *  can take quite a while. Consequently caching will speedup the start phase.
 	 *  If set to true and no cache file could be found a new one will be created.
-	 *  The cache file will get the same name as the camera file with the added extension '.LUT'
+	 *  The cache file will get the same name as the camera file with the added extension '.LUT2'
 	 */
 	virtual void setLoadUndistLUT(bool nSet) = 0;
 
 
+	/// Set to true to share the undistortion tables with other trackers
+	/**
+	 *  The tables of UNDIST_LUT and UNDIST_GRID are then taken from the UndistCache:
+	 *  they are built only once per camera file and resolution and all trackers on
+	 *  the machine map the same read-only memory. Must be set before the camera
+	 *  file is loaded. Falls back to a private table if sharing fails.
+	 */
+	virtual void setShareUndistTables(bool nSet) = 0;
+
+
 	/// sets an instance which implements the ARToolKit::Logger interface
 	virtual void setLogger(ARToolKitPlus::Logger* nLogger) = 0;
 
@@ -117,6 +148,28 @@ public:
 	virtual int arDetectMarkerLite(ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num) = 0;
 
 
+	/// Creates a context for detecting markers concurrently with this tracker's configuration
+	/**
+	 *  The context has to be deleted by the caller. Its buffers are sized
+	 *  for the camera resolution at the time of the first detection.
+	 */
+	virtual DetectionContext* createDetectionContext() = 0;
+
+
+	/// marker detection using the tracking history of nContext
+	/**
+	 *  Can be called from several threads at once with different contexts. The
+	 *  resulting marker_info belongs to nContext and is valid until its next detection.
+	 *  With automatic thresholding the threshold of the next frame is kept in
+	 *  nContext (see DetectionContext::getThreshold()), not in the tracker.
+	 */
+	virtual int arDetectMarker(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num) = 0;
+
+
+	/// marker detection without tracking history using the buffers of nContext
+	virtual int arDetectMarkerLite(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num) = 0;
+
+
 	/// calculates the transformation matrix between camera and the given multi-marker config
 	virtual ARFloat arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config) = 0;
 	/// calculates the transformation matrix between camera and the given marker
@@ -127,6 +180,14 @@ public:
 	// RPP integration -- [t.pintaric]
 	virtual ARFloat rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config) = 0;
 	virtual ARFloat rppGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]) = 0;
+	/// like rppGetTransMat() but starts the iteration from the rotation of prev_conv
+	virtual ARFloat rppGetTransMatCont(ARMarkerInfo *marker_info, ARFloat prev_conv[3][4], ARFloat center[2], ARFloat width, ARFloat conv[3][4]) = 0;
+
+	// IPPE: "Infinitesimal Plane-based Pose Estimation", closed form
+	virtual ARFloat ippeMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config) = 0;
+	virtual ARFloat ippeGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]) = 0;
+	/// both poses of the marker sorted by their reprojection errors, returns -1 on failure
+	virtual int ippeGetTransMats(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[2][3][4], ARFloat err[2]) = 0;
 
 
 	/// loads a pattern from a file
@@ -148,6 +209,19 @@ public:
 	 */
 	virtual void activateBinaryMarker(int nThreshold) = 0;
 
+	/// activates a PCA pre-filter for template matching
+	/**
+	 *  Projects the extracted pattern onto the principal components of the loaded
+	 *  patterns to bound its correlation with each of them. Only the patterns
+	 *  whose bound beats the best match found so far are correlated in full, so the
+	 *  result is the same as without the pre-filter. The bounds are only tight if
+	 *  the patterns are well described by EVEC_MAX principal components: with 64
+	 *  random block patterns the pre-filter takes twice as long as correlating all
+	 *  of them (see benchPatternMatch), so it is off by default. Should be
+	 *  activated after the patterns have been loaded.
+	 */
+	virtual void activatePCAMatching(bool nEnable) = 0;
+
 	/// activate the usage of id-based markers rather than template based markers
 	/**
 	 *  Template markers are the classic marker type used in ARToolKit.
@@ -174,6 +248,47 @@ public:
 	 */
 	virtual void activateVignettingCompensation(bool nEnable, int nCorners=0, int nLeftRight=0, int nTopBottom=0) = 0;
 
+
+	/// activates a vectorized binarization pass that runs in front of labeling
+	/**
+	 *  Only supported for PIXEL_FORMAT_LUM and YUV422 images. The image is thresholded (including
+	 *  vignetting compensation) into a packed 1-bit-per-pixel mask using SSE2/AVX2 if
+	 *  available. Labeling then reads the mask instead of the image, which reduces
+	 *  memory traffic considerably. Detection results are identical to the default path.
+	 */
+	virtual void activateBinarization(bool nEnable) = 0;
+
+
+	/// sets how the image is thresholded for black/white conversion
+	/**
+	 *  THRESH_ADAPTIVE_LOCAL builds an integral image once per frame and marks a pixel
+	 *  as black if it is at least nBias darker than the mean of the nWindowSize x nWindowSize
+	 *  pixels around it (nWindowSize<=0 selects 1/8 of the image width). This makes
+	 *  detection robust to uneven lighting without automatic threshold retries. ID markers
+	 *  are then decoded with a threshold computed from each marker's own samples.
+	 *  Only supported for PIXEL_FORMAT_LUM and YUV422 images, other formats keep THRESH_GLOBAL.
+	 */
+	virtual void setThresholdMode(THRESHOLD_MODE nMode, int nWindowSize=0, int nBias=7) = 0;
+
+
+	/// sets the connected-component labeling algorithm
+	/**
+	 *  LABELING_RLE extracts the black runs of each row from the binarization mask and
+	 *  merges them with union-find. It is faster for large images with few dark areas and
+	 *  is not limited by the number of provisional labels. Only supported for
+	 *  PIXEL_FORMAT_LUM and YUV422 images, other formats always use LABELING_STD.
+	 */
+	virtual void setLabelingMode(LABELING_MODE nMode) = 0;
+
+
+	/// sets the number of threads used for labeling
+	/**
+	 *  The image is split into horizontal stripes that are labeled in parallel. Equivalences
+	 *  across the stripe borders are merged afterwards, so the result is identical to
+	 *  single-threaded labeling. Only supported for PIXEL_FORMAT_LUM and YUV422 images.
+	 */
+	virtual void setNumLabelingThreads(int nNumThreads) = 0;
+
 	
 	/// changes the resolution of the camera after the camerafile was already loaded
 	virtual void changeCameraSize(int nWidth, int nHeight) = 0;
@@ -183,16 +298,39 @@ public:
 	/**
 	 * Default value is UNDIST_STD which means that
 	 * artoolkit's standard undistortion method is used.
+	 * UNDIST_LUT uses a lookup table of the whole frame,
+	 * UNDIST_GRID interpolates bilinearly in a table with a
+	 * node every AR_UNDIST_GRID_STEP pixels,
+	 * UNDIST_SAMPLED undistorts only AR_UNDIST_EDGE_SAMPLES
+	 * averaged points per marker edge and needs no table.
 	 */
 	virtual void setUndistortionMode(UNDIST_MODE nMode) = 0;
 
 	/// Changes the Pose Estimation Algorithm
 	/**
 	* POSE_ESTIMATOR_ORIGINAL (default): arGetTransMat()
-	* POSE_ESTIMATOR_RPP: "Robust Pose Estimation from a Planar Target"
+	* POSE_ESTIMATOR_RPP: "Robust Pose Estimation from a Planar Target", more accurate but about ten times as
+	*                     expensive as POSE_ESTIMATOR_ORIGINAL run through estimatePoses()
+	* POSE_ESTIMATOR_IPPE: "Infinitesimal Plane-based Pose Estimation", closed form, no iterations
 	*/
 	virtual bool setPoseEstimator(POSE_ESTIMATOR nMethod) = 0;
 
+	/// Turns the pose history on/off (Default: off)
+	/**
+	 *  With the history the tracker remembers the last pose of every marker id. If a marker
+	 *  shows up again close to where it was seen last time, POSE_ESTIMATOR_RPP starts from
+	 *  that pose instead of from scratch (rppGetTransMatCont()) and still checks the second
+	 *  (ambiguous) pose on its own. POSE_ESTIMATOR_ORIGINAL starts from scratch as before and
+	 *  only continues from the last pose (arGetTransMatContSub()) where arGetInitRot() finds
+	 *  no initial rotation: started from the last pose every frame it drifts by several
+	 *  degrees along the tilt of the marker. POSE_ESTIMATOR_IPPE has nothing to iterate and
+	 *  does not use the history. Every DetectionContext has its own history.
+	 */
+	virtual void activatePoseHistory(bool nEnable) = 0;
+
+	/// Returns true if the pose history is enabled
+	virtual bool isPoseHistoryActivated() const = 0;
+
 	/// Sets a new relative border width. ARToolKit's default value is 0.25
 	/**
 	 * Take caution that the markers need of course really have thiner borders.
@@ -219,15 +357,16 @@ public:
 	virtual bool isAutoThresholdActivated() const = 0;
 
 
-	/// Sets the number of times the threshold is randomized in case no marker was visible (Default: 2)
+	/// Sets the number of times the threshold is changed in case no marker was visible (Default: 2)
 	/**
 	 *  Autothreshold requires a visible marker to estime the optimal thresholding value. If
-	 *  no marker is visible ARToolKitPlus randomizes the thresholding value until a marker is
-	 *  found. This function sets the number of times ARToolKitPlus will randomize the threshold
-	 *  value and research for a marker per calc() invokation until it gives up.
-	 *  A value of 2 means that ARToolKitPlus will analyze the image a second time with an other treshold value
-	 *  if it does not find a marker the first time. Each unsuccessful try uses less processing power
-	 *  than a single full successful position estimation.
+	 *  no marker is visible ARToolKitPlus picks new thresholds from a luminance histogram of
+	 *  the image (Otsu's method on the histogram smoothed over the last frames, then on its dark
+	 *  and its bright part) and searches again. This function sets the maximum number of these
+	 *  retries per calc() invokation. Thresholds close to one that already failed are skipped,
+	 *  so fewer retries can happen. A value of 2 means that ARToolKitPlus will analyze the image
+	 *  up to two more times if it does not find a marker the first time. Each unsuccessful try
+	 *  uses less processing power than a single full successful position estimation.
 	 */
 	virtual void setNumAutoThresholdRetries(int nNumRetries) = 0;
 
@@ -285,6 +424,23 @@ public:
 	virtual ARFloat calcOpenGLMatrixFromMarker(ARMarkerInfo* nMarkerInfo, ARFloat nPatternCenter[2], ARFloat nPatternSize, ARFloat *nOpenGLMatrix) = 0;
 
 
+	/// Calculates the OpenGL transformation matrices for several markers of the same size
+	/**
+	 *  Gives the same results as calling calcOpenGLMatrixFromMarker() for each marker.
+	 *  With POSE_ESTIMATOR_ORIGINAL the pose refinement runs for all markers in lockstep,
+	 *  which is considerably faster if many markers are visible at once.
+	 *  nErrors (optional) receives the error of each marker or -1 if no pose was found.
+	 *  The matrix of such a marker is set to zero.
+	 *  Returns the number of markers a pose was found for.
+	 */
+	virtual int estimatePoses(const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize,
+							  ARFloat nOpenGLMatrices[][16], ARFloat* nErrors=NULL) = 0;
+
+	/// Like estimatePoses() but takes its temporary memory and the pose history from nContext
+	virtual int estimatePoses(DetectionContext* nContext, const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize,
+							  ARFloat nOpenGLMatrices[][16], ARFloat* nErrors=NULL) = 0;
+
+
 	/// Returns the internal profiler object
 	virtual Profiler& getProfiler() = 0;
 
@@ -294,6 +450,12 @@ public:
 
 	/// Calls the pose estimator set with setPoseEstimator() for multi marker tracking
 	virtual ARFloat executeMultiMarkerPoseEstimator(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config) = 0;
+
+	/// Like executeSingleMarkerPoseEstimator() but takes its temporary memory from nContext
+	virtual ARFloat executeSingleMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]) = 0;
+
+	/// Like executeMultiMarkerPoseEstimator() but takes its temporary memory from nContext
+	virtual ARFloat executeMultiMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config) = 0;
 };
 
 
@@ -47,9 +47,13 @@
 #include <ARToolKitPlus/matrix.h>
 #include <ARToolKitPlus/Tracker.h>
 #include <ARToolKitPlus/MemoryManager.h>
+#include <ARToolKitPlus/MemoryManagerArena.h>
 #include <ARToolKitPlus/Camera.h>
 #include <ARToolKitPlus/CameraFactory.h>
+#include <ARToolKitPlus/UndistCache.h>
 #include <ARToolKitPlus/extra/BCH.h>
+#include <ARToolKitPlus/extra/ThreadPool.h>
+#include <string.h>
 
 
 #if defined(_MSC_VER)
@@ -88,6 +92,20 @@ template<class T> T* artkp_Alloc(size_t size)
 		return (T*)::malloc(size*sizeof(T));
 }
 
+// allocates nNewSize elements via artkp_Alloc(), copies the
+// first nOldSize elements of nOld and releases nOld
+template<class T> T* artkp_Grow(T* nOld, size_t nOldSize, size_t nNewSize)
+{
+	T* ret = artkp_Alloc<T>(nNewSize);
+
+	if(ret && nOld)
+		memcpy(ret, nOld, nOldSize*sizeof(T));
+	if(nOld)
+		artkp_Free(nOld);
+
+	return ret;
+}
+
 
 /// TrackerImpl implements the Tracker interface
 template <int __PATTERN_SIZE_X, int __PATTERN_SIZE_Y, int __PATTERN_SAMPLE_NUM, int __MAX_LOAD_PATTERNS, int __MAX_IMAGE_PATTERNS>
@@ -100,9 +118,19 @@ public:
 		PATTERN_SAMPLE_NUM = __PATTERN_SAMPLE_NUM,
 
 		MAX_LOAD_PATTERNS = __MAX_LOAD_PATTERNS,
+		// row lengths of the pattern bank, padded for the 16-bit correlation kernel
+		PATTERN_BANK_STRIDE = (__PATTERN_SIZE_X*__PATTERN_SIZE_Y*3+15) & ~15,
+		PATTERN_BANK_STRIDE_BW = (__PATTERN_SIZE_X*__PATTERN_SIZE_Y+15) & ~15,
+		// initial sizes of the marker candidate and label work tables,
+		// both grow at runtime (see growMarkerBuffers(), growWorkBuffers())
 		MAX_IMAGE_PATTERNS = __MAX_IMAGE_PATTERNS,
 		WORK_SIZE = 1024*MAX_IMAGE_PATTERNS,
 
+		MAX_LABELING_THREADS = 16,
+
+		// removeNestedCandidates() uses a spatial hash from this many candidates on
+		NESTED_CANDIDATES_HASH_MIN = 128,
+
 #ifdef SMALL_LUM8_TABLE
 		LUM_TABLE_SIZE = (0xffff >> 6) + 1,
 #else
@@ -136,6 +164,8 @@ public:
 
 	virtual void setLoadUndistLUT(bool nSet)  {  loadCachedUndist = nSet;  }
 
+	virtual void setShareUndistTables(bool nSet)  {  shareUndistTables = nSet;  }
+
 	/// sets an instance which implements the ARToolKit::Logger interface
 	virtual void setLogger(ARToolKitPlus::Logger* nLogger)  {  logger = nLogger;  }
 
@@ -145,6 +175,15 @@ public:
 	/// marker detection without using tracking history
 	virtual int arDetectMarkerLite(ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num);
 
+	/// creates a context for concurrent detection with this tracker's configuration
+	virtual DetectionContext* createDetectionContext();
+
+	/// marker detection using the tracking history and the buffers of nContext
+	virtual int arDetectMarker(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num);
+
+	/// marker detection without using tracking history, using the buffers of nContext
+	virtual int arDetectMarkerLite(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num);
+
 	/// calculates the transformation matrix between camera and the given multi-marker config
 	virtual ARFloat arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config);
 
@@ -156,6 +195,12 @@ public:
 	// RPP integration -- [t.pintaric]
 	virtual ARFloat rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config);
 	virtual ARFloat rppGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+	virtual ARFloat rppGetTransMatCont(ARMarkerInfo *marker_info, ARFloat prev_conv[3][4], ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+
+	// IPPE: "Infinitesimal Plane-based Pose Estimation", closed form
+	virtual ARFloat ippeMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config);
+	virtual ARFloat ippeGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+	virtual int ippeGetTransMats(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[2][3][4], ARFloat err[2]);
 
 	/// loads a pattern from a file
 	virtual int arLoadPatt(char *filename);
@@ -169,6 +214,13 @@ public:
 
 	virtual void activateBinaryMarker(int nThreshold)  {  binaryMarkerThreshold = nThreshold;  }
 
+	/// Prunes template matching with a PCA of the loaded patterns
+	/**
+	 *  the principal components are recomputed whenever a pattern is loaded or freed,
+	 *  so this should be activated after loading the patterns.
+	 */
+	virtual void activatePCAMatching(bool nEnable);
+
 	/// Activate the usage of id-based markers rather than template based markers
 	/**
 	 *  id-based markers directly encode the marker id in the image.
@@ -192,6 +244,36 @@ public:
 	virtual void activateVignettingCompensation(bool nEnable, int nCorners=0, int nLeftRight=0, int nTopBottom=0);
 
 
+	/// activates a vectorized binarization pass that runs in front of labeling
+	/**
+	 *  Only supported for PIXEL_FORMAT_LUM and YUV422 images. The image (including vignetting
+	 *  compensation) is thresholded into a 1-bit-per-pixel mask using SSE2/AVX2 if
+	 *  available, labeling then only reads that mask. Detection results are identical
+	 *  to the default path.
+	 */
+	virtual void activateBinarization(bool nEnable)  {  useBinarization = nEnable;  }
+
+
+	/// sets the connected-component labeling algorithm
+	/**
+	 *  LABELING_RLE labels runs of black pixels instead of single pixels (see
+	 *  arLabelingRLE.cxx). It always uses the binarization mask, independent of
+	 *  activateBinarization(). Only supported for PIXEL_FORMAT_LUM and YUV422 images.
+	 */
+	virtual void setLabelingMode(LABELING_MODE nMode)  {  labelingMode = nMode;  }
+
+
+	/// sets the number of threads used for labeling
+	/**
+	 *  The image is split into horizontal stripes which are binarized and labeled
+	 *  in parallel (see arLabelingRLE.cxx), the results are identical to single-threaded
+	 *  labeling. The calling thread takes part in the work, so nNumThreads-1 worker threads
+	 *  are created. At most MAX_LABELING_THREADS threads are used. Only supported for
+	 *  PIXEL_FORMAT_LUM and YUV422 images.
+	 */
+	virtual void setNumLabelingThreads(int nNumThreads);
+
+
 	/// Calculates the camera matrix from an ARToolKit camera file.
 	/**
 	 * This method retrieves the OpenGL projection matrix that is stored
@@ -210,6 +292,11 @@ public:
 	/**
 	 * Default value is UNDIST_STD which means that
 	 * artoolkit's standard undistortion method is used.
+	 * UNDIST_LUT uses a lookup table of the whole frame,
+	 * UNDIST_GRID interpolates bilinearly in a table with a
+	 * node every AR_UNDIST_GRID_STEP pixels,
+	 * UNDIST_SAMPLED undistorts only AR_UNDIST_EDGE_SAMPLES
+	 * averaged points per marker edge and needs no table.
 	 */
 	virtual void setUndistortionMode(UNDIST_MODE nMode);
 
@@ -217,9 +304,16 @@ public:
 	/**
 	* POSE_ESTIMATOR_ORIGINAL (default): arGetTransMat()
 	* POSE_ESTIMATOR_RPP: "Robust Pose Estimation from a Planar Target"
+	* POSE_ESTIMATOR_IPPE: "Infinitesimal Plane-based Pose Estimation", closed form, no iterations
 	*/
 	virtual bool setPoseEstimator(POSE_ESTIMATOR nMethod);
 
+	/// Turns the pose history on/off, see Tracker::activatePoseHistory()
+	virtual void activatePoseHistory(bool nEnable);
+
+	/// Returns true if the pose history is enabled
+	virtual bool isPoseHistoryActivated() const  {  return poseHistoryEnable;  }
+
 	/// Sets a new relative border width. ARToolKit's default value is 0.25
 	/**
 	 * Take caution that the markers need of course really have thiner borders.
@@ -238,6 +332,15 @@ public:
 	virtual int getThreshold() const  {  return thresh;  }
 
 
+	/// Sets how the image is thresholded for black/white conversion
+	/**
+	 *  With THRESH_ADAPTIVE_LOCAL every pixel is compared against the mean of its
+	 *  nWindowSize x nWindowSize neighbourhood (see arBinarize.cxx). The global
+	 *  threshold, vignetting compensation and threshold retries are not used then.
+	 */
+	virtual void setThresholdMode(THRESHOLD_MODE nMode, int nWindowSize=0, int nBias=7);
+
+
 	/// Turns automatic threshold calculation on/off
 	virtual void activateAutoThreshold(bool nEnable)  {  autoThreshold.enable = nEnable;  }
 
@@ -245,17 +348,13 @@ public:
 	/// Returns true if automatic threshold detection is enabled
 	virtual bool isAutoThresholdActivated() const  {  return autoThreshold.enable;  }
 
-	/// Sets the number of times the threshold is randomized in case no marker was visible (Minimum: 1, Default: 2)
+	/// Sets the number of times the threshold is changed in case no marker was visible (Minimum: 1, Default: 2)
 	/**
 	 *  Autothreshold requires a visible marker to estime the optimal thresholding value. If
-	 *  no marker is visible ARToolKitPlus randomizes the thresholding value until a marker is
-	 *  found. This function sets the number of times ARToolKitPlus will randomize the threshold
-	 *  value and research for a marker per calc() invokation until it gives up.
-	 *  A value of 2 means that ARToolKitPlus will analyze the image a second time with an other treshold value
-	 *  if it does not find a marker the first time. Each unsuccessful try uses less processing power
-	 *  than a single full successful position estimation.
+	 *  no marker is visible the retries use thresholds computed from a luminance histogram
+	 *  of the image (see AutoThreshold::getRetryThreshold()) instead of random values.
 	 */
-	virtual void setNumAutoThresholdRetries(int nNumRetries)  {  autoThreshold.numRandomRetries = nNumRetries>=1 ? nNumRetries : 1;  }
+	virtual void setNumAutoThresholdRetries(int nNumRetries)  {  autoThreshold.numRetries = nNumRetries>=1 ? nNumRetries : 1;  }
 
 
 	/// Sets an image processing mode (half or full resolution)
@@ -306,17 +405,39 @@ public:
 	virtual ARFloat calcOpenGLMatrixFromMarker(ARMarkerInfo* nMarkerInfo, ARFloat nPatternCenter[2], ARFloat nPatternSize, ARFloat *nOpenGLMatrix);
 
 
+	virtual int estimatePoses(const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize,
+							  ARFloat nOpenGLMatrices[][16], ARFloat* nErrors=NULL);
+
+
+	virtual int estimatePoses(DetectionContext* nContext, const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize,
+							  ARFloat nOpenGLMatrices[][16], ARFloat* nErrors=NULL);
+
+
 	virtual ARFloat executeSingleMarkerPoseEstimator(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
 
 
 	virtual ARFloat executeMultiMarkerPoseEstimator(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config);
 
 
+	virtual ARFloat executeSingleMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+
+
+	virtual ARFloat executeMultiMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config);
+
+
 
 protected:
+	struct Context;
+	struct PoseHistoryEntry;
+
 	bool checkPixelFormat();
 
-	void checkImageBuffer();
+	int detectMarker(Context* ctx, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num);
+
+	int detectMarkerLite(Context* ctx, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num);
+
+	// adds a sparse grid of luminance samples of the image to the smoothed histogram of ctx
+	void updateThresholdHistogram(Context* ctx, ARUint8 *image);
 
 	//static int arParamChangeSize( ARParam *source, int xsize, int ysize, ARParam *newparam );
 
@@ -331,22 +452,37 @@ protected:
 	static bool convertProjectionMatrixToOpenGLStyle2(ARFloat cparam[3][4], int width, int height, ARFloat gnear, ARFloat gfar, ARFloat m[16]);
 
 
-	ARMarkerInfo2* arDetectMarker2(ARInt16 *limage, int label_num, int *label_ref,
+	ARMarkerInfo2* arDetectMarker2(Context* ctx, ARLabel *limage, int label_num, int *label_ref,
 								   int *warea, ARFloat *wpos, int *wclip,
 								   int area_max, int area_min, ARFloat factor, int *marker_num);
 
-	int arGetContour(ARInt16 *limage, int *label_ref, int label, int clip[4], ARMarkerInfo2 *marker_infoTWO);
+	int arGetContour(Context* ctx, ARLabel *limage, int *label_ref, int label, int clip[4], ARMarkerInfo2 *marker_infoTWO);
 
 	int check_square(int area, ARMarkerInfo2 *marker_infoTWO, ARFloat factor);
 
-	int arGetCode(ARUint8 *image, int *x_coord, int *y_coord, int *vertex,
+	// removes candidates nested in larger ones from marker_infoTWO, returns the new number of candidates.
+	// which candidates are suppressed is the same as with the original double loop of arDetectMarker2(),
+	// but all of them are removed now: the original compaction skipped the entry that moved into a
+	// removed slot, so of two consecutive suppressed candidates the second one stayed with area 0.
+	int removeNestedCandidates(Context* ctx, int nNum);
+
+	// removes the candidates with area 0 from marker_infoTWO, returns the new number of candidates
+	int compactCandidates(Context* ctx, int nNum);
+
+	int arGetCode(Context* ctx, ARUint8 *image, int *x_coord, int *y_coord, int *vertex,
 				  int *code, int *dir, ARFloat *cf, int thresh);
 
 	int arGetPatt(ARUint8 *image, int *x_coord, int *y_coord, int *vertex,
 				  ARUint8 ext_pat[PATTERN_HEIGHT][PATTERN_WIDTH][3]);
 
+	// reads the pixels at (xc[i],yc[i]) as 3 channels, valid[i] is false for points outside of the image
+	void getSampleRow(ARUint8 *image, const int *xc, const int *yc, int num, ARUint8 row[][3], bool *valid);
+
 	int pattern_match( ARUint8 *data, int *code, int *dir, ARFloat *cf);
 
+	// copies the active patterns into patBank/patBankBW, called whenever patf changes
+	void updatePatternBank();
+
 	int downsamplePattern(ARUint8* data, unsigned char* imgPtr);
 
 	int bitfield_check_simple(ARUint8 *data, int *code, int *dir, ARFloat *cf, int thresh);
@@ -355,7 +491,7 @@ protected:
 
 	void gen_evec(void);
 
-	ARMarkerInfo* arGetMarkerInfo(ARUint8 *image, ARMarkerInfo2 *marker_info2, int *marker_num, int thresh);
+	ARMarkerInfo* arGetMarkerInfo(Context* ctx, ARUint8 *image, ARMarkerInfo2 *marker_info2, int *marker_num, int thresh);
 
 	ARFloat arGetTransMat2(ARFloat rot[3][3], ARFloat ppos2d[][2], ARFloat ppos3d[][2], int num, ARFloat conv[3][4]);
 
@@ -372,9 +508,19 @@ protected:
 							 Camera *pCam);
 							 //ARFloat *dist_factor, ARFloat cpara[3][4] );
 
+	void arGetTransMatTrans(ARFloat rot[3][3], ARFloat pos2d[][2],
+							ARFloat pos3d[][3], int num, ARFloat trans[3],
+							Camera *pCam);
+
+	int arGetTransMatBatch(const ARMarkerInfo *marker_info, int num, ARFloat center[2], ARFloat width,
+						   ARFloat conv[][3][4], ARFloat *err, PoseHistoryEntry *const *prev=NULL);
+
 	ARFloat arModifyMatrix(ARFloat rot[3][3], ARFloat trans[3], ARFloat cpara[3][4],
 								  ARFloat vertex[][3], ARFloat pos2d[][2], int num);
 
+	void arModifyMatrixBatch(ARFloat rot[][3][3], ARFloat trans[][3], ARFloat cpara[3][4],
+							 ARFloat vertex[4][3], ARFloat pos2d[][4][2], const int *idx, int num, ARFloat *err);
+
 	ARFloat arModifyMatrix2(ARFloat rot[3][3], ARFloat trans[3], ARFloat cpara[3][4],
 								   ARFloat vertex[][3], ARFloat pos2d[][2], int num);
 
@@ -393,22 +539,46 @@ protected:
 
 	ARFloat arGetTransMatContSub(ARMarkerInfo *marker_info, ARFloat prev_conv[3][4], ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
 
+	// rot is the initial rotation, NULL to let RPP estimate it
+	ARFloat rppGetTransMatSub(ARMarkerInfo *marker_info, ARFloat rot[3][3], ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+
+	// both IPPE poses for num points of the z=0 plane, sorted by their errors
+	int ippeGetTransMatSub(ARFloat pos2d[][2], ARFloat pos3d[][2], int num, ARFloat conv[2][3][4], ARFloat err[2]);
+
+	// runs the selected pose estimator, seeded from ctx's pose history if it is enabled
+	ARFloat estimateSingleMarkerPose(Context* ctx, ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+
 
 
-	ARInt16* arLabeling(ARUint8 *image, int thresh,int *label_num, int **area,
+	ARLabel* arLabeling(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area,
 						ARFloat **pos, int **clip, int **label_ref );
 
 
-	ARInt16* arLabeling_ABGR(ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
-	ARInt16* arLabeling_BGR(ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
-	ARInt16* arLabeling_RGB(ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
-	ARInt16* arLabeling_RGB565(ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
-	ARInt16* arLabeling_LUM(ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_ABGR(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_BGR(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_RGB(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_RGB565(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_LUM(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_YUV422(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	ARLabel* arLabeling_BIN(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+
+	ARLabel* arLabeling_RLE(Context* ctx, ARUint8 *image, int thresh,int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref);
+	static void rleExtractStripeTask(void* nContext, int nStripe);
+	static void rleFillStripeTask(void* nContext, int nStripe);
+
+	// LUM and YUV422 images are thresholded on their luminance only
+	bool isLumaFormat() const  {  return pixelFormat==PIXEL_FORMAT_LUM || pixelFormat==PIXEL_FORMAT_UYVY || pixelFormat==PIXEL_FORMAT_YUYV;  }
+	int getLumaOffset() const  {  return pixelFormat==PIXEL_FORMAT_UYVY ? 1 : 0;  }
+
+	ARUint32* arBinarize_LUM(Context* ctx, ARUint8 *image, int thresh);
+	void arBinarizeRows_LUM(Context* ctx, ARUint8 *image, int thresh, int nRowBegin, int nRowEnd, ARInt16 *nRowThresh);
+	void arBuildIntegralImage_LUM(Context* ctx, ARUint8 *image);
+	void arBinarizeRowsAdaptive_LUM(Context* ctx, ARUint8 *image, int nRowBegin, int nRowEnd);
 
-	//ARInt16* labeling2(ARUint8 *image, int thresh,int *label_num, int **area,
+	//ARLabel* labeling2(ARUint8 *image, int thresh,int *label_num, int **area,
 	//				   ARFloat **pos, int **clip, int **label_ref, int LorR );
 
-	//ARInt16* labeling3(ARUint8 *image, int thresh, int *label_num, int **area,
+	//ARLabel* labeling3(ARUint8 *image, int thresh, int *label_num, int **area,
 	//				   ARFloat **pos, int **clip, int **label_ref, int LorR );
 
 
@@ -428,6 +598,9 @@ protected:
 
 	int arGetLine2(int x_coord[], int y_coord[], int coord_num, int vertex[], ARFloat line[4][3], ARFloat v[4][2], Camera *pCam);
 
+	// like arGetLine2() but only undistorts AR_UNDIST_EDGE_SAMPLES points per edge (UNDIST_SAMPLED)
+	int arGetLineSampled(int x_coord[], int y_coord[], int coord_num, int vertex[], ARFloat line[4][3], ARFloat v[4][2], Camera *pCam);
+
 	static int arUtilMatMul(ARFloat s1[3][4], ARFloat s2[3][4], ARFloat d[3][4]);
 
 	static int arUtilMatInv(ARFloat s[3][4], ARFloat d[3][4]);
@@ -448,6 +621,8 @@ protected:
 
 	int arParamObserv2Ideal_LUT(Camera* pCam, ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy);
 
+	int arParamObserv2Ideal_grid(Camera* pCam, ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy);
+
 	int arParamObserv2Ideal_std(Camera* pCam, ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy);
 	int arParamIdeal2Observ_std(Camera* pCam, ARFloat ix, ARFloat iy, ARFloat *ox, ARFloat *oy);
 
@@ -458,10 +633,22 @@ protected:
 
 	void buildUndistO2ITable(Camera* pCam);
 
+	void buildUndistGrid(Camera* pCam);
+
+	// fill rows of the undistortion tables, nInfo is an UndistBuildInfo (see UndistCache::BuildFunc)
+	static void buildUndistO2IRows(void* nTable, int nRowBegin, int nRowEnd, void* nInfo);
+	static void buildUndistGridRows(void* nTable, int nRowBegin, int nRowEnd, void* nInfo);
+
+	// releases a shared (UndistCache) or private (artkp_Alloc) undistortion table
+	void freeUndistTable(void* nTable);
+
 	void checkRGB565LUT();
 
+	void checkBCHCodebook();
+
 	// calculates amount of data that will be allocated via artkp_Alloc()
-	static size_t getDynamicMemoryRequirements();
+	// for a camera resolution of nWidth x nHeight
+	static size_t getDynamicMemoryRequirements(int nWidth, int nHeight);
 
 	Profiler& getProfiler()  {  return profiler;  }
 
@@ -491,20 +678,32 @@ protected:
 	struct AutoThreshold {
 		enum {
 			MINLUM0 = 255,
-			MAXLUM0 = 0
+			MAXLUM0 = 0,
+
+			HIST_STEP = 8,			// the histogram samples every 8th pixel of every 8th row
+			HIST_WEIGHT = 16,		// weight of a sample, the histogram decays by 1/4 per frame
+			MAX_FAILED = 4,			// the first try plus the 3 histogram thresholds
+			MIN_THRESH_DIST = 8		// retry thresholds closer than this to a failed one are skipped
 		};
 
 		void reset()
 		{
 			minLum = MINLUM0;  maxLum = MAXLUM0;
+			numFailed = 0;
+		}
+
+		void resetHistogram()
+		{
+			memset(histogram, 0, sizeof(histogram));
 		}
 
 		void addValue(int nRed, int nGreen, int nBlue, int nPixelFormat)
 		{
 			int lum;
 
-			// in RGB565 and LUM8 all three values are simply the grey value...
-			if(nPixelFormat==PIXEL_FORMAT_RGB565 || nPixelFormat==PIXEL_FORMAT_LUM)
+			// in RGB565, LUM8 and YUV422 all three values are simply the grey value...
+			if(nPixelFormat==PIXEL_FORMAT_RGB565 || nPixelFormat==PIXEL_FORMAT_LUM ||
+			   nPixelFormat==PIXEL_FORMAT_UYVY || nPixelFormat==PIXEL_FORMAT_YUYV)
 				lum = nRed;
 			else
 				lum = (nRed + (nGreen<<1) + nBlue)>>2;
@@ -520,12 +719,144 @@ protected:
 			return (minLum+maxLum)/2;
 		}
 
+		// Otsu's threshold for histogram[nFirst..nLast], -1 if the range does not hold two classes
+		int calcOtsu(int nFirst, int nLast) const;
+
+		// records that nThresh found no marker and returns the next threshold to try
+		// (global Otsu, then Otsu of the dark and of the bright part), -1 if there is none left
+		int getRetryThreshold(int nThresh);
+
 		bool enable;
 		int minLum,maxLum;
-		int numRandomRetries;
+		int numRetries;
+
+		int histogram[256];		// luminance histogram, smoothed over the frames
+		int failed[MAX_FAILED];	// thresholds that found no marker in this frame
+		int numFailed;
 	} autoThreshold;
 
 
+	// the last pose of a marker id, see activatePoseHistory()
+	struct PoseHistoryEntry {
+		int		id, dir, area;
+		ARFloat	pos[2];
+		ARFloat	center[2], width;		// the pattern the pose was estimated for
+		ARFloat	trans[3][4];
+		unsigned int stamp;				// of the last update, the oldest entry is replaced
+	};
+
+
+	// the scratch buffers and the tracking history of marker detection.
+	// everything else in the tracker is only read while detecting, so
+	// several threads can detect with their own Context at the same time.
+	//
+	struct Context : public DetectionContext
+	{
+		Context(TrackerImpl* nTracker);
+		~Context();
+
+		int getThreshold() const  {  return thresh;  }
+
+		// releases all buffers, they are allocated again on demand
+		void cleanup();
+
+		// (re)allocates the image sized buffers if the resolution changed
+		void checkImageBuffer(int nWidth, int nHeight);
+
+		// grows marker_infoTWO, marker_infoL & prev_info to at least nSize entries (contents are kept)
+		bool growMarkerBuffers(int nSize);
+
+		// grows the label work tables to at least nSize labels (contents are kept)
+		bool growWorkBuffers(int nSize);
+
+		// grows the contour arena to at least nSize ints and moves the contours
+		// of the first nNumMarkers entries of marker_infoTWO along
+		bool growContourArena(int nSize, int nNumMarkers);
+
+		// the last pose of marker_info's id if the marker is close to where it was then, NULL otherwise
+		PoseHistoryEntry* findPose(const ARMarkerInfo *marker_info, const ARFloat center[2], ARFloat width);
+
+		// remembers conv as the last pose of marker_info's id
+		void storePose(const ARMarkerInfo *marker_info, const ARFloat center[2], ARFloat width, ARFloat conv[3][4]);
+
+		void clearPoseHistory()  {  poseHistoryNum = 0;  poseHistoryStamp = 0;  }
+
+		TrackerImpl				*tracker;
+
+		int						thresh;					// threshold of the next frame (auto threshold)
+		AutoThreshold			autoThreshold;			// the settings are the tracker's, the rest is per context
+
+		// arDetectMarker.cpp
+		//
+		ARMarkerInfo2			*marker_info2;
+		ARMarkerInfo			*wmarker_info;
+		int						wmarker_num;
+
+		arPrevInfo				*prev_info;				// [markerBufferSize]						// dyna
+		int						prev_num;
+
+		// arDetectMarker2.cpp
+		//
+		ARMarkerInfo2			*marker_infoTWO;		// [markerBufferSize]						// dyna
+		int						markerBufferSize;		// capacity of marker_infoTWO, marker_infoL & prev_info
+
+		int						*contourArena;			// contour points of all candidates of a frame	// dyna
+		int						contourArenaSize;
+		int						contourArenaUsed;
+
+		int						*candidateGrid;			// spatial hash, see removeNestedCandidates()	// dyna
+		int						candidateGridSize;
+
+		// arGetMarkerInfo.cpp
+		//
+		ARMarkerInfo			*marker_infoL;			// [markerBufferSize]						// dyna
+
+		// arLabeling.cpp
+		//
+		ARLabel					*l_imageL;				// label image, screenWidth*screenHeight	// dyna
+		int						l_imageL_width, l_imageL_height;
+
+		ARUint32				*binMaskL;				// packed 1-bit image, see arBinarize.cxx	// dyna
+		ARInt16					*binRowThresh;			// per-pixel thresholds of one row per stripe	// dyna
+		int						binMaskStride;			// in ARUint32 words
+		ARUint32				*integral;				// (lxsize+1)*(lysize+1) sums for adaptive thresholding	// dyna
+
+		ARInt16					*rleRunX;				// start/end column of each run, see arLabelingRLE.cxx	// dyna
+		int						*rleParent;				// union-find parent of each run			// dyna
+		int						*rleRowStart;			// index of the first run of each row		// dyna
+		int						*rleRowEnd;				// index behind the last run of each row	// dyna
+		int						rleRunsMax;
+
+		ThreadPool				labelingPool;
+		int						rleNumStripes;
+		int						rleStripeRow[MAX_LABELING_THREADS+1];
+		ARUint8					*rleImage;
+		int						rleThresh;
+
+		int						*workL;					// [workSize]								// dyna
+		int						*work2L;				// [workSize*7]								// dyna
+		int						workSize;				// capacity of the label work tables
+
+		int						wlabel_numL;
+		int						*wareaL;				// [workSize]								// dyna
+		int						*wclipL;				// [workSize*4]								// dyna
+		ARFloat					*wposL;					// [workSize*2]								// dyna
+
+		// arGetTransMatCont.cpp
+		//
+		PoseHistoryEntry		poseHistory[AR_POSE_HISTORY_SIZE];
+		int						poseHistoryNum;
+		unsigned int			poseHistoryStamp;
+
+		// holds the temporary matrices of detection and pose estimation.
+		// the detection and pose functions make it the current arena
+		// of the calling thread and reset it on return.
+		MemoryManagerArena		frameArena;
+	};
+
+	Context					*defaultContext;		// used by the functions without a DetectionContext parameter
+
+
 	PIXEL_FORMAT			pixelFormat;
 	int						pixelSize;
 
@@ -533,25 +864,9 @@ protected:
 
 	// arDetectMarker.cpp
 	//
-	ARMarkerInfo2			*marker_info2;
-	ARMarkerInfo			*wmarker_info;
-	int						wmarker_num;
-
-	arPrevInfo				prev_info[MAX_IMAGE_PATTERNS];
-	int						prev_num;
-
 	arPrevInfo				sprev_info[2][MAX_IMAGE_PATTERNS];
 	int						sprev_num[2];
 
-	// arDetectMarker2.cpp
-	//
-	ARMarkerInfo2			*marker_infoTWO;		// CAUTION: this member has to be manually allocated!
-													//          see TrackerSingleMarker for more info on this.
-
-    int						arGetContour_wx[AR_CHAIN_MAX];
-    int						arGetContour_wy[AR_CHAIN_MAX];
-
-
 	// arGetCode.cpp
 	int    pattern_num;
 	int    patf[MAX_LOAD_PATTERNS];
@@ -569,23 +884,21 @@ protected:
 	int    evec_dimBW;
 	int    evecBWf;
 
-	// arGetMarkerInfo.cpp
-	//
-	ARMarkerInfo    marker_infoL[MAX_IMAGE_PATTERNS];
-
-	// arGetTransMat.cpp
+	// the 4 rotations of all active patterns as one contiguous array of 16-bit rows,
+	// patBankIdx holds pattern number*4+direction of each row
 	//
-	ARFloat  pos2d[P_MAX][2];
-	ARFloat  pos3d[P_MAX][3];
+	ARInt16 patBank[MAX_LOAD_PATTERNS*4][PATTERN_BANK_STRIDE];
+	ARInt16 patBankBW[MAX_LOAD_PATTERNS*4][PATTERN_BANK_STRIDE_BW];
+	int    patBankIdx[MAX_LOAD_PATTERNS*4];
+	int    patBankNum;
 
 	// arLabeling.cpp
 	//
-	ARInt16      *l_imageL; //[HARDCODED_BUFFER_WIDTH*HARDCODED_BUFFER_HEIGHT];		// dyna
-	ARInt16      *l_imageR;
-	int			 l_imageL_size;
+	ARLabel      *l_imageR;
 
-	int          *workL;  //[WORK_SIZE];											// dyna
-	int          *work2L; //[WORK_SIZE*7];											// dyna
+	bool         useBinarization;
+	LABELING_MODE labelingMode;
+	int          numLabelingThreads;
 
 	int          *workR;
 	int          *work2R;
@@ -593,25 +906,21 @@ protected:
 	int          *wclipR;
 	ARFloat      *wposR;
 
-	int          wlabel_numL;
 	int          wlabel_numR;
-	int          *wareaL;  //[WORK_SIZE];											// dyna
-	int          *wclipL;  //[WORK_SIZE*4];											// dyna
-	ARFloat       *wposL;  //[WORK_SIZE*2];											// dyna
 
 	int        arFittingMode;
 	int        arImageProcMode;
 	Camera	   *arCamera;
 	bool		loadCachedUndist;
+	bool		shareUndistTables;
 	int        arImXsize, arImYsize;
 	int        arTemplateMatchingMode;
 	int        arMatchingPCAMode;
 
-	ARUint8*   arImageL;
-
 	MARKER_MODE		markerMode;
 
 	unsigned char *RGB565_to_LUM8_LUT;		// lookup table for RGB565 to LUM8 conversion
+	BCHCodebook *bchCodebook;				// decoding tables for MARKER_ID_BCH, shared by all contexts
 
 
 	// camera distortion addon by Daniel
@@ -619,6 +928,8 @@ protected:
 	UNDIST_MODE		undistMode;
 	unsigned int	*undistO2ITable;
 	//unsigned int	*undistI2OTable;
+	ARFloat			*undistGrid;				// (dx,dy) offset to the ideal position for each node
+	int				undistGridW, undistGridH;	// number of nodes
 
 
 	ARFloat			relBorderWidth;
@@ -628,6 +939,7 @@ protected:
 
 	// RPP integration -- [t.pintaric]
 	POSE_ESTIMATOR  poseEstimator;
+	bool			poseHistoryEnable;
 	//POSE_ESTIMATOR_FUNC poseEstimator_func;
 	//MULTI_POSE_ESTIMATOR_FUNC multiPoseEstimator_func;
 
@@ -648,7 +960,11 @@ protected:
 		int corners, leftright, bottomtop;
 	} vignetting;
 
-	BCH						*bchProcessor;
+	struct {
+		THRESHOLD_MODE mode;
+		int windowSize, bias;
+	} adaptiveThreshold;
+
 	Profiler				profiler;
 };
 
@@ -669,8 +985,11 @@ protected:
 #include "../../src/core/arGetTransMat2.cxx"
 #include "../../src/core/arGetTransMat3.cxx"
 #include "../../src/core/rppGetTransMat.cxx" // RPP integration -- [t.pintaric]
+#include "../../src/core/ippeGetTransMat.cxx"
 #include "../../src/core/arGetTransMatCont.cxx"
+#include "../../src/core/arBinarize.cxx"
 #include "../../src/core/arLabeling.cxx"
+#include "../../src/core/arLabelingRLE.cxx"
 #include "../../src/core/arMultiActivate.cxx"
 #include "../../src/core/arMultiGetTransMat.cxx"
 #include "../../src/core/rppMultiGetTransMat.cxx" 	// RPP integration -- [t.pintaric]
@@ -62,7 +62,8 @@ namespace ARToolKitPlus
  *  __PATTERN_SAMPLE_NUM describes the maximum resolution at which a pattern is sampled from the camera image
  *  (64 by default, must a a multiple of __PATTERN_SIZE_X and __PATTERN_SIZE_Y).
  *  __MAX_LOAD_PATTERNS describes the maximum number of pattern files that can be loaded.
- *  __MAX_IMAGE_PATTERNS describes the maximum number of patterns that can be analyzed in a camera image.
+ *  __MAX_IMAGE_PATTERNS describes the number of patterns per camera image the buffers are initially sized for.
+ *  The buffers grow at runtime if an image contains more marker candidates.
  *  Reduce __MAX_LOAD_PATTERNS and __MAX_IMAGE_PATTERNS to reduce memory footprint.
  */
 template <int __PATTERN_SIZE_X, int __PATTERN_SIZE_Y, int __PATTERN_SAMPLE_NUM, int __MAX_LOAD_PATTERNS=32, int __MAX_IMAGE_PATTERNS=32>
@@ -124,27 +125,42 @@ public:
 	bool setPixelFormat(PIXEL_FORMAT nFormat)  {  return AR_TEMPL_TRACKER::setPixelFormat(nFormat);  }
 	bool loadCameraFile(const char* nCamParamFile, ARFloat nNearClip, ARFloat nFarClip)  {  return AR_TEMPL_TRACKER::loadCameraFile(nCamParamFile, nNearClip, nFarClip);  }
 	void setLoadUndistLUT(bool nSet)  {  AR_TEMPL_TRACKER::setLoadUndistLUT(nSet);  }
+	void setShareUndistTables(bool nSet)  {  AR_TEMPL_TRACKER::setShareUndistTables(nSet);  }
 	void setLogger(ARToolKitPlus::Logger* nLogger)  {  AR_TEMPL_TRACKER::setLogger(nLogger);  }
 	int arDetectMarker(ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)  {  return AR_TEMPL_TRACKER::arDetectMarker(dataPtr, thresh, marker_info, marker_num);  }
 	int arDetectMarkerLite(ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)  {  return AR_TEMPL_TRACKER::arDetectMarkerLite(dataPtr, thresh, marker_info, marker_num);  }
+	DetectionContext* createDetectionContext()  {  return AR_TEMPL_TRACKER::createDetectionContext();  }
+	int arDetectMarker(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)  {  return AR_TEMPL_TRACKER::arDetectMarker(nContext, dataPtr, thresh, marker_info, marker_num);  }
+	int arDetectMarkerLite(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)  {  return AR_TEMPL_TRACKER::arDetectMarkerLite(nContext, dataPtr, thresh, marker_info, marker_num);  }
 	ARFloat arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)  {  return AR_TEMPL_TRACKER::arMultiGetTransMat(marker_info, marker_num, config);  }
 	ARFloat arGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::arGetTransMat(marker_info, center, width, conv);  }
 	ARFloat arGetTransMatCont(ARMarkerInfo *marker_info, ARFloat prev_conv[3][4], ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::arGetTransMatCont(marker_info, prev_conv, center, width, conv);  }
 	ARFloat rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)  {  return AR_TEMPL_TRACKER::rppMultiGetTransMat(marker_info, marker_num, config);  }
 	ARFloat rppGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::rppGetTransMat(marker_info, center, width, conv);  }
+	ARFloat rppGetTransMatCont(ARMarkerInfo *marker_info, ARFloat prev_conv[3][4], ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::rppGetTransMatCont(marker_info, prev_conv, center, width, conv);  }
+	ARFloat ippeMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)  {  return AR_TEMPL_TRACKER::ippeMultiGetTransMat(marker_info, marker_num, config);  }
+	ARFloat ippeGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::ippeGetTransMat(marker_info, center, width, conv);  }
+	int ippeGetTransMats(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[2][3][4], ARFloat err[2])  {  return AR_TEMPL_TRACKER::ippeGetTransMats(marker_info, center, width, conv, err);  }
 	int arLoadPatt(char *filename)  {  return AR_TEMPL_TRACKER::arLoadPatt(filename);  }
 	int arFreePatt(int patno)  {  return AR_TEMPL_TRACKER::arFreePatt(patno);  }
 	int arMultiFreeConfig(ARMultiMarkerInfoT *config)  {  return AR_TEMPL_TRACKER::arMultiFreeConfig(config);  }
 	ARMultiMarkerInfoT *arMultiReadConfigFile(const char *filename)  {  return AR_TEMPL_TRACKER::arMultiReadConfigFile(filename);  }
 	void activateBinaryMarker(int nThreshold)  {  AR_TEMPL_TRACKER::activateBinaryMarker(nThreshold);  }
+	void activatePCAMatching(bool nEnable)  {  AR_TEMPL_TRACKER::activatePCAMatching(nEnable);  }
 	void setMarkerMode(MARKER_MODE nMarkerMode)  {  AR_TEMPL_TRACKER::setMarkerMode(nMarkerMode);  }
 	void activateVignettingCompensation(bool nEnable, int nCorners=0, int nLeftRight=0, int nTopBottom=0)  {  AR_TEMPL_TRACKER::activateVignettingCompensation(nEnable, nCorners, nLeftRight, nTopBottom);  }
+	void activateBinarization(bool nEnable)  {  AR_TEMPL_TRACKER::activateBinarization(nEnable);  }
+	void setLabelingMode(LABELING_MODE nMode)  {  AR_TEMPL_TRACKER::setLabelingMode(nMode);  }
+	void setNumLabelingThreads(int nNumThreads)  {  AR_TEMPL_TRACKER::setNumLabelingThreads(nNumThreads);  }
 	void changeCameraSize(int nWidth, int nHeight)  {  AR_TEMPL_TRACKER::changeCameraSize(nWidth, nHeight);  }
 	void setUndistortionMode(UNDIST_MODE nMode)  {  AR_TEMPL_TRACKER::setUndistortionMode(nMode);  }
 	bool setPoseEstimator(POSE_ESTIMATOR nMethod) {  return AR_TEMPL_TRACKER::setPoseEstimator(nMethod);  }
+	void activatePoseHistory(bool nEnable)  {  AR_TEMPL_TRACKER::activatePoseHistory(nEnable);  }
+	bool isPoseHistoryActivated() const  {  return AR_TEMPL_TRACKER::isPoseHistoryActivated();  }
 	void setBorderWidth(ARFloat nFraction)  {  AR_TEMPL_TRACKER::setBorderWidth(nFraction);  }
 	void setThreshold(int nValue)  {  AR_TEMPL_TRACKER::setThreshold(nValue);  }
 	int getThreshold() const  {  return AR_TEMPL_TRACKER::getThreshold();  }
+	void setThresholdMode(THRESHOLD_MODE nMode, int nWindowSize=0, int nBias=7)  {  AR_TEMPL_TRACKER::setThresholdMode(nMode, nWindowSize, nBias);  }
 	void activateAutoThreshold(bool nEnable)  {  AR_TEMPL_TRACKER::activateAutoThreshold(nEnable);  }
 	bool isAutoThresholdActivated() const  {  return AR_TEMPL_TRACKER::isAutoThresholdActivated();  }
 	void setNumAutoThresholdRetries(int nNumRetries)  {  AR_TEMPL_TRACKER::setNumAutoThresholdRetries(nNumRetries);  }
@@ -160,14 +176,18 @@ public:
 	void setCamera(Camera* nCamera)  {  AR_TEMPL_TRACKER::setCamera(nCamera);  }
 	void setCamera(Camera* nCamera, ARFloat nNearClip, ARFloat nFarClip)  {  AR_TEMPL_TRACKER::setCamera(nCamera, nNearClip, nFarClip);  }
 	ARFloat calcOpenGLMatrixFromMarker(ARMarkerInfo* nMarkerInfo, ARFloat nPatternCenter[2], ARFloat nPatternSize, ARFloat *nOpenGLMatrix)  {  return AR_TEMPL_TRACKER::calcOpenGLMatrixFromMarker(nMarkerInfo, nPatternCenter, nPatternSize, nOpenGLMatrix);  }
+	int estimatePoses(const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize, ARFloat nOpenGLMatrices[][16], ARFloat* nErrors=NULL)  {  return AR_TEMPL_TRACKER::estimatePoses(nMarkerInfos, nNumMarkers, nPatternCenter, nPatternSize, nOpenGLMatrices, nErrors);  }
+	int estimatePoses(DetectionContext* nContext, const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize, ARFloat nOpenGLMatrices[][16], ARFloat* nErrors=NULL)  {  return AR_TEMPL_TRACKER::estimatePoses(nContext, nMarkerInfos, nNumMarkers, nPatternCenter, nPatternSize, nOpenGLMatrices, nErrors);  }
 	ARFloat executeSingleMarkerPoseEstimator(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::executeSingleMarkerPoseEstimator(marker_info, center, width, conv);  }
 	ARFloat executeMultiMarkerPoseEstimator(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)  {  return AR_TEMPL_TRACKER::executeMultiMarkerPoseEstimator(marker_info, marker_num, config);  }
+	ARFloat executeSingleMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])  {  return AR_TEMPL_TRACKER::executeSingleMarkerPoseEstimator(nContext, marker_info, center, width, conv);  }
+	ARFloat executeMultiMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)  {  return AR_TEMPL_TRACKER::executeMultiMarkerPoseEstimator(nContext, marker_info, marker_num, config);  }
 
 	static void* operator new(size_t size);
 
 	static void operator delete(void *rawMemory);
 
-	static size_t getMemoryRequirements();
+	static size_t getMemoryRequirements(int nWidth, int nHeight);
 
 protected:
 	int				numDetected;
@@ -175,8 +195,9 @@ protected:
 
 	ARMultiMarkerInfoT  *config;
 
-	int				detectedMarkerIDs[AR_TEMPL_TRACKER::MAX_IMAGE_PATTERNS];
-	ARMarkerInfo	detectedMarkers[AR_TEMPL_TRACKER::MAX_IMAGE_PATTERNS];
+	int				*detectedMarkerIDs;		// [detectedMarkersSize]
+	ARMarkerInfo	*detectedMarkers;		// [detectedMarkersSize]
+	int				detectedMarkersSize;
 };
 
 
@@ -0,0 +1,107 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#ifndef __ARTOOLKITPLUS_UNDISTCACHE_HEADERFILE__
+#define __ARTOOLKITPLUS_UNDISTCACHE_HEADERFILE__
+
+
+#include <ARToolKitPlus/ARToolKitPlus.h>
+#include <stddef.h>
+
+
+namespace ARToolKitPlus {
+
+
+/// A machine wide store of read-only undistortion tables
+/**
+ *  Tables are keyed by a hash of the calibration file's contents, the frame
+ *  size and a caller defined format id. The first caller builds a table into
+ *  a named shared memory mapping, splitting the rows over a ThreadPool. Every
+ *  later caller (in this or any other process) maps the same pages read-only
+ *  instead of building its own copy. Tables are reference counted per process
+ *  and unmapped when the last user releases them.
+ *
+ *  On Windows the mapping lives as long as any process has it open. On POSIX
+ *  systems it stays in the shared memory file system (e.g. /dev/shm) until
+ *  reboot or removeTables(), so later runs start without building it again.
+ *  Tables are created readable by their owner only, and mappings of other
+ *  users or writable by others are never used. A mapping whose builder died
+ *  before finishing is removed and acquire() returns NULL, in which case the
+ *  caller should build a private table.
+ *
+ *  Mapping names contain a format version, so tables of older library
+ *  versions are never used, but they are not removed either.
+ */
+class ARTOOLKITPLUS_API UndistCache
+{
+public:
+	/// Fills rows [nRowBegin,nRowEnd) of a table, called from several threads at once
+	typedef void (*BuildFunc)(void* nTable, int nRowBegin, int nRowEnd, void* nData);
+
+	/// Returns a shared table of nBytes bytes, building it with nBuild if it does not exist yet
+	/**
+	 *  nFormat has to change whenever the layout or the contents of the
+	 *  table change for the same camera file and frame size.
+	 *  Returns NULL if the calibration file can not be read or no shared
+	 *  memory is available.
+	 */
+	static const void* acquire(const char* nCalibFile, unsigned int nFormat, int nWidth, int nHeight,
+							   size_t nBytes, int nNumRows, BuildFunc nBuild, void* nData);
+
+	/// Releases a table returned by acquire(). Returns false if nTable is no shared table.
+	static bool release(const void* nTable);
+
+	/// Sets the number of threads that build a table (defaults to the number of CPUs)
+	static void setNumBuildThreads(int nNumThreads);
+
+	/// Removes all tables of the current user from the shared memory file system
+	/**
+	 *  Tables that are mapped stay valid for their users, the next acquire()
+	 *  builds them again. Returns the number of removed tables; only
+	 *  implemented on Linux, elsewhere nothing is removed.
+	 */
+	static int removeTables();
+};
+
+
+}  // namespace ARToolKitPlus
+
+
+#endif //__ARTOOLKITPLUS_UNDISTCACHE_HEADERFILE__
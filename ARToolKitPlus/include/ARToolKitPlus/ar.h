@@ -56,6 +56,12 @@
 { if( ((V) = (T *)malloc( sizeof(T) * (S) )) == 0 ) \
 {printf("malloc error!!\n"); exit(1);} }
 
+// like arMalloc(), but takes the memory from the current frame arena
+// (see MemoryManagerArena). release it with artkp_FrameFree().
+#define arFrameMalloc(V,T,S)  \
+{ if( ((V) = (T *)artkp_FrameAlloc( sizeof(T) * (S) )) == 0 ) \
+{printf("malloc error!!\n"); exit(1);} }
+
 
 namespace ARToolKitPlus {
 
@@ -67,6 +73,15 @@ typedef unsigned char     ARUint8;
 typedef unsigned short    ARUint16;
 typedef unsigned int      ARUint32;
 
+// type of the label image, see _USE_LABEL32_ in config.h
+#ifdef _USE_LABEL32_
+typedef ARInt32           ARLabel;
+#define AR_LABEL_MAX      0x7fffffff
+#else
+typedef ARInt16           ARLabel;
+#define AR_LABEL_MAX      0x7fff
+#endif
+
 
 typedef struct {
     int     area;
@@ -83,8 +98,8 @@ typedef struct {
     int     area;
     ARFloat  pos[2];
     int     coord_num;
-    int     x_coord[AR_CHAIN_MAX];
-    int     y_coord[AR_CHAIN_MAX];
+    int     *x_coord;       // point into the tracker's contour arena,
+    int     *y_coord;       // valid until the next marker detection
     int     vertex[5];
 } ARMarkerInfo2;
 
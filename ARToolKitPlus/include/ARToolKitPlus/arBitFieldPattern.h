@@ -94,6 +94,28 @@ namespace ARToolKitPlus {
 		35, 29, 23, 17, 11,  5 
 	};
 
+	// rotate90 moves row r of the grid to column 5-r. this table spreads
+	// the 6 bits of a row to every 6th bit, so a rotation takes one
+	// lookup per row (see rotate90CW())
+	const unsigned int rowToColumn[64] = {
+		0x00000000, 0x00000001, 0x00000040, 0x00000041,
+		0x00001000, 0x00001001, 0x00001040, 0x00001041,
+		0x00040000, 0x00040001, 0x00040040, 0x00040041,
+		0x00041000, 0x00041001, 0x00041040, 0x00041041,
+		0x01000000, 0x01000001, 0x01000040, 0x01000041,
+		0x01001000, 0x01001001, 0x01001040, 0x01001041,
+		0x01040000, 0x01040001, 0x01040040, 0x01040041,
+		0x01041000, 0x01041001, 0x01041040, 0x01041041,
+		0x40000000, 0x40000001, 0x40000040, 0x40000041,
+		0x40001000, 0x40001001, 0x40001040, 0x40001041,
+		0x40040000, 0x40040001, 0x40040040, 0x40040041,
+		0x40041000, 0x40041001, 0x40041040, 0x40041041,
+		0x41000000, 0x41000001, 0x41000040, 0x41000041,
+		0x41001000, 0x41001001, 0x41001040, 0x41001041,
+		0x41040000, 0x41040001, 0x41040040, 0x41040041,
+		0x41041000, 0x41041001, 0x41041040, 0x41041041
+	};
+
 
 	// some internal methods. primarily needed for
 	// marker printing, etc.
@@ -104,8 +126,6 @@ namespace ARToolKitPlus {
 
 	// static void setBit(IDPATTERN& pat, int which);
 
-	static bool isBitSet(IDPATTERN pat, int which);
-
 
 }  // namespace ARToolKitPlus
 
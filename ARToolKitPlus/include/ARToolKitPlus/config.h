@@ -160,6 +160,13 @@
 // arGetTransMat(...) instead
 #define   AR_GET_TRANS_CONT_MAT_MAX_FIT_ERROR     1.0
 
+// pose history (see Tracker::activatePoseHistory()):
+// number of marker ids remembered per detection context
+#define   AR_POSE_HISTORY_SIZE                    32
+// max. squared move of the marker center relative to its
+// area for the last pose to be used as starting point
+#define   AR_POSE_HISTORY_MAX_MOVE                0.5
+
 // min/max area of fiducial interiors to be matched
 // against templates, used in arDetectMarker.c
 #define   AR_AREA_MAX      100000
@@ -194,19 +201,48 @@
 #define   EVEC_MAX     10
 #define	  P_MAX       500
 
-// this defines the maximum screen width that
-// can be processed by artoolkit...
-// memory consumption (if static) is: 2*width*height bytes
-#ifdef _WIN32_WCE
-  #define MAX_BUFFER_WIDTH  320
-  #define MAX_BUFFER_HEIGHT 240
-#else
-  #define MAX_BUFFER_WIDTH  720
-  #define MAX_BUFFER_HEIGHT 576
-#endif //_WIN32_WCE
+// there is no compile-time limit on the screen size: all image
+// buffers are sized from the camera resolution when the camera
+// is loaded or resized (see loadCameraFile() & changeCameraSize()).
+//
+// the label image uses 16-bit labels by default (2*width*height bytes),
+// which limits labeling to 32767 connected components per frame.
+// define _USE_LABEL32_ to switch to 32-bit labels for large frames.
+//#define _USE_LABEL32_
 
 //#define WORK_SIZE   1024*32
 
+// spacing in pixels of the nodes of the UNDIST_GRID undistortion table.
+// a 640x480 camera needs 42x32 nodes (~10KB) with a spacing of 16.
+// strong wide angle lenses may want a spacing of 8 (~40KB).
+#define AR_UNDIST_GRID_STEP      16
+
+// number of points per marker edge that are undistorted with UNDIST_SAMPLED.
+// each point is the average of a run of contour pixels of that edge.
+#define AR_UNDIST_EDGE_SAMPLES   8
+
+// marker edges are fitted in closed form from their 2x2 covariance.
+// define _USE_PCA_LINE_FIT_ to go back to the general arMatrixPCA() fit.
+//#define _USE_PCA_LINE_FIT_
+
+// initial size of the arena that holds the temporary matrices of the
+// detection and pose functions (see MemoryManagerArena). the arena grows
+// when needed, so this only saves a few allocations in the first frames.
+#define AR_FRAME_ARENA_SIZE      (32*1024)
+
+
+// SIMD instruction sets used by the binarization pre-pass.
+// these are derived from the compiler's predefined macros,
+// define _ARTKP_NO_SIMD_ to always use the plain C code.
+#ifndef _ARTKP_NO_SIMD_
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#    define AR_USE_SSE2
+#  endif
+#  if defined(__AVX2__)
+#    define AR_USE_AVX2
+#  endif
+#endif //_ARTKP_NO_SIMD_
+
 
 //#define SMALL_LUM8_TABLE
 
@@ -63,6 +63,10 @@ namespace ARToolKitPlus {
 	#define BCH_MAX_SQ   8  // SQRT(MAX_LUT) -- (?)
 // -------------------------------------------------------
 
+// generator polynomial of the (36, 12, 9) code as computed by
+// BCH::gen_poly(), without its leading x^24 term
+#define BCH_GENERATOR 0xdb2777
+
 // we only use unsigned __int64 under windows.
 // have to use unsigned long long othersie...
 #if defined(_MSC_VER) || defined(_WIN32_WCE)
@@ -80,6 +84,8 @@ static void _copyBit(_64bits &dest_n, const int dest_bit, const _64bits src_n, c
 static int _countOnes(const _64bits src_n);
 */
 
+static int _popCount(_64bits n);
+
 static int* toBitPattern(int b[], _64bits n, int n_bits);
 static _64bits fromBitPattern(int b[], int n_bits);
 
@@ -126,6 +132,38 @@ class BCH
 };
 
 
+class BCHCodebook
+// table driven decoder for the (36, 12, 9) code of class BCH. it stores the
+// 4096 codewords and the error patterns of all correctable words indexed by
+// their syndrome, so decoding needs no Berlekamp iteration. the tables are
+// not modified after construction: one instance can be shared by all threads.
+{
+	public:
+		BCHCodebook();
+
+		// same result as BCH::encode() but without building the Galois field
+		static _64bits encode(const _64bits orig_n);
+
+		// corrects up to BCH_DEFAULT_T wrong bits, like BCH::decode()
+		bool decode(int &err_n, _64bits &orig_n, const _64bits encoded_n) const;
+
+
+	protected:
+		enum {
+			NUM_CODEWORDS = 1<<BCH_DEFAULT_K,
+			PARITY_BITS = BCH_DEFAULT_LENGTH-BCH_DEFAULT_K,
+			SYNDROME_TABLE_BITS = 17		// for the 66712 correctable error patterns
+		};
+
+		unsigned int getSyndrome(_64bits n) const;
+		static unsigned int hashSyndrome(unsigned int syndrome);
+		void addErrorPattern(_64bits error_n);
+
+		_64bits codewords[NUM_CODEWORDS];
+		_64bits errorPatterns[1<<SYNDROME_TABLE_BITS];		// 0 marks an empty entry
+};
+
+
 }  // namespace ARToolKitPlus
 
 
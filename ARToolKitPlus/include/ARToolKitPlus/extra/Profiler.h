@@ -61,6 +61,7 @@ public:
 	enum MES {
 		SINGLEMARKER_OVERALL,
 			LABELING,
+				BINARIZE,
 			DETECTMARKER2,
 			GETMARKERINFO,
 
@@ -83,7 +84,7 @@ public:
 		void reset();
 	};
 
-	Measurement _SINGLEMARKER_OVERALL, _LABELING, _DETECTMARKER2, _GETMARKERINFO, _GETTRANSMAT,
+	Measurement _SINGLEMARKER_OVERALL, _LABELING, _BINARIZE, _DETECTMARKER2, _GETMARKERINFO, _GETTRANSMAT,
 				_GETINITROT, _GETTRANSMAT3, _GETTRANSMATSUB, _MODIFYMATRIX_LOOP, _MODIFYMATRIX, _GETNEWMATRIX,
 				_GETROT, _GETANGLE;
 
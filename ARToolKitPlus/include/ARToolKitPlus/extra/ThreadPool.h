@@ -0,0 +1,110 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+#ifndef __ARTOOLKITPLUS_THREADPOOL_HEADERFILE__
+#define __ARTOOLKITPLUS_THREADPOOL_HEADERFILE__
+
+
+#include <ARToolKitPlus/ARToolKitPlus.h>
+
+
+namespace ARToolKitPlus {
+
+
+/// A minimal pool of worker threads for data parallel loops
+/**
+ *  run() executes nFunc(nData, i) for all i in [0,nCount) and returns after
+ *  all calls have finished. The calling thread takes part in the work, so a
+ *  pool with nNumThreads threads starts nNumThreads-1 worker threads.
+ *  Uses Win32 threads on Windows and pthreads elsewhere.
+ */
+class ARTOOLKITPLUS_API ThreadPool
+{
+public:
+	typedef void (*TaskFunc)(void* nData, int nIndex);
+
+	ThreadPool();
+	~ThreadPool();
+
+	/// Starts nNumThreads-1 worker threads. Stops running workers first.
+	/**
+	 *  If not all threads can be created, none are kept and false is
+	 *  returned; run() then executes all tasks on the calling thread.
+	 */
+	bool start(int nNumThreads);
+
+	/// Stops and joins all worker threads
+	void stop();
+
+	/// Returns the number of threads including the calling thread
+	int getNumThreads() const  {  return numWorkers+1;  }
+
+	/// Returns the thread count passed to the last start(), whether it succeeded or not
+	int getNumRequested() const  {  return numRequested;  }
+
+	/// Runs nFunc(nData, i) for i=0..nCount-1 and waits for all of them
+	void run(TaskFunc nFunc, void* nData, int nCount);
+
+protected:
+	struct Impl;
+
+	void workerLoop();
+	bool runNextTask();
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+	static unsigned long __stdcall workerMain(void* nPool);
+#else
+	static void* workerMain(void* nPool);
+#endif
+
+	Impl			*impl;
+	int				numWorkers, numRequested;
+
+	TaskFunc		taskFunc;
+	void			*taskData;
+	int				taskCount, taskNext, taskPending;
+	unsigned int	generation;
+	bool			quit;
+};
+
+
+}  // namespace ARToolKitPlus
+
+
+#endif //__ARTOOLKITPLUS_THREADPOOL_HEADERFILE__
@@ -145,6 +145,53 @@ observ2Ideal(ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy)
 	}
 }
 
+void CameraAdvImpl::
+observ2IdealBatch(int nNum, const ARFloat *ox, const ARFloat *oy, ARFloat *ix, ARFloat *iy)
+{
+	if(undist_iterations <= 0)
+	{
+		for(int i=0; i<nNum; i++)
+		{
+			ix[i] = ox[i];
+			iy[i] = oy[i];
+		}
+		return;
+	}
+
+	// same iteration as observ2Ideal() with the coefficients kept in registers
+	const ARFloat k1 = kc[0];
+	const ARFloat k2 = kc[1];
+	const ARFloat k3 = kc[4];
+	const ARFloat p1 = kc[2];
+	const ARFloat p2 = kc[3];
+	const ARFloat ifc[2] = { 1 / fc[0], 1 / fc[1] };
+
+	for(int i=0; i<nNum; i++)
+	{
+		const ARFloat xd[2] = { (ox[i] - cc[0]) * ifc[0], (oy[i] - cc[1]) * ifc[1] };
+
+		ARFloat x[2] = { xd[0], xd[1] };
+		for(int kk=0; kk<undist_iterations; kk++)
+		{
+			const ARFloat x0_sq = (x[0]*x[0]);
+			const ARFloat x1_sq = (x[1]*x[1]);
+			const ARFloat x0_x1 = (x[0]*x[1]);
+			const ARFloat r_2 = x0_sq + x1_sq;
+			const ARFloat r_2_sq = (r_2 * r_2);
+			const ARFloat k_radial =  1 + k1 * r_2 + k2 * (r_2_sq) + k3 * (r_2*r_2_sq);
+			const ARFloat delta_x[2] = {   2*p1*x0_x1 + p2*(r_2 + 2*x0_sq),
+				p1 * (r_2 + 2*x1_sq) + 2*p2*x0_x1   };
+			x[0] = xd[0] - delta_x[0];
+			x[1] = xd[1] - delta_x[1];
+			x[0] /= k_radial;
+			x[1] /= k_radial;
+		}
+
+		ix[i] = (x[0] * fc[0]) + cc[0];
+		iy[i] = (x[1] * fc[1]) + cc[1];
+	}
+}
+
 void CameraAdvImpl::
 ideal2Observ(ARFloat ix, ARFloat iy, ARFloat *ox, ARFloat *oy)
 {
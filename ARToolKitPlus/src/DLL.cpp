@@ -72,7 +72,7 @@ createTrackerSingleMarker(int nWidth, int nHeight,
 		typedef ARToolKitPlus::TrackerSingleMarkerImpl<6,6,6, 3, 10> TrackerSingleMarker_6_6_6_3_10;
 
 		if(memManager && !memManager->didInit())
-			memManager->init(TrackerSingleMarker_6_6_6_3_10::getMemoryRequirements());
+			memManager->init(TrackerSingleMarker_6_6_6_3_10::getMemoryRequirements(nWidth, nHeight));
 
 		TrackerSingleMarker* tracker = new TrackerSingleMarker_6_6_6_3_10(nWidth, nHeight);
 		tracker->setPixelFormat(nPixelFormat);
@@ -0,0 +1,341 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <ARToolKitPlus/MemoryManagerArena.h>
+#include <ARToolKitPlus/config.h>
+#include <assert.h>
+#include <stdlib.h>
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+#  define _ARTKP_ARENA_WIN32_
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
+
+namespace ARToolKitPlus
+{
+
+
+enum {
+	ARENA_ALIGN = 16		// alignment of all blocks returned by getMemory()
+};
+
+
+static size_t
+arenaAlign(size_t nNumBytes)
+{
+	return (nNumBytes + ARENA_ALIGN-1) & ~(size_t)(ARENA_ALIGN-1);
+}
+
+
+// the current arena is stored per thread. we use the TLS API rather than
+// __declspec(thread) / __thread, since neither works everywhere
+// (delay loaded DLLs on Windows, Windows CE, older Mac OS X compilers).
+//
+#ifdef _ARTKP_ARENA_WIN32_
+
+static DWORD arenaTlsIndex = TlsAlloc();
+
+static MemoryManagerArena*
+getThreadArena()
+{
+	return (MemoryManagerArena*)TlsGetValue(arenaTlsIndex);
+}
+
+static void
+setThreadArena(MemoryManagerArena* nArena)
+{
+	TlsSetValue(arenaTlsIndex, nArena);
+}
+
+#else
+
+static pthread_key_t arenaKey;
+static pthread_once_t arenaKeyOnce = PTHREAD_ONCE_INIT;
+
+static void
+createArenaKey()
+{
+	pthread_key_create(&arenaKey, NULL);
+}
+
+static MemoryManagerArena*
+getThreadArena()
+{
+	pthread_once(&arenaKeyOnce, createArenaKey);
+	return (MemoryManagerArena*)pthread_getspecific(arenaKey);
+}
+
+static void
+setThreadArena(MemoryManagerArena* nArena)
+{
+	pthread_once(&arenaKeyOnce, createArenaKey);
+	pthread_setspecific(arenaKey, nArena);
+}
+
+#endif //_ARTKP_ARENA_WIN32_
+
+
+MemoryManagerArena::Scope::Scope(MemoryManagerArena& nArena)
+{
+	prevArena = getThreadArena();
+
+	// the outermost Scope of a thread decides which arena serves it
+	arena = prevArena ? prevArena : &nArena;
+
+	arena->scopeDepth++;
+	if(!prevArena)
+		setThreadArena(arena);
+}
+
+
+MemoryManagerArena::Scope::~Scope()
+{
+	if(--arena->scopeDepth==0)
+		arena->reset();
+
+	if(!prevArena)
+		setThreadArena(NULL);
+}
+
+
+MemoryManagerArena::MemoryManagerArena()
+{
+	_didInit = false;
+
+	blocks = NULL;
+	lastMemory = NULL;
+	fullSize = growSize = 0;
+	scopeDepth = 0;
+	numSystemAllocs = 0;
+}
+
+
+MemoryManagerArena::~MemoryManagerArena()
+{
+	deinit();
+}
+
+
+bool
+MemoryManagerArena::init(size_t nNumInitialBytes, size_t nNumGrowBytes)
+{
+	if(_didInit)
+		return false;
+
+	growSize = nNumGrowBytes ? nNumGrowBytes : nNumInitialBytes;
+	if(!allocBlock(nNumInitialBytes))
+		return false;
+
+	_didInit = true;
+	return true;
+}
+
+
+bool
+MemoryManagerArena::deinit()
+{
+	if(!_didInit)
+		return false;
+
+	assert(scopeDepth==0 && "MemoryManagerArena released while in use");
+
+	freeBlocks();
+	_didInit = false;
+	return true;
+}
+
+
+bool
+MemoryManagerArena::didInit()
+{
+	return _didInit;
+}
+
+
+void*
+MemoryManagerArena::getMemory(size_t nNumBytes)
+{
+	if(!_didInit && !init(AR_FRAME_ARENA_SIZE))
+		return NULL;
+
+	nNumBytes = arenaAlign(nNumBytes);
+
+	Block* block = blocks;
+	if(block->size-block->used < nNumBytes)
+	{
+		// a new block is only needed until the next reset() merges them
+		size_t size = growSize;
+		while(size<nNumBytes)
+			size *= 2;
+
+		if(!(block = allocBlock(size)))
+			return NULL;
+	}
+
+	lastMemory = block->data + block->used;
+	block->used += nNumBytes;
+	return lastMemory;
+}
+
+
+void
+MemoryManagerArena::releaseMemory(void* nMemoryBlock)
+{
+	// only the most recent allocation can be given back right away
+	if(nMemoryBlock && nMemoryBlock==lastMemory)
+	{
+		blocks->used = (unsigned char*)lastMemory - blocks->data;
+		lastMemory = NULL;
+	}
+}
+
+
+void
+MemoryManagerArena::reset()
+{
+	if(!_didInit)
+		return;
+
+	if(blocks->next)
+	{
+		// the last frame did not fit into one block: replace
+		// all blocks by a single one that can hold all of them
+		size_t size = fullSize;
+
+		freeBlocks();
+		allocBlock(size);
+	}
+
+	if(blocks)
+		blocks->used = 0;
+	else
+		_didInit = false;		// out of memory, try again with the next getMemory()
+	lastMemory = NULL;
+}
+
+
+bool
+MemoryManagerArena::owns(const void* nMemoryBlock) const
+{
+	const unsigned char* ptr = (const unsigned char*)nMemoryBlock;
+
+	for(const Block* block=blocks; block; block=block->next)
+		if(ptr>=block->data && ptr<block->data+block->size)
+			return true;
+
+	return false;
+}
+
+
+MemoryManagerArena*
+MemoryManagerArena::getCurrent()
+{
+	return getThreadArena();
+}
+
+
+MemoryManagerArena::Block*
+MemoryManagerArena::allocBlock(size_t nNumBytes)
+{
+	const size_t headerSize = arenaAlign(sizeof(Block));
+
+	nNumBytes = arenaAlign(nNumBytes);
+
+	// the system allocator only guarantees 8 byte alignment on some platforms
+	unsigned char* mem = (unsigned char*)::malloc(headerSize + nNumBytes + ARENA_ALIGN);
+	if(!mem)
+		return NULL;
+
+	Block* block = (Block*)mem;
+	block->data = (unsigned char*)arenaAlign((size_t)(mem + headerSize));
+	block->size = nNumBytes;
+	block->used = 0;
+	block->next = blocks;
+
+	blocks = block;
+	fullSize += nNumBytes;
+	numSystemAllocs++;
+	return block;
+}
+
+
+void
+MemoryManagerArena::freeBlocks()
+{
+	while(blocks)
+	{
+		Block* next = blocks->next;
+		::free(blocks);
+		blocks = next;
+	}
+
+	fullSize = 0;
+	lastMemory = NULL;
+}
+
+
+void*
+artkp_FrameAlloc(size_t nNumBytes)
+{
+	if(MemoryManagerArena* arena = getThreadArena())
+		return arena->getMemory(nNumBytes);
+	return ::malloc(nNumBytes);
+}
+
+
+void
+artkp_FrameFree(void* nMemoryBlock)
+{
+	if(!nMemoryBlock)
+		return;
+
+	MemoryManagerArena* arena = getThreadArena();
+
+	if(arena && arena->owns(nMemoryBlock))
+		arena->releaseMemory(nMemoryBlock);
+	else
+		::free(nMemoryBlock);
+}
+
+
+}  // namespace ARToolKitPlus
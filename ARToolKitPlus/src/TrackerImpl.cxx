@@ -73,38 +73,29 @@ AR_TEMPL_TRACKER::TrackerImpl()
 	pixelSize = 3;
 
 	binaryMarkerThreshold = -1;
+	thresh = 100;
 
 	autoThreshold.enable = false;
-	autoThreshold.numRandomRetries = 2;
+	autoThreshold.numRetries = 2;
 
-	wmarker_num = 0;
-	prev_num = 0;
 	sprev_num[0] = sprev_num[1] = 0;
 
-	marker_infoTWO = NULL;
-
 	pattern_num = -1;
 	for(i=0; i<MAX_LOAD_PATTERNS; i++)
 		patf[i] = 0;
 	evecf = 0;
 	evecBWf = 0;
+	patBankNum = 0;
 
-	// we allocate all large data dynamically
-	//
-	l_imageL = NULL;
-	l_imageL_size = 0;
+	useBinarization = false;
+	labelingMode = LABELING_STD;
+	numLabelingThreads = 1;
 
-	workL = artkp_Alloc<int>(WORK_SIZE);
-	work2L = artkp_Alloc<int>(WORK_SIZE*7);
-	wareaL = artkp_Alloc<int>(WORK_SIZE);
-	wclipL = artkp_Alloc<int>(WORK_SIZE*4);
-	wposL = artkp_Alloc<ARFloat>(WORK_SIZE*2);
+	logger = NULL;
 
-	//workL = new int[WORK_SIZE];
-	//work2L = new int[WORK_SIZE*7];
-	//wareaL = new int[WORK_SIZE];
-	//wclipL = new int[WORK_SIZE*4];
-	//wposL = new ARFloat[WORK_SIZE*2];
+	// we allocate all large data dynamically
+	//
+	defaultContext = new Context(this);
 
 
 	// set all right side structures to NULL
@@ -122,16 +113,16 @@ AR_TEMPL_TRACKER::TrackerImpl()
 	
 	arCamera                = NULL;
 	loadCachedUndist        = false;
+	shareUndistTables       = false;
 	//arParam;
 	arImXsize = arImYsize	= 0;
 	arTemplateMatchingMode  = DEFAULT_TEMPLATE_MATCHING_MODE;
 	arMatchingPCAMode       = DEFAULT_MATCHING_PCA_MODE;
-	arImageL                = NULL;
-	//arImageR                = NULL;
 
 	markerMode = MARKER_TEMPLATE;
 
 	RGB565_to_LUM8_LUT = NULL;
+	bchCodebook = NULL;
 
 	relBorderWidth = 0.25f;
 
@@ -140,6 +131,8 @@ AR_TEMPL_TRACKER::TrackerImpl()
 	undistMode = UNDIST_STD;
 	undistO2ITable = NULL;
 	//undistI2OTable = NULL;
+	undistGrid = NULL;
+	undistGridW = undistGridH = 0;
 	arParamObserv2Ideal_func = &AR_TEMPL_TRACKER::arParamObserv2Ideal_std;
 	//arParamIdeal2Observ_func = arParamIdeal2Observ_std;
 
@@ -148,10 +141,13 @@ AR_TEMPL_TRACKER::TrackerImpl()
 	vignetting.leftright = 
 	vignetting.bottomtop = 0;
 
-	bchProcessor = NULL;
+	adaptiveThreshold.mode = THRESH_GLOBAL;
+	adaptiveThreshold.windowSize = 0;
+	adaptiveThreshold.bias = 7;
 
 	// RPP integration -- [t.pintaric]
 	poseEstimator = POSE_ESTIMATOR_ORIGINAL;
+	poseHistoryEnable = false;
 	//poseEstimator_func = &AR_TEMPL_TRACKER::arGetTransMat;
 	//multiPoseEstimator_func = &AR_TEMPL_TRACKER::arMultiGetTransMat;
 
@@ -168,42 +164,26 @@ AR_TEMPL_TRACKER::~TrackerImpl()
 		delete arCamera;
 	arCamera = NULL;
 
-	if(bchProcessor)
-		delete bchProcessor;
-	bchProcessor = NULL;
-
-	if(l_imageL)
-		artkp_Free(l_imageL);
-	l_imageL = NULL;
-
-	if(workL)
-		artkp_Free(workL);
-	workL = NULL;
-
-	if(work2L)
-		artkp_Free(work2L);
-	work2L = NULL;
-
-	if(wareaL)
-		artkp_Free(wareaL);
-	wareaL = NULL;
-
-	if(wclipL)
-		artkp_Free(wclipL);
-	wclipL = NULL;
-
-	if(wposL)
-		artkp_Free(wposL);
-	wposL = NULL;
+	if(defaultContext)
+		delete defaultContext;
+	defaultContext = NULL;
 
 	if(RGB565_to_LUM8_LUT)
 		artkp_Free(RGB565_to_LUM8_LUT);
 	RGB565_to_LUM8_LUT = NULL;
 
+	if(bchCodebook)
+		delete bchCodebook;
+	bchCodebook = NULL;
+
 	if(undistO2ITable)
-		artkp_Free(undistO2ITable);
+		freeUndistTable(undistO2ITable);
 	undistO2ITable = NULL;
 
+	if(undistGrid)
+		freeUndistTable(undistGrid);
+	undistGrid = NULL;
+
 	if(descriptionString)
 		delete [] descriptionString;
 	descriptionString = NULL;
@@ -222,6 +202,8 @@ AR_TEMPL_TRACKER::setPixelFormat(PIXEL_FORMAT nFormat)
 		return true;
 
 	case PIXEL_FORMAT_RGB565:
+	case PIXEL_FORMAT_UYVY:
+	case PIXEL_FORMAT_YUYV:
 		pixelSize=2;
 		return true;
 
@@ -243,29 +225,6 @@ AR_TEMPL_TRACKER::setPixelFormat(PIXEL_FORMAT nFormat)
 }
 
 
-AR_TEMPL_FUNC void
-AR_TEMPL_TRACKER::checkImageBuffer()
-{
-	// we have to take care here when using a memory manager that can not free memory
-	// (usually this image buffer should only be built once - unless we change camera resolution)
-	//
-
-	int newSize = screenWidth*screenHeight;
-
-	if(newSize==l_imageL_size)
-		return;
-
-	if(l_imageL)
-		//delete l_imageL;
-		artkp_Free(l_imageL);
-
-	l_imageL_size = newSize;
-
-	//l_imageL = new ARInt16[newSize];
-	l_imageL = artkp_Alloc<ARInt16>(newSize);
-}
-
-
 AR_TEMPL_FUNC bool
 AR_TEMPL_TRACKER::checkPixelFormat()
 {
@@ -275,6 +234,8 @@ AR_TEMPL_TRACKER::checkPixelFormat()
 		return pixelSize==1;
 
 	case PIXEL_FORMAT_RGB565:
+	case PIXEL_FORMAT_UYVY:
+	case PIXEL_FORMAT_YUYV:
 		return pixelSize==2;
 
 	case PIXEL_FORMAT_BGR:
@@ -330,7 +291,14 @@ AR_TEMPL_TRACKER::setCamera(Camera* nCamera)
 		// printf("%f %f %f;\n",arCamera->mat[1][0],arCamera->mat[1][1],arCamera->mat[1][2]);
 		// printf("%f %f %f ]\n",arCamera->mat[2][0],arCamera->mat[2][1],arCamera->mat[2][2]);
 
-		buildUndistO2ITable(arCamera);
+		if(undistMode==UNDIST_LUT)
+			buildUndistO2ITable(arCamera);
+		else if(undistMode==UNDIST_GRID)
+			buildUndistGrid(arCamera);
+
+		// allocate the image buffers for the camera's resolution
+		// now rather than when the first frame arrives
+		defaultContext->checkImageBuffer(screenWidth, screenHeight);
 	}
 }
 
@@ -360,6 +328,84 @@ AR_TEMPL_TRACKER::calcOpenGLMatrixFromMarker(ARMarkerInfo* nMarkerInfo, ARFloat
 }
 
 
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::estimatePoses(const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize,
+								ARFloat nOpenGLMatrices[][16], ARFloat* nErrors)
+{
+	return estimatePoses(defaultContext, nMarkerInfos, nNumMarkers, nPatternCenter, nPatternSize, nOpenGLMatrices, nErrors);
+}
+
+
+// the Scope opened here serves the nested Scopes of arGetTransMatBatch() and
+// the estimators, see executeSingleMarkerPoseEstimator(DetectionContext*,...)
+//
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::estimatePoses(DetectionContext* nContext, const ARMarkerInfo* nMarkerInfos, int nNumMarkers, ARFloat nPatternCenter[2], ARFloat nPatternSize,
+								ARFloat nOpenGLMatrices[][16], ARFloat* nErrors)
+{
+	Context *context = static_cast<Context*>(nContext);
+	MemoryManagerArena::Scope arenaScope(context->frameArena);
+	ARFloat (*tmpTrans)[3][4] = (ARFloat (*)[3][4])artkp_FrameAlloc(sizeof(ARFloat)*12*nNumMarkers);
+	ARFloat *err = nErrors ? nErrors : (ARFloat*)artkp_FrameAlloc(sizeof(ARFloat)*nNumMarkers);
+	int i, numFound = 0;
+
+#ifndef _FIXEDPOINT_MATH_ACTIVATED_
+	if(poseEstimator==POSE_ESTIMATOR_ORIGINAL && !poseHistoryEnable)
+		arGetTransMatBatch(nMarkerInfos, nNumMarkers, nPatternCenter, nPatternSize, tmpTrans, err);
+	else if(poseEstimator==POSE_ESTIMATOR_ORIGINAL)
+	{
+		// as in estimateSingleMarkerPose(): markers without an initial
+		// rotation continue from their last pose if they have one
+		PoseHistoryEntry **warmPrev = (PoseHistoryEntry**)artkp_FrameAlloc(sizeof(PoseHistoryEntry*)*nNumMarkers);
+		ARMarkerInfo *warmInfo = (ARMarkerInfo*)artkp_FrameAlloc(sizeof(ARMarkerInfo)*nNumMarkers);
+		ARFloat (*warmTrans)[3][4] = (ARFloat (*)[3][4])artkp_FrameAlloc(sizeof(ARFloat)*12*nNumMarkers);
+		ARFloat *warmErr = (ARFloat*)artkp_FrameAlloc(sizeof(ARFloat)*nNumMarkers);
+		int *warmIdx = (int*)artkp_FrameAlloc(sizeof(int)*nNumMarkers);
+		int numWarm = 0;
+
+		arGetTransMatBatch(nMarkerInfos, nNumMarkers, nPatternCenter, nPatternSize, tmpTrans, err);
+
+		for(i=0; i<nNumMarkers; i++)
+			if(err[i]<0 && (warmPrev[numWarm] = context->findPose(nMarkerInfos+i, nPatternCenter, nPatternSize))!=NULL)
+			{
+				warmInfo[numWarm] = nMarkerInfos[i];
+				warmIdx[numWarm++] = i;
+			}
+
+		arGetTransMatBatch(warmInfo, numWarm, nPatternCenter, nPatternSize, warmTrans, warmErr, warmPrev);
+
+		for(i=0; i<numWarm; i++)
+			if(warmErr[i]>=0)
+			{
+				memcpy(tmpTrans[warmIdx[i]], warmTrans[i], sizeof(ARFloat)*12);
+				err[warmIdx[i]] = warmErr[i];
+			}
+
+		for(i=0; i<nNumMarkers; i++)
+			if(err[i]>=0)
+				context->storePose(nMarkerInfos+i, nPatternCenter, nPatternSize, tmpTrans[i]);
+	}
+	else
+#endif //_FIXEDPOINT_MATH_ACTIVATED_
+	for(i=0; i<nNumMarkers; i++)
+		err[i] = estimateSingleMarkerPose(context, const_cast<ARMarkerInfo*>(nMarkerInfos+i), nPatternCenter, nPatternSize, tmpTrans[i]);
+
+	for(i=0; i<nNumMarkers; i++)
+	{
+		if(err[i]<0)
+		{
+			memset(nOpenGLMatrices[i], 0, sizeof(ARFloat)*16);
+			continue;
+		}
+
+		convertTransformationMatrixToOpenGLStyle(tmpTrans[i], nOpenGLMatrices[i]);
+		numFound++;
+	}
+
+	return numFound;
+}
+
+
 AR_TEMPL_FUNC void
 AR_TEMPL_TRACKER::convertTransformationMatrixToOpenGLStyle(ARFloat para[3][4], ARFloat gl_para[16])
 {
@@ -446,7 +492,7 @@ AR_TEMPL_TRACKER::calcCameraMatrix(const char* nCamParamFile, int nWidth, int nH
 		return(false);
 	}
 
-	pCam->changeFrameSize(AR_TEMPL_TRACKER::screenWidth,AR_TEMPL_TRACKER::screenHeight);
+	pCam->changeFrameSize(nWidth,nHeight);
 
 	int i;
     for(i = 0; i < 4; i++ )
@@ -474,6 +520,14 @@ AR_TEMPL_TRACKER::changeCameraSize(int nWidth, int nHeight)
 	arCamera->changeFrameSize(nWidth,nHeight);
 	arInitCparam(arCamera);
 
+	// arInitCparam() dropped the undistortion table if the size changed
+	if(!undistO2ITable && undistMode==UNDIST_LUT)
+		buildUndistO2ITable(arCamera);
+	if(!undistGrid && undistMode==UNDIST_GRID)
+		buildUndistGrid(arCamera);
+
+	defaultContext->checkImageBuffer(screenWidth, screenHeight);
+
 	if(logger)
 		logger->artLogEx("ARToolKitPlus: Changed CamSize %d, %d", arCamera->xsize, arCamera->ysize);
 }
@@ -498,8 +552,34 @@ AR_TEMPL_TRACKER::setUndistortionMode(UNDIST_MODE nMode)
 	case UNDIST_LUT:
 		arParamObserv2Ideal_func = &AR_TEMPL_TRACKER::arParamObserv2Ideal_LUT;
 		//arParamIdeal2Observ_func = arParamIdeal2Observ_LUT;
+		if(!undistO2ITable && arCamera)
+			buildUndistO2ITable(arCamera);
+		break;
+
+	case UNDIST_GRID:
+		arParamObserv2Ideal_func = &AR_TEMPL_TRACKER::arParamObserv2Ideal_grid;
+		if(!undistGrid && arCamera)
+			buildUndistGrid(arCamera);
+		break;
+
+	case UNDIST_SAMPLED:
+		// arGetLine() undistorts its edge samples in a batch (see arGetLineSampled()),
+		// this is only used for single points
+		arParamObserv2Ideal_func = &AR_TEMPL_TRACKER::arParamObserv2Ideal_std;
 		break;
 	}
+
+	// only UNDIST_LUT needs the (frame sized) lookup table
+	if(undistMode!=UNDIST_LUT && undistO2ITable)
+	{
+		freeUndistTable(undistO2ITable);
+		undistO2ITable = NULL;
+	}
+	if(undistMode!=UNDIST_GRID && undistGrid)
+	{
+		freeUndistTable(undistGrid);
+		undistGrid = NULL;
+	}
 }
 
 
@@ -538,28 +618,67 @@ AR_TEMPL_TRACKER::setPoseEstimator(POSE_ESTIMATOR nMode)
 }
 
 
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::activatePoseHistory(bool nEnable)
+{
+	poseHistoryEnable = nEnable;
+	defaultContext->clearPoseHistory();
+}
+
+
 AR_TEMPL_FUNC ARFloat
 AR_TEMPL_TRACKER::executeSingleMarkerPoseEstimator(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])
 {
+	return estimateSingleMarkerPose(defaultContext, marker_info, center, width, conv);
+}
+
+
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::estimateSingleMarkerPose(Context* ctx, ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])
+{
+	PoseHistoryEntry *prev = poseHistoryEnable ? ctx->findPose(marker_info, center, width) : NULL;
+	ARFloat err;
+
 	switch(poseEstimator)
 	{
 	case POSE_ESTIMATOR_ORIGINAL:
-		return arGetTransMat(marker_info, center, width, conv);
+		// started from the last pose arModifyMatrix() drifts along the
+		// badly constrained tilt of the marker from frame to frame, so the
+		// history only stands in where arGetInitRot() finds no rotation
+		err = arGetTransMat(marker_info, center, width, conv);
+		if(err<0 && prev)
+			err = arGetTransMatContSub(marker_info, prev->trans, center, width, conv);
+		break;
 
 	case POSE_ESTIMATOR_ORIGINAL_CONT:
-		return arGetTransMatCont2(marker_info, center, width, conv);
+		err = prev ? arGetTransMatCont(marker_info, prev->trans, center, width, conv)
+				   : arGetTransMatCont2(marker_info, center, width, conv);
+		break;
 
 	case POSE_ESTIMATOR_RPP:
 		if(rppSupportAvailabe())
 		{
-			return rppGetTransMat(marker_info, center, width, conv);
+			err = prev ? rppGetTransMatCont(marker_info, prev->trans, center, width, conv)
+					   : rppGetTransMat(marker_info, center, width, conv);
+			break;
 		}
 		if(logger)
 			logger->artLog("ARToolKitPlus: Failed to set RPP pose estimator - RPP disabled during build\n");
 		return -1.0f;
+
+	case POSE_ESTIMATOR_IPPE:
+		// closed form, a previous pose would not save anything
+		err = ippeGetTransMat(marker_info, center, width, conv);
+		break;
+
+	default:
+		return -1.0f;
 	}
 
-	return -1.0f;
+	if(poseHistoryEnable && err>=0)
+		ctx->storePose(marker_info, center, width, conv);
+
+	return err;
 }
 
 
@@ -582,12 +701,38 @@ AR_TEMPL_TRACKER::executeMultiMarkerPoseEstimator(ARMarkerInfo *marker_info, int
 		if(logger)
 			logger->artLog("ARToolKitPlus: Failed to set RPP pose estimator - RPP disabled during build\n");
 		return -1.0f;
+
+	case POSE_ESTIMATOR_IPPE:
+		return ippeMultiGetTransMat(marker_info, marker_num, config);
 	}
 
 	return -1.0f;
 }
 
 
+// the pose estimators only read the tracker, their temporary memory comes
+// from the current arena. a Scope opened here keeps serving the nested
+// Scopes of the estimators, so the tracker's default context is not touched.
+// the pose history is nContext's as well.
+//
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::executeSingleMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])
+{
+	MemoryManagerArena::Scope arenaScope(static_cast<Context*>(nContext)->frameArena);
+
+	return estimateSingleMarkerPose(static_cast<Context*>(nContext), marker_info, center, width, conv);
+}
+
+
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::executeMultiMarkerPoseEstimator(DetectionContext* nContext, ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)
+{
+	MemoryManagerArena::Scope arenaScope(static_cast<Context*>(nContext)->frameArena);
+
+	return executeMultiMarkerPoseEstimator(marker_info, marker_num, config);
+}
+
+
 
 AR_TEMPL_FUNC void
 AR_TEMPL_TRACKER::activateVignettingCompensation(bool nEnable, int nCorners, int nLeftRight, int nTopBottom)
@@ -599,10 +744,49 @@ AR_TEMPL_TRACKER::activateVignettingCompensation(bool nEnable, int nCorners, int
 }
 
 
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::setThresholdMode(THRESHOLD_MODE nMode, int nWindowSize, int nBias)
+{
+	adaptiveThreshold.mode = nMode;
+	adaptiveThreshold.windowSize = nWindowSize;
+	adaptiveThreshold.bias = nBias;
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::setNumLabelingThreads(int nNumThreads)
+{
+	if(nNumThreads>MAX_LABELING_THREADS)
+		nNumThreads = MAX_LABELING_THREADS;
+	if(nNumThreads<1)
+		nNumThreads = 1;
+
+	numLabelingThreads = nNumThreads;
+
+	// other contexts start their workers with their first frame (see arLabeling_RLE())
+	if(nNumThreads!=defaultContext->labelingPool.getNumRequested())
+		if(!defaultContext->labelingPool.start(nNumThreads) && logger)
+			logger->artLogEx("ARToolKitPlus: failed to start %d labeling threads, labeling single threaded", nNumThreads);
+}
+
+
 AR_TEMPL_FUNC void
 AR_TEMPL_TRACKER::setMarkerMode(MARKER_MODE nMarkerMode)
 {
 	markerMode = nMarkerMode;
+
+	if(markerMode==MARKER_ID_BCH)
+		checkBCHCodebook();
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::activatePCAMatching(bool nEnable)
+{
+	arMatchingPCAMode = nEnable ? AR_MATCHING_WITH_PCA : AR_MATCHING_WITHOUT_PCA;
+
+	if(nEnable)
+		gen_evec();
 }
 
 
@@ -651,22 +835,339 @@ AR_TEMPL_TRACKER::checkRGB565LUT()
 }
 
 
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::checkBCHCodebook()
+{
+	if(!bchCodebook)
+		bchCodebook = new BCHCodebook;
+}
+
+
 // cleanup function called when program exits
 //
 AR_TEMPL_FUNC void
 AR_TEMPL_TRACKER::cleanup()
+{
+	defaultContext->cleanup();
+}
+
+
+AR_TEMPL_FUNC DetectionContext*
+AR_TEMPL_TRACKER::createDetectionContext()
+{
+	// tables which would otherwise be built lazily during detection
+	if(pixelFormat==PIXEL_FORMAT_RGB565)
+		checkRGB565LUT();
+	if(markerMode==MARKER_ID_BCH)
+		checkBCHCodebook();
+	if(!undistO2ITable && undistMode==UNDIST_LUT && arCamera)
+		buildUndistO2ITable(arCamera);
+	if(!undistGrid && undistMode==UNDIST_GRID && arCamera)
+		buildUndistGrid(arCamera);
+
+	return new Context(this);
+}
+
+
+AR_TEMPL_FUNC
+AR_TEMPL_TRACKER::Context::Context(TrackerImpl* nTracker)
+{
+	tracker = nTracker;
+	thresh = nTracker->thresh;
+	autoThreshold.reset();
+	autoThreshold.resetHistogram();
+
+	wmarker_num = 0;
+	prev_num = 0;
+
+	marker_info2 = NULL;
+	wmarker_info = NULL;
+	marker_infoTWO = NULL;
+	marker_infoL = NULL;
+	prev_info = NULL;
+	markerBufferSize = 0;
+
+	contourArena = NULL;
+	contourArenaSize = contourArenaUsed = 0;
+
+	candidateGrid = NULL;
+	candidateGridSize = 0;
+
+	l_imageL = NULL;
+	l_imageL_width = l_imageL_height = 0;
+
+	binMaskL = NULL;
+	binRowThresh = NULL;
+	binMaskStride = 0;
+	integral = NULL;
+
+	rleRunX = NULL;
+	rleParent = NULL;
+	rleRowStart = NULL;
+	rleRowEnd = NULL;
+	rleRunsMax = 0;
+	rleNumStripes = 0;
+	rleImage = NULL;
+	rleThresh = 0;
+
+	workL = work2L = wareaL = wclipL = NULL;
+	wposL = NULL;
+	workSize = 0;
+	wlabel_numL = 0;
+	growWorkBuffers(WORK_SIZE);
+
+	clearPoseHistory();
+
+	// the default context gets these again in init() after a cleanup()
+	growMarkerBuffers(MAX_IMAGE_PATTERNS);
+}
+
+
+AR_TEMPL_FUNC
+AR_TEMPL_TRACKER::Context::~Context()
+{
+	cleanup();
+
+	if(l_imageL)
+		artkp_Free(l_imageL);
+	l_imageL = NULL;
+
+	if(binMaskL)
+		artkp_Free(binMaskL);
+	binMaskL = NULL;
+
+	if(binRowThresh)
+		artkp_Free(binRowThresh);
+	binRowThresh = NULL;
+
+	if(integral)
+		artkp_Free(integral);
+	integral = NULL;
+
+	if(rleRunX)
+		artkp_Free(rleRunX);
+	rleRunX = NULL;
+
+	if(rleParent)
+		artkp_Free(rleParent);
+	rleParent = NULL;
+
+	if(rleRowStart)
+		artkp_Free(rleRowStart);
+	rleRowStart = NULL;
+
+	if(rleRowEnd)
+		artkp_Free(rleRowEnd);
+	rleRowEnd = NULL;
+
+	if(workL)
+		artkp_Free(workL);
+	workL = NULL;
+
+	if(work2L)
+		artkp_Free(work2L);
+	work2L = NULL;
+
+	if(wareaL)
+		artkp_Free(wareaL);
+	wareaL = NULL;
+
+	if(wclipL)
+		artkp_Free(wclipL);
+	wclipL = NULL;
+
+	if(wposL)
+		artkp_Free(wposL);
+	wposL = NULL;
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::Context::cleanup()
 {
 	if(marker_infoTWO)
 		//delete [] marker_infoTWO;
 		artkp_Free(marker_infoTWO);
 	marker_infoTWO = NULL;
+
+	if(marker_infoL)
+		artkp_Free(marker_infoL);
+	marker_infoL = NULL;
+
+	if(prev_info)
+		artkp_Free(prev_info);
+	prev_info = NULL;
+
+	markerBufferSize = 0;
+	prev_num = 0;
+
+	if(contourArena)
+		artkp_Free(contourArena);
+	contourArena = NULL;
+	contourArenaSize = contourArenaUsed = 0;
+
+	if(candidateGrid)
+		artkp_Free(candidateGrid);
+	candidateGrid = NULL;
+	candidateGridSize = 0;
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::Context::checkImageBuffer(int nWidth, int nHeight)
+{
+	// we have to take care here when using a memory manager that can not free memory
+	// (usually this image buffer should only be built once - unless we change camera resolution)
+	//
+	// the buffers depend on width and height, not only on their product
+	//
+	if(nWidth==l_imageL_width && nHeight==l_imageL_height)
+		return;
+
+	if(l_imageL)
+		//delete l_imageL;
+		artkp_Free(l_imageL);
+
+	l_imageL_width = nWidth;
+	l_imageL_height = nHeight;
+
+	int newSize = nWidth*nHeight;
+
+	//l_imageL = new ARLabel[newSize];
+	l_imageL = artkp_Alloc<ARLabel>(newSize);
+
+	// buffers for the binarization pre-pass (sized for full resolution)
+	//
+	if(binMaskL)
+		artkp_Free(binMaskL);
+	if(binRowThresh)
+		artkp_Free(binRowThresh);
+
+	binMaskL = artkp_Alloc<ARUint32>(((nWidth+31)>>5)*nHeight);
+	binRowThresh = artkp_Alloc<ARInt16>(nWidth*MAX_LABELING_THREADS);		// one row per stripe
+
+	// buffers for run-length labeling. since the border columns are
+	// always white a row can contain at most nWidth/2 runs.
+	//
+	if(rleRunX)
+		artkp_Free(rleRunX);
+	if(rleParent)
+		artkp_Free(rleParent);
+	if(rleRowStart)
+		artkp_Free(rleRowStart);
+	if(rleRowEnd)
+		artkp_Free(rleRowEnd);
+
+	rleRunsMax = (nWidth/2)*nHeight;
+	rleRunX = artkp_Alloc<ARInt16>(rleRunsMax*2);
+	rleParent = artkp_Alloc<int>(rleRunsMax);
+	rleRowStart = artkp_Alloc<int>(nHeight);
+	rleRowEnd = artkp_Alloc<int>(nHeight);
+
+	// integral image for adaptive thresholding
+	//
+	if(integral)
+		artkp_Free(integral);
+
+	integral = artkp_Alloc<ARUint32>((nWidth+1)*(nHeight+1));
+}
+
+
+AR_TEMPL_FUNC bool
+AR_TEMPL_TRACKER::Context::growMarkerBuffers(int nSize)
+{
+	if(nSize<=markerBufferSize)
+		return true;
+
+	// grow geometrically, so that a frame with many candidates
+	// only causes a few reallocations
+	//
+	int newSize = markerBufferSize*2>nSize ? markerBufferSize*2 : nSize;
+
+	marker_infoTWO = artkp_Grow(marker_infoTWO, markerBufferSize, newSize);
+	marker_infoL = artkp_Grow(marker_infoL, markerBufferSize, newSize);
+	prev_info = artkp_Grow(prev_info, markerBufferSize, newSize);
+
+	if(!marker_infoTWO || !marker_infoL || !prev_info)
+	{
+		if(tracker->logger)
+			tracker->logger->artLogEx("ARToolKitPlus: failed to grow the marker buffers to %d entries", newSize);
+		cleanup();
+		return false;
+	}
+
+	markerBufferSize = newSize;
+	return true;
+}
+
+
+AR_TEMPL_FUNC bool
+AR_TEMPL_TRACKER::Context::growContourArena(int nSize, int nNumMarkers)
+{
+	if(nSize<=contourArenaSize)
+		return true;
+
+	int newSize = contourArenaSize*2>nSize ? contourArenaSize*2 : nSize;
+	int *newArena = artkp_Alloc<int>(newSize);
+
+	if(!newArena)
+	{
+		if(tracker->logger)
+			tracker->logger->artLogEx("ARToolKitPlus: failed to grow the contour arena to %d points", newSize/2);
+		return false;
+	}
+
+	if(contourArena)
+	{
+		memcpy(newArena, contourArena, contourArenaUsed*sizeof(int));
+
+		// candidates found so far refer into the old arena
+		for(int i=0; i<nNumMarkers; i++)
+		{
+			marker_infoTWO[i].x_coord = newArena + (marker_infoTWO[i].x_coord-contourArena);
+			marker_infoTWO[i].y_coord = newArena + (marker_infoTWO[i].y_coord-contourArena);
+		}
+
+		artkp_Free(contourArena);
+	}
+
+	contourArena = newArena;
+	contourArenaSize = newSize;
+	return true;
+}
+
+
+AR_TEMPL_FUNC bool
+AR_TEMPL_TRACKER::Context::growWorkBuffers(int nSize)
+{
+	if(nSize<=workSize)
+		return true;
+
+	int newSize = workSize*2>nSize ? workSize*2 : nSize;
+
+	workL = artkp_Grow(workL, workSize, newSize);
+	work2L = artkp_Grow(work2L, workSize*7, newSize*7);
+	wareaL = artkp_Grow(wareaL, workSize, newSize);
+	wclipL = artkp_Grow(wclipL, workSize*4, newSize*4);
+	wposL = artkp_Grow(wposL, workSize*2, newSize*2);
+
+	if(!workL || !work2L || !wareaL || !wclipL || !wposL)
+	{
+		if(tracker->logger)
+			tracker->logger->artLogEx("ARToolKitPlus: failed to grow the label work tables to %d labels", newSize);
+		workSize = 0;
+		return false;
+	}
+
+	workSize = newSize;
+	return true;
 }
 
 
 AR_TEMPL_FUNC const char*
 AR_TEMPL_TRACKER::getDescription()
 {
-	char* pixelformats[] = { "NONE", "ABGR", "BGRA", "BGR", "RGBA", "RGB", "RGB565", "LUM"  };
+	char* pixelformats[] = { "NONE", "ABGR", "BGRA", "BGR", "RGBA", "RGB", "RGB565", "LUM", "UYVY", "YUYV"  };
 	int f = getPixelFormat();
 
 	char *compilerstr = new char[256];
@@ -721,7 +1222,7 @@ AR_TEMPL_TRACKER::getDescription()
 #endif
 			usesSinglePrecision() ? "single" : "double",
 			PATTERN_WIDTH,PATTERN_HEIGHT,
-			f<=PIXEL_FORMAT_LUM ? pixelformats[f] : pixelformats[0],
+			f<=PIXEL_FORMAT_YUYV ? pixelformats[f] : pixelformats[0],
 #ifdef _ARTKP_NO_MEMORYMANAGER_
 			"no ",
 #else
@@ -771,9 +1272,10 @@ AR_TEMPL_TRACKER::operator delete(void *rawMemory)
 
 
 AR_TEMPL_FUNC size_t
-AR_TEMPL_TRACKER::getDynamicMemoryRequirements()
+AR_TEMPL_TRACKER::getDynamicMemoryRequirements(int nWidth, int nHeight)
 {
-	// requirements for allocations in the constructor
+	// requirements for allocations in the constructor. the work tables
+	// and marker buffers start at these sizes and grow on demand later on.
 	//
 	size_t size = sizeof(unsigned int)*(WORK_SIZE +			// workL = new int[WORK_SIZE];
 										WORK_SIZE*7 +		// work2L = new int[WORK_SIZE*7];
@@ -781,24 +1283,49 @@ AR_TEMPL_TRACKER::getDynamicMemoryRequirements()
 										WORK_SIZE*4 +		// wclipL = new int[WORK_SIZE*4];
 										WORK_SIZE*2);		// wposL = new ARFloat[WORK_SIZE*2];
 
-	// requirements for the image buffer (arImageL)
+	// requirements for allocation of marker_infoTWO, marker_infoL & prev_info
 	//
-	size += sizeof(ARUint8)*MAX_BUFFER_WIDTH*MAX_BUFFER_HEIGHT;
+	size += (sizeof(ARMarkerInfo2)+sizeof(ARMarkerInfo)+sizeof(arPrevInfo))*MAX_IMAGE_PATTERNS;
 
 
-	// requirements for allocation of marker_infoTWO
+	// requirements for the contour arena (room to trace one contour)
 	//
-	size += sizeof(ARMarkerInfo2)*MAX_IMAGE_PATTERNS;
+	size += sizeof(int)*AR_CHAIN_MAX*2;
 
 
 	// requirements for allocation of l_imageL
 	//
-	size += sizeof(ARInt16)*MAX_BUFFER_WIDTH*MAX_BUFFER_HEIGHT;
+	size += sizeof(ARLabel)*nWidth*nHeight;
+
+
+	// requirements for the binarization pre-pass (binMaskL, binRowThresh)
+	//
+	size += sizeof(ARUint32)*((nWidth+31)>>5)*nHeight;
+	size += sizeof(ARInt16)*nWidth*MAX_LABELING_THREADS;
+
+
+	// requirements for run-length labeling (rleRunX, rleParent, rleRowStart, rleRowEnd)
+	//
+	size += sizeof(ARInt16)*nWidth*nHeight;
+	size += sizeof(int)*(nWidth/2)*nHeight;
+	size += sizeof(int)*nHeight*2;
+
+
+	// requirements for adaptive thresholding (integral)
+	//
+	size += sizeof(ARUint32)*(nWidth+1)*(nHeight+1);
+
+
+	// requirements for the lens undistortion table (undistO2ITable),
+	// which is only allocated with UNDIST_LUT
+	//
+	size += sizeof(unsigned int)*nWidth*nHeight;
 
 
-	// requirements for the lens undistortion table (undistO2ITable)
+	// requirements for the coarse undistortion table (undistGrid),
+	// which is only allocated with UNDIST_GRID
 	//
-	size += sizeof(unsigned int)*MAX_BUFFER_WIDTH*MAX_BUFFER_HEIGHT;
+	size += sizeof(ARFloat)*2*((nWidth-1)/AR_UNDIST_GRID_STEP+2)*((nHeight-1)/AR_UNDIST_GRID_STEP+2);
 
 
 	// requirements for the RGB565 to gray table RGB565_to_LUM8_LUT
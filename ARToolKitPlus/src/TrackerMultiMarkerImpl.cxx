@@ -58,6 +58,10 @@ ARMM_TEMPL_TRACKER::TrackerMultiMarkerImpl(int nWidth, int nHeight)
 	useDetectLite = true;
 	numDetected = 0;
 
+	detectedMarkerIDs = NULL;
+	detectedMarkers = NULL;
+	detectedMarkersSize = 0;
+
 	config = 0;
 
 	this->thresh = 150;
@@ -70,6 +74,11 @@ ARMM_TEMPL_TRACKER::~TrackerMultiMarkerImpl()
 	cleanup();
 	if(config)
 		arMultiFreeConfig(config);
+
+	if(detectedMarkerIDs)
+		artkp_Free(detectedMarkerIDs);
+	if(detectedMarkers)
+		artkp_Free(detectedMarkers);
 }
 
 
@@ -78,9 +87,9 @@ ARMM_TEMPL_TRACKER::init(const char* nCamParamFile, const char* nMultiFile, ARFl
 						 ARToolKitPlus::Logger* nLogger)
 {
 	// init some "static" from TrackerMultiMarker
+	// (grows later on if an image contains more marker candidates)
 	//
-	if(this->marker_infoTWO==NULL)
-		this->marker_infoTWO = artkp_Alloc<ARMarkerInfo2>(AR_TEMPL_TRACKER::MAX_IMAGE_PATTERNS);
+	this->defaultContext->growMarkerBuffers(AR_TEMPL_TRACKER::MAX_IMAGE_PATTERNS);
 
 	this->logger = nLogger;
 
@@ -118,19 +127,29 @@ ARMM_TEMPL_TRACKER::calc(const unsigned char* nImage)
 			return 0;
 	}
 
+	if(tmpNumDetected>detectedMarkersSize)
+	{
+		detectedMarkerIDs = artkp_Grow(detectedMarkerIDs, 0, tmpNumDetected);
+		detectedMarkers = artkp_Grow(detectedMarkers, 0, tmpNumDetected);
+		if(!detectedMarkerIDs || !detectedMarkers)
+		{
+			detectedMarkersSize = 0;
+			return 0;
+		}
+		detectedMarkersSize = tmpNumDetected;
+	}
+
 	for(int i=0; i<tmpNumDetected; i++)
 		if(tmp_markers[i].id!=-1)
 		{
 			detectedMarkers[numDetected] = tmp_markers[i];
 			detectedMarkerIDs[numDetected++] = tmp_markers[i].id;
-			if(numDetected>=__MAX_IMAGE_PATTERNS)							// increase this value if more markers should be possible to be detected in one image...
-				break;
 		}
 
 	if(executeMultiMarkerPoseEstimator(tmp_markers, tmpNumDetected, config) < 0)
 		return 0;
 
-	convertTransformationMatrixToOpenGLStyle(config->trans, this->gl_para);
+	this->convertTransformationMatrixToOpenGLStyle(config->trans, this->gl_para);
 	return numDetected;
 }
 
@@ -180,11 +199,11 @@ ARMM_TEMPL_TRACKER::operator delete(void *rawMemory)
 
 
 ARMM_TEMPL_FUNC size_t
-ARMM_TEMPL_TRACKER::getMemoryRequirements()
+ARMM_TEMPL_TRACKER::getMemoryRequirements(int nWidth, int nHeight)
 {
 	size_t size = sizeof(ARMM_TEMPL_TRACKER);
 
-	size += AR_TEMPL_TRACKER::getDynamicMemoryRequirements();
+	size += AR_TEMPL_TRACKER::getDynamicMemoryRequirements(nWidth, nHeight);
 
 	return size;
 }
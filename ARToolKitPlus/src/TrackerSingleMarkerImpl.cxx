@@ -87,10 +87,10 @@ ARSM_TEMPL_TRACKER::init(const char* nCamParamFile, ARFloat nNearClip, ARFloat n
 
 	// init some "static" members from artoolkit
 	// (some systems don't like such large global members
-	// so we allocate this manually)
+	// so we allocate this manually). they grow later on
+	// if an image contains more marker candidates.
 	//
-	if(this->marker_infoTWO==NULL)
-		this->marker_infoTWO = artkp_Alloc<ARMarkerInfo2>(__MAX_IMAGE_PATTERNS);
+	this->defaultContext->growMarkerBuffers(__MAX_IMAGE_PATTERNS);
 
 	//initialize applications
 	if(nCamParamFile)
@@ -185,7 +185,7 @@ ARSM_TEMPL_TRACKER::calc(const unsigned char* nImage, int nPattern, bool nUpdate
 	if(nUpdateMatrix)
 	{
 		executeSingleMarkerPoseEstimator(&marker_info[k], patt_center, patt_width, patt_trans);
-		convertTransformationMatrixToOpenGLStyle(patt_trans, this->gl_para);
+		this->convertTransformationMatrixToOpenGLStyle(patt_trans, this->gl_para);
 	}
 
 	PROFILE_ENDSEC(profiler, SINGLEMARKER_OVERALL)
@@ -245,11 +245,11 @@ ARSM_TEMPL_TRACKER::operator delete(void *rawMemory)
 
 
 ARSM_TEMPL_FUNC size_t
-ARSM_TEMPL_TRACKER::getMemoryRequirements()
+ARSM_TEMPL_TRACKER::getMemoryRequirements(int nWidth, int nHeight)
 {
 	size_t size = sizeof(ARSM_TEMPL_TRACKER);
 
-	size += AR_TEMPL_TRACKER::getDynamicMemoryRequirements();
+	size += AR_TEMPL_TRACKER::getDynamicMemoryRequirements(nWidth, nHeight);
 
 	return size;
 }
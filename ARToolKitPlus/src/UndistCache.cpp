@@ -0,0 +1,553 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <ARToolKitPlus/UndistCache.h>
+#include <ARToolKitPlus/extra/ThreadPool.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+#  define _ARTKP_UNDISTCACHE_WIN32_
+#  include <windows.h>
+#else
+#  include <dirent.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <signal.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+
+namespace ARToolKitPlus {
+
+
+enum {
+	UNDISTCACHE_MAGIC = 0x55434b41,
+	UNDISTCACHE_VERSION = 2,			// bump whenever the header or the naming changes
+	UNDISTCACHE_HEADER_SIZE = 64,		// the table starts at this offset of the mapping
+	UNDISTCACHE_TIMEOUT_MS = 5000,		// how long to wait for another process' build
+	UNDISTCACHE_SIZE_TIMEOUT_MS = 100	// how long a new mapping may stay empty
+};
+
+
+// prefix of all mapping names
+static const char undistCachePrefix[] = "ARToolKitPlus_";
+
+
+// every mapping starts with this header
+struct UndistCacheHeader
+{
+	unsigned int			magic;
+	volatile unsigned int	ready;		// set by the builder once the table is complete
+	unsigned int			version;
+	unsigned int			format;
+	int						width, height;
+	unsigned int			bytes;
+	volatile int			builder;	// process id of the builder, 0 until it has started
+};
+
+
+// one entry per table this process has mapped
+struct UndistCacheEntry
+{
+	char				name[96];
+	UndistCacheHeader	*header;
+	size_t				mapSize;
+	int					refCount;
+#ifdef _ARTKP_UNDISTCACHE_WIN32_
+	HANDLE				mapping;
+#endif
+	UndistCacheEntry	*next;
+
+	const void* getTable() const  {  return (const unsigned char*)header + UNDISTCACHE_HEADER_SIZE;  }
+};
+
+
+#ifdef _ARTKP_UNDISTCACHE_WIN32_
+
+struct UndistCacheLock
+{
+	CRITICAL_SECTION lock;
+
+	UndistCacheLock()  {  InitializeCriticalSection(&lock);  }
+	~UndistCacheLock()  {  DeleteCriticalSection(&lock);  }
+
+	void enter()  {  EnterCriticalSection(&lock);  }
+	void leave()  {  LeaveCriticalSection(&lock);  }
+};
+
+static void undistCacheSleep(int nMS)  {  Sleep(nMS);  }
+static void undistCacheBarrier()  {  MemoryBarrier();  }
+static int undistCacheProcessId()  {  return (int)GetCurrentProcessId();  }
+
+// a mapping is dropped together with its last handle, so a builder that died
+// only leaves a table behind while others are waiting for it: let them time out
+static bool undistCacheIsAlive(int)  {  return true;  }
+
+static int
+undistCacheNumCPUs()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+}
+
+#else
+
+struct UndistCacheLock
+{
+	pthread_mutex_t lock;
+
+	UndistCacheLock()  {  pthread_mutex_init(&lock, NULL);  }
+	~UndistCacheLock()  {  pthread_mutex_destroy(&lock);  }
+
+	void enter()  {  pthread_mutex_lock(&lock);  }
+	void leave()  {  pthread_mutex_unlock(&lock);  }
+};
+
+static void undistCacheSleep(int nMS)  {  usleep(nMS*1000);  }
+static void undistCacheBarrier()  {  __sync_synchronize();  }
+static int undistCacheProcessId()  {  return (int)getpid();  }
+static bool undistCacheIsAlive(int nPid)  {  return kill((pid_t)nPid, 0)==0 || errno!=ESRCH;  }
+
+static int
+undistCacheNumCPUs()
+{
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+#endif //_ARTKP_UNDISTCACHE_WIN32_
+
+
+static UndistCacheLock		undistCacheLock;
+static UndistCacheEntry		*undistCacheEntries = NULL;
+static int					undistCacheBuildThreads = 0;
+
+
+#ifdef _ARTKP_UNDISTCACHE_WIN32_
+
+// creates or opens the mapping for nEntry. if nCreated is set on return,
+// the caller owns the (writable) mapping and has to build the table.
+//
+static bool
+mapShared(UndistCacheEntry* nEntry, bool& nCreated)
+{
+	wchar_t name[128] = L"Local\\";
+	size_t len = wcslen(name);
+	for(size_t i=0; nEntry->name[i] && len<127; i++)
+		name[len++] = (wchar_t)nEntry->name[i];
+	name[len] = 0;
+
+	nEntry->mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+										 (DWORD)((unsigned long long)nEntry->mapSize>>32), (DWORD)nEntry->mapSize, name);
+	if(nEntry->mapping==NULL)
+		return false;
+	nCreated = GetLastError()!=ERROR_ALREADY_EXISTS;
+
+	nEntry->header = (UndistCacheHeader*)MapViewOfFile(nEntry->mapping, nCreated ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+	if(nEntry->header==NULL)
+	{
+		CloseHandle(nEntry->mapping);
+		return false;
+	}
+
+	return true;
+}
+
+// makes a freshly built table read-only
+static void
+sealShared(UndistCacheEntry* nEntry)
+{
+	DWORD oldProtect;
+	VirtualProtect(nEntry->header, nEntry->mapSize, PAGE_READONLY, &oldProtect);
+}
+
+// removes the name of a broken mapping so the next caller builds it again
+static void
+discardShared(UndistCacheEntry*)
+{
+	// windows drops the mapping together with its last handle
+}
+
+static void
+unmapShared(UndistCacheEntry* nEntry)
+{
+	UnmapViewOfFile(nEntry->header);
+	CloseHandle(nEntry->mapping);
+}
+
+#else
+
+// creates a new mapping for nEntry, returns false if the name already exists
+static bool
+createShared(UndistCacheEntry* nEntry, const char* nName)
+{
+	// only this user may read the tables: they are trusted without checks
+	int fd = shm_open(nName, O_CREAT|O_EXCL|O_RDWR, 0600);
+	if(fd<0)
+		return false;
+
+	void* mem = MAP_FAILED;
+	if(ftruncate(fd, (off_t)nEntry->mapSize)==0)
+		mem = mmap(NULL, nEntry->mapSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mem==MAP_FAILED)
+	{
+		shm_unlink(nName);
+		return false;
+	}
+
+	nEntry->header = (UndistCacheHeader*)mem;
+	return true;
+}
+
+
+// opens an existing mapping read-only. objects of other users, objects
+// others may write to and objects of the wrong size are refused. nStale
+// is set if the object has stayed empty, i.e. its creator died before sizing it.
+//
+static bool
+openShared(UndistCacheEntry* nEntry, const char* nName, bool& nStale)
+{
+	nStale = false;
+
+	int fd = shm_open(nName, O_RDONLY, 0);
+	if(fd<0)
+		return false;
+
+	struct stat st;
+	for(int waited=0; ; waited+=10)
+	{
+		if(fstat(fd, &st)!=0 || st.st_uid!=geteuid() || (st.st_mode & (S_IWGRP|S_IWOTH)) ||
+		   (st.st_size!=0 && (size_t)st.st_size!=nEntry->mapSize))
+		{
+			close(fd);
+			return false;
+		}
+		if(st.st_size!=0)
+			break;
+		if(waited>=UNDISTCACHE_SIZE_TIMEOUT_MS)
+		{
+			close(fd);
+			nStale = true;
+			return false;
+		}
+		undistCacheSleep(10);
+	}
+
+	void* mem = mmap(NULL, nEntry->mapSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mem==MAP_FAILED)
+		return false;
+
+	nEntry->header = (UndistCacheHeader*)mem;
+	return true;
+}
+
+
+static bool
+mapShared(UndistCacheEntry* nEntry, bool& nCreated)
+{
+	char name[128];
+	sprintf(name, "/%s", nEntry->name);
+
+	// a stale empty object is removed once and the table is created again
+	for(int attempt=0; attempt<2; attempt++)
+	{
+		bool stale = false;
+
+		nCreated = createShared(nEntry, name);
+		if(nCreated)
+			return true;
+		if(errno!=EEXIST)
+			return false;
+
+		if(openShared(nEntry, name, stale))
+			return true;
+		if(!stale)
+			return false;
+		shm_unlink(name);
+	}
+
+	return false;
+}
+
+static void
+sealShared(UndistCacheEntry* nEntry)
+{
+	mprotect(nEntry->header, nEntry->mapSize, PROT_READ);
+}
+
+static void
+discardShared(UndistCacheEntry* nEntry)
+{
+	char name[128];
+	sprintf(name, "/%s", nEntry->name);
+	shm_unlink(name);
+}
+
+static void
+unmapShared(UndistCacheEntry* nEntry)
+{
+	munmap(nEntry->header, nEntry->mapSize);
+}
+
+#endif //_ARTKP_UNDISTCACHE_WIN32_
+
+
+// 64-bit FNV-1a hash of a file's contents
+static bool
+hashFile(const char* nFileName, unsigned int nHash[2])
+{
+	FILE* fp = fopen(nFileName, "rb");
+	if(!fp)
+		return false;
+
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	unsigned char buf[4096];
+	size_t num;
+
+	while((num = fread(buf, 1, sizeof(buf), fp)) > 0)
+		for(size_t i=0; i<num; i++)
+			hash = (hash ^ buf[i]) * 0x100000001b3ULL;
+
+	fclose(fp);
+	nHash[0] = (unsigned int)(hash>>32);
+	nHash[1] = (unsigned int)hash;
+	return true;
+}
+
+
+struct UndistCacheBuild
+{
+	UndistCache::BuildFunc	func;
+	void					*table, *data;
+	int						numRows, rowsPerTask;
+};
+
+static void
+buildRows(void* nData, int nIndex)
+{
+	UndistCacheBuild* build = (UndistCacheBuild*)nData;
+	int begin = nIndex*build->rowsPerTask;
+	int end = begin+build->rowsPerTask;
+
+	if(end>build->numRows)
+		end = build->numRows;
+	build->func(build->table, begin, end, build->data);
+}
+
+
+const void*
+UndistCache::acquire(const char* nCalibFile, unsigned int nFormat, int nWidth, int nHeight,
+					 size_t nBytes, int nNumRows, BuildFunc nBuild, void* nData)
+{
+	unsigned int hash[2];
+
+	if(!nCalibFile || !nBuild || nBytes==0 || nNumRows<=0 || !hashFile(nCalibFile, hash))
+		return NULL;
+
+	UndistCacheEntry* entry = new UndistCacheEntry;
+	sprintf(entry->name, "%sv%d_%08x%08x_%x_%dx%d_%lu", undistCachePrefix, UNDISTCACHE_VERSION,
+			hash[0], hash[1], nFormat, nWidth, nHeight, (unsigned long)nBytes);
+	entry->mapSize = UNDISTCACHE_HEADER_SIZE + nBytes;
+	entry->refCount = 1;
+
+	undistCacheLock.enter();
+
+	// already mapped by this process?
+	for(UndistCacheEntry* e=undistCacheEntries; e; e=e->next)
+		if(strcmp(e->name, entry->name)==0)
+		{
+			e->refCount++;
+			undistCacheLock.leave();
+			delete entry;
+			return e->getTable();
+		}
+
+	bool created = false;
+	if(!mapShared(entry, created))
+	{
+		undistCacheLock.leave();
+		delete entry;
+		return NULL;
+	}
+
+	UndistCacheHeader* header = entry->header;
+
+	if(created)
+	{
+		header->builder = undistCacheProcessId();
+		header->magic = UNDISTCACHE_MAGIC;
+		header->version = UNDISTCACHE_VERSION;
+		header->format = nFormat;
+		header->width = nWidth;
+		header->height = nHeight;
+		header->bytes = (unsigned int)nBytes;
+
+		int numThreads = undistCacheBuildThreads>0 ? undistCacheBuildThreads : undistCacheNumCPUs();
+		if(numThreads<1)
+			numThreads = 1;
+
+		UndistCacheBuild build;
+		build.func = nBuild;
+		build.table = (unsigned char*)header + UNDISTCACHE_HEADER_SIZE;
+		build.data = nData;
+		build.numRows = nNumRows;
+		build.rowsPerTask = (nNumRows+4*numThreads-1)/(4*numThreads);
+
+		ThreadPool pool;
+		pool.start(numThreads);
+		pool.run(buildRows, &build, (nNumRows+build.rowsPerTask-1)/build.rowsPerTask);
+		pool.stop();
+
+		undistCacheBarrier();
+		header->ready = 1;
+		sealShared(entry);
+	}
+	else
+	{
+		// another process is building (or has built) the table.
+		// a builder that died is not waited for.
+		int waited = 0;
+		while(!header->ready && waited<UNDISTCACHE_TIMEOUT_MS &&
+			  (header->builder==0 || undistCacheIsAlive(header->builder)))
+		{
+			undistCacheSleep(10);
+			waited += 10;
+		}
+		undistCacheBarrier();
+
+		bool valid = header->ready && header->magic==UNDISTCACHE_MAGIC && header->version==UNDISTCACHE_VERSION &&
+					 header->format==nFormat &&
+					 header->width==nWidth && header->height==nHeight && header->bytes==(unsigned int)nBytes;
+		if(!valid)
+		{
+			if(!header->ready)
+				discardShared(entry);
+			unmapShared(entry);
+			undistCacheLock.leave();
+			delete entry;
+			return NULL;
+		}
+	}
+
+	entry->next = undistCacheEntries;
+	undistCacheEntries = entry;
+	undistCacheLock.leave();
+
+	return entry->getTable();
+}
+
+
+bool
+UndistCache::release(const void* nTable)
+{
+	if(!nTable)
+		return false;
+
+	undistCacheLock.enter();
+
+	for(UndistCacheEntry** e=&undistCacheEntries; *e; e=&(*e)->next)
+		if((*e)->getTable()==nTable)
+		{
+			UndistCacheEntry* entry = *e;
+			if(--entry->refCount==0)
+			{
+				*e = entry->next;
+				unmapShared(entry);
+				delete entry;
+			}
+			undistCacheLock.leave();
+			return true;
+		}
+
+	undistCacheLock.leave();
+	return false;
+}
+
+
+void
+UndistCache::setNumBuildThreads(int nNumThreads)
+{
+	undistCacheBuildThreads = nNumThreads;
+}
+
+
+int
+UndistCache::removeTables()
+{
+#if !defined(_ARTKP_UNDISTCACHE_WIN32_) && defined(__linux__)
+	// shm_open() objects are files in /dev/shm on linux
+	DIR* dir = opendir("/dev/shm");
+	if(!dir)
+		return 0;
+
+	struct dirent* ent;
+	struct stat st;
+	char path[300];
+	int num = 0;
+
+	while((ent = readdir(dir))!=NULL)
+	{
+		if(strncmp(ent->d_name, undistCachePrefix, sizeof(undistCachePrefix)-1)!=0)
+			continue;
+
+		sprintf(path, "/dev/shm/%.250s", ent->d_name);
+		if(stat(path, &st)!=0 || st.st_uid!=geteuid())
+			continue;
+
+		if(shm_unlink(path+8)==0)
+			num++;
+	}
+
+	closedir(dir);
+	return num;
+#else
+	// windows drops a mapping with its last handle, other systems can't list their objects
+	return 0;
+#endif
+}
+
+
+}  // namespace ARToolKitPlus
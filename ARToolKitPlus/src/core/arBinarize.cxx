@@ -0,0 +1,526 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+#include <ARToolKitPlus/Tracker.h>
+#include <string.h>
+
+#ifdef AR_USE_SSE2
+#  include <emmintrin.h>
+#endif
+#ifdef AR_USE_AVX2
+#  include <immintrin.h>
+#endif
+
+
+namespace ARToolKitPlus {
+
+
+// The binarization pre-pass thresholds a LUM image into a packed mask
+// with one bit per pixel (bit i&31 of word i>>5 in each row) before
+// labeling runs. arLabeling_BIN() then reads 1/16 of the memory the
+// label pass would otherwise touch for the thresholding step
+// and can skip whole words of white pixels at once.
+//
+// The mask is stored in labeling coordinates, so in half resolution
+// mode only every second pixel of every second row is sampled.
+// YUV422 images are handled the same way, only their luminance bytes
+// are read (at twice the pixel offset).
+//
+// With THRESH_ADAPTIVE_LOCAL the mask is created from an integral image
+// instead: a pixel is black if it is at least 'bias' darker than the mean
+// of the window around it. The integral image is built once per frame,
+// after that every pixel costs four lookups regardless of the window size.
+
+
+// plain C version, also used for the tail of each SIMD row
+//
+static void
+binarizeRow_C(const ARUint8 *pnt, int poff, int i0, int lxsize, const ARInt16 *rowThresh, int thresh, ARUint32 *row)
+{
+	int i;
+
+	for(i=i0; i<lxsize; i++)
+	{
+		int t = rowThresh ? rowThresh[i] : thresh;
+
+		if(pnt[i*poff] <= t)
+			row[i>>5] |= 1u << (i&31);
+	}
+}
+
+
+// fills rowThresh[x0,x1) with the vignetting corrected thresholds for a fixed-point
+// correction of corr at x0 that changes by dCorr per pixel, clamped to [-1,255]
+//
+static void
+fillRowThresh_C(ARInt16 *rowThresh, int x0, int x1, int corr, int dCorr, int thresh, int shiftBits)
+{
+	for(int x=x0; x<x1; x++, corr+=dCorr)
+	{
+		int t = thresh + (corr>>shiftBits);
+
+		rowThresh[x] = (ARInt16)(t<-1 ? -1 : (t>255 ? 255 : t));
+	}
+}
+
+
+#ifdef AR_USE_SSE2
+
+// same as fillRowThresh_C(), eight thresholds at a time.
+// returns the number of thresholds that have been filled
+//
+static int
+fillRowThresh_SSE2(ARInt16 *rowThresh, int x0, int x1, int corr, int dCorr, int thresh, int shiftBits)
+{
+	const __m128i step = _mm_set1_epi32(8*dCorr), t = _mm_set1_epi32(thresh), shift = _mm_cvtsi32_si128(shiftBits),
+				  minThresh = _mm_set1_epi16(-1), maxThresh = _mm_set1_epi16(255);
+	__m128i c0 = _mm_setr_epi32(corr, corr+dCorr, corr+2*dCorr, corr+3*dCorr),
+			c1 = _mm_add_epi32(c0, _mm_set1_epi32(4*dCorr));
+	int x;
+
+	for(x=x0; x+8<=x1; x+=8)
+	{
+		__m128i t0 = _mm_add_epi32(_mm_sra_epi32(c0, shift), t),
+				t1 = _mm_add_epi32(_mm_sra_epi32(c1, shift), t),
+				packed = _mm_packs_epi32(t0, t1);
+
+		_mm_storeu_si128((__m128i*)(rowThresh+x), _mm_min_epi16(_mm_max_epi16(packed, minThresh), maxThresh));
+		c0 = _mm_add_epi32(c0, step);
+		c1 = _mm_add_epi32(c1, step);
+	}
+
+	return x-x0;
+}
+
+
+// loads 16 pixels, taking every byte (poff==1) or every second byte (poff==2)
+//
+static inline __m128i
+loadPixels_SSE2(const ARUint8 *pnt, int poff)
+{
+	if(poff==1)
+		return _mm_loadu_si128((const __m128i*)pnt);
+
+	const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+	__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)pnt), lowBytes),
+			b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pnt+16)), lowBytes);
+
+	return _mm_packus_epi16(a, b);
+}
+
+
+// returns the number of pixels that have been processed
+//
+static int
+binarizeRow_SSE2(const ARUint8 *pnt, int poff, int lxsize, int thresh, ARUint32 *row)
+{
+	const __m128i t = _mm_set1_epi8((char)thresh);
+	int i;
+
+	for(i=0; i+32<=lxsize; i+=32)
+	{
+		__m128i p0 = loadPixels_SSE2(pnt+i*poff, poff),
+				p1 = loadPixels_SSE2(pnt+(i+16)*poff, poff);
+
+		// (p <= t)  <=>  (min(p,t) == p)
+		unsigned int m0 = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(p0, t), p0)),
+					 m1 = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(p1, t), p1));
+
+		row[i>>5] = m0 | (m1<<16);
+	}
+
+	return i;
+}
+
+
+// same as above but with an individual threshold per pixel. the thresholds
+// are clamped to [-1,255] so that a signed 16-bit compare can be used.
+//
+static int
+binarizeRowVignetting_SSE2(const ARUint8 *pnt, int poff, int lxsize, const ARInt16 *rowThresh, ARUint32 *row)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int i, k;
+
+	for(i=0; i+32<=lxsize; i+=32)
+	{
+		unsigned int bits = 0;
+
+		for(k=0; k<32; k+=16)
+		{
+			__m128i p = loadPixels_SSE2(pnt+(i+k)*poff, poff),
+					tLo = _mm_loadu_si128((const __m128i*)(rowThresh+i+k)),
+					tHi = _mm_loadu_si128((const __m128i*)(rowThresh+i+k+8)),
+					white = _mm_packs_epi16(_mm_cmpgt_epi16(_mm_unpacklo_epi8(p, zero), tLo),
+											_mm_cmpgt_epi16(_mm_unpackhi_epi8(p, zero), tHi));
+
+			bits |= (~(unsigned int)_mm_movemask_epi8(white) & 0xffff) << k;
+		}
+
+		row[i>>5] = bits;
+	}
+
+	return i;
+}
+
+#endif //AR_USE_SSE2
+
+
+#ifdef AR_USE_AVX2
+
+static int
+binarizeRow_AVX2(const ARUint8 *pnt, int poff, int lxsize, int thresh, ARUint32 *row)
+{
+	const __m256i t = _mm256_set1_epi8((char)thresh),
+				  lowBytes = _mm256_set1_epi16(0x00ff);
+	int i;
+
+	for(i=0; i+32<=lxsize; i+=32)
+	{
+		__m256i p;
+
+		if(poff==1)
+			p = _mm256_loadu_si256((const __m256i*)(pnt+i));
+		else
+		{
+			__m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(pnt+2*i)), lowBytes),
+					b = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(pnt+2*i+32)), lowBytes);
+
+			// packus works per 128-bit lane, so the quadwords have to be reordered
+			p = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+		}
+
+		row[i>>5] = (ARUint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(p, t), p));
+	}
+
+	return i;
+}
+
+#endif //AR_USE_AVX2
+
+
+static void
+fillRowThresh(ARInt16 *rowThresh, int x0, int x1, int corr, int dCorr, int thresh, int shiftBits)
+{
+	int n = 0;
+
+#ifdef AR_USE_SSE2
+	n = fillRowThresh_SSE2(rowThresh, x0, x1, corr, dCorr, thresh, shiftBits);
+#endif
+	fillRowThresh_C(rowThresh, x0+n, x1, corr+n*dCorr, dCorr, thresh, shiftBits);
+}
+
+
+AR_TEMPL_FUNC ARUint32*
+AR_TEMPL_TRACKER::arBinarize_LUM(Context* ctx, ARUint8 *image, int thresh)
+{
+	int lysize;
+
+	assert(ctx->binMaskL && "checkImageBuffer() must be called before arBinarize_LUM()");
+
+	PROFILE_BEGINSEC(profiler, BINARIZE)
+
+	if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
+		ctx->binMaskStride = (arImXsize/2+31) >> 5;
+		lysize = arImYsize / 2;
+	}
+	else {
+		ctx->binMaskStride = (arImXsize+31) >> 5;
+		lysize = arImYsize;
+	}
+
+	if(adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL)
+		arBuildIntegralImage_LUM(ctx, image);
+
+	arBinarizeRows_LUM(ctx, image, thresh, 0, lysize, ctx->binRowThresh);
+
+	PROFILE_ENDSEC(profiler, BINARIZE)
+
+	return ctx->binMaskL;
+}
+
+
+// binarizes the mask rows [nRowBegin,nRowEnd). binMaskStride of ctx must already
+// be set. nRowThresh is a scratch buffer of one row, which allows
+// several stripes to be processed in parallel.
+//
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::arBinarizeRows_LUM(Context* ctx, ARUint8 *image, int thresh, int nRowBegin, int nRowEnd, ARInt16 *nRowThresh)
+{
+	const ARUint8	*pnt;
+	ARUint32		*row;
+	int				lxsize, lysize;
+	int				poff, rowoff;
+	int				i, j;
+
+	memset(ctx->binMaskL + nRowBegin*ctx->binMaskStride, 0, ctx->binMaskStride*(nRowEnd-nRowBegin)*sizeof(ARUint32));
+
+	if(adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL)
+	{
+		arBinarizeRowsAdaptive_LUM(ctx, image, nRowBegin, nRowEnd);
+		return;
+	}
+
+	if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
+		lxsize = arImXsize / 2;
+		lysize = arImYsize / 2;
+		poff = 2*pixelSize;
+		rowoff = arImXsize*2*pixelSize;
+	}
+	else {
+		lxsize = arImXsize;
+		lysize = arImYsize;
+		poff = pixelSize;
+		rowoff = arImXsize*pixelSize;
+	}
+	image += getLumaOffset();
+
+	if(nRowBegin<1)
+		nRowBegin = 1;
+	if(nRowEnd>lysize-1)
+		nRowEnd = lysize-1;
+
+
+	// vignetting compensation: this has to produce exactly the same
+	// fixed-point threshold sequence as arLabelingImpl.hxx does
+	//
+	const int shiftBits = 10;
+	int iHalf=lxsize/2, jHalf=lysize/2;
+
+	int corrLeftY = vignetting.corners<<shiftBits,
+		dCorrLeftY = ((vignetting.leftright-vignetting.corners)<<shiftBits)/jHalf,
+		corrCenterY = vignetting.bottomtop<<shiftBits,
+		dCorrCenterY = -corrCenterY/jHalf,
+		corrX, dCorrX;
+
+
+	for(j = 1; j < nRowEnd; j++)
+	{
+		pnt = image + j*rowoff;
+		row = ctx->binMaskL + j*ctx->binMaskStride;
+		i = 0;
+
+		if(vignetting.enabled)
+		{
+			corrX = corrLeftY;
+			dCorrX = (corrCenterY-corrLeftY)/iHalf;
+
+			if(j==jHalf)
+			{
+				dCorrLeftY = -dCorrLeftY;
+				dCorrCenterY = -dCorrCenterY;
+			}
+
+			corrLeftY += dCorrLeftY;
+			corrCenterY += dCorrCenterY;
+
+			// rows in front of the stripe only advance the vertical interpolation
+			if(j<nRowBegin)
+				continue;
+
+			// the border columns are never read by the labeling
+			nRowThresh[0] = nRowThresh[lxsize-1] = 0;
+
+			// the correction rises by dCorrX per pixel up to iHalf-1, turns
+			// at iHalf and falls again: both halves are linear ramps
+			fillRowThresh(nRowThresh, 1, iHalf, corrX+dCorrX, dCorrX, thresh, shiftBits);
+			fillRowThresh(nRowThresh, iHalf, lxsize-1, corrX+(iHalf-2)*dCorrX, -dCorrX, thresh, shiftBits);
+
+#ifdef AR_USE_SSE2
+			if(poff<=2)
+				i = binarizeRowVignetting_SSE2(pnt, poff, lxsize, nRowThresh, row);
+#endif
+			binarizeRow_C(pnt, poff, i, lxsize, nRowThresh, thresh, row);
+		}
+		else
+		{
+			if(j<nRowBegin)
+			{
+				j = nRowBegin-1;
+				continue;
+			}
+			if(thresh<0)
+				continue;			// no pixel can be black
+
+			// the SIMD versions read every byte or every second byte
+#if defined(AR_USE_AVX2)
+			if(thresh<255 && poff<=2)
+				i = binarizeRow_AVX2(pnt, poff, lxsize, thresh, row);
+#elif defined(AR_USE_SSE2)
+			if(thresh<255 && poff<=2)
+				i = binarizeRow_SSE2(pnt, poff, lxsize, thresh, row);
+#endif
+			binarizeRow_C(pnt, poff, i, lxsize, NULL, thresh, row);
+		}
+
+		// the border columns are never labeled. clearing them here
+		// guarantees that every run found in the mask ends inside the row
+		row[0] &= ~1u;
+		row[(lxsize-1)>>5] &= ~(1u << ((lxsize-1)&31));
+	}
+}
+
+
+// builds the integral image of the (sampled) LUM image:
+// integral[(j+1)*(lxsize+1)+(i+1)] is the sum of all pixels (x,y) with x<=i, y<=j
+//
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::arBuildIntegralImage_LUM(Context* ctx, ARUint8 *image)
+{
+	const ARUint8	*pnt;
+	ARUint32		*sum, *sumUp, rowSum;
+	int				lxsize, lysize, poff, rowoff, i, j;
+
+	assert(ctx->integral && "checkImageBuffer() must be called before arBuildIntegralImage_LUM()");
+
+	if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
+		lxsize = arImXsize / 2;
+		lysize = arImYsize / 2;
+		poff = 2*pixelSize;
+		rowoff = arImXsize*2*pixelSize;
+	}
+	else {
+		lxsize = arImXsize;
+		lysize = arImYsize;
+		poff = pixelSize;
+		rowoff = arImXsize*pixelSize;
+	}
+	image += getLumaOffset();
+
+	memset(ctx->integral, 0, (lxsize+1)*sizeof(ARUint32));
+
+	for(j = 0; j < lysize; j++)
+	{
+		pnt = image + j*rowoff;
+		sumUp = ctx->integral + j*(lxsize+1);
+		sum = sumUp + lxsize+1;
+		sum[0] = 0;
+		rowSum = 0;
+
+		for(i = 0; i < lxsize; i++, pnt+=poff)
+		{
+			rowSum += *pnt;
+			sum[i+1] = sumUp[i+1] + rowSum;
+		}
+	}
+}
+
+
+// thresholds the rows [nRowBegin,nRowEnd) against the local mean.
+// requires the integral image of the current frame.
+//
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::arBinarizeRowsAdaptive_LUM(Context* ctx, ARUint8 *image, int nRowBegin, int nRowEnd)
+{
+	const ARUint8	*pnt;
+	const ARUint32	*sumTop, *sumBottom;
+	ARUint32		*row;
+	int				lxsize, lysize, poff, rowoff, stride;
+	int				radius, bias, x0, x1, y0, y1, cnt, sum;
+	int				i, j;
+
+	if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
+		lxsize = arImXsize / 2;
+		lysize = arImYsize / 2;
+		poff = 2*pixelSize;
+		rowoff = arImXsize*2*pixelSize;
+	}
+	else {
+		lxsize = arImXsize;
+		lysize = arImYsize;
+		poff = pixelSize;
+		rowoff = arImXsize*pixelSize;
+	}
+	image += getLumaOffset();
+
+	radius = (adaptiveThreshold.windowSize>0 ? adaptiveThreshold.windowSize : lxsize/8) / 2;
+	if(radius<1)
+		radius = 1;
+	bias = adaptiveThreshold.bias;
+	stride = lxsize+1;
+
+	if(nRowBegin<1)
+		nRowBegin = 1;
+	if(nRowEnd>lysize-1)
+		nRowEnd = lysize-1;
+
+	for(j = nRowBegin; j < nRowEnd; j++)
+	{
+		pnt = image + j*rowoff;
+		row = ctx->binMaskL + j*ctx->binMaskStride;
+
+		y0 = j-radius<0 ? 0 : j-radius;
+		y1 = j+radius>=lysize ? lysize-1 : j+radius;
+		sumTop = ctx->integral + y0*stride;
+		sumBottom = ctx->integral + (y1+1)*stride;
+
+		// black if pixel <= mean-bias, evaluated without division.
+		// the window is clipped only near the left and right border,
+		// in between the pixel count is constant.
+		for(i = 1; i < lxsize-1; i++)
+		{
+			x0 = i-radius<0 ? 0 : i-radius;
+			x1 = i+radius>=lxsize ? lxsize-1 : i+radius;
+
+			if(x0>0 && x1<lxsize-1)
+			{
+				int iEnd = lxsize-1-radius;
+
+				cnt = (2*radius+1)*(y1-y0+1);
+				for(; i < iEnd; i++)
+				{
+					sum = (int)(sumBottom[i+radius+1] - sumBottom[i-radius] - sumTop[i+radius+1] + sumTop[i-radius]);
+					if((pnt[i*poff]+bias)*cnt <= sum)
+						row[i>>5] |= 1u << (i&31);
+				}
+				i--;
+				continue;
+			}
+
+			cnt = (x1-x0+1)*(y1-y0+1);
+			sum = (int)(sumBottom[x1+1] - sumBottom[x0] - sumTop[x1+1] + sumTop[x0]);
+
+			if((pnt[i*poff]+bias)*cnt <= sum)
+				row[i>>5] |= 1u << (i&31);
+		}
+	}
+}
+
+
+}  // namespace ARToolKitPlus
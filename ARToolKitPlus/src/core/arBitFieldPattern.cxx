@@ -62,12 +62,6 @@ applyMaskBCH(IDPATTERN& nPattern)
 }
 
 
-static bool
-isBitSet(IDPATTERN pat, int which)
-{
-	return ((pat>>which)&1) != 0;
-}
-
 /*
 static void
 setBit(IDPATTERN& pat, int which)
@@ -89,14 +83,19 @@ clearBit(IDPATTERN& pat, int which)
 static void
 rotate90CW(IDPATTERN& nPattern)
 {
-	IDPATTERN one=1, tmpPat = nPattern;
+	IDPATTERN tmpPat = nPattern;
 	nPattern = 0;
 
-	for(int i=0; i<pattBits; i++)
-	{
-		if(isBitSet(tmpPat, rotate90[i]))
-			nPattern |= (one<<i);
-	}
+	for(int row=0; row<idPattHeight; row++)
+		nPattern |= (IDPATTERN)rowToColumn[(int)(tmpPat>>(row*idPattWidth)) & 63] << (idPattWidth-1-row);
+}
+
+
+static int
+countBits(int nBits)
+{
+	static const int bitsInNibble[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+	return bitsInNibble[nBits&15] + bitsInNibble[(nBits>>4)&15] + bitsInNibble[(nBits>>8)&15];
 }
 
 
@@ -113,67 +112,31 @@ generatePatternSimple(int nID, IDPATTERN& nPattern)
 static void
 generatePatternBCH(int nID, IDPATTERN& nPattern)
 {
-	BCH bchProcessor;
-	_64bits encoded;
-
-	bchProcessor.encode(encoded, nID);
-
-	nPattern = encoded;
+	nPattern = BCHCodebook::encode(nID);
 	applyMaskBCH(nPattern);
 }
 
 
-static float
-checkPatternBitSimple(IDPATTERN nPattern, int nBit, int& nValue)
-{
-	int b0 = (int)(nPattern>>(posMask0+nBit))&1,
-		b1 = (int)(nPattern>>(posMask1+nBit))&1,
-		b2 = (int)(nPattern>>(posMask2+nBit))&1,
-		b3 = (int)(nPattern>>(posMask3+nBit))&1,
-		sum = b0+b1+b2+b3;
-
-	switch(sum)
-	{
-	case 0:
-		nValue = 0;
-		return 1.00f;
-	case 1:
-		nValue = 0;
-		return 0.50f;
-	case 2:
-		nValue = 0;			// opt for zero since one means white area which can happen due to reflectance
-		return 0.00f;
-	case 3:
-		nValue = 1;
-		return 0.50f;
-	case 4:
-		nValue = 1;
-		return 1.00f;
-	}
-
-	// should never come here...
-	//assert(false);
-	return 0.0f;
-}
-
-
 static void
 checkPatternSimple(IDPATTERN nPattern, int& nID, float& nProp)
 {
-	nProp = 0.0f;
-	nID = 0;
-
 	applyMaskSimple(nPattern);
 
-	for(int i=0; i<idBits; i++)
-	{
-		int bitvalue = 0;
-		nProp += checkPatternBitSimple(nPattern, i, bitvalue);
+	// each id bit is stored four times. the copies vote for all bits at once:
+	//   0 or 4 set bits: value 0 or 1 with propability 1.0
+	//   1 or 3 set bits: value 0 or 1 with propability 0.5
+	//   2 set bits: value 0 (one means white area which can happen due to reflectance), propability 0.0
+	//
+	int b0 = (int)(nPattern>>posMask0) & idMask,
+		b1 = (int)(nPattern>>posMask1) & idMask,
+		b2 = (int)(nPattern>>posMask2) & idMask,
+		b3 = (int)(nPattern>>posMask3) & idMask;
 
-		nID |= (bitvalue<<i);
-	}
+	int sure = ((b0&b1&b2&b3) | ~(b0|b1|b2|b3)) & idMask,
+		odd = b0^b1^b2^b3;
 
-	nProp /= (float)idBits;
+	nID = (b0&b1&(b2|b3)) | (b2&b3&(b0|b1));
+	nProp = (countBits(sure) + 0.5f*countBits(odd)) / (float)idBits;
 
 	if(nProp<0.9f)
 		nProp = 0.0f;
@@ -181,7 +144,7 @@ checkPatternSimple(IDPATTERN nPattern, int& nID, float& nProp)
 
 
 static void
-checkPatternBCH(IDPATTERN nPattern, int& nID, float& nProp, BCH* nProcessor)
+checkPatternBCH(IDPATTERN nPattern, int& nID, float& nProp, const BCHCodebook* nCodebook)
 {
 	int err = -1;
 	_64bits decodedPattern = 0;
@@ -192,7 +155,7 @@ checkPatternBCH(IDPATTERN nPattern, int& nID, float& nProp, BCH* nProcessor)
 
 	applyMaskBCH(nPattern);
 
-	nProcessor->decode(err, decodedPattern, nPattern);
+	nCodebook->decode(err, decodedPattern, nPattern);
 
 	nID = (int)(decodedPattern & andMask);
 
@@ -479,23 +442,24 @@ AR_TEMPL_TRACKER::bitfield_check_BCH( ARUint8 *data, int *code, int *dir, ARFloa
 	int			id0=-1,id90=-1,id180=-1,id270=-1;
 	float		prop0=0.0f,prop90=0.0f,prop180=0.0f,prop270=0.0f;
 
-	if(bchProcessor==NULL)
-		bchProcessor = new BCH;
+	// built by setMarkerMode() and createDetectionContext(), never here:
+	// contexts decoding concurrently would race on the allocation
+	assert(bchCodebook && "setMarkerMode(MARKER_ID_BCH) builds the codebook");
 
 	pat0 = pat;
-	checkPatternBCH(pat0, id0, prop0, bchProcessor);
+	checkPatternBCH(pat0, id0, prop0, bchCodebook);
 
 	pat90 = pat0;
 	rotate90CW(pat90);
-	checkPatternBCH(pat90, id90, prop90, bchProcessor);
+	checkPatternBCH(pat90, id90, prop90, bchCodebook);
 
 	pat180 = pat90;
 	rotate90CW(pat180);
-	checkPatternBCH(pat180, id180, prop180, bchProcessor);
+	checkPatternBCH(pat180, id180, prop180, bchCodebook);
 
 	pat270 = pat180;
 	rotate90CW(pat270);
-	checkPatternBCH(pat270, id270, prop270, bchProcessor);
+	checkPatternBCH(pat270, id270, prop270, bchCodebook);
 
 	if(prop0>=prop90 && prop0>=prop180 && prop0>=prop270)		// is prop0 maximum?
 	{
@@ -45,12 +45,138 @@
 namespace ARToolKitPlus {
 
 
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::AutoThreshold::calcOtsu(int nFirst, int nLast) const
+{
+	double sum = 0.0, sumDark = 0.0, var, maxVar = 0.0;
+	int num = 0, numDark = 0, best = -1, bestEnd = -1, i;
+
+	for(i=nFirst; i<=nLast; i++)
+	{
+		num += histogram[i];
+		sum += (double)i*histogram[i];
+	}
+
+	for(i=nFirst; i<nLast; i++)
+	{
+		numDark += histogram[i];
+		sumDark += (double)i*histogram[i];
+		if(numDark==0)
+			continue;
+		if(numDark==num)
+			break;
+
+		double meanDiff = sumDark/numDark - (sum-sumDark)/(num-numDark);
+		var = (double)numDark*(num-numDark)*meanDiff*meanDiff;
+
+		// empty bins between the classes give the same variance,
+		// the threshold is put in the middle of such a gap
+		if(var>maxVar)
+		{
+			maxVar = var;
+			best = bestEnd = i;
+		}
+		else if(var==maxVar && best>=0)
+			bestEnd = i;
+	}
+
+	return best<0 ? -1 : (best+bestEnd)/2;
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::AutoThreshold::getRetryThreshold(int nThresh)
+{
+	int candidates[3], i, j;
+
+	if(numFailed<MAX_FAILED)
+		failed[numFailed++] = nThresh;
+
+	candidates[0] = calcOtsu(0, 255);
+	if(candidates[0]<0)
+		return -1;
+	candidates[1] = calcOtsu(0, candidates[0]);
+	candidates[2] = calcOtsu(candidates[0]+1, 255);
+
+	for(i=0; i<3; i++)
+	{
+		if(candidates[i]<0)
+			continue;
+		for(j=0; j<numFailed; j++)
+			if(abs(candidates[i]-failed[j])<MIN_THRESH_DIST)
+				break;
+		if(j==numFailed)
+			return candidates[i];
+	}
+
+	return -1;
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::updateThresholdHistogram(Context* ctx, ARUint8 *image)
+{
+	int *hist = ctx->autoThreshold.histogram;
+	const int step = AutoThreshold::HIST_STEP, weight = AutoThreshold::HIST_WEIGHT;
+	int x, y, i;
+
+	if(pixelFormat==PIXEL_FORMAT_RGB565)
+		checkRGB565LUT();
+
+	for(i=0; i<256; i++)
+		hist[i] -= hist[i]>>2;
+
+	// the luminance is computed the same way as in arLabeling(),
+	// so the thresholds can be used there directly
+	for(y=step/2; y<arImYsize; y+=step)
+	{
+		const ARUint8 *row = image + y*arImXsize*pixelSize;
+
+		switch(pixelFormat)
+		{
+		case PIXEL_FORMAT_ABGR:
+			for(x=step/2; x<arImXsize; x+=step)
+				hist[(row[x*4+1]+row[x*4+2]+row[x*4+3])/3] += weight;
+			break;
+
+		case PIXEL_FORMAT_BGRA:
+		case PIXEL_FORMAT_RGBA:
+			for(x=step/2; x<arImXsize; x+=step)
+				hist[(row[x*4+0]+row[x*4+1]+row[x*4+2])/3] += weight;
+			break;
+
+		case PIXEL_FORMAT_BGR:
+		case PIXEL_FORMAT_RGB:
+			for(x=step/2; x<arImXsize; x+=step)
+				hist[(row[x*3+0]+row[x*3+1]+row[x*3+2])/3] += weight;
+			break;
+
+		case PIXEL_FORMAT_RGB565:
+			for(x=step/2; x<arImXsize; x+=step)
+				hist[getLUM8_from_RGB565((unsigned short*)row+x)] += weight;
+			break;
+
+		case PIXEL_FORMAT_LUM:
+			for(x=step/2; x<arImXsize; x+=step)
+				hist[row[x]] += weight;
+			break;
+
+		case PIXEL_FORMAT_UYVY:
+		case PIXEL_FORMAT_YUYV:
+			for(x=step/2; x<arImXsize; x+=step)
+				hist[row[x*2+getLumaOffset()]] += weight;
+			break;
+		}
+	}
+}
+
+
 // marker detection using tracking history
 //
 AR_TEMPL_FUNC int
-AR_TEMPL_TRACKER::arDetectMarker(ARUint8 *dataPtr, int _thresh, ARMarkerInfo **marker_info, int *marker_num)
+AR_TEMPL_TRACKER::detectMarker(Context* ctx, ARUint8 *dataPtr, int _thresh, ARMarkerInfo **marker_info, int *marker_num)
 {
-    ARInt16                *limage=NULL;
+    ARLabel                *limage=NULL;
     int                    label_num;
     int                    *area, *clip, *label_ref;
     ARFloat                 *pos;
@@ -58,9 +184,13 @@ AR_TEMPL_TRACKER::arDetectMarker(ARUint8 *dataPtr, int _thresh, ARMarkerInfo **m
     ARFloat                 diff, diffmin;
     int                    cid, cdir;
     int                    i, j, k;
+    MemoryManagerArena::Scope arenaScope(ctx->frameArena);
+
 
-	autoThreshold.reset();
-	checkImageBuffer();
+	ctx->autoThreshold.reset();
+	ctx->checkImageBuffer(screenWidth, screenHeight);
+	if(autoThreshold.enable && adaptiveThreshold.mode!=THRESH_ADAPTIVE_LOCAL)
+		updateThresholdHistogram(ctx, dataPtr);
 
 //	FILE* fp = fopen("imgdump.raw", "wb");
 //	fwrite(dataPtr, 1, 320*240*2, fp);
@@ -70,129 +200,145 @@ AR_TEMPL_TRACKER::arDetectMarker(ARUint8 *dataPtr, int _thresh, ARMarkerInfo **m
 
 	for(int numTries = 0;;)
 	{
-		limage = arLabeling(dataPtr, _thresh, &label_num, &area, &pos, &clip, &label_ref);
+		limage = arLabeling(ctx, dataPtr, _thresh, &label_num, &area, &pos, &clip, &label_ref);
 		if(limage)
 		{
-			marker_info2 = arDetectMarker2(limage, label_num, label_ref, area, pos, clip, AR_AREA_MAX, AR_AREA_MIN, 1.0, &wmarker_num);
-			assert(wmarker_num <= MAX_IMAGE_PATTERNS);
-			if(marker_info2)
+			ctx->marker_info2 = arDetectMarker2(ctx, limage, label_num, label_ref, area, pos, clip, AR_AREA_MAX, AR_AREA_MIN, 1.0, &ctx->wmarker_num);
+			assert(ctx->wmarker_num <= ctx->markerBufferSize);
+			if(ctx->marker_info2)
 			{
-				wmarker_info = arGetMarkerInfo(dataPtr, marker_info2, &wmarker_num, _thresh);
-				assert(wmarker_num <= MAX_IMAGE_PATTERNS);
-				if(wmarker_info && wmarker_num>0)
+				ctx->wmarker_info = arGetMarkerInfo(ctx, dataPtr, ctx->marker_info2, &ctx->wmarker_num, _thresh);
+				assert(ctx->wmarker_num <= ctx->markerBufferSize);
+				if(ctx->wmarker_info && ctx->wmarker_num>0)
 					break;
 			}
 		}
 
-		if(!autoThreshold.enable)
+		// adaptive thresholding does not depend on the threshold value,
+		// so retrying with another one would not help
+		if(!autoThreshold.enable || adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL)
 			break;
 		else
 		{
-			_thresh = thresh = (rand() % 230) + 10;
-			if(++numTries>autoThreshold.numRandomRetries)
+			int retryThresh = ctx->autoThreshold.getRetryThreshold(_thresh);
+			if(retryThresh<0 || ++numTries>autoThreshold.numRetries)
 				break;
+			_thresh = ctx->thresh = retryThresh;
 		}
 
 	}
 
-	if(!limage || !marker_info2 || !wmarker_info)
+	if(!limage || !ctx->marker_info2 || !ctx->wmarker_info)
+	{
+		// start the next frame at the threshold of the whole histogram
+		if(autoThreshold.enable && ctx->autoThreshold.numFailed>0)
+		{
+			int otsu = ctx->autoThreshold.calcOtsu(0, 255);
+			if(otsu>=0)
+				ctx->thresh = otsu;
+		}
 		return -1;
+	}
 
-    for( i = 0; i < prev_num; i++ ) {
+    for( i = 0; i < ctx->prev_num; i++ ) {
         rlenmin = 10.0;
         cid = -1;
-        for( j = 0; j < wmarker_num; j++ ) {
-            rarea = (ARFloat)prev_info[i].marker.area / (ARFloat)wmarker_info[j].area;
+        for( j = 0; j < ctx->wmarker_num; j++ ) {
+            rarea = (ARFloat)ctx->prev_info[i].marker.area / (ARFloat)ctx->wmarker_info[j].area;
             if( rarea < 0.7 || rarea > 1.43 ) continue;
-            rlen = ( (wmarker_info[j].pos[0] - prev_info[i].marker.pos[0])
-                   * (wmarker_info[j].pos[0] - prev_info[i].marker.pos[0])
-                   + (wmarker_info[j].pos[1] - prev_info[i].marker.pos[1])
-                   * (wmarker_info[j].pos[1] - prev_info[i].marker.pos[1]) ) / wmarker_info[j].area;
+            rlen = ( (ctx->wmarker_info[j].pos[0] - ctx->prev_info[i].marker.pos[0])
+                   * (ctx->wmarker_info[j].pos[0] - ctx->prev_info[i].marker.pos[0])
+                   + (ctx->wmarker_info[j].pos[1] - ctx->prev_info[i].marker.pos[1])
+                   * (ctx->wmarker_info[j].pos[1] - ctx->prev_info[i].marker.pos[1]) ) / ctx->wmarker_info[j].area;
             if( rlen < 0.5 && rlen < rlenmin ) {
                 rlenmin = rlen;
                 cid = j;
             }
         }
-        if( cid >= 0 && wmarker_info[cid].cf < prev_info[i].marker.cf ) {
-            wmarker_info[cid].cf = prev_info[i].marker.cf;
-            wmarker_info[cid].id = prev_info[i].marker.id;
+        if( cid >= 0 && ctx->wmarker_info[cid].cf < ctx->prev_info[i].marker.cf ) {
+            ctx->wmarker_info[cid].cf = ctx->prev_info[i].marker.cf;
+            ctx->wmarker_info[cid].id = ctx->prev_info[i].marker.id;
             diffmin = 10000.0 * 10000.0;
             cdir = -1;
             for( j = 0; j < 4; j++ ) {
                 diff = 0;
                 for( k = 0; k < 4; k++ ) {
-                    diff += (prev_info[i].marker.vertex[k][0] - wmarker_info[cid].vertex[(j+k)%4][0])
-                          * (prev_info[i].marker.vertex[k][0] - wmarker_info[cid].vertex[(j+k)%4][0])
-                          + (prev_info[i].marker.vertex[k][1] - wmarker_info[cid].vertex[(j+k)%4][1])
-                          * (prev_info[i].marker.vertex[k][1] - wmarker_info[cid].vertex[(j+k)%4][1]);
+                    diff += (ctx->prev_info[i].marker.vertex[k][0] - ctx->wmarker_info[cid].vertex[(j+k)%4][0])
+                          * (ctx->prev_info[i].marker.vertex[k][0] - ctx->wmarker_info[cid].vertex[(j+k)%4][0])
+                          + (ctx->prev_info[i].marker.vertex[k][1] - ctx->wmarker_info[cid].vertex[(j+k)%4][1])
+                          * (ctx->prev_info[i].marker.vertex[k][1] - ctx->wmarker_info[cid].vertex[(j+k)%4][1]);
                 }
                 if( diff < diffmin ) {
                     diffmin = diff;
-                    cdir = (prev_info[i].marker.dir - j + 4) % 4;
+                    cdir = (ctx->prev_info[i].marker.dir - j + 4) % 4;
                 }
             }
-            wmarker_info[cid].dir = cdir;
+            ctx->wmarker_info[cid].dir = cdir;
         }
     }
 
-    for( i = 0; i < wmarker_num; i++ ) {
-        if( wmarker_info[i].cf < 0.5 ) wmarker_info[i].id = -1;
+    for( i = 0; i < ctx->wmarker_num; i++ ) {
+        if( ctx->wmarker_info[i].cf < 0.5 ) ctx->wmarker_info[i].id = -1;
    }
 
 
 /*------------------------------------------------------------*/
 
-    for( i = j = 0; i < prev_num; i++ ) {
-        prev_info[i].count++;
-        if( prev_info[i].count < 4 ) {
-            prev_info[j] = prev_info[i];
+    for( i = j = 0; i < ctx->prev_num; i++ ) {
+        ctx->prev_info[i].count++;
+        if( ctx->prev_info[i].count < 4 ) {
+            ctx->prev_info[j] = ctx->prev_info[i];
             j++;
         }
     }
-    prev_num = j;
+    ctx->prev_num = j;
 
-    for( i = 0; i < wmarker_num; i++ ) {
-        if( wmarker_info[i].id < 0 )
+    for( i = 0; i < ctx->wmarker_num; i++ ) {
+        if( ctx->wmarker_info[i].id < 0 )
 			continue;
 
-        for( j = 0; j < prev_num; j++ ) {
-            if( prev_info[j].marker.id == wmarker_info[i].id )
+        for( j = 0; j < ctx->prev_num; j++ ) {
+            if( ctx->prev_info[j].marker.id == ctx->wmarker_info[i].id )
 				break;
         }
-		if(j<MAX_IMAGE_PATTERNS)
-		{
-			prev_info[j].marker = wmarker_info[i];
-			prev_info[j].count  = 1;
-			if( j == prev_num )
-				prev_num++;
-		}
+		if(j==ctx->prev_num && !ctx->growMarkerBuffers(ctx->prev_num+1))
+			return -1;
+
+		ctx->wmarker_info = ctx->marker_infoL;
+		ctx->prev_info[j].marker = ctx->wmarker_info[i];
+		ctx->prev_info[j].count  = 1;
+		if( j == ctx->prev_num )
+			ctx->prev_num++;
     }
 
-    for( i = 0; i < prev_num; i++ ) {
-        for( j = 0; j < wmarker_num; j++ ) {
-            rarea = (ARFloat)prev_info[i].marker.area / (ARFloat)wmarker_info[j].area;
+    for( i = 0; i < ctx->prev_num; i++ ) {
+        for( j = 0; j < ctx->wmarker_num; j++ ) {
+            rarea = (ARFloat)ctx->prev_info[i].marker.area / (ARFloat)ctx->wmarker_info[j].area;
             if( rarea < 0.7 || rarea > 1.43 ) continue;
-            rlen = ( (wmarker_info[j].pos[0] - prev_info[i].marker.pos[0])
-                   * (wmarker_info[j].pos[0] - prev_info[i].marker.pos[0])
-                   + (wmarker_info[j].pos[1] - prev_info[i].marker.pos[1])
-                   * (wmarker_info[j].pos[1] - prev_info[i].marker.pos[1]) ) / wmarker_info[j].area;
+            rlen = ( (ctx->wmarker_info[j].pos[0] - ctx->prev_info[i].marker.pos[0])
+                   * (ctx->wmarker_info[j].pos[0] - ctx->prev_info[i].marker.pos[0])
+                   + (ctx->wmarker_info[j].pos[1] - ctx->prev_info[i].marker.pos[1])
+                   * (ctx->wmarker_info[j].pos[1] - ctx->prev_info[i].marker.pos[1]) ) / ctx->wmarker_info[j].area;
             if( rlen < 0.5 ) break;
         }
-        if(j==wmarker_num && wmarker_num<MAX_IMAGE_PATTERNS) {
-            wmarker_info[wmarker_num] = prev_info[i].marker;
-            wmarker_num++;
-			assert(wmarker_num <= MAX_IMAGE_PATTERNS);
+        if(j==ctx->wmarker_num) {
+            if(!ctx->growMarkerBuffers(ctx->wmarker_num+1))
+                return -1;
+            ctx->wmarker_info = ctx->marker_infoL;
+            ctx->wmarker_info[ctx->wmarker_num] = ctx->prev_info[i].marker;
+            ctx->wmarker_num++;
+			assert(ctx->wmarker_num <= ctx->markerBufferSize);
         }
     }
 
 
-    *marker_num  = wmarker_num;
-    *marker_info = wmarker_info;
+    *marker_num  = ctx->wmarker_num;
+    *marker_info = ctx->wmarker_info;
 
-	assert(*marker_num <= MAX_IMAGE_PATTERNS);
+	assert(*marker_num <= ctx->markerBufferSize);
 
 	if(autoThreshold.enable)
-		thresh = autoThreshold.calc();
+		ctx->thresh = ctx->autoThreshold.calc();
 
     return 0;
 }
@@ -201,72 +347,128 @@ AR_TEMPL_TRACKER::arDetectMarker(ARUint8 *dataPtr, int _thresh, ARMarkerInfo **m
 // marker detection without using tracking history
 //
 AR_TEMPL_FUNC int
-AR_TEMPL_TRACKER::arDetectMarkerLite(ARUint8 *dataPtr, int _thresh, ARMarkerInfo **marker_info, int *marker_num)
+AR_TEMPL_TRACKER::detectMarkerLite(Context* ctx, ARUint8 *dataPtr, int _thresh, ARMarkerInfo **marker_info, int *marker_num)
 {
-    ARInt16                *limage = NULL;
+    ARLabel                *limage = NULL;
     int                    label_num;
     int                    *area, *clip, *label_ref;
     ARFloat                 *pos;
     int                    i;
+    MemoryManagerArena::Scope arenaScope(ctx->frameArena);
 
-	autoThreshold.reset();
-	checkImageBuffer();
+
+	ctx->autoThreshold.reset();
+	ctx->checkImageBuffer(screenWidth, screenHeight);
+	if(autoThreshold.enable && adaptiveThreshold.mode!=THRESH_ADAPTIVE_LOCAL)
+		updateThresholdHistogram(ctx, dataPtr);
 
     *marker_num = 0;
 
 	for(int numTries = 0;;)
 	{
-		limage = arLabeling(dataPtr, _thresh, &label_num, &area, &pos, &clip, &label_ref);
+		limage = arLabeling(ctx, dataPtr, _thresh, &label_num, &area, &pos, &clip, &label_ref);
 		if(limage)
 		{
-			marker_info2 = arDetectMarker2(limage, label_num, label_ref, area, pos, clip, AR_AREA_MAX, AR_AREA_MIN, 1.0, &wmarker_num);
-			if(marker_info2)
+			ctx->marker_info2 = arDetectMarker2(ctx, limage, label_num, label_ref, area, pos, clip, AR_AREA_MAX, AR_AREA_MIN, 1.0, &ctx->wmarker_num);
+			if(ctx->marker_info2)
 			{
-				wmarker_info = arGetMarkerInfo(dataPtr, marker_info2, &wmarker_num, _thresh);
-				if(wmarker_info && wmarker_num>0)
+				ctx->wmarker_info = arGetMarkerInfo(ctx, dataPtr, ctx->marker_info2, &ctx->wmarker_num, _thresh);
+				if(ctx->wmarker_info && ctx->wmarker_num>0)
 					break;
 			}
 		}
 
-		if(!autoThreshold.enable)
+		// adaptive thresholding does not depend on the threshold value,
+		// so retrying with another one would not help
+		if(!autoThreshold.enable || adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL)
 			break;
 		else
 		{
-			_thresh = thresh = (rand() % 230) + 10;
-			if(++numTries>autoThreshold.numRandomRetries)
+			int retryThresh = ctx->autoThreshold.getRetryThreshold(_thresh);
+			if(retryThresh<0 || ++numTries>autoThreshold.numRetries)
 				break;
+			_thresh = ctx->thresh = retryThresh;
 		}
 
 	}
 
-	if(!limage || !marker_info2 || !wmarker_info)
+	if(!limage || !ctx->marker_info2 || !ctx->wmarker_info)
+	{
+		// start the next frame at the threshold of the whole histogram
+		if(autoThreshold.enable && ctx->autoThreshold.numFailed>0)
+		{
+			int otsu = ctx->autoThreshold.calcOtsu(0, 255);
+			if(otsu>=0)
+				ctx->thresh = otsu;
+		}
 		return -1;
+	}
 
 
 /*
-    limage = arLabeling(dataPtr, _thresh, &label_num, &area, &pos, &clip, &label_ref);
+    limage = arLabeling(ctx, dataPtr, _thresh, &label_num, &area, &pos, &clip, &label_ref);
     if( limage == 0 )    return -1;
 
-    marker_info2 = arDetectMarker2(limage, label_num, label_ref, area, pos, clip, AR_AREA_MAX, AR_AREA_MIN, 1.0, &wmarker_num);
-    if( marker_info2 == 0 ) return -1;
+    ctx->marker_info2 = arDetectMarker2(ctx, limage, label_num, label_ref, area, pos, clip, AR_AREA_MAX, AR_AREA_MIN, 1.0, &ctx->wmarker_num);
+    if( ctx->marker_info2 == 0 ) return -1;
 
-    wmarker_info = arGetMarkerInfo(dataPtr, marker_info2, &wmarker_num, _thresh);
-    if( wmarker_info == 0 ) return -1;
+    ctx->wmarker_info = arGetMarkerInfo(ctx, dataPtr, ctx->marker_info2, &ctx->wmarker_num, _thresh);
+    if( ctx->wmarker_info == 0 ) return -1;
 */
 
-    for( i = 0; i < wmarker_num; i++ )
-        if( wmarker_info[i].cf < 0.5 )
-			wmarker_info[i].id = -1;
+    for( i = 0; i < ctx->wmarker_num; i++ )
+        if( ctx->wmarker_info[i].cf < 0.5 )
+			ctx->wmarker_info[i].id = -1;
 
 
-    *marker_num  = wmarker_num;
-    *marker_info = wmarker_info;
+    *marker_num  = ctx->wmarker_num;
+    *marker_info = ctx->wmarker_info;
 
 	if(autoThreshold.enable)
-		thresh = autoThreshold.calc();
+		ctx->thresh = ctx->autoThreshold.calc();
 
     return 0;
 }
 
 
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arDetectMarker(ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)
+{
+	int ret = detectMarker(defaultContext, dataPtr, thresh, marker_info, marker_num);
+
+	// the automatic threshold is kept in the context, but this
+	// interface reports it via the tracker's getThreshold()
+	if(autoThreshold.enable)
+		this->thresh = defaultContext->thresh;
+
+	return ret;
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arDetectMarkerLite(ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)
+{
+	int ret = detectMarkerLite(defaultContext, dataPtr, thresh, marker_info, marker_num);
+
+	if(autoThreshold.enable)
+		this->thresh = defaultContext->thresh;
+
+	return ret;
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arDetectMarker(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)
+{
+	return detectMarker(static_cast<Context*>(nContext), dataPtr, thresh, marker_info, marker_num);
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arDetectMarkerLite(DetectionContext* nContext, ARUint8 *dataPtr, int thresh, ARMarkerInfo **marker_info, int *marker_num)
+{
+	return detectMarkerLite(static_cast<Context*>(nContext), dataPtr, thresh, marker_info, marker_num);
+}
+
+
 }	// namespace ARToolKitPlus
@@ -39,6 +39,7 @@
 
 
 #include <ARToolKitPlus/Tracker.h>
+#include <algorithm>
 
 
 namespace ARToolKitPlus {
@@ -48,7 +49,7 @@ static int get_vertex( int x_coord[], int y_coord[], int st,  int ed,
 
 
 AR_TEMPL_FUNC ARMarkerInfo2*
-AR_TEMPL_TRACKER::arDetectMarker2(ARInt16 *limage, int label_num, int *label_ref,
+AR_TEMPL_TRACKER::arDetectMarker2(Context* ctx, ARLabel *limage, int label_num, int *label_ref,
                     int *warea, ARFloat *wpos, int *wclip,
                     int area_max, int area_min, ARFloat factor, int *marker_num)
 {
@@ -56,7 +57,6 @@ AR_TEMPL_TRACKER::arDetectMarker2(ARInt16 *limage, int label_num, int *label_ref
     int               xsize, ysize;
     int               marker_num2;
     int               i, j, ret;
-    ARFloat            d;
 
 	PROFILE_BEGINSEC(profiler, DETECTMARKER2)
 
@@ -71,55 +71,36 @@ AR_TEMPL_TRACKER::arDetectMarker2(ARInt16 *limage, int label_num, int *label_ref
         ysize = arImYsize;
     }
     marker_num2 = 0;
+    ctx->contourArenaUsed = 0;
     for(i=0; i<label_num; i++ ) {
         if( warea[i] < area_min || warea[i] > area_max ) continue;
         if( wclip[i*4+0] == 1 || wclip[i*4+1] == xsize-2 ) continue;
         if( wclip[i*4+2] == 1 || wclip[i*4+3] == ysize-2 ) continue;
 
-        ret = arGetContour( limage, label_ref, i+1,
-                            &(wclip[i*4]), &(marker_infoTWO[marker_num2]));
+        if( !ctx->growMarkerBuffers(marker_num2+1) ||
+            !ctx->growContourArena(ctx->contourArenaUsed+AR_CHAIN_MAX*2, marker_num2) ) {
+            PROFILE_ENDSEC(profiler, DETECTMARKER2)
+            return(0);
+        }
+
+        ret = arGetContour( ctx, limage, label_ref, i+1,
+                            &(wclip[i*4]), &(ctx->marker_infoTWO[marker_num2]));
         if( ret < 0 ) continue;
 
-        ret = check_square( warea[i], &(marker_infoTWO[marker_num2]), factor );
+        ret = check_square( warea[i], &(ctx->marker_infoTWO[marker_num2]), factor );
         if( ret < 0 ) continue;
 
-        marker_infoTWO[marker_num2].area   = warea[i];
-        marker_infoTWO[marker_num2].pos[0] = wpos[i*2+0];
-        marker_infoTWO[marker_num2].pos[1] = wpos[i*2+1];
+        ctx->marker_infoTWO[marker_num2].area   = warea[i];
+        ctx->marker_infoTWO[marker_num2].pos[0] = wpos[i*2+0];
+        ctx->marker_infoTWO[marker_num2].pos[1] = wpos[i*2+1];
+        ctx->contourArenaUsed += ctx->marker_infoTWO[marker_num2].coord_num*2;
         marker_num2++;
-        if(marker_num2==MAX_IMAGE_PATTERNS)
-			break;
     }
 
-    for( i=0; i < marker_num2; i++ ) {
-        for( j=i+1; j < marker_num2; j++ ) {
-            d = (marker_infoTWO[i].pos[0] - marker_infoTWO[j].pos[0])
-              * (marker_infoTWO[i].pos[0] - marker_infoTWO[j].pos[0])
-              + (marker_infoTWO[i].pos[1] - marker_infoTWO[j].pos[1])
-              * (marker_infoTWO[i].pos[1] - marker_infoTWO[j].pos[1]);
-            if( marker_infoTWO[i].area > marker_infoTWO[j].area ) {
-                if( d < marker_infoTWO[i].area / 4 ) {
-                    marker_infoTWO[j].area = 0;
-                }
-            }
-            else {
-                if( d < marker_infoTWO[j].area / 4 ) {
-                    marker_infoTWO[i].area = 0;
-                }
-            }
-        }
-    }
-    for( i=0; i < marker_num2; i++ ) {
-        if( marker_infoTWO[i].area == 0.0 ) {
-            for( j=i+1; j < marker_num2; j++ ) {
-                marker_infoTWO[j-1] = marker_infoTWO[j];
-            }
-            marker_num2--;
-        }
-    }
+    marker_num2 = removeNestedCandidates(ctx, marker_num2);
 
     if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
-        pm = &(marker_infoTWO[0]);
+        pm = &(ctx->marker_infoTWO[0]);
         for( i = 0; i < marker_num2; i++ ) {
             pm->area *= 4;
             pm->pos[0] *= 2.0;
@@ -135,18 +116,185 @@ AR_TEMPL_TRACKER::arDetectMarker2(ARInt16 *limage, int label_num, int *label_ref
 	PROFILE_ENDSEC(profiler, DETECTMARKER2)
 
     *marker_num = marker_num2;
-    return( &(marker_infoTWO[0]) );
+    return( &(ctx->marker_infoTWO[0]) );
+}
+
+
+// Of two candidates whose centers are closer than a quarter of the larger
+// area (squared distance) the smaller one is dropped. Such pairs can only
+// be in the same or in neighbouring cells of a grid whose cells are wider
+// than that distance for the largest candidate, so instead of comparing all
+// pairs the candidates are put into a spatial hash of these cells.
+// The result depends on the order in which the pairs are compared, so for
+// every candidate i the neighbours j>i are visited in increasing order,
+// just like the plain double loop would do. For few candidates that
+// double loop is faster than building the hash and is used instead.
+//
+static inline int
+gridHash(int nX, int nY, int nMask)
+{
+	return (int)(((unsigned int)nX*73856093u ^ (unsigned int)nY*19349663u) & (unsigned int)nMask);
+}
+
+
+// drops the smaller of two candidates i<j if j lies within i or vice versa
+static inline void
+compareCandidates(ARMarkerInfo2 *m1, ARMarkerInfo2 *m2)
+{
+    ARFloat d = (m1->pos[0] - m2->pos[0]) * (m1->pos[0] - m2->pos[0])
+              + (m1->pos[1] - m2->pos[1]) * (m1->pos[1] - m2->pos[1]);
+    if( m1->area > m2->area ) {
+        if( d < m1->area / 4 ) {
+            m2->area = 0;
+        }
+    }
+    else {
+        if( d < m2->area / 4 ) {
+            m1->area = 0;
+        }
+    }
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::removeNestedCandidates(Context* ctx, int nNum)
+{
+	ARMarkerInfo2	*cand = ctx->marker_infoTWO;
+	int		*bucket, *item;
+	int		tableSize, mask, maxArea, cell;
+	int		cells[9], runBegin[9], runEnd[9], numCells, numRuns;
+	int		cx, cy, dx, dy, h, i, j, k;
+
+	if(nNum<2)
+		return nNum;
+
+	// a dropped candidate (area 0) can not drop any other one, so it is skipped
+
+	if(nNum<NESTED_CANDIDATES_HASH_MIN)
+	{
+		for(i=0; i<nNum; i++)
+			for(j=i+1; j<nNum && cand[i].area; j++)
+				if(cand[j].area)
+					compareCandidates(&cand[i], &cand[j]);
+		return compactCandidates(ctx, nNum);
+	}
+
+	for(tableSize = 1; tableSize < nNum*2; tableSize <<= 1)
+		;
+	mask = tableSize-1;
+
+	if(tableSize+1+nNum > ctx->candidateGridSize)
+	{
+		ctx->candidateGrid = artkp_Grow(ctx->candidateGrid, 0, tableSize+1+nNum);
+		ctx->candidateGridSize = ctx->candidateGrid ? tableSize+1+nNum : 0;
+		if(!ctx->candidateGrid)
+			return 0;
+	}
+
+	bucket = ctx->candidateGrid;			// [tableSize+1]
+	item = bucket + tableSize+1;		// [nNum]
+
+	maxArea = 0;
+	for(i=0; i<nNum; i++)
+		if(cand[i].area > maxArea)
+			maxArea = cand[i].area;
+	cell = (int)(sqrt((ARFloat)maxArea)/2) + 1;
+
+
+	// counting sort of the candidates into the buckets. filling backwards
+	// keeps them ascending within a bucket and leaves bucket h spanning
+	// item[bucket[h]] to item[bucket[h+1]-1].
+	//
+	memset(bucket, 0, (tableSize+1)*sizeof(int));
+	for(i=0; i<nNum; i++)
+		bucket[gridHash((int)cand[i].pos[0]/cell, (int)cand[i].pos[1]/cell, mask)]++;
+	for(h=1; h<tableSize; h++)
+		bucket[h] += bucket[h-1];
+	bucket[tableSize] = nNum;
+	for(i=nNum-1; i>=0; i--)
+		item[--bucket[gridHash((int)cand[i].pos[0]/cell, (int)cand[i].pos[1]/cell, mask)]] = i;
+
+
+	// compare each candidate with the later ones in the 3x3 neighbouring cells.
+	// the later candidates of each bucket form an ascending run, merging the
+	// runs visits them in increasing order without sorting. if all candidates
+	// share a few cells this stays a double loop with a small overhead.
+	//
+	for(i=0; i<nNum; i++)
+	{
+		if(!cand[i].area)
+			continue;
+
+		cx = (int)cand[i].pos[0]/cell;
+		cy = (int)cand[i].pos[1]/cell;
+		numRuns = numCells = 0;
+
+		for(dy=-1; dy<=1; dy++)
+			for(dx=-1; dx<=1; dx++)
+			{
+				// cells can share a bucket, visit each bucket once
+				h = gridHash(cx+dx, cy+dy, mask);
+				for(k=0; k<numCells && cells[k]!=h; k++)
+					;
+				if(k<numCells)
+					continue;
+				cells[numCells++] = h;
+
+				k = (int)(std::upper_bound(item+bucket[h], item+bucket[h+1], i) - item);
+				if(k<bucket[h+1])
+				{
+					runBegin[numRuns] = k;
+					runEnd[numRuns++] = bucket[h+1];
+				}
+			}
+
+		while(numRuns>0 && cand[i].area)
+		{
+			for(j=0, k=1; k<numRuns; k++)
+				if(item[runBegin[k]] < item[runBegin[j]])
+					j = k;
+
+			if(cand[item[runBegin[j]]].area)
+				compareCandidates(&cand[i], &cand[item[runBegin[j]]]);
+
+			if(++runBegin[j]==runEnd[j])
+			{
+				numRuns--;
+				runBegin[j] = runBegin[numRuns];
+				runEnd[j] = runEnd[numRuns];
+			}
+		}
+	}
+
+	return compactCandidates(ctx, nNum);
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::compactCandidates(Context* ctx, int nNum)
+{
+	int i, j;
+
+	// stable, every remaining candidate is moved at most once
+	for(i=j=0; i<nNum; i++)
+	{
+		if(ctx->marker_infoTWO[i].area==0)
+			continue;
+		if(j!=i)
+			ctx->marker_infoTWO[j] = ctx->marker_infoTWO[i];
+		j++;
+	}
+
+	return j;
 }
 
 
 AR_TEMPL_FUNC int
-AR_TEMPL_TRACKER::arGetContour(ARInt16 *limage, int *label_ref, int label, int clip[4], ARMarkerInfo2 *marker_infoTWO)
+AR_TEMPL_TRACKER::arGetContour(Context* ctx, ARLabel *limage, int *label_ref, int label, int clip[4], ARMarkerInfo2 *marker_infoTWO)
 {
     static const int      xdir[8] = { 0, 1, 1, 1, 0,-1,-1,-1};
     static const int      ydir[8] = {-1,-1, 0, 1, 1, 1, 0,-1};
-    //static int      wx[AR_CHAIN_MAX];
-    //static int      wy[AR_CHAIN_MAX];
-    ARInt16         *p1;
+    ARLabel         *p1;
     int             xsize, ysize;
     int             sx, sy, dir;
     int             dmax, d, v1 = 0;
@@ -171,6 +319,12 @@ AR_TEMPL_TRACKER::arGetContour(ARInt16 *limage, int *label_ref, int label, int c
         printf("??? 1\n"); return(-1);
     }
 
+    // the contour is traced into the unused part of the contour arena
+    // (see arDetectMarker2()), x in the first and y in the second half
+    // of a slice of AR_CHAIN_MAX*2 ints
+    marker_infoTWO->x_coord = ctx->contourArena + ctx->contourArenaUsed;
+    marker_infoTWO->y_coord = marker_infoTWO->x_coord + AR_CHAIN_MAX;
+
     marker_infoTWO->coord_num = 1;
     marker_infoTWO->x_coord[0] = sx;
     marker_infoTWO->y_coord[0] = sy;
@@ -208,22 +362,16 @@ AR_TEMPL_TRACKER::arGetContour(ARInt16 *limage, int *label_ref, int label, int c
         }
     }
 
-    for(i=0;i<v1;i++) {
-        arGetContour_wx[i] = marker_infoTWO->x_coord[i];
-        arGetContour_wy[i] = marker_infoTWO->y_coord[i];
-    }
-    for(i=v1;i<marker_infoTWO->coord_num;i++) {
-        marker_infoTWO->x_coord[i-v1] = marker_infoTWO->x_coord[i];
-        marker_infoTWO->y_coord[i-v1] = marker_infoTWO->y_coord[i];
-    }
-    for(i=0;i<v1;i++) {
-        marker_infoTWO->x_coord[i-v1+marker_infoTWO->coord_num] = arGetContour_wx[i];
-        marker_infoTWO->y_coord[i-v1+marker_infoTWO->coord_num] = arGetContour_wy[i];
-    }
+    std::rotate(marker_infoTWO->x_coord, marker_infoTWO->x_coord+v1, marker_infoTWO->x_coord+marker_infoTWO->coord_num);
+    std::rotate(marker_infoTWO->y_coord, marker_infoTWO->y_coord+v1, marker_infoTWO->y_coord+marker_infoTWO->coord_num);
     marker_infoTWO->x_coord[marker_infoTWO->coord_num] = marker_infoTWO->x_coord[0];
     marker_infoTWO->y_coord[marker_infoTWO->coord_num] = marker_infoTWO->y_coord[0];
     marker_infoTWO->coord_num++;
 
+    // move y right behind x, so the contour takes coord_num*2 ints of the arena
+    memmove(marker_infoTWO->x_coord+marker_infoTWO->coord_num, marker_infoTWO->y_coord, marker_infoTWO->coord_num*sizeof(int));
+    marker_infoTWO->y_coord = marker_infoTWO->x_coord+marker_infoTWO->coord_num;
+
     return 0;
 }
 
@@ -45,6 +45,13 @@
 #include <ARToolKitPlus/ar.h>
 #include <ARToolKitPlus/matrix.h>
 
+#ifdef AR_USE_SSE2
+#  include <emmintrin.h>
+#endif
+#ifdef AR_USE_AVX2
+#  include <immintrin.h>
+#endif
+
 
 namespace ARToolKitPlus {
 	
@@ -53,6 +60,108 @@ static void get_cpara(ARFloat world[4][2], ARFloat vertex[4][2], ARFloat para[3]
 static void put_zero(ARUint8 *p, int size);
 
 
+// maps the sample points (xw[i],yw) of one pattern row into the image via the
+// homography para. the terms are added in the same order as in the plain C
+// loop, so the SSE2 version yields exactly the same pixel coordinates.
+// returns false if a point lies on the horizon (d==0).
+//
+static bool
+projectSampleRow(ARFloat para[3][3], const ARFloat *xw, ARFloat yw, int num, int *xc, int *yc)
+{
+	int i = 0;
+
+#if defined(AR_USE_SSE2) && !defined(_USE_DOUBLE_)
+	const __m128 p00 = _mm_set1_ps(para[0][0]),  p01 = _mm_set1_ps(para[0][1]*yw),  p02 = _mm_set1_ps(para[0][2]),
+				 p10 = _mm_set1_ps(para[1][0]),  p11 = _mm_set1_ps(para[1][1]*yw),  p12 = _mm_set1_ps(para[1][2]),
+				 p20 = _mm_set1_ps(para[2][0]),  p21 = _mm_set1_ps(para[2][1]*yw),  p22 = _mm_set1_ps(para[2][2]);
+
+	for( ; i+4 <= num; i += 4 )
+	{
+		__m128 x = _mm_loadu_ps(xw+i);
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p20, x), p21), p22);
+
+		if(_mm_movemask_ps(_mm_cmpeq_ps(d, _mm_setzero_ps())))
+			return false;
+
+		__m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p00, x), p01), p02),
+			   v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p10, x), p11), p12);
+
+		_mm_storeu_si128((__m128i*)(xc+i), _mm_cvttps_epi32(_mm_div_ps(u, d)));
+		_mm_storeu_si128((__m128i*)(yc+i), _mm_cvttps_epi32(_mm_div_ps(v, d)));
+	}
+#endif //AR_USE_SSE2
+
+	for( ; i < num; i++ )
+	{
+		ARFloat d = para[2][0]*xw[i] + para[2][1]*yw + para[2][2];
+		if( d == 0 ) return false;
+		xc[i] = (int)((para[0][0]*xw[i] + para[0][1]*yw + para[0][2])/d);
+		yc[i] = (int)((para[1][0]*xw[i] + para[1][1]*yw + para[1][2])/d);
+	}
+
+	return true;
+}
+
+
+// dot product of two rows of the pattern bank, n has to be a multiple of 16.
+// the values are within [-255,255], so the sums of pairs of products
+// computed by madd fit into 32 bits without loss.
+//
+static int
+correlateRow(const ARInt16 *a, const ARInt16 *b, int n)
+{
+	int i, sum = 0;
+
+#if defined(AR_USE_AVX2)
+	__m256i acc = _mm256_setzero_si256();
+	for( i = 0; i < n; i += 16 )
+		acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(a+i)),
+													  _mm256_loadu_si256((const __m256i*)(b+i))));
+	__m128i acc4 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+	acc4 = _mm_add_epi32(acc4, _mm_shuffle_epi32(acc4, 0x4e));
+	acc4 = _mm_add_epi32(acc4, _mm_shuffle_epi32(acc4, 0xb1));
+	sum = _mm_cvtsi128_si32(acc4);
+#elif defined(AR_USE_SSE2)
+	__m128i acc = _mm_setzero_si128();
+	for( i = 0; i < n; i += 8 )
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a+i)),
+												_mm_loadu_si128((const __m128i*)(b+i))));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4e));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xb1));
+	sum = _mm_cvtsi128_si32(acc);
+#else
+	for( i = 0; i < n; i++ )
+		sum += a[i]*b[i];
+#endif
+
+	return sum;
+}
+
+
+// dot product of a float row with an eigenvector
+//
+static ARFloat
+dotRow(const ARFloat *a, const ARFloat *b, int n)
+{
+	int i = 0;
+	ARFloat sum = 0.0f;
+
+#if defined(AR_USE_SSE2) && !defined(_USE_DOUBLE_)
+	__m128 acc = _mm_setzero_ps();
+	for( ; i+4 <= n; i += 4 )
+		acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+	sum = _mm_cvtss_f32(acc);
+#endif
+
+	for( ; i < n; i++ )
+		sum += a[i]*b[i];
+
+	return sum;
+}
+
+
 AR_TEMPL_FUNC int
 AR_TEMPL_TRACKER::arLoadPatt(char *filename)
 {
@@ -120,9 +229,8 @@ AR_TEMPL_TRACKER::arLoadPatt(char *filename)
     patf[patno] = 1;
     pattern_num++;
 
-/*
-    gen_evec();
-*/
+    updatePatternBank();
+    if( arMatchingPCAMode == AR_MATCHING_WITH_PCA ) gen_evec();
 
     return( patno );
 }
@@ -135,6 +243,7 @@ AR_TEMPL_TRACKER::arFreePatt( int patno )
     patf[patno] = 0;
     pattern_num--;
 
+    updatePatternBank();
     gen_evec();
 
     return 1;
@@ -146,6 +255,7 @@ AR_TEMPL_TRACKER::arActivatePatt( int patno )
     if( patf[patno] == 0 ) return -1;
 
     patf[patno] = 1;
+    updatePatternBank();
 
     return 1;
 }
@@ -156,13 +266,33 @@ AR_TEMPL_TRACKER::arDeactivatePatt( int patno )
     if( patf[patno] == 0 ) return -1;
 
     patf[patno] = 2;
+    updatePatternBank();
 
     return 1;
 }
 
 
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::updatePatternBank()
+{
+    int i, j, k;
+
+    patBankNum = 0;
+    for( k = 0; k < MAX_LOAD_PATTERNS; k++ ) {
+        if( patf[k] != 1 ) continue;
+        for( j = 0; j < 4; j++ ) {
+            for( i = 0; i < PATTERN_BANK_STRIDE; i++ )
+                patBank[patBankNum][i] = (ARInt16)(i < PATTERN_HEIGHT*PATTERN_WIDTH*3 ? pat[k][j][i] : 0);
+            for( i = 0; i < PATTERN_BANK_STRIDE_BW; i++ )
+                patBankBW[patBankNum][i] = (ARInt16)(i < PATTERN_HEIGHT*PATTERN_WIDTH ? patBW[k][j][i] : 0);
+            patBankIdx[patBankNum++] = k*4+j;
+        }
+    }
+}
+
+
 AR_TEMPL_FUNC int
-AR_TEMPL_TRACKER::arGetCode(ARUint8 *image, int *x_coord, int *y_coord, int *vertex,
+AR_TEMPL_TRACKER::arGetCode(Context* ctx, ARUint8 *image, int *x_coord, int *y_coord, int *vertex,
 				   int *code, int *dir, ARFloat *cf, int thresh)
 {
     ARUint8 ext_pat[PATTERN_HEIGHT][PATTERN_WIDTH][3];
@@ -176,7 +306,24 @@ AR_TEMPL_TRACKER::arGetCode(ARUint8 *image, int *x_coord, int *y_coord, int *ver
 		for(y=0; y<PATTERN_HEIGHT; y++)
 			for(x=0; x<PATTERN_WIDTH; x++)
 				//autoThreshold.addValue(ext_pat[y][x][0], ext_pat[y][x][1], ext_pat[y][x][2]);
-				autoThreshold.addValue(ext_pat[y][x][0], ext_pat[y][x][1], ext_pat[y][x][2], pixelFormat);
+				ctx->autoThreshold.addValue(ext_pat[y][x][0], ext_pat[y][x][1], ext_pat[y][x][2], pixelFormat);
+	}
+
+
+	// with adaptive thresholding there is no meaningful global threshold,
+	// so ID markers are decoded with the midpoint of their own samples
+	if(adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL && isLumaFormat() && markerMode!=MARKER_TEMPLATE)
+	{
+		int x,y, minVal=255, maxVal=0;
+
+		for(y=0; y<PATTERN_HEIGHT; y++)
+			for(x=0; x<PATTERN_WIDTH; x++)
+			{
+				if(ext_pat[y][x][0]<minVal)  minVal = ext_pat[y][x][0];
+				if(ext_pat[y][x][0]>maxVal)  maxVal = ext_pat[y][x][0];
+			}
+
+		thresh = (minVal+maxVal)/2;
 	}
 
 
@@ -222,17 +369,12 @@ AR_TEMPL_TRACKER::arGetPatt(ARUint8 *image, int *x_coord, int *y_coord, int *ver
     ARFloat    world[4][2];
     ARFloat    local[4][2];
     ARFloat    para[3][3];
-    ARFloat    d, xw, yw;
-    int       xc, yc;
     int       xdiv, ydiv;
     int       xdiv2, ydiv2;
     int       lx1, lx2, ly1, ly2;
     int       i, j;
-	ARUint8		col8;
     // int       k1, k2, k3; // unreferenced
 
-	unsigned short* image16 = (unsigned short*)image;
-
     world[0][0] = 100.0;
     world[0][1] = 100.0;
     world[1][0] = 100.0 + 10.0;
@@ -277,210 +419,66 @@ printf("%3d(%f), %3d(%f)\n", xdiv2, sqrt(lx1), ydiv2, sqrt(ly1));
 */
 
 
+	// the sample points are taken row by row: projectSampleRow() maps a whole
+	// row into the image, getSampleRow() reads its pixels with one switch
+	// on the pixel format per row instead of one per sample
+	//
+	ARFloat border = relBorderWidth * 10.0f;
+	ARFloat xyFrom = 100.0f + border,
+			xyTo = 110.0f - border,
+			xyStep = xyTo-xyFrom;
+	ARFloat xsteps[PATTERN_SAMPLE_NUM+3], ysteps[PATTERN_SAMPLE_NUM];
+	int     xc[PATTERN_SAMPLE_NUM+3], yc[PATTERN_SAMPLE_NUM+3];
+	ARUint8 row[PATTERN_SAMPLE_NUM][3];
+	bool    valid[PATTERN_SAMPLE_NUM];
+
+	for( i = 0; i < xdiv2; i++ )
+		xsteps[i] = xyFrom + xyStep * (ARFloat)(i+0.5f) / (ARFloat)xdiv2;
+	for( j = 0; j < ydiv2; j++ )
+		ysteps[j] = xyFrom + xyStep * (ARFloat)(j+0.5f) / (ARFloat)ydiv2;
+
+
 	// special case xdiv==1 and ydiv==1, so we can remove all divides and multiplies for indexing
 	//
 	if(xdiv==1 && ydiv==1)
 	{
-		ARFloat border = relBorderWidth * 10.0f;
-		ARFloat xyFrom = 100.0f + border,
-				xyTo = 110.0f - border,
-				xyStep = xyTo-xyFrom;
-		ARFloat steps[PATTERN_WIDTH];
-
-		for( i = 0; i < xdiv2; i++ )
-			steps[i] = xyFrom + xyStep * (ARFloat)(i+0.5f) / (ARFloat)xdiv2;
-
 		for( j = 0; j < ydiv2; j++ ) {
-			yw = steps[j];
-			for( i = 0; i < xdiv2; i++ ) {
-				xw = steps[i];
-				d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-				if( d == 0 ) return(-1);
-				xc = (int)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-				yc = (int)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-				//das hier sollte noch getestet werden...
-				/*
-				if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
-					xc = ((xc+1)/2)*2;
-					yc = ((yc+1)/2)*2;
-				}*/
-
-				if( xc >= 0 && xc < arImXsize && yc >= 0 && yc < arImYsize )
+			if(!projectSampleRow(para, xsteps, ysteps[j], xdiv2, xc, yc))
+				return(-1);
+			getSampleRow(image, xc, yc, xdiv2, row, valid);
+
+			for( i = 0; i < xdiv2; i++ )
+				if(valid[i])
 				{
-					switch(pixelFormat)
-					{
-					case PIXEL_FORMAT_ABGR:
-						ext_pat[j][i][0] = image[(yc*arImXsize+xc)*4+1];
-						ext_pat[j][i][1] = image[(yc*arImXsize+xc)*4+2];
-						ext_pat[j][i][2] = image[(yc*arImXsize+xc)*4+3];
-						break;
-					
-					case PIXEL_FORMAT_BGRA:
-						ext_pat[j][i][0] = image[(yc*arImXsize+xc)*4+0];
-						ext_pat[j][i][1] = image[(yc*arImXsize+xc)*4+1];
-						ext_pat[j][i][2] = image[(yc*arImXsize+xc)*4+2];
-						break;
-
-					case PIXEL_FORMAT_BGR:
-						ext_pat[j][i][0] = image[(yc*arImXsize+xc)*3+0];
-						ext_pat[j][i][1] = image[(yc*arImXsize+xc)*3+1];
-						ext_pat[j][i][2] = image[(yc*arImXsize+xc)*3+2];
-						break;
-
-					case PIXEL_FORMAT_RGBA:
-						ext_pat[j][i][0] = image[(yc*arImXsize+xc)*4+2];
-						ext_pat[j][i][1] = image[(yc*arImXsize+xc)*4+1];
-						ext_pat[j][i][2] = image[(yc*arImXsize+xc)*4+0];
-
-					case PIXEL_FORMAT_RGB:
-						ext_pat[j][i][0] = image[(yc*arImXsize+xc)*3+2];
-						ext_pat[j][i][1] = image[(yc*arImXsize+xc)*3+1];
-						ext_pat[j][i][2] = image[(yc*arImXsize+xc)*3+0];
-						break;
-
-					case PIXEL_FORMAT_RGB565:
-						col8 = getLUM8_from_RGB565(image16+yc*arImXsize+xc);
-						ext_pat[j][i][0] = col8;
-						ext_pat[j][i][1] = col8;
-						ext_pat[j][i][2] = col8;
-						break;
-
-					case PIXEL_FORMAT_LUM:
-						col8 = image[(yc*arImXsize+xc)];
-						ext_pat[j][i][0] = col8;
-						ext_pat[j][i][1] = col8;
-						ext_pat[j][i][2] = col8;
-						break;
-					}
+					ext_pat[j][i][0] = row[i][0];
+					ext_pat[j][i][1] = row[i][1];
+					ext_pat[j][i][2] = row[i][2];
 				}
-			}
 		}
 	}
 	else
 	// general case: xdiv!=1 or ydiv!=1
 	//
 	{
-		ARFloat border = relBorderWidth * 10.0f;
-		ARFloat xyFrom = 100.0f + border,
-				xyTo = 110.0f - border,
-				xyStep = xyTo-xyFrom;
-		int jy,ix;
-		ARUint8 col8;
-
 		put_zero( (ARUint8 *)ext_pat2, PATTERN_HEIGHT*PATTERN_WIDTH*3*sizeof(ARUint32) );
 
 		for( j = 0; j < ydiv2; j++ ) {
-			//yw = (ARFloat)(102.5) + (ARFloat)(5.0) * (ARFloat)(j+0.5) / (ARFloat)ydiv2;
-			yw = xyFrom + xyStep * (ARFloat)(j+0.5f) / (ARFloat)ydiv2;
-			for( i = 0; i < xdiv2; i++ ) {
-				//xw = (ARFloat)(102.5) + (ARFloat)(5.0) * (ARFloat)(i+0.5) / (ARFloat)xdiv2;
-				xw = xyFrom + xyStep * (ARFloat)(i+0.5f) / (ARFloat)xdiv2;
-				d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-				if( d == 0 ) return(-1);
-				xc = (int)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-				yc = (int)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-				/*
-				if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
-					xc = ((xc+1)/2)*2;
-					yc = ((yc+1)/2)*2;
-				}*/
-				if( xc >= 0 && xc < arImXsize && yc >= 0 && yc < arImYsize )
+			if(!projectSampleRow(para, xsteps, ysteps[j], xdiv2, xc, yc))
+				return(-1);
+			getSampleRow(image, xc, yc, xdiv2, row, valid);
+
+			ARUint32 (*dst)[3] = ext_pat2[j/ydiv];
+			for( i = 0; i < xdiv2; i++ )
+				if(valid[i])
 				{
-					/*if(PIX_FORMAT==PIXEL_FORMAT_ABGR) {
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*PIX_SIZE+1];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*PIX_SIZE+2];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*PIX_SIZE+3];
-					}
-					if(PIX_FORMAT==PIXEL_FORMAT_BGRA) {
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*PIX_SIZE+0];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*PIX_SIZE+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*PIX_SIZE+2];
-					}
-					if(PIX_FORMAT==PIXEL_FORMAT_BGR) {
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*PIX_SIZE+0];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*PIX_SIZE+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*PIX_SIZE+2];
-					}
-					if(PIX_FORMAT==PIXEL_FORMAT_RGBA) {
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*PIX_SIZE+2];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*PIX_SIZE+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*PIX_SIZE+0];
-					}
-					if(PIX_FORMAT==PIXEL_FORMAT_RGB) {
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*PIX_SIZE+2];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*PIX_SIZE+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*PIX_SIZE+0];
-					}
-					if(PIX_FORMAT==PIXEL_FORMAT_RGB565) {
-						int jy=j/ydiv, ix=i/xdiv;
-						//ARUint8 col = RGB565_to_LUM8_LUT[image16[yc*arImXsize+xc]];
-						ARUint8 col = getLUM8_from_RGB565(image16+yc*arImXsize+xc);
-						ext_pat2[jy][ix][0] += col;
-						ext_pat2[jy][ix][1] += col;
-						ext_pat2[jy][ix][2] += col;
-					}
-					if(PIX_FORMAT==PIXEL_FORMAT_LUM) {
-						int jy=j/ydiv, ix=i/xdiv;
-						ARUint8 col = image[(yc*arImXsize+xc)*PIX_SIZE];
-						ext_pat2[jy][ix][0] += col;
-						ext_pat2[jy][ix][1] += col;
-						ext_pat2[jy][ix][2] += col;
-					}*/
-
-					switch(pixelFormat)
-					{
-					case PIXEL_FORMAT_ABGR:
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*4+1];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*4+2];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*4+3];
-						break;
-
-					case PIXEL_FORMAT_BGRA:
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*4+0];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*4+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*4+2];
-						break;
-
-					case PIXEL_FORMAT_BGR:
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*3+0];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*3+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*3+2];
-						break;
-
-					case PIXEL_FORMAT_RGBA:
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*4+2];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*4+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*4+0];
-						break;
-
-					case PIXEL_FORMAT_RGB:
-						ext_pat2[j/ydiv][i/xdiv][0] += image[(yc*arImXsize+xc)*3+2];
-						ext_pat2[j/ydiv][i/xdiv][1] += image[(yc*arImXsize+xc)*3+1];
-						ext_pat2[j/ydiv][i/xdiv][2] += image[(yc*arImXsize+xc)*3+0];
-						break;
-
-					case PIXEL_FORMAT_RGB565:
-						jy=j/ydiv; ix=i/xdiv;
-						col8 = getLUM8_from_RGB565(image16+yc*arImXsize+xc);
-						ext_pat2[jy][ix][0] += col8;
-						ext_pat2[jy][ix][1] += col8;
-						ext_pat2[jy][ix][2] += col8;
-						break;
-
-					case PIXEL_FORMAT_LUM:
-						jy=j/ydiv; ix=i/xdiv;
-						col8 = image[yc*arImXsize+xc];
-						ext_pat2[jy][ix][0] += col8;
-						ext_pat2[jy][ix][1] += col8;
-						ext_pat2[jy][ix][2] += col8;
-						break;
-					}
+					dst[i/xdiv][0] += row[i][0];
+					dst[i/xdiv][1] += row[i][1];
+					dst[i/xdiv][2] += row[i][2];
 				}
-			}
 		}
 
 		for( j = 0; j < PATTERN_HEIGHT; j++ ) {
-			for( i = 0; i < PATTERN_HEIGHT; i++ ) {
+			for( i = 0; i < PATTERN_WIDTH; i++ ) {
 				ext_pat[j][i][0] = ext_pat2[j][i][0] / (xdiv*ydiv);
 				ext_pat[j][i][1] = ext_pat2[j][i][1] / (xdiv*ydiv);
 				ext_pat[j][i][2] = ext_pat2[j][i][2] / (xdiv*ydiv);
@@ -490,6 +488,71 @@ printf("%3d(%f), %3d(%f)\n", xdiv2, sqrt(lx1), ydiv2, sqrt(ly1));
 
     return(0);
 }
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::getSampleRow(ARUint8 *image, const int *xc, const int *yc, int num,
+							   ARUint8 row[][3], bool *valid)
+{
+	int i, off, c0=0, c1=1, c2=2, pixSize=4;
+
+	// image offsets of the samples, invalid for points outside of the image
+	for( i = 0; i < num; i++ )
+		valid[i] = (xc[i] >= 0 && xc[i] < arImXsize && yc[i] >= 0 && yc[i] < arImYsize);
+
+	switch(pixelFormat)
+	{
+	case PIXEL_FORMAT_RGB565:
+		for( i = 0; i < num; i++ )
+			if(valid[i])
+				row[i][0] = row[i][1] = row[i][2] = getLUM8_from_RGB565((unsigned short*)image+yc[i]*arImXsize+xc[i]);
+		return;
+
+	case PIXEL_FORMAT_LUM:
+		for( i = 0; i < num; i++ )
+			if(valid[i])
+				row[i][0] = row[i][1] = row[i][2] = image[yc[i]*arImXsize+xc[i]];
+		return;
+
+	case PIXEL_FORMAT_UYVY:
+	case PIXEL_FORMAT_YUYV:
+		off = getLumaOffset();
+		for( i = 0; i < num; i++ )
+			if(valid[i])
+				row[i][0] = row[i][1] = row[i][2] = image[(yc[i]*arImXsize+xc[i])*2+off];
+		return;
+
+	case PIXEL_FORMAT_ABGR:
+		c0 = 1;  c1 = 2;  c2 = 3;
+		break;
+
+	case PIXEL_FORMAT_BGRA:
+		break;
+
+	case PIXEL_FORMAT_BGR:
+		pixSize = 3;
+		break;
+
+	case PIXEL_FORMAT_RGBA:
+		c0 = 2;  c2 = 0;
+		break;
+
+	case PIXEL_FORMAT_RGB:
+		c0 = 2;  c2 = 0;  pixSize = 3;
+		break;
+	}
+
+	for( i = 0; i < num; i++ )
+		if(valid[i])
+		{
+			const ARUint8 *pix = image + (yc[i]*arImXsize+xc[i])*pixSize;
+			row[i][0] = pix[c0];
+			row[i][1] = pix[c1];
+			row[i][2] = pix[c2];
+		}
+}
+
+
 //#else
 /*
 int arGetPatt( ARUint8 *image, int *x_coord, int *y_coord, int *vertex,
@@ -615,11 +678,12 @@ AR_TEMPL_FUNC int
 AR_TEMPL_TRACKER::pattern_match( ARUint8 *data, int *code, int *dir, ARFloat *cf)
 {
     ARFloat invec[EVEC_MAX];
-    int    input[PATTERN_HEIGHT*PATTERN_WIDTH*3];
-    int    i, j, l;
-    int    k = 0; // fix VC7 compiler warning: uninitialized variable
-    int    ave, sum, res, res2;
-    ARFloat datapow, sum2, min;
+    ARFloat bound[MAX_LOAD_PATTERNS*4];
+    ARFloat inputf[PATTERN_HEIGHT*PATTERN_WIDTH*3];
+    ARInt16 input[PATTERN_BANK_STRIDE];
+    int    i, k, b, n;
+    int    ave, sum, res;
+    ARFloat datapow, sum2, inres;
     ARFloat max = 0.0; // fix VC7 compiler warning: uninitialized variable
 
 	// uncomment to dump the unprojected content of the marker that artoolkit found in the image
@@ -629,24 +693,25 @@ AR_TEMPL_TRACKER::pattern_match( ARUint8 *data, int *code, int *dir, ARFloat *cf
 			fclose(fp);
 		}*/
 
-    sum = ave = 0;
+    ave = 0;
     for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH*3;i++) {
         ave += (255-data[i]);
     }
     ave /= (PATTERN_HEIGHT*PATTERN_WIDTH*3);
 
     if( arTemplateMatchingMode == AR_TEMPLATE_MATCHING_COLOR ) {
-        for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH*3;i++) {
-            input[i] = (255-data[i]) - ave;
-            sum += input[i]*input[i];
-        }
+        n = PATTERN_BANK_STRIDE;
+        for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH*3;i++)
+            input[i] = (ARInt16)((255-data[i]) - ave);
+        for( ; i < n; i++ ) input[i] = 0;
     }
     else {
-        for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH;i++) {
-            input[i] = ((255-data[i*3+0]) + (255-data[i*3+1]) + (255-data[i*3+02]))/3 - ave;
-            sum += input[i]*input[i];
-        }
+        n = PATTERN_BANK_STRIDE_BW;
+        for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH;i++)
+            input[i] = (ARInt16)(((255-data[i*3+0]) + (255-data[i*3+1]) + (255-data[i*3+02]))/3 - ave);
+        for( ; i < n; i++ ) input[i] = 0;
     }
+    sum = correlateRow(input, input, n);
 
     datapow = (ARFloat)sqrt( (ARFloat)sum );
     if( datapow == 0.0 ) {
@@ -656,81 +721,69 @@ AR_TEMPL_TRACKER::pattern_match( ARUint8 *data, int *code, int *dir, ARFloat *cf
         return -1;
     }
 
-    res = res2 = -1;
+    res = -1;
     if( arTemplateMatchingMode == AR_TEMPLATE_MATCHING_COLOR ) {
         if( arMatchingPCAMode == AR_MATCHING_WITH_PCA && evecf ) {
-
+            // input and patterns are unit vectors, so their correlation is the
+            // product of the projections onto the eigenvectors plus at most the
+            // product of the lengths of the residuals. patterns are correlated in
+            // order of this bound until no bound can beat the best match anymore.
+            //
+            for( i = 0; i < PATTERN_HEIGHT*PATTERN_WIDTH*3; i++ ) inputf[i] = input[i];
+            sum2 = 0.0;
             for( i = 0; i < evec_dim; i++ ) {
-                invec[i] = 0.0;
-                for( j = 0; j < PATTERN_HEIGHT*PATTERN_WIDTH*3; j++ ) {
-                    invec[i] += evec[i][j] * input[j];
+                invec[i] = dotRow(evec[i], inputf, PATTERN_HEIGHT*PATTERN_WIDTH*3) / datapow;
+                sum2 += invec[i]*invec[i];
+            }
+            inres = (sum2 < 1.0f) ? (ARFloat)sqrt(1.0f-sum2) : 0.0f;
+
+            k = 0;
+            for( b = 0; b < patBankNum; b++ ) {
+                const ARFloat *ep = epat[patBankIdx[b]>>2][patBankIdx[b]&3];
+                ARFloat dot = 0.0, epow = 0.0;
+                for( i = 0; i < evec_dim; i++ ) {
+                    dot += invec[i] * ep[i];
+                    epow += ep[i] * ep[i];
                 }
-                invec[i] /= datapow;
+                // the margin covers the rounding errors of the projections
+                bound[b] = dot + inres * ((epow < 1.0f) ? (ARFloat)sqrt(1.0f-epow) : 0.0f) + 0.001f;
+                if( bound[b] > bound[k] ) k = b;
             }
 
-            min = 10000.0;
-            k = -1;
-            for( l = 0; l < pattern_num; l++ ) {
-                k++;
-                while( patf[k] == 0 ) k++;
-                if( patf[k] == 2 ) continue;
-#ifdef ARTK_DEBUG
-                printf("%3d: ", k);
-#endif
-                for( j = 0; j < 4; j++ ) {
-                    sum2 = 0;
-                    for(i = 0; i < evec_dim; i++ ) {
-                        sum2 += (invec[i] - epat[k][j][i]) * (invec[i] - epat[k][j][i]);
-                    }
-#ifdef ARTK_DEBUG
-                    printf("%10.7f ", sum2);
-#endif
-                    if( sum2 < min ) { min = sum2; res = j; res2 = k; }
-                }
-#ifdef ARTK_DEBUG
-                printf("\n");
-#endif
+            // the pattern with the highest bound is correlated first,
+            // it is most likely the match and prunes most of the others
+            for( i = (patBankNum > 0) ? -1 : 0; i < patBankNum; i++ ) {
+                b = (i < 0) ? k : i;
+                if( (i >= 0 && b == k) || bound[b] < max ) continue;
+
+                sum = correlateRow(input, patBank[b], n);
+                sum2 = sum / patpow[patBankIdx[b]>>2][patBankIdx[b]&3] / datapow;
+                // ties go to the first pattern, as with the plain search
+                if( sum2 > max || (sum2 == max && b < res) ) { max = sum2; res = b; }
             }
-            sum = 0;
-            for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH*3;i++) sum += input[i]*pat[res2][res][i];
-            max = sum / patpow[res2][res] / datapow;
         }
         else {
-            k = -1;
-            max = 0.0;
-            for( l = 0; l < pattern_num; l++ ) {
-                k++;
-                while( patf[k] == 0 ) k++;
-                if( patf[k] == 2 ) continue;
-                for( j = 0; j < 4; j++ ) {
-                    sum = 0;
-                    for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH*3;i++) sum += input[i]*pat[k][j][i];
-                    sum2 = sum / patpow[k][j] / datapow;
-                    if( sum2 > max ) { max = sum2; res = j; res2 = k; }
-                }
+            for( b = 0; b < patBankNum; b++ ) {
+                sum = correlateRow(input, patBank[b], n);
+                sum2 = sum / patpow[patBankIdx[b]>>2][patBankIdx[b]&3] / datapow;
+                if( sum2 > max ) { max = sum2; res = b; }
             }
         }
     }
     else {
-        for( l = 0; l < pattern_num; l++ ) {
-            k++;
-            while( patf[k] == 0 ) k++;
-            if( patf[k] == 2 ) continue;
-            for( j = 0; j < 4; j++ ) {
-                sum = 0;
-                for(i=0;i<PATTERN_HEIGHT*PATTERN_WIDTH;i++) sum += input[i]*patBW[k][j][i];
-                sum2 = sum / patpowBW[k][j] / datapow;
-                if( sum2 > max ) { max = sum2; res = j; res2 = k; }
-            }
+        for( b = 0; b < patBankNum; b++ ) {
+            sum = correlateRow(input, patBankBW[b], n);
+            sum2 = sum / patpowBW[patBankIdx[b]>>2][patBankIdx[b]&3] / datapow;
+            if( sum2 > max ) { max = sum2; res = b; }
         }
     }
 
-    *code = res2;
-    *dir  = res;
+    *code = (res >= 0) ? patBankIdx[res]>>2 : -1;
+    *dir  = (res >= 0) ? patBankIdx[res]&3 : -1;
     *cf   = max;
 
 #ifdef ARTK_DEBUG
-    printf("%d %d %f\n", res2, res, max);
+    printf("%d %d %f\n", *code, *dir, max);
 #endif
 
     return 0;
@@ -765,7 +818,7 @@ AR_TEMPL_TRACKER::gen_evec(void)
         if( patf[jj] == 0 ) continue;
         for( k = 0; k < 4; k++ ) {
             for( i = 0; i < PATTERN_HEIGHT*PATTERN_WIDTH*3; i++ ) {
-                input->m[(j*4+k)*PATTERN_HEIGHT*PATTERN_WIDTH*3+i] = pat[j][k][i] / patpow[j][k];
+                input->m[(j*4+k)*PATTERN_HEIGHT*PATTERN_WIDTH*3+i] = pat[jj][k][i] / patpow[jj][k];
             }
         }
         j++;
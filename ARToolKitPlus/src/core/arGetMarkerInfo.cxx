@@ -45,7 +45,7 @@ namespace ARToolKitPlus {
 
 
 AR_TEMPL_FUNC ARMarkerInfo*
-AR_TEMPL_TRACKER::arGetMarkerInfo(ARUint8 *image, ARMarkerInfo2 *marker_info2, int *marker_num, int thresh)
+AR_TEMPL_TRACKER::arGetMarkerInfo(Context* ctx, ARUint8 *image, ARMarkerInfo2 *marker_info2, int *marker_num, int thresh)
 {
     int            id, dir;
     ARFloat         cf;
@@ -54,21 +54,21 @@ AR_TEMPL_TRACKER::arGetMarkerInfo(ARUint8 *image, ARMarkerInfo2 *marker_info2, i
 	PROFILE_BEGINSEC(profiler, GETMARKERINFO)
 
     for( i = j = 0; i < *marker_num; i++ ) {
-        marker_infoL[j].area   = marker_info2[i].area;
-        marker_infoL[j].pos[0] = marker_info2[i].pos[0];
-        marker_infoL[j].pos[1] = marker_info2[i].pos[1];
+        ctx->marker_infoL[j].area   = marker_info2[i].area;
+        ctx->marker_infoL[j].pos[0] = marker_info2[i].pos[0];
+        ctx->marker_infoL[j].pos[1] = marker_info2[i].pos[1];
 
         if( arGetLine(marker_info2[i].x_coord, marker_info2[i].y_coord,
                       marker_info2[i].coord_num, marker_info2[i].vertex,
-                      marker_infoL[j].line, marker_infoL[j].vertex) < 0 ) continue;
+                      ctx->marker_infoL[j].line, ctx->marker_infoL[j].vertex) < 0 ) continue;
 
-        arGetCode( image,
+        arGetCode( ctx, image,
                    marker_info2[i].x_coord, marker_info2[i].y_coord,
                    marker_info2[i].vertex, &id, &dir, &cf, thresh);
 
-        marker_infoL[j].id  = id;
-        marker_infoL[j].dir = dir;
-        marker_infoL[j].cf  = cf;
+        ctx->marker_infoL[j].id  = id;
+        ctx->marker_infoL[j].dir = dir;
+        ctx->marker_infoL[j].cf  = cf;
 
         j++;
     }
@@ -76,7 +76,7 @@ AR_TEMPL_TRACKER::arGetMarkerInfo(ARUint8 *image, ARMarkerInfo2 *marker_info2, i
 
 	PROFILE_ENDSEC(profiler, GETMARKERINFO)
 
-    return( marker_infoL );
+    return( ctx->marker_infoL );
 }
 
 
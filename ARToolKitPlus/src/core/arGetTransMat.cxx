@@ -57,6 +57,8 @@ AR_TEMPL_TRACKER::arGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], AR
     int     dir;
     ARFloat  err;
     int     i;
+    MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
 
 	PROFILE_BEGINSEC(profiler, GETTRANSMAT)
 
@@ -93,6 +95,118 @@ AR_TEMPL_TRACKER::arGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], AR
     return err;
 }
 
+#ifndef _FIXEDPOINT_MATH_ACTIVATED_
+
+// arGetTransMat() for num markers of the same size at once. the refinement
+// loops of all markers run in lockstep, see arModifyMatrixBatch(). err
+// receives the error of each marker or -1 if no initial rotation was found,
+// conv is left untouched for such markers. markers with an entry in prev
+// start from that pose instead, like arGetTransMatContSub().
+// returns the number of markers a pose was found for.
+//
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arGetTransMatBatch(const ARMarkerInfo *marker_info, int num, ARFloat center[2], ARFloat width,
+									 ARFloat conv[][3][4], ARFloat *err, PoseHistoryEntry *const *prev)
+{
+    ARFloat  (*rot)[3][3], (*trans)[3], (*pos2d)[4][2];
+    ARFloat  ppos3d[4][2], pos3d[4][3];
+    ARFloat  off[3], pmax[3], pmin[3];
+    int     *idx, numActive = 0, numFound;
+    int     dir;
+    int     i, j, k, m;
+    MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
+    ppos3d[0][0] = center[0] - width*(ARFloat)0.5;
+    ppos3d[0][1] = center[1] + width*(ARFloat)0.5;
+    ppos3d[1][0] = center[0] + width*(ARFloat)0.5;
+    ppos3d[1][1] = center[1] + width*(ARFloat)0.5;
+    ppos3d[2][0] = center[0] + width*(ARFloat)0.5;
+    ppos3d[2][1] = center[1] - width*(ARFloat)0.5;
+    ppos3d[3][0] = center[0] - width*(ARFloat)0.5;
+    ppos3d[3][1] = center[1] - width*(ARFloat)0.5;
+
+    // same centering as in arGetTransMat3()
+    pmax[0]=pmax[1]=pmax[2] = -10000000000.0;
+    pmin[0]=pmin[1]=pmin[2] =  10000000000.0;
+    for( i = 0; i < 4; i++ ) {
+        if( ppos3d[i][0] > pmax[0] ) pmax[0] = ppos3d[i][0];
+        if( ppos3d[i][0] < pmin[0] ) pmin[0] = ppos3d[i][0];
+        if( ppos3d[i][1] > pmax[1] ) pmax[1] = ppos3d[i][1];
+        if( ppos3d[i][1] < pmin[1] ) pmin[1] = ppos3d[i][1];
+    }
+    off[0] = -(pmax[0] + pmin[0])  * (ARFloat)0.5;
+    off[1] = -(pmax[1] + pmin[1])  * (ARFloat)0.5;
+    off[2] = -(pmax[2] + pmin[2])  * (ARFloat)0.5;
+    for( i = 0; i < 4; i++ ) {
+        pos3d[i][0] = ppos3d[i][0] + off[0];
+        pos3d[i][1] = ppos3d[i][1] + off[1];
+        pos3d[i][2] = 0.0;
+    }
+
+    rot = (ARFloat (*)[3][3])artkp_FrameAlloc( sizeof(ARFloat)*9*num );
+    trans = (ARFloat (*)[3])artkp_FrameAlloc( sizeof(ARFloat)*3*num );
+    pos2d = (ARFloat (*)[4][2])artkp_FrameAlloc( sizeof(ARFloat)*8*num );
+    idx = (int*)artkp_FrameAlloc( sizeof(int)*num );
+
+    for( m = 0; m < num; m++ ) {
+        if( prev && prev[m] ) {
+            for( i = 0; i < 3; i++ ) {
+                for( j = 0; j < 3; j++ ) rot[m][i][j] = prev[m]->trans[i][j];
+            }
+        }
+        else if( arGetInitRot( const_cast<ARMarkerInfo*>(marker_info+m), arCamera->mat, rot[m] ) < 0 ) {
+            err[m] = -1;
+            continue;
+        }
+
+        dir = marker_info[m].dir;
+        for( i = 0; i < 4; i++ ) {
+            const ARFloat *vertex = marker_info[m].vertex[(4-dir+i)%4];
+            if( arFittingMode == AR_FITTING_TO_INPUT )
+                arParamIdeal2Observ_std(arCamera, vertex[0], vertex[1], &pos2d[m][i][0], &pos2d[m][i][1]);
+            else {
+                pos2d[m][i][0] = vertex[0];
+                pos2d[m][i][1] = vertex[1];
+            }
+        }
+        idx[numActive++] = m;
+    }
+    numFound = numActive;
+
+    // markers that fit well enough drop out, the others go for another round
+    for( k = 0; k < AR_GET_TRANS_MAT_MAX_LOOP_COUNT && numActive > 0; k++ ) {
+        for( i = 0; i < numActive; i++ )
+            arGetTransMatTrans( rot[idx[i]], pos2d[idx[i]], pos3d, 4, trans[idx[i]], arCamera );
+
+        arModifyMatrixBatch( rot, trans, arCamera->mat, pos3d, pos2d, idx, numActive, err );
+
+        for( i = 0, j = 0; i < numActive; i++ ) {
+            m = idx[i];
+
+            for( int r = 0; r < 3; r++ ) {
+                conv[m][r][0] = rot[m][r][0];
+                conv[m][r][1] = rot[m][r][1];
+                conv[m][r][2] = rot[m][r][2];
+                conv[m][r][3] = conv[m][r][0]*off[0] + conv[m][r][1]*off[1] + conv[m][r][2]*off[2] + trans[m][r];
+            }
+
+            if( err[m] >= AR_GET_TRANS_MAT_MAX_FIT_ERROR )
+                idx[j++] = m;
+        }
+        numActive = j;
+    }
+
+    artkp_FrameFree( idx );
+    artkp_FrameFree( pos2d );
+    artkp_FrameFree( trans );
+    artkp_FrameFree( rot );
+
+    return numFound;
+}
+
+#endif //_FIXEDPOINT_MATH_ACTIVATED_
+
+
 AR_TEMPL_FUNC ARFloat
 AR_TEMPL_TRACKER::arGetTransMat2(ARFloat rot[3][3], ARFloat ppos2d[][2], ARFloat ppos3d[][2], int num, ARFloat conv[3][4])
 {
@@ -107,6 +221,7 @@ AR_TEMPL_TRACKER::arGetTransMat3(ARFloat rot[3][3], ARFloat ppos2d[][2],
                    //ARFloat *dist_factor, ARFloat cpara[3][4] )
 {
     ARFloat  off[3], pmax[3], pmin[3];
+    ARFloat  (*pos3d)[3];
     ARFloat  ret;
     int     i;
 
@@ -127,6 +242,7 @@ AR_TEMPL_TRACKER::arGetTransMat3(ARFloat rot[3][3], ARFloat ppos2d[][2],
     off[0] = -(pmax[0] + pmin[0])  * (ARFloat)0.5;
     off[1] = -(pmax[1] + pmin[1])  * (ARFloat)0.5;
     off[2] = -(pmax[2] + pmin[2])  * (ARFloat)0.5;
+    pos3d = (ARFloat (*)[3])artkp_FrameAlloc( sizeof(ARFloat)*3*num );
     for( i = 0; i < num; i++ ) {
         pos3d[i][0] = ppos3d[i][0] + off[0];
         pos3d[i][1] = ppos3d[i][1] + off[1];
@@ -138,6 +254,7 @@ AR_TEMPL_TRACKER::arGetTransMat3(ARFloat rot[3][3], ARFloat ppos2d[][2],
 
     ret = arGetTransMatSub( rot, ppos2d, pos3d, num, conv, pCam);
                             //dist_factor, cpara );
+    artkp_FrameFree( pos3d );
 
     conv[0][3] = conv[0][0]*off[0] + conv[0][1]*off[1] + conv[0][2]*off[2] + conv[0][3];
     conv[1][3] = conv[1][0]*off[0] + conv[1][1]*off[1] + conv[1][2]*off[2] + conv[1][3];
@@ -162,6 +279,7 @@ AR_TEMPL_TRACKER::arGetTransMat5(ARFloat rot[3][3], ARFloat ppos2d[][2],
 				   //ARFloat *dist_factor, ARFloat cpara[3][4])
 {
     ARFloat  off[3], pmax[3], pmin[3];
+    ARFloat  (*pos3d)[3];
     ARFloat  ret;
     int     i;
 
@@ -178,6 +296,7 @@ AR_TEMPL_TRACKER::arGetTransMat5(ARFloat rot[3][3], ARFloat ppos2d[][2],
     off[0] = -(pmax[0] + pmin[0])  * (ARFloat)0.5;
     off[1] = -(pmax[1] + pmin[1])  * (ARFloat)0.5;
     off[2] = -(pmax[2] + pmin[2])  * (ARFloat)0.5;
+    pos3d = (ARFloat (*)[3])artkp_FrameAlloc( sizeof(ARFloat)*3*num );
     for( i = 0; i < num; i++ ) {
         pos3d[i][0] = ppos3d[i][0] + off[0];
         pos3d[i][1] = ppos3d[i][1] + off[1];
@@ -186,6 +305,7 @@ AR_TEMPL_TRACKER::arGetTransMat5(ARFloat rot[3][3], ARFloat ppos2d[][2],
 
     ret = arGetTransMatSub( rot, ppos2d, pos3d, num, conv, pCam);
                             //dist_factor, cpara );
+    artkp_FrameFree( pos3d );
 
     conv[0][3] = conv[0][0]*off[0] + conv[0][1]*off[1] + conv[0][2]*off[2] + conv[0][3];
     conv[1][3] = conv[1][0]*off[0] + conv[1][1]*off[1] + conv[1][2]*off[2] + conv[1][3];
@@ -200,20 +320,14 @@ AR_TEMPL_TRACKER::arGetTransMatSub(ARFloat rot[3][3], ARFloat ppos2d[][2],
 					 Camera *pCam )
                      //ARFloat *dist_factor, ARFloat cpara[3][4] )
 {
-    ARMat   *mat_a, *mat_b, *mat_c, *mat_d, *mat_e, *mat_f;
+    ARFloat  (*pos2d)[2];
     ARFloat  trans[3];
-    ARFloat  wx, wy, wz;
     ARFloat  ret;
     int     i, j;
 
 	PROFILE_BEGINSEC(profiler, GETTRANSMATSUB)
 
-    mat_a = Matrix::alloc( num*2, 3 );
-    mat_b = Matrix::alloc( 3, num*2 );
-    mat_c = Matrix::alloc( num*2, 1 );
-    mat_d = Matrix::alloc( 3, 3 );
-    mat_e = Matrix::alloc( 3, 1 );
-    mat_f = Matrix::alloc( 3, 1 );
+    pos2d = (ARFloat (*)[2])artkp_FrameAlloc( sizeof(ARFloat)*2*num );
 
     if( arFittingMode == AR_FITTING_TO_INPUT ) {
         for( i = 0; i < num; i++ ) {
@@ -227,7 +341,30 @@ AR_TEMPL_TRACKER::arGetTransMatSub(ARFloat rot[3][3], ARFloat ppos2d[][2],
         }
     }
 
-    for( j = 0; j < num; j++ ) {
+    arGetTransMatTrans( rot, pos2d, pos3d, num, trans, pCam );
+
+	/*trans[0] = 3.96559f;
+	trans[1] = 27.0546f;
+	trans[2] = 274.627f;*/
+
+	{
+		ARFloat a,b,c;
+		arGetAngle( rot, &a, &b, &c );
+
+		//trans[0] = -13.5f;
+		//trans[1] = 45.7f;
+		//trans[2] = 303.0f;
+		//arGetRot( -90.5f*3.1415f/180.0f, 120.3f*3.1415f/180.0f, 31.2f*3.1415f/180.0f, rot );
+
+		ret = arModifyMatrix( rot, trans, pCam->mat, pos3d, pos2d, num );
+
+		arGetAngle( rot, &a, &b, &c );
+		a=a;
+	}
+
+	// double begin
+	//
+    /*for( j = 0; j < num; j++ ) {
         wx = rot[0][0] * pos3d[j][0]
            + rot[0][1] * pos3d[j][1]
            + rot[0][2] * pos3d[j][2];
@@ -256,28 +393,41 @@ AR_TEMPL_TRACKER::arGetTransMatSub(ARFloat rot[3][3], ARFloat ppos2d[][2],
     trans[1] = mat_f->m[1];
     trans[2] = mat_f->m[2];
 
-	/*trans[0] = 3.96559f;
-	trans[1] = 27.0546f;
-	trans[2] = 274.627f;*/
+    ret = arModifyMatrix( rot, trans, pCam->mat, pos3d, pos2d, num );*/
+	//
+	// double end
 
-	{
-		ARFloat a,b,c;
-		arGetAngle( rot, &a, &b, &c );
+    artkp_FrameFree( pos2d );
 
-		//trans[0] = -13.5f;
-		//trans[1] = 45.7f;
-		//trans[2] = 303.0f;
-		//arGetRot( -90.5f*3.1415f/180.0f, 120.3f*3.1415f/180.0f, 31.2f*3.1415f/180.0f, rot );
+    for( j = 0; j < 3; j++ ) {
+        for( i = 0; i < 3; i++ ) conv[j][i] = rot[j][i];
+        conv[j][3] = trans[j];
+    }
 
-		ret = arModifyMatrix( rot, trans, pCam->mat, pos3d, pos2d, num );
+	PROFILE_ENDSEC(profiler, GETTRANSMATSUB)
+    return ret;
+}
 
-		arGetAngle( rot, &a, &b, &c );
-		a=a;
-	}
 
-	// double begin
-	//
-    /*for( j = 0; j < num; j++ ) {
+// solves the linear system for the translation of a pose with rotation rot
+//
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::arGetTransMatTrans(ARFloat rot[3][3], ARFloat pos2d[][2],
+                     ARFloat pos3d[][3], int num, ARFloat trans[3],
+					 Camera *pCam )
+{
+    ARMat   *mat_a, *mat_b, *mat_c, *mat_d, *mat_e, *mat_f;
+    ARFloat  wx, wy, wz;
+    int     j;
+
+    mat_a = Matrix::alloc( num*2, 3 );
+    mat_b = Matrix::alloc( 3, num*2 );
+    mat_c = Matrix::alloc( num*2, 1 );
+    mat_d = Matrix::alloc( 3, 3 );
+    mat_e = Matrix::alloc( 3, 1 );
+    mat_f = Matrix::alloc( 3, 1 );
+
+    for( j = 0; j < num; j++ ) {
         wx = rot[0][0] * pos3d[j][0]
            + rot[0][1] * pos3d[j][1]
            + rot[0][2] * pos3d[j][2];
@@ -306,24 +456,12 @@ AR_TEMPL_TRACKER::arGetTransMatSub(ARFloat rot[3][3], ARFloat ppos2d[][2],
     trans[1] = mat_f->m[1];
     trans[2] = mat_f->m[2];
 
-    ret = arModifyMatrix( rot, trans, pCam->mat, pos3d, pos2d, num );*/
-	//
-	// double end
-
     Matrix::free( mat_a );
     Matrix::free( mat_b );
     Matrix::free( mat_c );
     Matrix::free( mat_d );
     Matrix::free( mat_e );
     Matrix::free( mat_f );
-
-    for( j = 0; j < 3; j++ ) {
-        for( i = 0; i < 3; i++ ) conv[j][i] = rot[j][i];
-        conv[j][3] = trans[j];
-    }
-
-	PROFILE_ENDSEC(profiler, GETTRANSMATSUB)
-    return ret;
 }
 
 
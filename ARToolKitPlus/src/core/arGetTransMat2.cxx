@@ -45,6 +45,10 @@
 //#include <ARToolKitPlus/matrix.h>
 //#include <ARToolKitPlus/extra/Profiler.h>
 
+#ifdef AR_USE_SSE2
+#  include <emmintrin.h>
+#endif
+
 
 namespace ARToolKitPlus {
 
@@ -137,6 +141,271 @@ AR_TEMPL_TRACKER::arModifyMatrix(ARFloat rot[3][3], ARFloat trans[3], ARFloat cp
 }
 
 
+// structure-of-arrays state of arModifyMatrixBatch(), each array holds
+// one entry per marker
+//
+struct ModifyMatrixBatch
+{
+	ARFloat	*px[4], *py[4];					// observed corners
+	ARFloat	*tx, *ty, *tz;					// last column of the combined matrix
+	ARFloat	*ang[3][3], *sn[3][3], *cs[3][3];	// angles a,b,c moved by -factor,0,+factor and their sine and cosine
+	ARFloat	*base[3], *best[3], *minerr, *factor;
+	int		*center;						// the best candidate left the angles unchanged
+};
+
+
+// one step of arModifyMatrix() for marker l: tries the 27 candidate rotations
+// in the same order and with the same arithmetic as arModifyMatrix()
+//
+static void
+modifyMatrixStep(ModifyMatrixBatch& mb, int l, ARFloat cpara[3][4], ARFloat vertex[4][3])
+{
+	ARFloat minerr = 1000000000.0;
+	ARFloat rot[3][3], combo[3][3];
+	int t1, t2, t3, i, j;
+
+	for(t1=0;t1<3;t1++) {
+		const ARFloat sina = mb.sn[0][t1][l], cosa = mb.cs[0][t1][l];
+		const ARFloat caca = cosa*cosa, sasa = sina*sina, saca = sina*cosa;
+
+		for(t2=0;t2<3;t2++) {
+			const ARFloat sinb = mb.sn[1][t2][l], cosb = mb.cs[1][t2][l];
+			const ARFloat cacacb = caca*cosb, sasacb = sasa*cosb, sacacb = saca*cosb;
+			const ARFloat casb = cosa*sinb, sasb = sina*sinb;
+
+			for(t3=0;t3<3;t3++) {
+				const ARFloat sinc = mb.sn[2][t3][l], cosc = mb.cs[2][t3][l];
+
+				rot[0][0] = cacacb*cosc+sasa*cosc+sacacb*sinc-saca*sinc;
+				rot[0][1] = -(cacacb*sinc)-sasa*sinc+sacacb*cosc-saca*cosc;
+				rot[0][2] = casb;
+				rot[1][0] = sacacb*cosc-saca*cosc+sasacb*sinc+caca*sinc;
+				rot[1][1] = -(sacacb*sinc)+saca*sinc+sasacb*cosc+caca*cosc;
+				rot[1][2] = sasb;
+				rot[2][0] = -(casb*cosc)-sasb*sinc;
+				rot[2][1] = casb*sinc-sasb*cosc;
+				rot[2][2] = cosb;
+
+				for( j = 0; j < 3; j++ )
+					for( i = 0; i < 3; i++ )
+						combo[j][i] = cpara[j][0] * rot[0][i]
+									+ cpara[j][1] * rot[1][i]
+									+ cpara[j][2] * rot[2][i];
+
+				ARFloat err = 0.0;
+				for( i = 0; i < 4; i++ ) {
+					ARFloat hx = combo[0][0] * vertex[i][0]
+							   + combo[0][1] * vertex[i][1]
+							   + combo[0][2] * vertex[i][2]
+							   + mb.tx[l];
+					ARFloat hy = combo[1][0] * vertex[i][0]
+							   + combo[1][1] * vertex[i][1]
+							   + combo[1][2] * vertex[i][2]
+							   + mb.ty[l];
+					ARFloat h  = combo[2][0] * vertex[i][0]
+							   + combo[2][1] * vertex[i][1]
+							   + combo[2][2] * vertex[i][2]
+							   + mb.tz[l];
+					ARFloat x = hx / h;
+					ARFloat y = hy / h;
+
+					err += (mb.px[i][l] - x) * (mb.px[i][l] - x)
+						 + (mb.py[i][l] - y) * (mb.py[i][l] - y);
+				}
+
+				if( err < minerr ) {
+					minerr = err;
+					mb.best[0][l] = mb.ang[0][t1][l];
+					mb.best[1][l] = mb.ang[1][t2][l];
+					mb.best[2][l] = mb.ang[2][t3][l];
+					mb.center[l] = (t1==1 && t2==1 && t3==1);
+				}
+			}
+		}
+	}
+
+	mb.minerr[l] = minerr;
+}
+
+
+#if defined(AR_USE_SSE2) && !defined(_USE_DOUBLE_)
+
+// modifyMatrixStep() for the four markers l..l+3. the operations are the
+// same as in the C version, so both give exactly the same results.
+//
+static void
+modifyMatrixStep4(ModifyMatrixBatch& mb, int l, ARFloat cpara[3][4], ARFloat vertex[4][3])
+{
+	__m128 minerr = _mm_set1_ps(1000000000.0f);
+	__m128 best0 = _mm_loadu_ps(mb.best[0]+l), best1 = _mm_loadu_ps(mb.best[1]+l), best2 = _mm_loadu_ps(mb.best[2]+l);
+	__m128 center = _mm_setzero_ps();
+	const __m128 tx = _mm_loadu_ps(mb.tx+l), ty = _mm_loadu_ps(mb.ty+l), tz = _mm_loadu_ps(mb.tz+l);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	__m128 cp[3][3], v[4][3], rot[3][3];
+	int t1, t2, t3, i, j, centerBits = 0;
+
+	for( j = 0; j < 3; j++ )
+		for( i = 0; i < 3; i++ )
+			cp[j][i] = _mm_set1_ps(cpara[j][i]);
+	for( i = 0; i < 4; i++ )
+		for( j = 0; j < 3; j++ )
+			v[i][j] = _mm_set1_ps(vertex[i][j]);
+
+	for( i = 0; i < 4; i++ )
+		if( mb.center[l+i] ) centerBits |= 1<<i;
+	center = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(centerBits), _mm_set_epi32(8,4,2,1)), _mm_set_epi32(8,4,2,1)));
+
+	for(t1=0;t1<3;t1++) {
+		const __m128 sina = _mm_loadu_ps(mb.sn[0][t1]+l), cosa = _mm_loadu_ps(mb.cs[0][t1]+l);
+		const __m128 caca = _mm_mul_ps(cosa, cosa), sasa = _mm_mul_ps(sina, sina), saca = _mm_mul_ps(sina, cosa);
+
+		for(t2=0;t2<3;t2++) {
+			const __m128 sinb = _mm_loadu_ps(mb.sn[1][t2]+l), cosb = _mm_loadu_ps(mb.cs[1][t2]+l);
+			const __m128 cacacb = _mm_mul_ps(caca, cosb), sasacb = _mm_mul_ps(sasa, cosb), sacacb = _mm_mul_ps(saca, cosb);
+			const __m128 casb = _mm_mul_ps(cosa, sinb), sasb = _mm_mul_ps(sina, sinb);
+
+			for(t3=0;t3<3;t3++) {
+				const __m128 sinc = _mm_loadu_ps(mb.sn[2][t3]+l), cosc = _mm_loadu_ps(mb.cs[2][t3]+l);
+
+				rot[0][0] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cacacb, cosc), _mm_mul_ps(sasa, cosc)), _mm_mul_ps(sacacb, sinc)), _mm_mul_ps(saca, sinc));
+				rot[0][1] = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_xor_ps(_mm_mul_ps(cacacb, sinc), sign), _mm_mul_ps(sasa, sinc)), _mm_mul_ps(sacacb, cosc)), _mm_mul_ps(saca, cosc));
+				rot[0][2] = casb;
+				rot[1][0] = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(sacacb, cosc), _mm_mul_ps(saca, cosc)), _mm_mul_ps(sasacb, sinc)), _mm_mul_ps(caca, sinc));
+				rot[1][1] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_xor_ps(_mm_mul_ps(sacacb, sinc), sign), _mm_mul_ps(saca, sinc)), _mm_mul_ps(sasacb, cosc)), _mm_mul_ps(caca, cosc));
+				rot[1][2] = sasb;
+				rot[2][0] = _mm_sub_ps(_mm_xor_ps(_mm_mul_ps(casb, cosc), sign), _mm_mul_ps(sasb, sinc));
+				rot[2][1] = _mm_sub_ps(_mm_mul_ps(casb, sinc), _mm_mul_ps(sasb, cosc));
+				rot[2][2] = cosb;
+
+				__m128 combo[3][3];
+				for( j = 0; j < 3; j++ )
+					for( i = 0; i < 3; i++ )
+						combo[j][i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cp[j][0], rot[0][i]), _mm_mul_ps(cp[j][1], rot[1][i])), _mm_mul_ps(cp[j][2], rot[2][i]));
+
+				__m128 err = _mm_setzero_ps();
+				for( i = 0; i < 4; i++ ) {
+					__m128 hx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(combo[0][0], v[i][0]), _mm_mul_ps(combo[0][1], v[i][1])), _mm_mul_ps(combo[0][2], v[i][2])), tx);
+					__m128 hy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(combo[1][0], v[i][0]), _mm_mul_ps(combo[1][1], v[i][1])), _mm_mul_ps(combo[1][2], v[i][2])), ty);
+					__m128 h  = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(combo[2][0], v[i][0]), _mm_mul_ps(combo[2][1], v[i][1])), _mm_mul_ps(combo[2][2], v[i][2])), tz);
+					__m128 dx = _mm_sub_ps(_mm_loadu_ps(mb.px[i]+l), _mm_div_ps(hx, h));
+					__m128 dy = _mm_sub_ps(_mm_loadu_ps(mb.py[i]+l), _mm_div_ps(hy, h));
+
+					err = _mm_add_ps(err, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+				}
+
+				const __m128 better = _mm_cmplt_ps(err, minerr);
+				minerr = _mm_or_ps(_mm_and_ps(better, err), _mm_andnot_ps(better, minerr));
+				best0 = _mm_or_ps(_mm_and_ps(better, _mm_loadu_ps(mb.ang[0][t1]+l)), _mm_andnot_ps(better, best0));
+				best1 = _mm_or_ps(_mm_and_ps(better, _mm_loadu_ps(mb.ang[1][t2]+l)), _mm_andnot_ps(better, best1));
+				best2 = _mm_or_ps(_mm_and_ps(better, _mm_loadu_ps(mb.ang[2][t3]+l)), _mm_andnot_ps(better, best2));
+				center = (t1==1 && t2==1 && t3==1) ? _mm_or_ps(center, better) : _mm_andnot_ps(better, center);
+			}
+		}
+	}
+
+	_mm_storeu_ps(mb.minerr+l, minerr);
+	_mm_storeu_ps(mb.best[0]+l, best0);
+	_mm_storeu_ps(mb.best[1]+l, best1);
+	_mm_storeu_ps(mb.best[2]+l, best2);
+	centerBits = _mm_movemask_ps(center);
+	for( i = 0; i < 4; i++ )
+		mb.center[l+i] = (centerBits>>i) & 1;
+}
+
+#endif //AR_USE_SSE2
+
+
+// runs arModifyMatrix() for the markers idx[0..num-1] in lockstep. the
+// rotations are refined in place and err receives the fitting errors.
+// all markers share the model points vertex, their corners and the candidate
+// angles are kept as structure-of-arrays, so each step works on four markers
+// at once. sine and cosine are evaluated once per angle and step instead of
+// once per candidate.
+//
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::arModifyMatrixBatch(ARFloat rot[][3][3], ARFloat trans[][3], ARFloat cpara[3][4],
+					ARFloat vertex[4][3], ARFloat pos2d[][4][2], const int *idx, int num, ARFloat *err)
+{
+	ModifyMatrixBatch mb;
+	ARFloat *memory, *mem;
+	int i, j, k, l, t;
+
+	memory = mem = (ARFloat*)artkp_FrameAlloc( sizeof(ARFloat)*46*num );
+	mb.center = (int*)artkp_FrameAlloc( sizeof(int)*num );
+
+	for( i = 0; i < 4; i++ ) {
+		mb.px[i] = mem;  mem += num;
+		mb.py[i] = mem;  mem += num;
+	}
+	mb.tx = mem;  mem += num;
+	mb.ty = mem;  mem += num;
+	mb.tz = mem;  mem += num;
+	for( k = 0; k < 3; k++ ) {
+		for( t = 0; t < 3; t++ ) {
+			mb.ang[k][t] = mem;  mem += num;
+			mb.sn[k][t] = mem;  mem += num;
+			mb.cs[k][t] = mem;  mem += num;
+		}
+		mb.base[k] = mem;  mem += num;
+		mb.best[k] = mem;  mem += num;
+	}
+	mb.minerr = mem;  mem += num;
+	mb.factor = mem;
+
+	for( l = 0; l < num; l++ ) {
+		const int m = idx[l];
+
+		for( i = 0; i < 4; i++ ) {
+			mb.px[i][l] = pos2d[m][i][0];
+			mb.py[i][l] = pos2d[m][i][1];
+		}
+		mb.tx[l] = cpara[0][0] * trans[m][0] + cpara[0][1] * trans[m][1] + cpara[0][2] * trans[m][2] + cpara[0][3];
+		mb.ty[l] = cpara[1][0] * trans[m][0] + cpara[1][1] * trans[m][1] + cpara[1][2] * trans[m][2] + cpara[1][3];
+		mb.tz[l] = cpara[2][0] * trans[m][0] + cpara[2][1] * trans[m][1] + cpara[2][2] * trans[m][2] + cpara[2][3];
+
+		arGetAngle( rot[m], mb.base[0]+l, mb.base[1]+l, mb.base[2]+l );
+		mb.best[0][l] = mb.best[1][l] = mb.best[2][l] = 0;
+		mb.center[l] = 1;
+		mb.factor[l] = (ARFloat)(10.0*MD_PI/180.0);
+	}
+
+	for( j = 0; j < 15; j++ ) {
+		for( l = 0; l < num; l++ ) {
+			for( k = 0; k < 3; k++ ) {
+				for( t = 0; t < 3; t++ ) {
+					const ARFloat ang = mb.base[k][l] + mb.factor[l]*(t-1);
+					mb.ang[k][t][l] = ang;
+					mb.sn[k][t][l] = (ARFloat)sin(ang);
+					mb.cs[k][t][l] = (ARFloat)cos(ang);
+				}
+			}
+		}
+
+		l = 0;
+#if defined(AR_USE_SSE2) && !defined(_USE_DOUBLE_)
+		for( ; l+4 <= num; l += 4 )
+			modifyMatrixStep4( mb, l, cpara, vertex );
+#endif
+		for( ; l < num; l++ )
+			modifyMatrixStep( mb, l, cpara, vertex );
+
+		for( l = 0; l < num; l++ ) {
+			if( mb.center[l] ) mb.factor[l] *= 0.5;
+			for( k = 0; k < 3; k++ )
+				mb.base[k][l] = mb.best[k][l];
+		}
+	}
+
+	for( l = 0; l < num; l++ ) {
+		arGetRot( mb.best[0][l], mb.best[1][l], mb.best[2][l], rot[idx[l]] );
+		err[idx[l]] = mb.minerr[l]/4;
+	}
+
+	artkp_FrameFree( mb.center );
+	artkp_FrameFree( memory );
+}
+
+
 AR_TEMPL_FUNC ARFloat
 AR_TEMPL_TRACKER::arModifyMatrix2(ARFloat rot[3][3], ARFloat trans[3], ARFloat cpara[3][4],
 					ARFloat vertex[][3], ARFloat pos2d[][2], int num)
@@ -274,8 +543,8 @@ AR_TEMPL_TRACKER::arModifyMatrix(ARFloat rot[3][3], ARFloat trans[3], ARFloat cp
 
 	PROFILE_BEGINSEC(profiler, MODIFYMATRIX)
 
-	FIXED_VEC3D	*_vertex = (FIXED_VEC3D*)malloc(num*sizeof(FIXED_VEC3D)),
-				*_pos2d = (FIXED_VEC3D*)malloc(num*sizeof(FIXED_VEC3D)),
+	FIXED_VEC3D	*_vertex = (FIXED_VEC3D*)artkp_FrameAlloc(num*sizeof(FIXED_VEC3D)),
+				*_pos2d = (FIXED_VEC3D*)artkp_FrameAlloc(num*sizeof(FIXED_VEC3D)),
 				_combo[3], _vec1, _vec2, _trans;
 	I32			_combo3[3];
 
@@ -403,8 +672,8 @@ AR_TEMPL_TRACKER::arModifyMatrix(ARFloat rot[3][3], ARFloat trans[3], ARFloat cp
 
 	PROFILE_ENDSEC(profiler, MODIFYMATRIX_LOOP)
 
-	free(_vertex);
-	free(_pos2d);
+	artkp_FrameFree(_pos2d);
+	artkp_FrameFree(_vertex);
 
 	ma = FIXED_Fixed_n_To_Float(_ma, 12);
 	mb = FIXED_Fixed_n_To_Float(_mb, 12);
@@ -57,11 +57,13 @@ AR_TEMPL_TRACKER::arGetTransMatCont(ARMarkerInfo *marker_info, ARFloat prev_conv
     ARFloat  err1, err2;
     ARFloat wtrans[3][4];
     int     i, j;
+    MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
 
     err1 = arGetTransMatContSub(marker_info, prev_conv, center, width, conv);
     if( err1 > AR_GET_TRANS_CONT_MAT_MAX_FIT_ERROR ) {
         err2 = arGetTransMat(marker_info, center, width, wtrans);
-        if( err2 < err1 ) {
+        if( err2 >= 0 && err2 < err1 ) {
             for( j = 0; j < 3; j++ ) {
                 for( i = 0; i < 4; i++ ) conv[j][i] = wtrans[j][i];
             }
@@ -115,4 +117,81 @@ AR_TEMPL_TRACKER::arGetTransMatContSub(ARMarkerInfo *marker_info, ARFloat prev_c
 }
 
 
+// a marker counts as the same as last time if it has the same id, direction
+// and pattern and moved about as little as arDetectMarker() allows for
+// following a marker from one frame to the next.
+//
+AR_TEMPL_FUNC typename AR_TEMPL_TRACKER::PoseHistoryEntry*
+AR_TEMPL_TRACKER::Context::findPose(const ARMarkerInfo *marker_info, const ARFloat center[2], ARFloat width)
+{
+	PoseHistoryEntry *entry = NULL;
+	ARFloat rarea, rlen, dx, dy;
+	int i;
+
+	if( marker_info->id < 0 || marker_info->area <= 0 ) return NULL;
+
+	for( i = 0; i < poseHistoryNum; i++ ) {
+		if( poseHistory[i].id == marker_info->id ) {
+			entry = &poseHistory[i];
+			break;
+		}
+	}
+	if( entry == NULL ) return NULL;
+
+	if( entry->dir != marker_info->dir || entry->width != width ||
+		entry->center[0] != center[0] || entry->center[1] != center[1] ) return NULL;
+
+	rarea = (ARFloat)entry->area / (ARFloat)marker_info->area;
+	if( rarea < 0.7 || rarea > 1.43 ) return NULL;
+
+	dx = marker_info->pos[0] - entry->pos[0];
+	dy = marker_info->pos[1] - entry->pos[1];
+	rlen = (dx*dx + dy*dy) / marker_info->area;
+	if( rlen > AR_POSE_HISTORY_MAX_MOVE ) return NULL;
+
+	return entry;
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::Context::storePose(const ARMarkerInfo *marker_info, const ARFloat center[2], ARFloat width, ARFloat conv[3][4])
+{
+	PoseHistoryEntry *entry = NULL;
+	int i, j;
+
+	if( marker_info->id < 0 ) return;
+
+	for( i = 0; i < poseHistoryNum; i++ ) {
+		if( poseHistory[i].id == marker_info->id ) {
+			entry = &poseHistory[i];
+			break;
+		}
+	}
+
+	// a new id takes a free entry or the one that was not updated for the longest time
+	if( entry == NULL ) {
+		if( poseHistoryNum < AR_POSE_HISTORY_SIZE ) entry = &poseHistory[poseHistoryNum++];
+		else {
+			entry = &poseHistory[0];
+			for( i = 1; i < poseHistoryNum; i++ ) {
+				if( poseHistory[i].stamp < entry->stamp ) entry = &poseHistory[i];
+			}
+		}
+	}
+
+	entry->id = marker_info->id;
+	entry->dir = marker_info->dir;
+	entry->area = marker_info->area;
+	entry->pos[0] = marker_info->pos[0];
+	entry->pos[1] = marker_info->pos[1];
+	entry->center[0] = center[0];
+	entry->center[1] = center[1];
+	entry->width = width;
+	for( j = 0; j < 3; j++ ) {
+		for( i = 0; i < 4; i++ ) entry->trans[j][i] = conv[j][i];
+	}
+	entry->stamp = ++poseHistoryStamp;
+}
+
+
 }  // namespace ARToolKitPlus
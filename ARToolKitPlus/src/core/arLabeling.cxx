@@ -40,6 +40,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <ARToolKitPlus/Tracker.h>
 
 
@@ -54,8 +55,9 @@ put_zero( ARUint8 *p, int size )
 
 
 // in order to get no speed loss we use the preprocessor
-// to create 5 different versions of labeling2, for the
-// five different major pixel formats
+// to create 6 different versions of labeling2, for the
+// six different major pixel formats. a seventh version
+// reads the bit mask created by arBinarize_LUM()
 //
 #define _DEF_PIXEL_FORMAT_ABGR
 #define LABEL_FUNC_NAME arLabeling_ABGR
@@ -82,12 +84,22 @@ put_zero( ARUint8 *p, int size )
 #include "arLabelingImpl.hxx"
 #undef _DEF_PIXEL_FORMAT_LUM
 
+#define _DEF_PIXEL_FORMAT_YUV422
+#define LABEL_FUNC_NAME arLabeling_YUV422
+#include "arLabelingImpl.hxx"
+#undef _DEF_PIXEL_FORMAT_YUV422
+
+#define _DEF_PIXEL_FORMAT_BIN
+#define LABEL_FUNC_NAME arLabeling_BIN
+#include "arLabelingImpl.hxx"
+#undef _DEF_PIXEL_FORMAT_BIN
 
-AR_TEMPL_FUNC ARInt16*
-AR_TEMPL_TRACKER::arLabeling(ARUint8 *image, int thresh, int *label_num, int **area,
+
+AR_TEMPL_FUNC ARLabel*
+AR_TEMPL_TRACKER::arLabeling(Context* ctx, ARUint8 *image, int thresh, int *label_num, int **area,
 					ARFloat **pos, int **clip, int **label_ref )
 {
-	ARInt16* ret = NULL;
+	ARLabel* ret = NULL;
 
 	PROFILE_BEGINSEC(profiler, LABELING)
 	//ret = labeling2(image, thresh, label_num, area, pos, clip, label_ref, 1);
@@ -95,25 +107,37 @@ AR_TEMPL_TRACKER::arLabeling(ARUint8 *image, int thresh, int *label_num, int **a
 	switch(pixelFormat)
 	{
 	case PIXEL_FORMAT_ABGR:
-		ret = arLabeling_ABGR(image, thresh, label_num, area, pos, clip, label_ref);
+		ret = arLabeling_ABGR(ctx, image, thresh, label_num, area, pos, clip, label_ref);
 		break;
 
 	case PIXEL_FORMAT_BGRA:
 	case PIXEL_FORMAT_BGR:
-		ret = arLabeling_BGR(image, thresh, label_num, area, pos, clip, label_ref);
+		ret = arLabeling_BGR(ctx, image, thresh, label_num, area, pos, clip, label_ref);
 		break;
 
 	case PIXEL_FORMAT_RGBA:
 	case PIXEL_FORMAT_RGB:
-		ret = arLabeling_RGB(image, thresh, label_num, area, pos, clip, label_ref);
+		ret = arLabeling_RGB(ctx, image, thresh, label_num, area, pos, clip, label_ref);
 		break;
 
 	case PIXEL_FORMAT_RGB565:
-		ret = arLabeling_RGB565(image, thresh, label_num, area, pos, clip, label_ref);
+		ret = arLabeling_RGB565(ctx, image, thresh, label_num, area, pos, clip, label_ref);
 		break;
 
 	case PIXEL_FORMAT_LUM:
-		ret = arLabeling_LUM(image, thresh, label_num, area, pos, clip, label_ref);
+	case PIXEL_FORMAT_UYVY:
+	case PIXEL_FORMAT_YUYV:
+		if(labelingMode==LABELING_RLE || numLabelingThreads>1)
+			ret = arLabeling_RLE(ctx, image, thresh, label_num, area, pos, clip, label_ref);
+		else if(useBinarization || adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL)
+		{
+			arBinarize_LUM(ctx, image, thresh);
+			ret = arLabeling_BIN(ctx, image, thresh, label_num, area, pos, clip, label_ref);
+		}
+		else if(pixelFormat==PIXEL_FORMAT_LUM)
+			ret = arLabeling_LUM(ctx, image, thresh, label_num, area, pos, clip, label_ref);
+		else
+			ret = arLabeling_YUV422(ctx, image, thresh, label_num, area, pos, clip, label_ref);
 		break;
 	}
 
@@ -125,19 +149,19 @@ AR_TEMPL_TRACKER::arLabeling(ARUint8 *image, int thresh, int *label_num, int **a
 
 
 #if 0
-AR_TEMPL_FUNC ARInt16*
+AR_TEMPL_FUNC ARLabel*
 AR_TEMPL_TRACKER::labeling2(ARUint8 *image, int thresh, int *label_num, int **area,
 				   ARFloat **pos, int **clip, int **label_ref, int LorR)
 {
     ARUint8   *pnt;                     /*  image pointer       */
-    ARInt16   *pnt1, *pnt2;             /*  image pointer       */
+    ARLabel   *pnt1, *pnt2;             /*  image pointer       */
     int       *wk;                      /*  pointer for work    */
     int       wk_max;                   /*  work                */
     int       m,n;                      /*  work                */
     int       i,j,k;                    /*  for loop            */
     int       lxsize, lysize;
     int       poff;
-    ARInt16   *l_image;
+    ARLabel   *l_image;
     int       *work, *work2;
     int       *wlabel_num;
     int       *warea;
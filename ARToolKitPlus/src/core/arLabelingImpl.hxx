@@ -38,19 +38,19 @@
  * ======================================================================== */
 
 
-AR_TEMPL_FUNC ARInt16*
-AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, int **area,
+AR_TEMPL_FUNC ARLabel*
+AR_TEMPL_TRACKER::LABEL_FUNC_NAME(Context* ctx, ARUint8 *image, int thresh, int *label_num, int **area,
 								  ARFloat **pos, int **clip, int **label_ref)
 {
     ARUint8   *pnt;                     /*  image pointer       */
-    ARInt16   *pnt1, *pnt2;             /*  image pointer       */
+    ARLabel   *pnt1, *pnt2;             /*  image pointer       */
     int       *wk;                      /*  pointer for work    */
     int       wk_max;                   /*  work                */
     int       m,n;                      /*  work                */
     int       i,j,k;                    /*  for loop            */
     int       lxsize, lysize;
     int       poff;
-    ARInt16   *l_image;
+    ARLabel   *l_image;
     int       *work, *work2;
     int       *wlabel_num;
     int       *warea;
@@ -61,23 +61,26 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 #else
 	#pragma message(">> Performance Warning: arlabeling() optimizations disabled.")
 #endif //_!DISABLE_TP_OPTIMIZATIONS_
+#ifdef _DEF_PIXEL_FORMAT_BIN
+	ARUint32  *binRow;                  /*  mask row pointer    */
+#endif
 
 	if(pixelFormat==PIXEL_FORMAT_RGB565)
 		checkRGB565LUT();
 
 
-	assert(l_imageL && "checkImageBuffer() must be called before labeling2(). this should happen automatically in arDetectMarker() & arDetectMarkerLite()");
+	assert(ctx->l_imageL && "checkImageBuffer() must be called before labeling2(). this should happen automatically in arDetectMarker() & arDetectMarkerLite()");
 
-    l_image = &l_imageL[0];
-    work    = &workL[0];
-    work2   = &work2L[0];
-    wlabel_num = &wlabel_numL;
-    warea   = &wareaL[0];
-    wclip   = &wclipL[0];
-    wpos    = &wposL[0];
+    l_image = &ctx->l_imageL[0];
+    work    = &ctx->workL[0];
+    work2   = &ctx->work2L[0];
+    wlabel_num = &ctx->wlabel_numL;
+    warea   = &ctx->wareaL[0];
+    wclip   = &ctx->wclipL[0];
+    wpos    = &ctx->wposL[0];
 
 
-	if(pixelFormat!=PIXEL_FORMAT_RGB565 && pixelFormat!=PIXEL_FORMAT_LUM)
+	if(pixelFormat!=PIXEL_FORMAT_RGB565 && !isLumaFormat())
 		thresh *= 3;
 
     if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
@@ -105,6 +108,13 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 
     wk_max = 0;
     pnt2 = &(l_image[lxsize+1]);
+#ifdef _DEF_PIXEL_FORMAT_BIN
+	// the image has already been thresholded into binMaskL by
+	// arBinarize_LUM(), so only the mask is read below
+	assert(ctx->binMaskL && ctx->binMaskStride==((lxsize+31)>>5));
+	pnt = image;
+	poff = 0;
+#else
     if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
         pnt = &(image[(arImXsize*2+2)*pixelSize]);
         poff = pixelSize*2;
@@ -113,16 +123,23 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
         pnt = &(image[(arImXsize+1)*pixelSize]);
         poff = pixelSize;
     }
+#endif
+#ifdef _DEF_PIXEL_FORMAT_YUV422
+	// only the luminance bytes are read
+	pnt += getLumaOffset();
+#endif
 
 
 //	int diffCorners = -60,
 //		diffLeftRight = -40,
 //		difftopBottom = -20;
 
+#ifndef _DEF_PIXEL_FORMAT_BIN
+	// the bin build gets the vignetting correction from arBinarize_LUM()
 	const int shiftBits = 10;
 	int iHalf=lxsize/2, jHalf=lysize/2;
 
-	int threshFact = (pixelFormat!=PIXEL_FORMAT_RGB565 && pixelFormat!=PIXEL_FORMAT_LUM) ? 3 : 1;
+	int threshFact = (pixelFormat!=PIXEL_FORMAT_RGB565 && !isLumaFormat()) ? 3 : 1;
 
 	int corrLeftY = (vignetting.corners*threshFact)<<shiftBits,
 		dCorrLeftY = ((vignetting.leftright-vignetting.corners*threshFact)<<shiftBits)/jHalf,
@@ -130,10 +147,14 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 		dCorrCenterY = -corrCenterY/jHalf,
 		corrX = 0, dCorrX = 0,
 		corrThresh;
+#endif
 
 
 	for(j = 1; j < lysize-1; j++, pnt+=poff*2, pnt2+=2)
 	{
+#ifdef _DEF_PIXEL_FORMAT_BIN
+		binRow = ctx->binMaskL + j*ctx->binMaskStride;
+#else
 		if(vignetting.enabled)
 		{
 			corrX = corrLeftY;
@@ -149,9 +170,20 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 			corrLeftY += dCorrLeftY;
 			corrCenterY += dCorrCenterY;
 		}
+#endif
 
 		for(i = 1; i < lxsize-1; i++, pnt+=poff, pnt2++)
 		{
+#ifdef _DEF_PIXEL_FORMAT_BIN
+			if((i&31)==0 && binRow[i>>5]==0 && i+31<lxsize-1)
+			{
+				// 32 white pixels in a row: clear their labels at once
+				memset(pnt2, 0, 32*sizeof(ARLabel));
+				i += 31;
+				pnt2 += 31;
+				continue;
+			}
+#else
 			if(vignetting.enabled)
 			{
 				if(i==iHalf)
@@ -162,6 +194,7 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 			}
 			else
 				corrThresh = thresh;
+#endif
 
 			bool isBlack = false;
 
@@ -181,6 +214,12 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 #ifdef _DEF_PIXEL_FORMAT_LUM
 				isBlack = ( *pnt <= corrThresh );
 #endif
+#ifdef _DEF_PIXEL_FORMAT_YUV422
+				isBlack = ( *pnt <= corrThresh );
+#endif
+#ifdef _DEF_PIXEL_FORMAT_BIN
+				isBlack = ( (binRow[i>>5] >> (i&31)) & 1 ) != 0;
+#endif
 
 			if(isBlack) {
 				pnt1 = &(pnt2[-lxsize]);
@@ -343,8 +382,13 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
                 }
                 else {
                     wk_max++;
-                    if( wk_max > WORK_SIZE ) {
-                        return(0);
+                    if( wk_max > ctx->workSize ) {
+                        if( wk_max > AR_LABEL_MAX || !ctx->growWorkBuffers(wk_max) ) return(0);
+                        work    = &ctx->workL[0];
+                        work2   = &ctx->work2L[0];
+                        warea   = &ctx->wareaL[0];
+                        wclip   = &ctx->wclipL[0];
+                        wpos    = &ctx->wposL[0];
                     }
                     work[wk_max-1] = *pnt2 = wk_max;
 #ifdef _DISABLE_TP_OPTIMIZATIONS_
@@ -373,7 +417,9 @@ AR_TEMPL_TRACKER::LABEL_FUNC_NAME(ARUint8 *image, int thresh, int *label_num, in
 
 		}	// end for x
 		
+#ifndef _DEF_PIXEL_FORMAT_BIN
 		if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) pnt += arImXsize*pixelSize;
+#endif
 
 	}	// end for y
 
@@ -0,0 +1,356 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+#include <ARToolKitPlus/Tracker.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+
+namespace ARToolKitPlus {
+
+
+// Run-length labeling (LABELING_RLE)
+//
+// Instead of labeling every pixel, the black runs of each row are extracted
+// from the bit mask created by arBinarize_LUM() and merged with the runs of
+// the previous row via union-find (8-connectivity, as in arLabelingImpl.hxx).
+// Processing time is proportional to the number of runs rather than to the
+// number of pixels, which is a big win for mostly white images.
+//
+// The result is delivered in exactly the form arDetectMarker2() expects:
+// components are numbered in the order of their first pixel (same as the
+// per-pixel labeling), l_imageL holds the final label of every black pixel
+// and label_ref is an identity mapping. Since provisional labels are runs
+// stored in int arrays sized from the image, the work tables only hold
+// the final components.
+//
+// For multi-threaded labeling (setNumLabelingThreads()) the image is split
+// into horizontal stripes. Binarization, run extraction and union-find
+// inside a stripe run in parallel, the runs at the stripe borders are then
+// joined and the components numbered on the calling thread, and finally
+// the label image is written in parallel again. Runs of stripe s are
+// stored at index rowBegin(s)*(lxsize/2), so run indices keep the raster
+// order and the result is identical to the single-threaded one.
+
+
+static inline int
+rleCountTrailingZeros(ARUint32 nValue)
+{
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward(&idx, nValue);
+	return (int)idx;
+#elif defined(__GNUC__)
+	return __builtin_ctz(nValue);
+#else
+	int n = 0;
+	while(!(nValue & 1))  {  nValue >>= 1;  n++;  }
+	return n;
+#endif
+}
+
+
+// returns the index of the first bit >= x in a mask row that is set (nBlack==true)
+// or cleared (nBlack==false). returns nBits if there is no such bit.
+//
+static inline int
+rleFindBit(const ARUint32 *row, int x, int nBits, bool nBlack)
+{
+	while(x < nBits)
+	{
+		ARUint32 w = nBlack ? row[x>>5] : ~row[x>>5];
+
+		w &= 0xffffffffu << (x&31);
+		if(w)
+		{
+			x = (x & ~31) + rleCountTrailingZeros(w);
+			return x<nBits ? x : nBits;
+		}
+		x = (x & ~31) + 32;
+	}
+
+	return nBits;
+}
+
+
+// union-find with path halving. the root of each set is always its
+// smallest run index, so parent[i]<=i holds for all runs.
+//
+static inline int
+rleFind(int *parent, int x)
+{
+	while(parent[x]!=x)
+	{
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+
+static inline void
+rleUnion(int *parent, int a, int b)
+{
+	a = rleFind(parent, a);
+	b = rleFind(parent, b);
+
+	if(a<b)
+		parent[b] = a;
+	else if(b<a)
+		parent[a] = b;
+}
+
+
+// joins the runs [nCur0,nCur1) with the touching runs [nPrev0,nPrev1) of
+// the row above. runs touch if they overlap including diagonal neighbours.
+//
+static void
+rleConnectRows(const ARInt16 *runX, int *parent, int nPrev0, int nPrev1, int nCur0, int nCur1)
+{
+	int k = nPrev0, m, c;
+
+	for(c = nCur0; c < nCur1; c++)
+	{
+		while(k<nPrev1 && runX[k*2+1]+1 < runX[c*2+0])
+			k++;
+		for(m = k; m<nPrev1 && runX[m*2+0] <= runX[c*2+1]+1; m++)
+			rleUnion(parent, m, c);
+	}
+}
+
+
+AR_TEMPL_FUNC ARLabel*
+AR_TEMPL_TRACKER::arLabeling_RLE(Context* ctx, ARUint8 *image, int thresh, int *label_num, int **area, ARFloat **pos, int **clip, int **label_ref)
+{
+	int		lxsize, lysize, rowsPerStripe;
+	int		lab, k, x0, x1, len;
+	int		i, j, s;
+
+	assert(ctx->l_imageL && ctx->rleRunX && "checkImageBuffer() must be called before arLabeling_RLE()");
+
+	if( arImageProcMode == AR_IMAGE_PROC_IN_HALF ) {
+		lxsize = arImXsize / 2;
+		lysize = arImYsize / 2;
+	}
+	else {
+		lxsize = arImXsize;
+		lysize = arImYsize;
+	}
+
+	ctx->binMaskStride = (lxsize+31) >> 5;
+	if(adaptiveThreshold.mode==THRESH_ADAPTIVE_LOCAL)
+		arBuildIntegralImage_LUM(ctx, image);
+
+	ctx->rleImage = image;
+	ctx->rleThresh = thresh;
+
+
+	// binarize and label all stripes independently
+	//
+	// a failed start is not retried until the thread count changes,
+	// the pool then runs all stripes on this thread
+	if(ctx->labelingPool.getNumRequested()!=numLabelingThreads)
+		if(!ctx->labelingPool.start(numLabelingThreads) && logger)
+			logger->artLogEx("ARToolKitPlus: failed to start %d labeling threads, labeling single threaded", numLabelingThreads);
+
+	ctx->rleNumStripes = ctx->labelingPool.getNumThreads();
+	if(ctx->rleNumStripes>lysize/4)
+		ctx->rleNumStripes = lysize/4>0 ? lysize/4 : 1;
+	rowsPerStripe = (lysize+ctx->rleNumStripes-1)/ctx->rleNumStripes;
+
+	for(s = 0; s < ctx->rleNumStripes; s++)
+	{
+		ctx->rleStripeRow[s] = s*rowsPerStripe;
+		ctx->rleStripeRow[s+1] = (s+1)*rowsPerStripe<lysize ? (s+1)*rowsPerStripe : lysize;
+	}
+
+	ctx->labelingPool.run(rleExtractStripeTask, ctx, ctx->rleNumStripes);
+
+
+	// join the runs along the stripe borders
+	//
+	for(s = 1; s < ctx->rleNumStripes; s++)
+	{
+		j = ctx->rleStripeRow[s];
+		if(j>=1 && j<lysize-1)
+			rleConnectRows(ctx->rleRunX, ctx->rleParent, ctx->rleRowStart[j-1], ctx->rleRowEnd[j-1], ctx->rleRowStart[j], ctx->rleRowEnd[j]);
+	}
+
+
+	// number the components in the order of their first run. roots get
+	// their negative label, all other runs copy it from their parent which
+	// has a smaller index and was therefore already resolved.
+	// the statistics are collected in the same pass, the coordinate sums
+	// as integers in work2L.
+	//
+	lab = 0;
+	for(j = 1; j < lysize-1; j++)
+	{
+		for(i = ctx->rleRowStart[j]; i < ctx->rleRowEnd[j]; i++)
+		{
+			k = ctx->rleParent[i];
+			if(k==i)
+			{
+				if(lab >= ctx->workSize && (lab >= AR_LABEL_MAX || !ctx->growWorkBuffers(lab+1)))
+					return(0);
+				ctx->rleParent[i] = -(++lab);
+
+				ctx->wareaL[lab-1] = 0;
+				ctx->work2L[(lab-1)*2+0] = ctx->work2L[(lab-1)*2+1] = 0;
+				ctx->wclipL[(lab-1)*4+0] = lxsize;
+				ctx->wclipL[(lab-1)*4+1] = 0;
+				ctx->wclipL[(lab-1)*4+2] = lysize;
+				ctx->wclipL[(lab-1)*4+3] = 0;
+				ctx->workL[lab-1] = lab;
+			}
+			else
+				ctx->rleParent[i] = ctx->rleParent[k];
+
+			x0 = ctx->rleRunX[i*2+0];
+			x1 = ctx->rleRunX[i*2+1];
+			len = x1-x0+1;
+			k = -ctx->rleParent[i]-1;
+
+			ctx->wareaL[k] += len;
+			ctx->work2L[k*2+0] += ((x0+x1)*len)/2;
+			ctx->work2L[k*2+1] += j*len;
+			if(ctx->wclipL[k*4+0] > x0) ctx->wclipL[k*4+0] = x0;
+			if(ctx->wclipL[k*4+1] < x1) ctx->wclipL[k*4+1] = x1;
+			if(ctx->wclipL[k*4+2] > j)  ctx->wclipL[k*4+2] = j;
+			if(ctx->wclipL[k*4+3] < j)  ctx->wclipL[k*4+3] = j;
+		}
+	}
+
+	for(i = 0; i < lab; i++) {
+		ctx->wposL[i*2+0] = (ARFloat)ctx->work2L[i*2+0] / ctx->wareaL[i];
+		ctx->wposL[i*2+1] = (ARFloat)ctx->work2L[i*2+1] / ctx->wareaL[i];
+	}
+
+	*label_num = ctx->wlabel_numL = lab;
+
+
+	// write the label image
+	//
+	ctx->labelingPool.run(rleFillStripeTask, ctx, ctx->rleNumStripes);
+
+	*label_ref = ctx->workL;
+	*area      = ctx->wareaL;
+	*pos       = ctx->wposL;
+	*clip      = ctx->wclipL;
+	return( ctx->l_imageL );
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::rleExtractStripeTask(void* nContext, int nStripe)
+{
+	Context				*ctx = reinterpret_cast<Context*>(nContext);
+	AR_TEMPL_TRACKER	*self = ctx->tracker;
+	const ARUint32		*row;
+	int					lxsize, j0, j1, numRuns;
+	int					x, x0, x1, j;
+
+	lxsize = self->arImageProcMode==AR_IMAGE_PROC_IN_HALF ? self->arImXsize/2 : self->arImXsize;
+	j0 = ctx->rleStripeRow[nStripe];
+	j1 = ctx->rleStripeRow[nStripe+1];
+
+	self->arBinarizeRows_LUM(ctx, ctx->rleImage, ctx->rleThresh, j0, j1, ctx->binRowThresh + nStripe*ctx->l_imageL_width);
+
+	numRuns = j0*(lxsize/2);
+
+	for(j = j0; j < j1; j++)
+	{
+		row = ctx->binMaskL + j*ctx->binMaskStride;
+		ctx->rleRowStart[j] = numRuns;
+
+		for(x = 1;;)
+		{
+			x0 = rleFindBit(row, x, lxsize, true);
+			if(x0>=lxsize)
+				break;
+			x1 = rleFindBit(row, x0, lxsize, false) - 1;
+			x = x1+2;
+
+			assert(numRuns<ctx->rleRunsMax);
+			ctx->rleRunX[numRuns*2+0] = (ARInt16)x0;
+			ctx->rleRunX[numRuns*2+1] = (ARInt16)x1;
+			ctx->rleParent[numRuns] = numRuns;
+			numRuns++;
+		}
+
+		ctx->rleRowEnd[j] = numRuns;
+
+		if(j>j0)
+			rleConnectRows(ctx->rleRunX, ctx->rleParent, ctx->rleRowStart[j-1], ctx->rleRowEnd[j-1], ctx->rleRowStart[j], numRuns);
+	}
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::rleFillStripeTask(void* nContext, int nStripe)
+{
+	Context				*ctx = reinterpret_cast<Context*>(nContext);
+	AR_TEMPL_TRACKER	*self = ctx->tracker;
+	ARLabel				*pnt;
+	int					lxsize, j0, j1, i, j, x, len;
+
+	lxsize = self->arImageProcMode==AR_IMAGE_PROC_IN_HALF ? self->arImXsize/2 : self->arImXsize;
+	j0 = ctx->rleStripeRow[nStripe];
+	j1 = ctx->rleStripeRow[nStripe+1];
+
+	memset(ctx->l_imageL + j0*lxsize, 0, (j1-j0)*lxsize*sizeof(ARLabel));
+
+	for(j = j0; j < j1; j++)
+	{
+		for(i = ctx->rleRowStart[j]; i < ctx->rleRowEnd[j]; i++)
+		{
+			pnt = ctx->l_imageL + j*lxsize + ctx->rleRunX[i*2+0];
+			len = ctx->rleRunX[i*2+1] - ctx->rleRunX[i*2+0] + 1;
+
+			for(x = 0; x < len; x++)
+				pnt[x] = (ARLabel)(-ctx->rleParent[i]);
+		}
+	}
+}
+
+
+}  // namespace ARToolKitPlus
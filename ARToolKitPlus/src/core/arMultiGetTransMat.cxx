@@ -74,6 +74,8 @@ AR_TEMPL_TRACKER::arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
     int                   max, max_area = 0, max_marker, vnum;
     int                   dir;
     int                   i, j, k;
+    MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
 
     if( config->prevF ) {
         verify_markers( marker_info, marker_num, config );
@@ -126,8 +128,8 @@ AR_TEMPL_TRACKER::arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
         return -1;
     }
 
-    arMalloc(pos2d, ARFloat, vnum*4*2);
-    arMalloc(pos3d, ARFloat, vnum*4*3);
+    arFrameMalloc(pos2d, ARFloat, vnum*4*2);
+    arFrameMalloc(pos3d, ARFloat, vnum*4*3);
 
     j = 0;
     for( i = 0; i < config->marker_num; i++ ) {
@@ -172,8 +174,8 @@ AR_TEMPL_TRACKER::arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
 
         if( err < THRESH_2 ) {
             config->prevF = 1;
-            free(pos3d);
-            free(pos2d);
+            artkp_FrameFree(pos3d);
+            artkp_FrameFree(pos2d);
             return err;
         }
     }
@@ -207,8 +209,8 @@ AR_TEMPL_TRACKER::arMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
         config->prevF = 0;
     }
 
-    free(pos3d);
-    free(pos2d);
+    artkp_FrameFree(pos3d);
+    artkp_FrameFree(pos2d);
     return err;
 }
 
@@ -226,7 +228,7 @@ AR_TEMPL_TRACKER::verify_markers(ARMarkerInfo *marker_info, int marker_num, ARMu
     int                            w1, w2;
     int                            i, j, k;
 
-    arMalloc(winfo,arMultiEachMarkerInternalInfoT,config->marker_num);
+    arFrameMalloc(winfo,arMultiEachMarkerInternalInfoT,config->marker_num);
 
     for( i = 0; i < config->marker_num; i++ ) {
 		arUtilMatMul(config->trans, config->marker[i].trans, wtrans);
@@ -355,7 +357,7 @@ printf("\n");
 	printf("w1,w2 = %d,%d\n", w1, w2);
 #endif
     if( w2 >= w1 ) {
-        free(winfo);
+        artkp_FrameFree(winfo);
         return -1;
     }
 
@@ -370,7 +372,7 @@ printf("\n");
         }
     }
 
-    free(winfo);
+    artkp_FrameFree(winfo);
 
     return 0;
 }
@@ -68,10 +68,17 @@ AR_TEMPL_TRACKER::arInitCparam(Camera *pCam)
 	//
 	if(undistO2ITable && (arImXsize!=pCam->xsize || arImYsize!=pCam->ysize))
 	{
-		artkp_Free(undistO2ITable);
+		freeUndistTable(undistO2ITable);
 		undistO2ITable = NULL;
 	}
 
+	// the grid is cheap to build, so it is always rebuilt (in arParamObserv2Ideal_grid)
+	if(undistGrid)
+	{
+		freeUndistTable(undistGrid);
+		undistGrid = NULL;
+	}
+
 	arImXsize = pCam->xsize;
 	arImYsize = pCam->ysize;
 
@@ -79,10 +86,60 @@ AR_TEMPL_TRACKER::arInitCparam(Camera *pCam)
 }
 
 
+// fits line (a*x + b*y + c = 0, a^2+b^2=1) to the principal axis of a set of
+// weighted points given by their moments. the moments are relative to (x0,y0).
+static int
+arLineFromMoments( double sw, double sx, double sy, double sxx, double sxy, double syy,
+                   ARFloat x0, ARFloat y0, ARFloat line[3] )
+{
+    double mx = sx / sw, my = sy / sw;
+    double cxx = sxx / sw - mx*mx;
+    double cxy = sxy / sw - mx*my;
+    double cyy = syy / sw - my*my;
+
+    // largest eigenvalue of [cxx cxy; cxy cyy] and its eigenvector, taken
+    // from whichever row of (C - l*I) is better conditioned
+    double h  = (cxx - cyy) * 0.5;
+    double l  = (cxx + cyy) * 0.5 + sqrt( h*h + cxy*cxy );
+    double ex, ey;
+    if( cxx >= cyy ) { ex = l - cyy;  ey = cxy; }
+    else             { ex = cxy;      ey = l - cxx; }
+    double len = sqrt( ex*ex + ey*ey );
+    if( len == 0.0 ) return(-1);
+
+    line[0] =  (ARFloat)(ey / len);
+    line[1] = (ARFloat)(-ex / len);
+    line[2] = -(line[0]*(ARFloat)(x0 + mx) + line[1]*(ARFloat)(y0 + my));
+
+    return(0);
+}
+
+// intersects neighbouring edge lines to get the marker's vertices
+static int
+arLineIntersections( ARFloat line[4][3], ARFloat v[4][2] )
+{
+    ARFloat   w1;
+    int      i;
+
+    for( i = 0; i < 4; i++ ) {
+        w1 = line[(i+3)%4][0] * line[i][1] - line[i][0] * line[(i+3)%4][1];
+        if( w1 == 0.0 ) return(-1);
+        v[i][0] = (  line[(i+3)%4][1] * line[i][2]
+                   - line[i][1] * line[(i+3)%4][2] ) / w1;
+        v[i][1] = (  line[i][0] * line[(i+3)%4][2]
+                   - line[(i+3)%4][0] * line[i][2] ) / w1;
+    }
+
+    return(0);
+}
+
+
 AR_TEMPL_FUNC int
 AR_TEMPL_TRACKER::arGetLine(int x_coord[], int y_coord[], int coord_num, int vertex[], ARFloat line[4][3], ARFloat v[4][2])
 {
     //return arGetLine2( x_coord, y_coord, coord_num, vertex, line, v, arParam.dist_factor );
+	if(undistMode==UNDIST_SAMPLED)
+		return arGetLineSampled( x_coord, y_coord, coord_num, vertex, line, v, arCamera );
 	return arGetLine2( x_coord, y_coord, coord_num, vertex, line, v, arCamera );
 }
 
@@ -91,6 +148,7 @@ AR_TEMPL_FUNC int
 AR_TEMPL_TRACKER::arGetLine2(int x_coord[], int y_coord[], int coord_num,
                     int vertex[], ARFloat line[4][3], ARFloat v[4][2], Camera *pCam) 
 {
+#ifdef _USE_PCA_LINE_FIT_
     ARMat    *input, *evec;
     ARVec    *ev, *mean;
     ARFloat   w1;
@@ -127,16 +185,101 @@ AR_TEMPL_TRACKER::arGetLine2(int x_coord[], int y_coord[], int coord_num,
     Vector::free( mean );
     Vector::free( ev );
 
+#else
+    ARFloat   w1;
+    int      st, ed, n;
+    int      i, j;
+
+	// each edge is fitted with the principal axis of the 2x2 covariance of its
+	// undistorted points. the sums are gathered in a single pass (relative to the
+	// first point, to keep the one-pass variance well conditioned) and the
+	// eigenvector is taken in closed form, so no matrices are allocated.
+	//
     for( i = 0; i < 4; i++ ) {
-        w1 = line[(i+3)%4][0] * line[i][1] - line[i][0] * line[(i+3)%4][1];
-        if( w1 == 0.0 ) return(-1);
-        v[i][0] = (  line[(i+3)%4][1] * line[i][2]
-                   - line[i][1] * line[(i+3)%4][2] ) / w1;
-        v[i][1] = (  line[i][0] * line[(i+3)%4][2]
-                   - line[(i+3)%4][0] * line[i][2] ) / w1;
+        w1 = (ARFloat)(vertex[i+1]-vertex[i]+1) * (ARFloat)0.05 + (ARFloat)0.5;
+        st = (int)(vertex[i]   + w1);
+        ed = (int)(vertex[i+1] - w1);
+        n = ed - st + 1;
+        if( n < 2 ) return(-1);
+
+        ARFloat  x0, y0, ix, iy;
+        double   sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0;
+
+        (this->*arParamObserv2Ideal_func)( pCam, (ARFloat)x_coord[st], (ARFloat)y_coord[st], &x0, &y0 );
+        for( j = 1; j < n; j++ ) {
+            (this->*arParamObserv2Ideal_func)( pCam, (ARFloat)x_coord[st+j], (ARFloat)y_coord[st+j], &ix, &iy );
+            double dx = ix - x0, dy = iy - y0;
+            sx  += dx;     sy  += dy;
+            sxx += dx*dx;  sxy += dx*dy;  syy += dy*dy;
+        }
+
+        if( arLineFromMoments(n, sx, sy, sxx, sxy, syy, x0, y0, line[i]) < 0 ) return(-1);
     }
+#endif //_USE_PCA_LINE_FIT_
 
-    return(0);
+    return arLineIntersections( line, v );
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arGetLineSampled(int x_coord[], int y_coord[], int coord_num,
+                    int vertex[], ARFloat line[4][3], ARFloat v[4][2], Camera *pCam) 
+{
+    ARFloat   ox[4*AR_UNDIST_EDGE_SAMPLES], oy[4*AR_UNDIST_EDGE_SAMPLES];
+    ARFloat   ix[4*AR_UNDIST_EDGE_SAMPLES], iy[4*AR_UNDIST_EDGE_SAMPLES];
+    int       wt[4*AR_UNDIST_EDGE_SAMPLES];
+    int       first[5];
+    ARFloat   w1;
+    int      st, ed, n, k, num;
+    int      i, j, s;
+
+	// the contour pixels of each edge are split into (at most) AR_UNDIST_EDGE_SAMPLES
+	// runs and only the centroid of each run is undistorted. that way the number of
+	// (expensive) undistortions per marker does not depend on its size, while the
+	// centroids still follow the curvature of the distorted edge.
+	//
+    num = 0;
+    for( i = 0; i < 4; i++ ) {
+        w1 = (ARFloat)(vertex[i+1]-vertex[i]+1) * (ARFloat)0.05 + (ARFloat)0.5;
+        st = (int)(vertex[i]   + w1);
+        ed = (int)(vertex[i+1] - w1);
+        n = ed - st + 1;
+        if( n < 2 ) return(-1);
+
+        k = (n < AR_UNDIST_EDGE_SAMPLES) ? n : AR_UNDIST_EDGE_SAMPLES;
+        first[i] = num;
+        for( s = 0; s < k; s++ ) {
+            int  a = st + s*n/k, b = st + (s+1)*n/k;
+            int  sx = 0, sy = 0;
+            for( j = a; j < b; j++ ) {
+                sx += x_coord[j];
+                sy += y_coord[j];
+            }
+            ox[num] = (ARFloat)sx / (b-a);
+            oy[num] = (ARFloat)sy / (b-a);
+            wt[num] = b-a;
+            num++;
+        }
+    }
+    first[4] = num;
+
+    pCam->observ2IdealBatch( num, ox, oy, ix, iy );
+
+    for( i = 0; i < 4; i++ ) {
+        ARFloat  x0 = ix[first[i]], y0 = iy[first[i]];
+        double   sw = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0;
+
+        for( j = first[i]; j < first[i+1]; j++ ) {
+            double w = wt[j], dx = ix[j] - x0, dy = iy[j] - y0;
+            sw  += w;
+            sx  += w*dx;     sy  += w*dy;
+            sxx += w*dx*dx;  sxy += w*dx*dy;  syy += w*dy*dy;
+        }
+
+        if( arLineFromMoments(sw, sx, sy, sxx, sxy, syy, x0, y0, line[i]) < 0 ) return(-1);
+    }
+
+    return arLineIntersections( line, v );
 }
 
 AR_TEMPL_FUNC int
@@ -0,0 +1,494 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology,
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <ARToolKitPlus/Tracker.h>
+#include <ARToolKitPlus/matrix.h>
+
+
+// Infinitesimal Plane-based Pose Estimation (IPPE), see T. Collins and
+// A. Bartoli: "Infinitesimal Plane-Based Pose Estimation", IJCV 2014.
+//
+// the homography between the marker plane and the normalized image is
+// decomposed at the marker center in closed form. this gives the two
+// poses a planar target can have (the well known pose ambiguity) without
+// any iteration, so the cost does not depend on the view.
+
+
+namespace ARToolKitPlus {
+
+
+// solves A x = b for n unknowns by gaussian elimination with partial
+// pivoting. A and b are overwritten, b receives x.
+static bool
+ippeSolve(double *A, double *b, int n)
+{
+	int i, j, k;
+
+	for(k=0; k<n; k++)
+	{
+		int p = k;
+		for(i=k+1; i<n; i++)
+			if(fabs(A[i*n+k]) > fabs(A[p*n+k]))
+				p = i;
+		if(fabs(A[p*n+k]) < 1e-12)
+			return false;
+
+		if(p!=k)
+		{
+			for(j=k; j<n; j++)
+			{
+				double tmp = A[k*n+j];  A[k*n+j] = A[p*n+j];  A[p*n+j] = tmp;
+			}
+			double tmp = b[k];  b[k] = b[p];  b[p] = tmp;
+		}
+
+		for(i=k+1; i<n; i++)
+		{
+			double f = A[i*n+k] / A[k*n+k];
+			for(j=k+1; j<n; j++)
+				A[i*n+j] -= f*A[k*n+j];
+			b[i] -= f*b[k];
+		}
+	}
+
+	for(k=n-1; k>=0; k--)
+	{
+		for(j=k+1; j<n; j++)
+			b[k] -= A[k*n+j]*b[j];
+		b[k] /= A[k*n+k];
+	}
+
+	return true;
+}
+
+
+// the two rotations of a plane that is seen at the normalized image point
+// v with the jacobian J of the plane to image homography at that point
+static bool
+ippeRotations(const double v[2], const double J[2][2], double R1[3][3], double R2[3][3])
+{
+	double Rv[3][3] = { {1,0,0}, {0,1,0}, {0,0,1} };
+	double B[2][2], A[2][2], R22[2][2];
+	double t = sqrt(v[0]*v[0] + v[1]*v[1]);
+	int i, j, k;
+
+	// Rv rotates the optical axis onto the ray through v
+	if(t > 1e-12)
+	{
+		double s = sqrt(v[0]*v[0] + v[1]*v[1] + 1.0);
+		double costh = 1.0/s, sinth = sqrt(1.0 - 1.0/(s*s));
+		double K[3][3] = { {0,0,v[0]/t}, {0,0,v[1]/t}, {-v[0]/t,-v[1]/t,0} };
+
+		for(i=0; i<3; i++)
+			for(j=0; j<3; j++)
+			{
+				double K2 = 0.0;
+				for(k=0; k<3; k++)
+					K2 += K[i][k]*K[k][j];
+				Rv[i][j] += sinth*K[i][j] + (1.0-costh)*K2;
+			}
+	}
+
+	for(i=0; i<2; i++)
+		for(j=0; j<2; j++)
+			B[i][j] = Rv[i][j] - v[i]*Rv[2][j];
+
+	double det = B[0][0]*B[1][1] - B[0][1]*B[1][0];
+	if(fabs(det) < 1e-12)
+		return false;
+
+	A[0][0] = ( B[1][1]*J[0][0] - B[0][1]*J[1][0]) / det;
+	A[0][1] = ( B[1][1]*J[0][1] - B[0][1]*J[1][1]) / det;
+	A[1][0] = (-B[1][0]*J[0][0] + B[0][0]*J[1][0]) / det;
+	A[1][1] = (-B[1][0]*J[0][1] + B[0][0]*J[1][1]) / det;
+
+	// largest singular value of A
+	double a00 = A[0][0]*A[0][0] + A[0][1]*A[0][1];
+	double a01 = A[0][0]*A[1][0] + A[0][1]*A[1][1];
+	double a11 = A[1][0]*A[1][0] + A[1][1]*A[1][1];
+	double gamma = sqrt(0.5*(a00 + a11 + sqrt((a00-a11)*(a00-a11) + 4.0*a01*a01)));
+	if(gamma < 1e-12)
+		return false;
+
+	for(i=0; i<2; i++)
+		for(j=0; j<2; j++)
+			R22[i][j] = A[i][j]/gamma;
+
+	// complete the upper left 2x2 block to the two rotations
+	double h00 = 1.0 - R22[0][0]*R22[0][0] - R22[1][0]*R22[1][0];
+	double h01 =     - R22[0][0]*R22[0][1] - R22[1][0]*R22[1][1];
+	double h11 = 1.0 - R22[0][1]*R22[0][1] - R22[1][1]*R22[1][1];
+	double b0 = sqrt(h00 > 0.0 ? h00 : 0.0);
+	double b1 = sqrt(h11 > 0.0 ? h11 : 0.0);
+	if(h01 < 0.0)
+		b1 = -b1;
+
+	double c0 = R22[1][0]*b1 - b0*R22[1][1];
+	double c1 = b0*R22[0][1] - R22[0][0]*b1;
+	double a  = R22[0][0]*R22[1][1] - R22[1][0]*R22[0][1];
+
+	const double M1[3][3] = { {R22[0][0], R22[0][1],  c0}, {R22[1][0], R22[1][1],  c1}, { b0,  b1, a} };
+	const double M2[3][3] = { {R22[0][0], R22[0][1], -c0}, {R22[1][0], R22[1][1], -c1}, {-b0, -b1, a} };
+
+	for(i=0; i<3; i++)
+		for(j=0; j<3; j++)
+		{
+			R1[i][j] = R2[i][j] = 0.0;
+			for(k=0; k<3; k++)
+			{
+				R1[i][j] += Rv[i][k]*M1[k][j];
+				R2[i][j] += Rv[i][k]*M2[k][j];
+			}
+		}
+
+	return true;
+}
+
+
+// least squares translation for the rotation R: plane points q (z=0) and
+// normalized image points u, the 3x3 normal equations are solved directly
+static void
+ippeTranslation(const double R[3][3], const double *q, const double *u, int num, double t[3])
+{
+	double a02 = 0.0, a12 = 0.0, a22 = 0.0, b0 = 0.0, b1 = 0.0, b2 = 0.0;
+
+	for(int i=0; i<num; i++)
+	{
+		const double ux = u[i*2+0], uy = u[i*2+1];
+		const double X0 = R[0][0]*q[i*2+0] + R[0][1]*q[i*2+1];
+		const double X1 = R[1][0]*q[i*2+0] + R[1][1]*q[i*2+1];
+		const double X2 = R[2][0]*q[i*2+0] + R[2][1]*q[i*2+1];
+		const double r0 = ux*X2 - X0, r1 = uy*X2 - X1;
+
+		a02 -= ux;
+		a12 -= uy;
+		a22 += ux*ux + uy*uy;
+		b0 += r0;
+		b1 += r1;
+		b2 -= ux*r0 + uy*r1;
+	}
+
+	t[2] = (b2 - (a02*b0 + a12*b1)/num) / (a22 - (a02*a02 + a12*a12)/num);
+	t[0] = (b0 - a02*t[2])/num;
+	t[1] = (b1 - a12*t[2])/num;
+}
+
+
+// like arGetTransMatSub() the points are fitted in the ideal (undistorted)
+// image by default. with AR_FITTING_TO_INPUT they are distorted back and
+// fitted where they were observed, the error is measured there as well.
+//
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::ippeGetTransMatSub(ARFloat ppos2d[][2], ARFloat pos3d[][2], int num, ARFloat conv[2][3][4], ARFloat err[2])
+{
+	const ARFloat (*P)[4] = arCamera->mat;
+	ARFloat (*pos2d)[2] = ppos2d;
+	double *q, *u, *A, b[8];
+	double mq[2] = {0,0}, mu[2] = {0,0}, sq = 0.0, su = 0.0;
+	double H[3][3], v[2], J[2][2], R[2][3][3], t[3];
+	int i, j, k;
+	MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
+	if(num < 4)
+		return -1;
+
+	if(arFittingMode == AR_FITTING_TO_INPUT)
+	{
+		pos2d = (ARFloat (*)[2])artkp_FrameAlloc(sizeof(ARFloat)*2*num);
+		for(i=0; i<num; i++)
+			arParamIdeal2Observ_std(arCamera, ppos2d[i][0], ppos2d[i][1], &pos2d[i][0], &pos2d[i][1]);
+	}
+
+	arFrameMalloc(q, double, num*4);
+	arFrameMalloc(A, double, 64);
+	u = q + num*2;
+
+	// plane points relative to their center, image points normalized
+	for(i=0; i<num; i++)
+	{
+		u[i*2+1] = (pos2d[i][1] - P[1][2]) / P[1][1];
+		u[i*2+0] = (pos2d[i][0] - P[0][2] - P[0][1]*u[i*2+1]) / P[0][0];
+		mq[0] += pos3d[i][0];  mq[1] += pos3d[i][1];
+		mu[0] += u[i*2+0];     mu[1] += u[i*2+1];
+	}
+	mq[0] /= num;  mq[1] /= num;
+	mu[0] /= num;  mu[1] /= num;
+
+	for(i=0; i<num; i++)
+	{
+		q[i*2+0] = pos3d[i][0] - mq[0];
+		q[i*2+1] = pos3d[i][1] - mq[1];
+		sq += q[i*2+0]*q[i*2+0] + q[i*2+1]*q[i*2+1];
+		su += (u[i*2+0]-mu[0])*(u[i*2+0]-mu[0]) + (u[i*2+1]-mu[1])*(u[i*2+1]-mu[1]);
+	}
+	if(sq <= 0.0 || su <= 0.0)
+	{
+		artkp_FrameFree(A);
+		artkp_FrameFree(q);
+		if(pos2d != ppos2d)
+			artkp_FrameFree(pos2d);
+		return -1;
+	}
+	sq = sqrt(num/sq);
+	su = sqrt(num/su);
+
+	// homography from the scaled plane to the scaled image (h22 = 1),
+	// exact for four points, least squares for more
+	memset(A, 0, sizeof(double)*64);
+	memset(b, 0, sizeof(b));
+	for(i=0; i<num; i++)
+	{
+		const double ax = sq*q[i*2+0], ay = sq*q[i*2+1];
+		const double bx = su*(u[i*2+0]-mu[0]), by = su*(u[i*2+1]-mu[1]);
+		const double r0[8] = { ax, ay, 1, 0, 0, 0, -ax*bx, -ay*bx };
+		const double r1[8] = { 0, 0, 0, ax, ay, 1, -ax*by, -ay*by };
+
+		for(j=0; j<8; j++)
+		{
+			for(k=0; k<8; k++)
+				A[j*8+k] += r0[j]*r0[k] + r1[j]*r1[k];
+			b[j] += r0[j]*bx + r1[j]*by;
+		}
+	}
+	if(!ippeSolve(A, b, 8))
+	{
+		artkp_FrameFree(A);
+		artkp_FrameFree(q);
+		if(pos2d != ppos2d)
+			artkp_FrameFree(pos2d);
+		return -1;
+	}
+
+	// undo the scaling: H maps the centered plane to the normalized image
+	for(j=0; j<3; j++)
+	{
+		const double s = j<2 ? sq : 1.0;
+		const double h2 = (j<2 ? b[6+j] : 1.0) * s;
+		H[0][j] = b[0+j]*s/su + mu[0]*h2;
+		H[1][j] = b[3+j]*s/su + mu[1]*h2;
+		H[2][j] = h2;
+	}
+
+	// image of the plane center and the jacobian there
+	v[0] = H[0][2];
+	v[1] = H[1][2];
+	J[0][0] = H[0][0] - H[2][0]*H[0][2];
+	J[0][1] = H[0][1] - H[2][1]*H[0][2];
+	J[1][0] = H[1][0] - H[2][0]*H[1][2];
+	J[1][1] = H[1][1] - H[2][1]*H[1][2];
+
+	if(!ippeRotations(v, J, R[0], R[1]))
+	{
+		artkp_FrameFree(A);
+		artkp_FrameFree(q);
+		if(pos2d != ppos2d)
+			artkp_FrameFree(pos2d);
+		return -1;
+	}
+
+	for(k=0; k<2; k++)
+	{
+		ippeTranslation(R[k], q, u, num, t);
+
+		// back from the plane center to the plane origin
+		for(i=0; i<3; i++)
+		{
+			conv[k][i][3] = (ARFloat)(t[i] - R[k][i][0]*mq[0] - R[k][i][1]*mq[1]);
+			for(j=0; j<3; j++)
+				conv[k][i][j] = (ARFloat)R[k][i][j];
+		}
+
+		// mean squared reprojection error, as in arGetTransMat()
+		err[k] = 0;
+		for(i=0; i<num; i++)
+		{
+			ARFloat X[3];
+			for(j=0; j<3; j++)
+				X[j] = conv[k][j][0]*pos3d[i][0] + conv[k][j][1]*pos3d[i][1] + conv[k][j][3];
+
+			const ARFloat h = P[2][0]*X[0] + P[2][1]*X[1] + P[2][2]*X[2] + P[2][3];
+			const ARFloat x = (P[0][0]*X[0] + P[0][1]*X[1] + P[0][2]*X[2] + P[0][3]) / h;
+			const ARFloat y = (P[1][0]*X[0] + P[1][1]*X[1] + P[1][2]*X[2] + P[1][3]) / h;
+			err[k] += (pos2d[i][0]-x)*(pos2d[i][0]-x) + (pos2d[i][1]-y)*(pos2d[i][1]-y);
+		}
+		err[k] /= num;
+	}
+
+	if(err[1] < err[0])
+	{
+		ARFloat tmp[3][4];
+		memcpy(tmp, conv[0], sizeof(tmp));
+		memcpy(conv[0], conv[1], sizeof(tmp));
+		memcpy(conv[1], tmp, sizeof(tmp));
+
+		const ARFloat e = err[0];  err[0] = err[1];  err[1] = e;
+	}
+
+	artkp_FrameFree(A);
+	artkp_FrameFree(q);
+	if(pos2d != ppos2d)
+		artkp_FrameFree(pos2d);
+	return 2;
+}
+
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::ippeGetTransMats(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[2][3][4], ARFloat err[2])
+{
+	ARFloat pos2d[4][2], pos3d[4][2];
+	const int dir = marker_info->dir;
+
+	for(int i=0; i<4; i++)
+	{
+		pos2d[i][0] = marker_info->vertex[(4-dir+i)%4][0];
+		pos2d[i][1] = marker_info->vertex[(4-dir+i)%4][1];
+	}
+
+	pos3d[0][0] = center[0] - width*(ARFloat)0.5;
+	pos3d[0][1] = center[1] + width*(ARFloat)0.5;
+	pos3d[1][0] = center[0] + width*(ARFloat)0.5;
+	pos3d[1][1] = center[1] + width*(ARFloat)0.5;
+	pos3d[2][0] = center[0] + width*(ARFloat)0.5;
+	pos3d[2][1] = center[1] - width*(ARFloat)0.5;
+	pos3d[3][0] = center[0] - width*(ARFloat)0.5;
+	pos3d[3][1] = center[1] - width*(ARFloat)0.5;
+
+	return ippeGetTransMatSub(pos2d, pos3d, 4, conv, err);
+}
+
+
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::ippeGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])
+{
+	ARFloat convs[2][3][4], errs[2];
+
+	if(ippeGetTransMats(marker_info, center, width, convs, errs) < 0)
+		return -1;
+
+	memcpy(conv, convs[0], sizeof(ARFloat)*12);
+	return errs[0];
+}
+
+
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::ippeMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num, ARMultiMarkerInfoT *config)
+{
+	ARFloat (*pos2d)[2], (*pos3d)[2];
+	ARFloat convs[2][3][4], errs[2];
+	int i, j, k, vnum;
+	MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
+	// IPPE needs all corners in one plane of the config, otherwise
+	// let arMultiGetTransMat() combine the single marker poses
+	const ARFloat z = config->marker_num>0 ? config->marker[0].pos3d[0][2] : 0;
+	for(i=0; i<config->marker_num; i++)
+		for(j=0; j<4; j++)
+			if(config->marker[i].pos3d[j][2] != z)
+				return arMultiGetTransMat(marker_info, marker_num, config);
+
+	if( config->prevF ) {
+		verify_markers( marker_info, marker_num, config );
+	}
+
+	vnum = 0;
+	for(i=0; i<config->marker_num; i++)
+	{
+		k = -1;
+		for(j=0; j<marker_num; j++)
+		{
+			if(marker_info[j].id != config->marker[i].patt_id) continue;
+			if(marker_info[j].cf < 0.70) continue;
+
+			if(k == -1) k = j;
+			else if(marker_info[k].cf < marker_info[j].cf) k = j;
+		}
+		if((config->marker[i].visible=k) != -1)
+			vnum++;
+	}
+	if(vnum == 0)
+	{
+		config->prevF = 0;
+		return -1;
+	}
+
+	pos2d = (ARFloat (*)[2])artkp_FrameAlloc(sizeof(ARFloat)*2*vnum*4);
+	pos3d = (ARFloat (*)[2])artkp_FrameAlloc(sizeof(ARFloat)*2*vnum*4);
+
+	j = 0;
+	for(i=0; i<config->marker_num; i++)
+	{
+		if((k=config->marker[i].visible) < 0) continue;
+
+		const int dir = marker_info[k].dir;
+		for(int c=0; c<4; c++, j++)
+		{
+			pos2d[j][0] = marker_info[k].vertex[(4-dir+c)%4][0];
+			pos2d[j][1] = marker_info[k].vertex[(4-dir+c)%4][1];
+			pos3d[j][0] = config->marker[i].pos3d[c][0];
+			pos3d[j][1] = config->marker[i].pos3d[c][1];
+		}
+	}
+
+	if(ippeGetTransMatSub(pos2d, pos3d, vnum*4, convs, errs) < 0)
+	{
+		artkp_FrameFree(pos3d);
+		artkp_FrameFree(pos2d);
+		config->prevF = 0;
+		return -1;
+	}
+
+	// the corners were taken at z=0, move the origin back to the config's
+	for(i=0; i<3; i++)
+	{
+		for(j=0; j<3; j++)
+			config->trans[i][j] = convs[0][i][j];
+		config->trans[i][3] = convs[0][i][3] - convs[0][i][2]*z;
+	}
+	config->prevF = 1;
+
+	artkp_FrameFree(pos3d);
+	artkp_FrameFree(pos2d);
+	return errs[0];
+}
+
+
+}  // namespace ARToolKitPlus
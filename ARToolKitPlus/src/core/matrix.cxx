@@ -46,6 +46,7 @@
 #include <stdlib.h>
 #endif
 #include <ARToolKitPlus/matrix.h>
+#include <ARToolKitPlus/MemoryManagerArena.h>
 
 
 namespace ARToolKitPlus {
@@ -63,23 +64,19 @@ static ARFloat *minv( ARFloat *ap, int dimen, int rowa );
 
 
 // from mAlloc.c
+// header and data share one block taken from the current frame arena
+// (see MemoryManagerArena), so temporary matrices cost no heap allocation.
 static ARMat*
 alloc(int row, int clm)
 {
 	ARMat *m;
 
-	m = (ARMat *)malloc(sizeof(ARMat));
+	m = (ARMat *)artkp_FrameAlloc(((sizeof(ARMat)+15) & ~15) + sizeof(ARFloat) * row * clm);
 	if( m == NULL ) return NULL;
 
-	m->m = (ARFloat *)malloc(sizeof(ARFloat) * row * clm);
-	if(m->m == NULL) {
-		free(m);
-		return NULL;
-	}
-	else {
-		m->row = row;
-		m->clm = clm;
-	}
+	m->m = (ARFloat *)((unsigned char*)m + ((sizeof(ARMat)+15) & ~15));
+	m->row = row;
+	m->clm = clm;
 
 	return m;
 }
@@ -89,8 +86,7 @@ alloc(int row, int clm)
 static int
 free(ARMat *m)
 {
-	::free(m->m);
-	::free(m);
+	artkp_FrameFree(m);
 
 	return 0;
 }
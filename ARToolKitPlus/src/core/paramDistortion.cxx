@@ -43,6 +43,7 @@
 #include <ARToolKitPlus/Tracker.h>
 #include <ARToolKitPlus/Camera.h>
 #include <ARToolKitPlus/param.h>
+#include <ARToolKitPlus/UndistCache.h>
 
 
 namespace ARToolKitPlus {
@@ -75,6 +76,10 @@ AR_TEMPL_TRACKER::arParamObserv2Ideal_none(Camera* pCam, ARFloat ox, ARFloat oy,
 //  these functions store 2 values (x & y) in a single 32-bit unsigned integer
 //  each value is stored as 11.5 fixed point
 //
+//  the undistortion table stores the offset from each pixel to its ideal
+//  position rather than the position itself, so the 11 integer bits
+//  limit the amount of distortion (+-1024 pixels) but not the image size.
+//
 
 inline
 void floatToFixed(ARFloat nX, ARFloat nY, unsigned int &nFixed)
@@ -103,6 +108,17 @@ void fixedToFloat(unsigned int nFixed, ARFloat& nX, ARFloat& nY)
 }
 
 
+// the row builders are static (see UndistCache::BuildFunc), so they get the
+// table width with the camera. it is taken from arImXsize like the lookups,
+// the camera's own size may have been changed since arInitCparam().
+//
+struct UndistBuildInfo
+{
+	Camera* camera;
+	int width;			// pixels for UNDIST_LUT, nodes for UNDIST_GRID
+};
+
+
 AR_TEMPL_FUNC int
 AR_TEMPL_TRACKER::arParamObserv2Ideal_LUT(Camera* pCam, ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy)
 {
@@ -110,8 +126,11 @@ AR_TEMPL_TRACKER::arParamObserv2Ideal_LUT(Camera* pCam, ARFloat ox, ARFloat oy,
 		buildUndistO2ITable(pCam);
 
 	int x=(int)ox, y=(int)oy;
+	ARFloat dx,dy;
 
-	fixedToFloat(undistO2ITable[x+y*arImXsize], *ix,*iy);
+	fixedToFloat(undistO2ITable[x+y*arImXsize], dx,dy);
+	*ix = x + dx;
+	*iy = y + dy;
 	return 0;
 }
 
@@ -119,26 +138,33 @@ AR_TEMPL_TRACKER::arParamObserv2Ideal_LUT(Camera* pCam, ARFloat ox, ARFloat oy,
 AR_TEMPL_FUNC void
 AR_TEMPL_TRACKER::buildUndistO2ITable(Camera* pCam)
 {
-	int x,y;
-	ARFloat cx,cy, ox,oy;
-	unsigned int fixed;
 	char* cachename = NULL;
 	bool loaded = false;
-
-	if(loadCachedUndist)
-	{
-		assert(pCam->getFileName());
-		cachename = new char[strlen(pCam->getFileName())+5];
-		strcpy(cachename, pCam->getFileName());
-		strcat(cachename, ".LUT");
-	}
+	UndistBuildInfo info = {  pCam, arImXsize  };
 
 	// we have to take care here when using a memory manager that can not free memory
 	// (usually this lookup table should only be built once - unless we change camera resolution)
 	//
 	if(undistO2ITable)
 		//delete undistO2ITable;
-		artkp_Free(undistO2ITable);
+		freeUndistTable(undistO2ITable);
+	undistO2ITable = NULL;
+
+	// the format id includes the version of the fixed point encoding (see floatToFixed())
+	if(shareUndistTables)
+		undistO2ITable = (unsigned int*)UndistCache::acquire(pCam->getFileName(), UNDIST_LUT | (2<<8), arImXsize, arImYsize,
+															 arImXsize*arImYsize*sizeof(unsigned int), arImYsize,
+															 &AR_TEMPL_TRACKER::buildUndistO2IRows, &info);
+	if(undistO2ITable)
+		return;
+
+	if(loadCachedUndist)
+	{
+		assert(pCam->getFileName());
+		cachename = new char[strlen(pCam->getFileName())+6];
+		strcpy(cachename, pCam->getFileName());
+		strcat(cachename, ".LUT2");		// offset table, see floatToFixed()
+	}
 
 	//undistO2ITable = new unsigned int [arImXsize*arImYsize];
 	undistO2ITable = artkp_Alloc<unsigned int>(arImXsize*arImYsize);
@@ -148,25 +174,17 @@ AR_TEMPL_TRACKER::buildUndistO2ITable(Camera* pCam)
 		if(FILE* fp = fopen(cachename, "rb"))
 		{
 			size_t numBytes = fread(undistO2ITable, 1, arImXsize*arImYsize*sizeof(unsigned int), fp);
+			bool atEnd = (fgetc(fp)==EOF);		// a cache of a larger frame size is rejected too
 			fclose(fp);
 
-			if(numBytes == arImXsize*arImYsize*sizeof(unsigned int))
+			if(numBytes == arImXsize*arImYsize*sizeof(unsigned int) && atEnd)
 				loaded = true;
 		}
 	}
 
 	if(!loaded)
 	{
-		for(x=0; x<arImXsize; x++)
-		{
-			for(y=0; y<arImYsize; y++)
-			{
-				arParamObserv2Ideal_std(pCam, (ARFloat)x, (ARFloat)y, &cx, &cy);
-				floatToFixed(cx,cy, fixed);
-				fixedToFloat(fixed, ox,oy);
-				undistO2ITable[x+y*arImXsize] = fixed;
-			}
-		}
+		buildUndistO2IRows(undistO2ITable, 0, arImYsize, &info);
 
 		if(loadCachedUndist)
 			if(FILE* fp = fopen(cachename, "wb"))
@@ -180,6 +198,111 @@ AR_TEMPL_TRACKER::buildUndistO2ITable(Camera* pCam)
 }
 
 
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::buildUndistO2IRows(void* nTable, int nRowBegin, int nRowEnd, void* nInfo)
+{
+	const UndistBuildInfo* info = (const UndistBuildInfo*)nInfo;
+	unsigned int* table = (unsigned int*)nTable;
+	ARFloat cx,cy;
+
+	for(int y=nRowBegin; y<nRowEnd; y++)
+		for(int x=0; x<info->width; x++)
+		{
+			info->camera->observ2Ideal((ARFloat)x, (ARFloat)y, &cx, &cy);
+			floatToFixed(cx-x,cy-y, table[x+y*info->width]);
+		}
+}
+
+
+//
+//  the coarse table of UNDIST_GRID stores the offset to the ideal position
+//  for a node every AR_UNDIST_GRID_STEP pixels (plus one node past the right
+//  and bottom border). lookups interpolate bilinearly between the four
+//  surrounding nodes, so sub-pixel positions are kept.
+//
+
+AR_TEMPL_FUNC int
+AR_TEMPL_TRACKER::arParamObserv2Ideal_grid(Camera* pCam, ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy)
+{
+	if(!undistGrid)
+		buildUndistGrid(pCam);
+
+	const ARFloat scale = (ARFloat)1 / AR_UNDIST_GRID_STEP;
+	ARFloat fx = ox*scale, fy = oy*scale;
+
+	// points outside of the frame use the border cells
+	if(fx<0) fx = 0;
+	if(fy<0) fy = 0;
+	int x = (int)fx, y = (int)fy;
+	if(x>undistGridW-2) x = undistGridW-2;
+	if(y>undistGridH-2) y = undistGridH-2;
+	fx -= x;
+	fy -= y;
+
+	const ARFloat* p0 = undistGrid + 2*(x+y*undistGridW);
+	const ARFloat* p1 = p0 + 2*undistGridW;
+
+	ARFloat dx0 = p0[0] + fx*(p0[2]-p0[0]),  dy0 = p0[1] + fx*(p0[3]-p0[1]);
+	ARFloat dx1 = p1[0] + fx*(p1[2]-p1[0]),  dy1 = p1[1] + fx*(p1[3]-p1[1]);
+
+	*ix = ox + dx0 + fy*(dx1-dx0);
+	*iy = oy + dy0 + fy*(dy1-dy0);
+	return 0;
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::buildUndistGrid(Camera* pCam)
+{
+	if(undistGrid)
+		freeUndistTable(undistGrid);
+	undistGrid = NULL;
+
+	undistGridW = (arImXsize-1)/AR_UNDIST_GRID_STEP + 2;
+	undistGridH = (arImYsize-1)/AR_UNDIST_GRID_STEP + 2;
+
+	UndistBuildInfo info = {  pCam, undistGridW  };
+
+	if(shareUndistTables)
+		undistGrid = (ARFloat*)UndistCache::acquire(pCam->getFileName(), UNDIST_GRID | (AR_UNDIST_GRID_STEP<<8) | (sizeof(ARFloat)<<16),
+													arImXsize, arImYsize, 2*undistGridW*undistGridH*sizeof(ARFloat), undistGridH,
+													&AR_TEMPL_TRACKER::buildUndistGridRows, &info);
+	if(undistGrid)
+		return;
+
+	undistGrid = artkp_Alloc<ARFloat>(2*undistGridW*undistGridH);
+	buildUndistGridRows(undistGrid, 0, undistGridH, &info);
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::buildUndistGridRows(void* nTable, int nRowBegin, int nRowEnd, void* nInfo)
+{
+	const UndistBuildInfo* info = (const UndistBuildInfo*)nInfo;
+	ARFloat* grid = (ARFloat*)nTable;
+	int gridW = info->width;
+	ARFloat cx,cy;
+
+	for(int y=nRowBegin; y<nRowEnd; y++)
+		for(int x=0; x<gridW; x++)
+		{
+			const ARFloat nx = (ARFloat)(x*AR_UNDIST_GRID_STEP), ny = (ARFloat)(y*AR_UNDIST_GRID_STEP);
+
+			info->camera->observ2Ideal(nx, ny, &cx, &cy);
+			grid[2*(x+y*gridW)+0] = cx-nx;
+			grid[2*(x+y*gridW)+1] = cy-ny;
+		}
+}
+
+
+AR_TEMPL_FUNC void
+AR_TEMPL_TRACKER::freeUndistTable(void* nTable)
+{
+	if(nTable && !UndistCache::release(nTable))
+		artkp_Free(nTable);
+}
+
+
 AR_TEMPL_FUNC int
 AR_TEMPL_TRACKER::arParamObserv2Ideal(Camera *pCam, ARFloat ox, ARFloat oy, ARFloat *ix, ARFloat *iy)
 {
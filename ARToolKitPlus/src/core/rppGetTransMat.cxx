@@ -52,15 +52,42 @@ AR_TEMPL_FUNC ARFloat
 AR_TEMPL_TRACKER::rppGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], ARFloat width, ARFloat conv[3][4])
 {
 	const bool initial_estimate_with_arGetInitRot = false; // only for testing
-	
-	rpp_float err = 1e+20;
-	rpp_mat R, R_init;
-	rpp_vec t;
 
 	if(initial_estimate_with_arGetInitRot )
 	{
 		ARFloat  rot[3][3];
 		if( arGetInitRot( marker_info, arCamera->mat, rot ) < 0 ) return -1;
+		return rppGetTransMatSub(marker_info, rot, center, width, conv);
+	}
+
+	return rppGetTransMatSub(marker_info, NULL, center, width, conv);
+}
+
+
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::rppGetTransMatCont(ARMarkerInfo *marker_info, ARFloat prev_conv[3][4], ARFloat center[2], ARFloat width, ARFloat conv[3][4])
+{
+	ARFloat  rot[3][3];
+
+	for(int i=0; i<3; i++)
+		for(int j=0; j<3; j++)
+			rot[i][j] = prev_conv[i][j];
+
+	return rppGetTransMatSub(marker_info, rot, center, width, conv);
+}
+
+
+AR_TEMPL_FUNC ARFloat
+AR_TEMPL_TRACKER::rppGetTransMatSub(ARMarkerInfo *marker_info, ARFloat rot[3][3], ARFloat center[2], ARFloat width, ARFloat conv[3][4])
+{
+	rpp_float err = 1e+20;
+	rpp_mat R, R_init;
+	rpp_vec t;
+	MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
+
+	if(rot)
+	{
 		for(int i=0; i<3; i++)
 			for(int j=0; j<3; j++)
 				R_init[i][j] = (rpp_float)rot[i][j];
@@ -102,7 +129,7 @@ AR_TEMPL_TRACKER::rppGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], A
 	const rpp_float cc[2] = {arCamera->mat[0][2],arCamera->mat[1][2]};
 	const rpp_float fc[2] = {arCamera->mat[0][0],arCamera->mat[1][1]};
 
-	robustPlanarPose(err,R,t,cc,fc,ppos3d,ppos2d,n_pts,R_init, !initial_estimate_with_arGetInitRot,0,0,0);
+	robustPlanarPose(err,R,t,cc,fc,ppos3d,ppos2d,n_pts,R_init, rot==NULL,0,0,0);
 
 	for(int i=0; i<3; i++)
 	{
@@ -111,8 +138,8 @@ AR_TEMPL_TRACKER::rppGetTransMat(ARMarkerInfo *marker_info, ARFloat center[2], A
 			conv[i][j] = (ARFloat)R[i][j];
 	}
 
-	if(err > 1e+10) return(-1); // an actual error has occurred in robustPlanarPose()
-	return(ARFloat(err)); // NOTE: err is a real number from the interval [0,1e+10]
+	if(err >= 1e+10) return(-1); // an actual error has occurred in robustPlanarPose(), R and t are zero
+	return(ARFloat(err)); // NOTE: err is a real number from the interval [0,1e+10)
 }
 
 }  // namespace ARToolKitPlus
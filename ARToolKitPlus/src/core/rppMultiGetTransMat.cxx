@@ -56,6 +56,8 @@ AR_TEMPL_TRACKER::rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
 	rpp_float err = 1e+20;
 	rpp_mat R, R_init;
 	rpp_vec t;
+	MemoryManagerArena::Scope arenaScope(defaultContext->frameArena);
+
 
 	std::map<int, int> marker_id_freq;
 	for(int i=0; i<marker_num; i++)
@@ -64,14 +66,14 @@ AR_TEMPL_TRACKER::rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
 		if(m_patt_id >= 0)
 		{
 			std::map<int, int>::iterator iter = marker_id_freq.find(m_patt_id);
-			if(iter == marker_id_freq.end()) marker_id_freq.insert(std::make_pair<int,int>(m_patt_id,1));
+			if(iter == marker_id_freq.end()) marker_id_freq.insert(std::make_pair(m_patt_id,1));
 			else ((*iter).second)++;
 		}
 	}
 
 	std::deque<std::pair<int,int> > config_patt_id;
 	for(int j=0; j<config->marker_num; j++)
-		config_patt_id.push_back(std::make_pair<int,int>(j, config->marker[j].patt_id));
+		config_patt_id.push_back(std::make_pair(j, config->marker[j].patt_id));
 
 	std::map<int, int> m2c_idx;
 	for(int m=0; m<marker_num; m++)
@@ -88,7 +90,7 @@ AR_TEMPL_TRACKER::rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
 				const int patt_id = (*c_iter).second;
 				if(marker_info[m].id == patt_id)
 				{
-					m2c_idx.insert(std::make_pair<int,int>(m,(*c_iter).first));
+					m2c_idx.insert(std::make_pair(m,(*c_iter).first));
 					config_patt_id.erase(c_iter);
 					c_iter = config_patt_id.end();
 					continue;
@@ -109,8 +111,8 @@ AR_TEMPL_TRACKER::rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
 	if(n_markers == 0) return(-1);
 
 	rpp_vec *ppos2d = NULL, *ppos3d = NULL;
-	arMalloc( ppos2d, rpp_vec, n_pts);
-	arMalloc( ppos3d, rpp_vec, n_pts);
+	arFrameMalloc( ppos2d, rpp_vec, n_pts);
+	arFrameMalloc( ppos3d, rpp_vec, n_pts);
 	memset(ppos2d,0,sizeof(rpp_vec)*n_pts);
 	memset(ppos3d,0,sizeof(rpp_vec)*n_pts);
 
@@ -148,11 +150,11 @@ AR_TEMPL_TRACKER::rppMultiGetTransMat(ARMarkerInfo *marker_info, int marker_num,
 			config->trans[k][j] = (ARFloat)R[k][j];
 	}
 
-	if(ppos2d != NULL) free(ppos2d);
-	if(ppos3d != NULL) free(ppos3d);
+	artkp_FrameFree(ppos3d);
+	artkp_FrameFree(ppos2d);
 
-	if(err > 1e+10) return(-1); // an actual error has occurred in robustPlanarPose()
-	return(ARFloat(err)); // NOTE: err is a real number from the interval [0,1e+10]
+	if(err >= 1e+10) return(-1); // an actual error has occurred in robustPlanarPose(), R and t are zero
+	return(ARFloat(err)); // NOTE: err is a real number from the interval [0,1e+10)
 }
 
 }  // namespace ARToolKitPlus
@@ -50,6 +50,7 @@
 #include <ARToolKitPlus/Tracker.h>
 #include <ARToolKitPlus/matrix.h>
 #include <ARToolKitPlus/vector.h>
+#include <ARToolKitPlus/MemoryManagerArena.h>
 
 
 namespace ARToolKitPlus {
@@ -59,20 +60,16 @@ namespace Vector {
 
 
 // from vAlloc.c
+// header and data share one block, see Matrix::alloc()
 static ARVec*
 alloc( int clm )
 {
     ARVec     *v;
 
-    v = (ARVec *)malloc(sizeof(ARVec));
+    v = (ARVec *)artkp_FrameAlloc(((sizeof(ARVec)+15) & ~15) + sizeof(ARFloat) * clm);
     if( v == NULL ) return NULL;
 
-    v->v = (ARFloat *)malloc(sizeof(ARFloat) * clm);
-    if( v->v == NULL ) {
-        free(v);
-        return NULL;
-    }
-
+    v->v = (ARFloat *)((unsigned char*)v + ((sizeof(ARVec)+15) & ~15));
     v->clm = clm;
 
     return v;
@@ -104,8 +101,7 @@ disp( ARVec *v )
 static int
 free( ARVec *v )
 {
-    ::free( v->v );
-    ::free( v );
+    artkp_FrameFree( v );
 
     return 0;
 }
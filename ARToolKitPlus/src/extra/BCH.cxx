@@ -104,6 +104,16 @@ fromBitPattern(int b[], int n_bits)
 	return(n);
 }
 
+static int
+_popCount(_64bits n)
+{
+	// one iteration per set bit, the error patterns have at most BCH_DEFAULT_T
+	int cnt = 0;
+	for(; n; n &= n-1)
+		cnt++;
+	return(cnt);
+}
+
 /*
 static void
 printBitPattern(_64bits n, int n_bits)
@@ -138,7 +148,7 @@ BCH::BCH(int _m, int _length, int _t)
 
 void BCH::initialize(int _m, int _length, int _t)
 {
-	int i, ninf;
+	int i;
 
 	m = _m;
 	length = _length;
@@ -189,7 +199,6 @@ void BCH::initialize(int _m, int _length, int _t)
         n *= 2;
     }
 	n = n / 2 - 1;
-	ninf = (n + 1) / 2 - 1;
 
 	generate_gf();          /* Construct the Galois Field GF(2**m) */
 	gen_poly(t);            /* Compute the generator polynomial of BCH code */
@@ -530,10 +539,10 @@ int BCH::decode_bch(int *recd)
 			    _d[u + 1] = alpha_to[_s[u + 1]];
 			  else
 			    _d[u + 1] = 0;
-			    for (i = 1; i <= _l[u + 1]; i++)
-			      if ((_s[u + 1 - i] != -1) && (_elp[u + 1][i] != 0))
-			        _d[u + 1] ^= alpha_to[(_s[u + 1 - i] 
-			                      + index_of[_elp[u + 1][i]]) % n];
+			  for (i = 1; i <= _l[u + 1]; i++)
+			    if ((_s[u + 1 - i] != -1) && (_elp[u + 1][i] != 0))
+			      _d[u + 1] ^= alpha_to[(_s[u + 1 - i] 
+			                    + index_of[_elp[u + 1][i]]) % n];
 			  /* put _d[u+1] into index form */
 			  _d[u + 1] = index_of[_d[u + 1]];	
 			}
@@ -645,4 +654,119 @@ bool BCH::decode(int &err_n, _64bits &orig_n,    const _64bits encoded_n)
 }
 
 
+
+BCHCodebook::BCHCodebook()
+{
+	int i, j, k, l;
+
+	for(i=0; i<NUM_CODEWORDS; i++)
+		codewords[i] = encode(i);
+
+	// a word with at most BCH_DEFAULT_T errors has a unique closest codeword,
+	// so the syndromes of all these error patterns are distinct
+	for(i=0; i<(1<<SYNDROME_TABLE_BITS); i++)
+		errorPatterns[i] = 0;
+
+	const _64bits one = 1;
+	for(i=0; i<BCH_DEFAULT_LENGTH; i++)
+	{
+		addErrorPattern(one<<i);
+		for(j=i+1; j<BCH_DEFAULT_LENGTH; j++)
+		{
+			addErrorPattern((one<<i) | (one<<j));
+			for(k=j+1; k<BCH_DEFAULT_LENGTH; k++)
+			{
+				addErrorPattern((one<<i) | (one<<j) | (one<<k));
+				for(l=k+1; l<BCH_DEFAULT_LENGTH; l++)
+					addErrorPattern((one<<i) | (one<<j) | (one<<k) | (one<<l));
+			}
+		}
+	}
+}
+
+
+_64bits BCHCodebook::encode(const _64bits orig_n)
+{
+	// the redundancy register of BCH::encode_bch() as a bitfield
+	unsigned int bb = 0;
+	const unsigned int mask = (1<<PARITY_BITS)-1;
+
+	for(int i=BCH_DEFAULT_K-1; i>=0; i--)
+	{
+		unsigned int feedback = (unsigned int)((orig_n>>i)&1) ^ (bb>>(PARITY_BITS-1));
+		bb = (bb<<1) & mask;
+		if(feedback)
+			bb ^= BCH_GENERATOR;
+	}
+
+	return ((orig_n & (NUM_CODEWORDS-1)) << PARITY_BITS) | bb;
+}
+
+
+unsigned int BCHCodebook::getSyndrome(_64bits n) const
+{
+	// the codeword with the same information bits differs in the parity bits only
+	return (unsigned int)(codewords[(int)(n>>PARITY_BITS)] ^ n) & ((1<<PARITY_BITS)-1);
+}
+
+
+unsigned int BCHCodebook::hashSyndrome(unsigned int syndrome)
+{
+	return (syndrome*2654435761u) >> (32-SYNDROME_TABLE_BITS);
+}
+
+
+void BCHCodebook::addErrorPattern(_64bits error_n)
+{
+	unsigned int idx = hashSyndrome(getSyndrome(error_n));
+
+	while(errorPatterns[idx])
+	{
+		assert(getSyndrome(errorPatterns[idx])!=getSyndrome(error_n));
+		idx = (idx+1) & ((1<<SYNDROME_TABLE_BITS)-1);
+	}
+
+	errorPatterns[idx] = error_n;
+}
+
+
+bool BCHCodebook::decode(int &err_n, _64bits &orig_n, const _64bits encoded_n) const
+{
+	const _64bits one = 1;
+	_64bits n = encoded_n & ((one<<BCH_DEFAULT_LENGTH)-1);
+	unsigned int syndrome = getSyndrome(n);
+
+	if(syndrome)
+	{
+		unsigned int idx = hashSyndrome(syndrome);
+
+		for(;;)
+		{
+			_64bits error_n = errorPatterns[idx];
+
+			if(error_n==0)
+			{
+				// further than BCH_DEFAULT_T bits from any codeword
+				err_n = BCH_DEFAULT_T+1;
+				return(false);
+			}
+
+			if(getSyndrome(error_n)==syndrome)
+			{
+				n ^= error_n;
+				err_n = _popCount(error_n);
+				break;
+			}
+
+			idx = (idx+1) & ((1<<SYNDROME_TABLE_BITS)-1);
+		}
+	}
+	else
+		err_n = 0;
+
+	orig_n = n>>PARITY_BITS;
+	return(true);
+}
+
+
 }  // namespace ARToolKitPlus
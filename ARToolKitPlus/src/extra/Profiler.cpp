@@ -24,6 +24,7 @@ Profiler::reset()
 {
 	_SINGLEMARKER_OVERALL.reset();
 	_LABELING.reset();
+	_BINARIZE.reset();
 	_DETECTMARKER2.reset();
 	_GETMARKERINFO.reset();
 	_GETTRANSMAT.reset();
@@ -47,6 +48,8 @@ Profiler::getMes(MES nMes) const
 		return &_SINGLEMARKER_OVERALL;
 	case LABELING:
 		return &_LABELING;
+	case BINARIZE:
+		return &_BINARIZE;
 	case DETECTMARKER2:
 		return &_DETECTMARKER2;
 	case GETMARKERINFO:
@@ -201,6 +204,7 @@ Profiler::writeReport(const char* nFileName, unsigned int nNumRuns) const
 	fprintf(fp, "PROFILER REPORT (%d runs)\n\n", nNumRuns);
 	fprintf(fp, "  SINGLEMARKER_OVERALL:                    %.3f msecs\n", 1000.0f*overall/nNumRuns);
 	fprintf(fp, "      LABELING:                            %.3f msecs  (%.2f %%)\n", 1000.0f*getTime(LABELING)/nNumRuns, 100.0f*getTime(LABELING)/overall);
+	fprintf(fp, "          BINARIZE:                        %.3f msecs  (%.2f %%)\n", 1000.0f*getTime(BINARIZE)/nNumRuns, 100.0f*getTime(BINARIZE)/overall);
 	fprintf(fp, "      DETECTMARKER2:                       %.3f msecs  (%.2f %%)\n", 1000.0f*getTime(DETECTMARKER2)/nNumRuns, 100.0f*getTime(DETECTMARKER2)/overall);
 	fprintf(fp, "      GETMARKERINFO:                       %.3f msecs  (%.2f %%)\n", 1000.0f*getTime(GETMARKERINFO)/nNumRuns, 100.0f*getTime(GETMARKERINFO)/overall);
 	fprintf(fp, "      GETTRANSMAT:                         %.3f msecs  (%.2f %%)\n", 1000.0f*getTime(GETTRANSMAT)/nNumRuns, 100.0f*getTime(GETTRANSMAT)/overall);
@@ -0,0 +1,306 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+#include <ARToolKitPlus/extra/ThreadPool.h>
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+#  define _ARTKP_THREADS_WIN32_
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
+
+namespace ARToolKitPlus {
+
+
+#ifdef _WIN32_WCE
+
+// Windows CE has no condition variables: a manual reset event wakes all
+// workers for a new batch and is cleared once its last task has been taken,
+// an auto reset event wakes the caller when the batch is done. the events
+// stay signaled until consumed, so waiting after leaving the lock is safe.
+struct ThreadPool::Impl
+{
+	CRITICAL_SECTION	lock;
+	HANDLE				workEvent, doneEvent;
+	HANDLE				*threads;
+
+	Impl() : threads(NULL)  {  InitializeCriticalSection(&lock);  workEvent = CreateEvent(NULL, TRUE, FALSE, NULL);  doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);  }
+	~Impl()  {  CloseHandle(doneEvent);  CloseHandle(workEvent);  DeleteCriticalSection(&lock);  }
+
+	void enter()  {  EnterCriticalSection(&lock);  }
+	void leave()  {  LeaveCriticalSection(&lock);  }
+	void waitWork()  {  LeaveCriticalSection(&lock);  WaitForSingleObject(workEvent, INFINITE);  EnterCriticalSection(&lock);  }
+	void waitDone()  {  LeaveCriticalSection(&lock);  WaitForSingleObject(doneEvent, INFINITE);  EnterCriticalSection(&lock);  }
+	void signalWork()  {  SetEvent(workEvent);  }
+	void clearWork()  {  ResetEvent(workEvent);  }
+	void signalDone()  {  SetEvent(doneEvent);  }
+};
+
+#elif defined(_ARTKP_THREADS_WIN32_)
+
+// condition variables require Windows Vista or newer
+struct ThreadPool::Impl
+{
+	CRITICAL_SECTION	lock;
+	CONDITION_VARIABLE	workCond, doneCond;
+	HANDLE				*threads;
+
+	Impl() : threads(NULL)  {  InitializeCriticalSection(&lock);  InitializeConditionVariable(&workCond);  InitializeConditionVariable(&doneCond);  }
+	~Impl()  {  DeleteCriticalSection(&lock);  }
+
+	void enter()  {  EnterCriticalSection(&lock);  }
+	void leave()  {  LeaveCriticalSection(&lock);  }
+	void waitWork()  {  SleepConditionVariableCS(&workCond, &lock, INFINITE);  }
+	void waitDone()  {  SleepConditionVariableCS(&doneCond, &lock, INFINITE);  }
+	void signalWork()  {  WakeAllConditionVariable(&workCond);  }
+	void clearWork()  {}
+	void signalDone()  {  WakeAllConditionVariable(&doneCond);  }
+};
+
+#else
+
+struct ThreadPool::Impl
+{
+	pthread_mutex_t		lock;
+	pthread_cond_t		workCond, doneCond;
+	pthread_t			*threads;
+
+	Impl() : threads(NULL)  {  pthread_mutex_init(&lock, NULL);  pthread_cond_init(&workCond, NULL);  pthread_cond_init(&doneCond, NULL);  }
+	~Impl()  {  pthread_cond_destroy(&doneCond);  pthread_cond_destroy(&workCond);  pthread_mutex_destroy(&lock);  }
+
+	void enter()  {  pthread_mutex_lock(&lock);  }
+	void leave()  {  pthread_mutex_unlock(&lock);  }
+	void waitWork()  {  pthread_cond_wait(&workCond, &lock);  }
+	void waitDone()  {  pthread_cond_wait(&doneCond, &lock);  }
+	void signalWork()  {  pthread_cond_broadcast(&workCond);  }
+	void clearWork()  {}
+	void signalDone()  {  pthread_cond_broadcast(&doneCond);  }
+};
+
+#endif //_ARTKP_THREADS_WIN32_
+
+
+ThreadPool::ThreadPool()
+{
+	impl = new Impl;
+	numWorkers = 0;
+	numRequested = 1;
+	taskFunc = NULL;
+	taskData = NULL;
+	taskCount = taskNext = taskPending = 0;
+	generation = 0;
+	quit = false;
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+	delete impl;
+}
+
+
+bool
+ThreadPool::start(int nNumThreads)
+{
+	stop();
+
+	// remembered even if starting fails, so that callers comparing against
+	// getNumRequested() do not retry every frame
+	numRequested = nNumThreads;
+	if(nNumThreads<=1)
+		return true;
+
+	quit = false;
+
+#ifdef _ARTKP_THREADS_WIN32_
+	impl->threads = new HANDLE[nNumThreads-1];
+	for(int i=0; i<nNumThreads-1; i++)
+	{
+		impl->threads[i] = CreateThread(NULL, 0, workerMain, this, 0, NULL);
+		if(impl->threads[i]==NULL)
+			break;
+		numWorkers++;
+	}
+#else
+	impl->threads = new pthread_t[nNumThreads-1];
+	for(int i=0; i<nNumThreads-1; i++)
+	{
+		if(pthread_create(impl->threads+i, NULL, workerMain, this)!=0)
+			break;
+		numWorkers++;
+	}
+#endif
+
+	if(numWorkers==nNumThreads-1)
+		return true;
+
+	// don't run with only some of the threads: fall back to the calling thread
+	int requested = numRequested;
+	stop();
+	numRequested = requested;
+	return false;
+}
+
+
+void
+ThreadPool::stop()
+{
+	if(!impl->threads)
+		return;
+
+	impl->enter();
+	quit = true;
+	impl->signalWork();
+	impl->leave();
+
+	for(int i=0; i<numWorkers; i++)
+	{
+#ifdef _ARTKP_THREADS_WIN32_
+		WaitForSingleObject(impl->threads[i], INFINITE);
+		CloseHandle(impl->threads[i]);
+#else
+		pthread_join(impl->threads[i], NULL);
+#endif
+	}
+
+	delete [] impl->threads;
+	impl->threads = NULL;
+	impl->clearWork();
+	numWorkers = 0;
+	numRequested = 1;
+}
+
+
+void
+ThreadPool::run(TaskFunc nFunc, void* nData, int nCount)
+{
+	if(numWorkers==0 || nCount<=1)
+	{
+		for(int i=0; i<nCount; i++)
+			nFunc(nData, i);
+		return;
+	}
+
+	impl->enter();
+	taskFunc = nFunc;
+	taskData = nData;
+	taskCount = taskPending = nCount;
+	taskNext = 0;
+	generation++;
+	impl->signalWork();
+
+	while(runNextTask())
+		;
+
+	while(taskPending>0)
+		impl->waitDone();
+	impl->leave();
+}
+
+
+// executes one task. must be called with the lock held,
+// returns false if there was nothing left to do.
+//
+bool
+ThreadPool::runNextTask()
+{
+	if(taskNext>=taskCount)
+		return false;
+
+	int idx = taskNext++;
+	if(taskNext==taskCount)
+		impl->clearWork();
+
+	impl->leave();
+	taskFunc(taskData, idx);
+	impl->enter();
+
+	if(--taskPending==0)
+		impl->signalDone();
+
+	return true;
+}
+
+
+void
+ThreadPool::workerLoop()
+{
+	unsigned int seen = 0;
+
+	impl->enter();
+	for(;;)
+	{
+		while(!quit && generation==seen)
+			impl->waitWork();
+		if(quit)
+			break;
+
+		seen = generation;
+		while(runNextTask())
+			;
+	}
+	impl->leave();
+}
+
+
+#ifdef _ARTKP_THREADS_WIN32_
+
+unsigned long __stdcall
+ThreadPool::workerMain(void* nPool)
+{
+	((ThreadPool*)nPool)->workerLoop();
+	return 0;
+}
+
+#else
+
+void*
+ThreadPool::workerMain(void* nPool)
+{
+	((ThreadPool*)nPool)->workerLoop();
+	return NULL;
+}
+
+#endif //_ARTKP_THREADS_WIN32_
+
+
+}  // namespace ARToolKitPlus
@@ -82,11 +82,6 @@ LIBRPP_API void robustPlanarPose(rpp_float &err,
 								 const rpp_float tolerance,
 								 const unsigned int max_iterations)
 {
-	vec3_array _model;
-	vec3_array _iprts;
-	_model.resize(model_iprts_size);
-	_iprts.resize(model_iprts_size);
-
 	mat33_t K, K_inv;
 	mat33_eye(K);
 	K.m[0][0] = (real_t)fc[0];
@@ -96,16 +91,6 @@ LIBRPP_API void robustPlanarPose(rpp_float &err,
 
 	mat33_inv(K_inv, K);
 
-	for(unsigned int i=0; i<model_iprts_size; i++)
-	{
-		vec3_t _v,_v2;
-		vec3_assign(_v,(real_t)model[i][0],(real_t)model[i][1],(real_t)model[i][2]);
-		_model[i] = _v;
-		vec3_assign(_v,(real_t)iprts[i][0],(real_t)iprts[i][1],(real_t)iprts[i][2]);
-		vec3_mult(_v2,K_inv,_v);
-		_iprts[i] = _v2;
-	}
-
 	options_t options;
 	options.max_iter = max_iterations;
 	options.epsilon = (real_t)(epsilon == 0 ? DEFAULT_EPSILON : epsilon);
@@ -124,7 +109,42 @@ LIBRPP_API void robustPlanarPose(rpp_float &err,
 	mat33_t _R;
 	vec3_t _t;
 
-	robust_pose(_err,_R,_t,_model,_iprts,options);
+	if(model_iprts_size == 4)
+	{
+		// the corners of a marker: use the fixed-size version, which does
+		// not allocate any memory
+		vec3_array4 _model;
+		vec3_array4 _iprts;
+
+		for(unsigned int i=0; i<4; i++)
+		{
+			vec3_t _v;
+			vec3_assign(_model[i],(real_t)model[i][0],(real_t)model[i][1],(real_t)model[i][2]);
+			vec3_assign(_v,(real_t)iprts[i][0],(real_t)iprts[i][1],(real_t)iprts[i][2]);
+			vec3_mult(_iprts[i],K_inv,_v);
+		}
+
+		robust_pose4(_err,_R,_t,_model,_iprts,options);
+	}
+	else
+	{
+		vec3_array _model;
+		vec3_array _iprts;
+		_model.resize(model_iprts_size);
+		_iprts.resize(model_iprts_size);
+
+		for(unsigned int i=0; i<model_iprts_size; i++)
+		{
+			vec3_t _v,_v2;
+			vec3_assign(_v,(real_t)model[i][0],(real_t)model[i][1],(real_t)model[i][2]);
+			_model[i] = _v;
+			vec3_assign(_v,(real_t)iprts[i][0],(real_t)iprts[i][1],(real_t)iprts[i][2]);
+			vec3_mult(_v2,K_inv,_v);
+			_iprts[i] = _v2;
+		}
+
+		robust_pose(_err,_R,_t,_model,_iprts,options);
+	}
 
 	for(int j=0; j<3; j++)
 	{
@@ -46,6 +46,7 @@
 
 #include <vector>
 #include "assert.h"
+#include <string.h>
 
 #include "rpp.h"
 #include "rpp_const.h"
@@ -53,6 +54,8 @@
 
 namespace rpp {
 
+int quartic(double[], double[], double[], int* );
+
 // ===========================================================================================
 void Quaternion_byAngleAndVector(quat_t &Q, const real_t &q_angle, const vec3_t &q_vector)
 {
@@ -793,6 +796,590 @@ void robust_pose(real_t &err, mat33_t &R, vec3_t &t,
 	}
 }
 
+// =====================================================================================
+//
+// fixed-size versions of the functions above for exactly four points (the
+// corners of a marker). they do the same computations in the same order but
+// keep all arrays on the stack, so robust_pose4() does no heap allocation.
+//
+// =====================================================================================
+
+void xform4(vec3_array4 Q, const vec3_array4 P, const mat33_t &R, const vec3_t &t)
+{
+	for(unsigned int i=0; i<4; i++)
+	{
+		vec3_mult(Q[i],R,P[i]);
+		vec3_add(Q[i],t);
+	}
+}
+
+// ===========================================================================================
+
+void xformproj4(vec3_array4 Qp, const vec3_array4 P, const mat33_t &R, const vec3_t &t)
+{
+	for(unsigned int i=0; i<4; i++)
+	{
+		vec3_t Q;
+		vec3_mult(Q,R,P[i]);
+		vec3_add(Q,t);
+		Qp[i].v[0] = Q.v[0] / Q.v[2];
+		Qp[i].v[1] = Q.v[1] / Q.v[2];
+		Qp[i].v[2] = 1.0;
+	}
+}
+
+// ===========================================================================================
+
+void abskernel4(mat33_t &R, vec3_t &t, vec3_array4 Qout, real_t &err2,
+				const vec3_array4 _P, const vec3_array4 _Q,
+				const mat33_array4 F, const mat33_array4 IF, const mat33_t &G)
+{
+	unsigned i,j;
+	const unsigned int n = 4;
+	vec3_array4 P, Q;
+
+	for(i=0; i<n; i++)
+	{
+		vec3_copy(P[i],_P[i]);
+		vec3_mult(Q[i],F[i],_Q[i]);
+	}
+
+	vec3_t pbar;
+	vec3_clear(pbar);
+	for(i=0; i<n; i++) vec3_add(pbar,P[i]);
+	vec3_div(pbar,real_t(n));
+	for(i=0; i<n; i++) vec3_sub(P[i],pbar);
+
+	vec3_t qbar;
+	vec3_clear(qbar);
+	for(i=0; i<n; i++) vec3_add(qbar,Q[i]);
+	vec3_div(qbar,real_t(n));
+	for(i=0; i<n; i++) vec3_sub(Q[i],qbar);
+
+	mat33_t M;
+	mat33_clear(M);
+	for(j=0; j<n; j++)
+	{
+		mat33_t _m;
+		vec3_mul_vec3trans(_m,P[j],Q[j]);
+		mat33_add(M,_m);
+	}
+
+	mat33_t _U;
+	mat33_t _S;
+	mat33_t _V;
+	mat33_clear(_U);
+	mat33_clear(_S);
+	mat33_clear(_V);
+	mat33_svd2(_U,_S,_V,M);
+
+	mat33_t _Ut;
+	mat33_transpose(_Ut,_U);
+	mat33_mult(R,_V,_Ut);
+
+	vec3_t _sum;
+	vec3_clear(_sum);
+	for(i=0; i<n; i++)
+	{
+		vec3_t _v1,_v2;
+		vec3_mult(_v1,R,P[i]);
+		vec3_mult(_v2,F[i],_v1);
+		vec3_add(_sum,_v2);
+	}
+
+	vec3_mult(t,G,_sum);
+	xform4(Qout,P,R,t);
+	err2 = 0;
+	for(i=0; i<n; i++)
+	{
+		vec3_t _v1;
+		vec3_mult(_v1,IF[i],Qout[i]);
+		err2 += vec3_dot(_v1,_v1);
+	}
+}
+
+// ===========================================================================================
+
+void objpose4(mat33_t &R, vec3_t &t, unsigned int &it, real_t &obj_err, real_t &img_err,
+			  bool calc_img_err, const vec3_array4 _P, const vec3_array4 Qp, const options_t &options)
+{
+	unsigned int i,j;
+	const unsigned int n = 4;
+	vec3_array4 P, Q;
+
+	vec3_t pbar;
+	vec3_clear(pbar);
+	for(i=0; i<n; i++) vec3_add(pbar,_P[i]);
+	vec3_div(pbar,real_t(n));
+	for(i=0; i<n; i++)
+	{
+		vec3_sub(P[i],_P[i],pbar);
+		vec3_copy(Q[i],Qp[i]);
+		Q[i].v[2] = 1;
+	}
+
+	mat33_array4 F;
+	vec3_t V;
+	for(i=0; i<n; i++)
+	{
+		V.v[0] = Q[i].v[0] / Q[i].v[2];
+		V.v[1] = Q[i].v[1] / Q[i].v[2];
+		V.v[2] = 1.0;
+		vec3_mul_vec3trans(F[i],V,V);
+		mat33_div(F[i],vec3trans_mul_vec3(V,V));
+	}
+
+	// I-F is needed for the error in every iteration
+	mat33_array4 IF;
+	for(i=0; i<n; i++)
+	{
+		mat33_eye(IF[i]);
+		mat33_sub(IF[i],F[i]);
+	}
+
+	mat33_t tFactor;
+	{
+		mat33_t _m1,_m2,_m3;
+		mat33_eye(_m1);
+		mat33_clear(_m2);
+		for(i=0; i<n; i++) mat33_add(_m2,F[i]);
+		mat33_div(_m2,real_t(n));
+		mat33_sub(_m3,_m1,_m2);
+		mat33_inv(tFactor,_m3);
+		mat33_div(tFactor,real_t(n));
+	}
+
+	it = 0;
+	bool initR_approximate = mat33_all_zeros(options.initR);
+	mat33_t Ri;
+	vec3_t ti;
+	vec3_array4 Qi;
+	real_t old_err, new_err;
+
+	// ----------------------------------------------------------------------------------------
+	if(!initR_approximate)
+	{
+		mat33_copy(Ri,options.initR);
+		vec3_t _sum;
+		vec3_clear(_sum);
+		for(j=0; j<n; j++)
+		{
+			vec3_t _v1, _v2;
+			mat33_t _m1,_m2;
+			mat33_eye(_m1);
+			mat33_sub(_m2,F[j],_m1);
+			vec3_mult(_v1,Ri,P[j]);
+			vec3_mult(_v2,_m2,_v1);
+			vec3_add(_sum,_v2);
+		}
+		vec3_mult(ti,tFactor,_sum);
+		xform4(Qi,P,Ri,ti);
+		old_err = 0;
+		vec3_t _v;
+		for(j=0; j<n; j++)
+		{
+			mat33_t _m1,_m2;
+			mat33_eye(_m1);
+			mat33_sub(_m2,F[j],_m1);
+			vec3_mult(_v,_m2,Qi[j]);
+			old_err += vec3_dot(_v,_v);
+		}
+	// ----------------------------------------------------------------------------------------
+	}
+	else
+	{
+		abskernel4(Ri,ti,Qi,old_err,P,Q,F,IF,tFactor);
+		it = 1;
+	}
+	// ----------------------------------------------------------------------------------------
+
+	abskernel4(Ri,ti,Qi,new_err,P,Qi,F,IF,tFactor);
+	it = it + 1;
+
+	while((_abs((old_err-new_err)/old_err) > options.tol) && (new_err > options.epsilon) &&
+		  (options.max_iter == 0 || it<options.max_iter))
+	{
+		old_err = new_err;
+		abskernel4(Ri,ti,Qi,new_err,P,Qi,F,IF,tFactor);
+		it = it + 1;
+	}
+
+
+	mat33_copy(R,Ri);
+	vec3_copy(t,ti);
+	obj_err = _sqrt(new_err/real_t(n));
+
+	if(calc_img_err)
+	{
+		vec3_array4 Qproj;
+		xformproj4(Qproj, P, Ri, ti);
+		img_err = 0;
+
+		vec3_t _v;
+		for(j=0; j<n; j++)
+		{
+			vec3_sub(_v,Qproj[j],Qp[j]);
+			img_err += vec3_dot(_v,_v);
+		}
+		img_err = _sqrt(img_err/real_t(n));
+	}
+
+	if(t.v[2] < 0)
+	{
+		mat33_mult(R,-1.0);
+		vec3_mult(t,-1.0);
+	}
+
+	vec3_t _ts;
+	vec3_mult(_ts,Ri,pbar);
+	vec3_sub(t,_ts);
+}
+
+// =====================================================================================
+
+int getRotationY_wrtT4(real_t al_ret[4], vec3_t tnew[4], const vec3_array4 v,
+					   const vec3_array4 p, const vec3_t &t, const real_t &DB,
+					   const mat33_t &Rz)
+{
+	unsigned int i,j;
+	const unsigned int n = 4;
+	mat33_array4 V;
+	for(i=0; i<n; i++)
+	{
+		vec3_mul_vec3trans(V[i],v[i],v[i]);
+		mat33_div(V[i], vec3trans_mul_vec3(v[i],v[i]));
+	}
+
+	mat33_t G, _g1, _g2, _g3;
+	mat33_clear(_g1);
+	for(i=0; i<n; i++) mat33_add(_g1,V[i]);
+	mat33_eye(_g2);
+	mat33_div(_g1,real_t(n));
+	mat33_sub(_g3,_g2,_g1);
+	mat33_inv(G, _g3);
+	mat33_div(G,real_t(n));
+	mat33_t _opt_t;
+	mat33_clear(_opt_t);
+
+	for(i=0; i<n; i++)
+	{
+		const real_t v11 = V[i].m[0][0];
+		const real_t v21 = V[i].m[1][0];
+		const real_t v31 = V[i].m[2][0];
+		const real_t v12 = V[i].m[0][1];
+		const real_t v22 = V[i].m[1][1];
+		const real_t v32 = V[i].m[2][1];
+		const real_t v13 = V[i].m[0][2];
+		const real_t v23 = V[i].m[1][2];
+		const real_t v33 = V[i].m[2][2];
+		const real_t px = p[i].v[0];
+		const real_t py = p[i].v[1];
+		const real_t pz = p[i].v[2];
+		const real_t r1 = Rz.m[0][0];
+		const real_t r2 = Rz.m[0][1];
+		const real_t r3 = Rz.m[0][2];
+		const real_t r4 = Rz.m[1][0];
+		const real_t r5 = Rz.m[1][1];
+		const real_t r6 = Rz.m[1][2];
+		const real_t r7 = Rz.m[2][0];
+		const real_t r8 = Rz.m[2][1];
+		const real_t r9 = Rz.m[2][2];
+
+		mat33_t _o;
+		_o.m[0][0] = (((v11-real_t(1))*r2+v12*r5+v13*r8)*py+(-(v11-real_t(1))*r1-v12*r4-v13*r7)*px+(-(v11-real_t(1))*r3-v12*r6-v13*r9)*pz);
+		_o.m[0][1] = ((real_t(2)*(v11-real_t(1))*r1+real_t(2)*v12*r4+real_t(2)*v13*r7)*pz+(-real_t(2)*(v11-real_t(1))*r3-real_t(2)*v12*r6-real_t(2)*v13*r9)*px);
+		_o.m[0][2] = ((v11-real_t(1))*r1+v12*r4+v13*r7)*px+((v11-real_t(1))*r3+v12*r6+v13*r9)*pz+((v11-real_t(1))*r2+v12*r5+v13*r8)*py;
+
+		_o.m[1][0] = ((v21*r2+(v22-real_t(1))*r5+v23*r8)*py+(-v21*r1-(v22-real_t(1))*r4-v23*r7)*px+(-v21*r3-(v22-real_t(1))*r6-v23*r9)*pz);
+		_o.m[1][1] = ((real_t(2)*v21*r1+real_t(2)*(v22-real_t(1))*r4+real_t(2)*v23*r7)*pz+(-real_t(2)*v21*r3-real_t(2)*(v22-real_t(1))*r6-real_t(2)*v23*r9)*px);
+		_o.m[1][2] = (v21*r1+(v22-real_t(1))*r4+v23*r7)*px+(v21*r3+(v22-real_t(1))*r6+v23*r9)*pz+(v21*r2+(v22-real_t(1))*r5+v23*r8)*py;
+
+		_o.m[2][0] = ((v31*r2+v32*r5+(v33-real_t(1))*r8)*py+(-v31*r1-v32*r4-(v33-real_t(1))*r7)*px+(-v31*r3-v32*r6-(v33-real_t(1))*r9)*pz);
+		_o.m[2][1] = ((real_t(2)*v31*r1+real_t(2)*v32*r4+real_t(2)*(v33-real_t(1))*r7)*pz+(-real_t(2)*v31*r3-real_t(2)*v32*r6-real_t(2)*(v33-real_t(1))*r9)*px);
+		_o.m[2][2] = (v31*r1+v32*r4+(v33-real_t(1))*r7)*px+(v31*r3+v32*r6+(v33-real_t(1))*r9)*pz+(v31*r2+v32*r5+(v33-real_t(1))*r8)*py;
+
+		mat33_add(_opt_t,_o);
+	}
+
+	mat33_t opt_t;
+	mat33_mult(opt_t,G,_opt_t);
+	real_t E_2[5] = {0,0,0,0,0};
+	for(i=0; i<n; i++)
+	{
+		const real_t px = p[i].v[0];
+		const real_t py = p[i].v[1];
+		const real_t pz = p[i].v[2];
+
+		mat33_t Rpi;
+		mat33_assign(Rpi,-px,real_t(2)*pz,px,py,real_t(0),py,-pz,-real_t(2)*px,pz);
+
+		mat33_t E,_e1,_e2;
+		mat33_eye(_e1);
+		mat33_sub(_e1,V[i]);
+		mat33_mult(_e2,Rz,Rpi);
+		mat33_add(_e2,opt_t);
+		mat33_mult(E,_e1,_e2);
+		vec3_t e2,e1,e0;
+		mat33_to_col_vec3(e2,e1,e0,E);
+		vec3_t _E2_0,_E2_1,_E2_2,_E2_3,_E2_4;
+		vec3_copy(_E2_0,e2);
+		vec3_mult(_E2_0,e2);
+		vec3_copy(_E2_1,e1);
+		vec3_mult(_E2_1,e2);
+		vec3_mult(_E2_1,2.0f);
+		vec3_copy(_E2_2,e0);
+		vec3_mult(_E2_2,e2);
+		vec3_mult(_E2_2,2.0f);
+		vec3_t _e1_sq;
+		vec3_copy(_e1_sq,e1);
+		vec3_mult(_e1_sq,e1);
+		vec3_add(_E2_2,_e1_sq);
+		vec3_copy(_E2_3,e0);
+		vec3_mult(_E2_3,e1);
+		vec3_mult(_E2_3,2.0f);
+		vec3_copy(_E2_4,e0);
+		vec3_mult(_E2_4,e0);
+		E_2[0] += vec3_sum(_E2_0);
+		E_2[1] += vec3_sum(_E2_1);
+		E_2[2] += vec3_sum(_E2_2);
+		E_2[3] += vec3_sum(_E2_3);
+		E_2[4] += vec3_sum(_E2_4);
+	}
+
+	real_t _a[5];
+	_a[4] = -E_2[1];
+	_a[3] = real_t(4)*E_2[0] - real_t(2)*E_2[2];
+	_a[2] = -real_t(3)*E_2[3] + real_t(3)*E_2[1];
+	_a[1] = -real_t(4)*E_2[4] + real_t(2)*E_2[2];
+	_a[0] = E_2[3];
+
+	// roots of the quartic (see solve_polynomial())
+	double dd[5] = {(double)_a[0], (double)_a[1], (double)_a[2], (double)_a[3], (double)_a[4]};
+	double sol[4] = {0,0,0,0};
+	double soli[4] = {0,0,0,0};
+	int num_sol = 0;
+	quartic(dd, sol, soli, &num_sol);
+
+	// keep the real roots which solve the polynomial and where the angle
+	// has a minimum
+	int num_al = 0;
+	for(j=0; j<(unsigned int)(num_sol>0 ? num_sol : 0); j++)
+	{
+		const real_t at = (real_t)sol[j];
+		real_t e = 0;
+		e += _a[0];
+		e += at*_a[1];
+		e += _pow(at,real_t(2))*_a[2];
+		e += _pow(at,real_t(3))*_a[3];
+		e += _pow(at,real_t(4))*_a[4];
+		if(!(_abs(e) < real_t(1e-3))) continue;
+
+		const real_t p1 = _pow(_pow(at,2)+1,3);
+		if(!(_abs(p1) > real_t(0.1f))) continue;
+
+		const real_t _ca1 = _pow(at,2)+1;
+		const real_t sa = (at*2)/_ca1;
+		const real_t ca = (-_pow(at,2)+1)/_ca1;
+		const real_t al = _atan2(sa,ca)*real_t(180./CONST_PI);
+
+		real_t tMaxMin = 0;
+		tMaxMin += _a[1];
+		tMaxMin += (at*_a[2])*2;
+		tMaxMin += (_pow(at,(real_t)real_t(3)-real_t(1.0f))*_a[3])*real_t(3);
+		tMaxMin += (_pow(at,(real_t)real_t(4)-real_t(1.0f))*_a[4])*real_t(4);
+		if(tMaxMin > 0) al_ret[num_al++] = al;
+	}
+
+	for(int a=0; a<num_al; a++)
+	{
+		vec3_t rpy;
+		vec3_assign(rpy,real_t(0),real_t(al_ret[a] * CONST_PI / real_t(180)), real_t(0));
+		mat33_t R,Ry_;
+		rpyMat(Ry_,rpy);
+		mat33_mult(R,Rz,Ry_);
+		vec3_t t_opt;
+		vec3_clear(t_opt);
+
+		for(i=0; i<n; i++)
+		{
+			mat33_t _m1,_eye3;
+			mat33_eye(_eye3);
+			mat33_copy(_m1,V[i]);
+			mat33_sub(_m1,_eye3);
+			vec3_t _v1,_v2;
+			vec3_mult(_v1,R,p[i]);
+			vec3_mult(_v2,_m1,_v1);
+			vec3_add(t_opt,_v2);
+		}
+
+		vec3_mult(tnew[a],G,t_opt);
+	}
+
+	return num_al;
+}
+
+// =====================================================================================
+
+int getRfor2ndPose_V_Exact4(pose_t sol[4], const vec3_array4 v, const vec3_array4 P,
+							const mat33_t &R, const vec3_t &t, const real_t DB)
+{
+	unsigned int i;
+	const unsigned int n = 4;
+
+	mat33_t RzN;
+	decomposeR(RzN, R);
+	mat33_t R_;
+	mat33_mult(R_,R,RzN);
+	mat33_t RzN_tr;
+	mat33_transpose(RzN_tr,RzN);
+	vec3_array4 P_;
+	for(i=0; i<n; i++) vec3_mult(P_[i],RzN_tr,P[i]);
+	vec3_t ang_zyx;
+	rpyAng_X(ang_zyx,R_);
+	vec3_t rpy;
+	mat33_t Ry,Rz;
+	vec3_assign(rpy,0,ang_zyx.v[1],0);
+	rpyMat(Ry,rpy);
+	vec3_assign(rpy,0,0,ang_zyx.v[2]);
+	rpyMat(Rz,rpy);
+	real_t bl[4];
+	vec3_t Tnew[4];
+	const int num_sol = getRotationY_wrtT4(bl,Tnew, v ,P_, t, DB, Rz);
+	const real_t bl_scale = 180.0f/CONST_PI;
+	mat33_array4 V;
+	for(i=0; i<n; i++)
+	{
+		vec3_mul_vec3trans(V[i],v[i],v[i]);
+		mat33_div(V[i],vec3trans_mul_vec3(v[i],v[i]));
+	}
+
+	for(int j=0; j<num_sol; j++)
+	{
+		bl[j] /= bl_scale;
+		vec3_assign(rpy,0,bl[j],0);
+		rpyMat(Ry,rpy);
+		mat33_t _m1;
+		mat33_mult(_m1,Rz,Ry);
+		mat33_mult(sol[j].R,_m1,RzN_tr);
+		vec3_copy(sol[j].t,Tnew[j]);
+		real_t E = 0;
+		for(i=0; i<n; i++)
+		{
+			mat33_t _m2;
+			mat33_eye(_m2);
+			mat33_sub(_m2,V[i]);
+			vec3_t _v1;
+			vec3_mult(_v1,sol[j].R,P[i]);
+			vec3_add(_v1,sol[j].t);
+			vec3_t _v2;
+			vec3_mult(_v2,_m2,_v1);
+			vec3_mult(_v2,_v2);
+			E += vec3_sum(_v2);
+		}
+		sol[j].E = E;
+	}
+
+	return num_sol;
+}
+
+// =====================================================================================
+
+int get2ndPose_Exact4(pose_t sol[4], const vec3_array4 v, const vec3_array4 P,
+					  const mat33_t &R, const vec3_t &t, const real_t DB)
+{
+	unsigned int i;
+	const unsigned int n = 4;
+
+	vec3_t cent, _v1, _vn;
+	vec3_clear(_v1);
+	for(i=0; i<n; i++)
+	{
+		normRv(_vn,v[i]);
+		vec3_add(_v1,_vn);
+	}
+	vec3_div(_v1,real_t(n));
+	normRv(cent,_v1);
+	mat33_t Rim;
+	vec3_clear(_v1);
+	_v1.v[2] = 1.0f;
+	GetRotationbyVector(Rim,_v1,cent);
+	vec3_array4 v_;
+	for(i=0; i<n; i++) vec3_mult(v_[i],Rim,v[i]);
+	mat33_t R_;
+	vec3_t  t_;
+	mat33_mult(R_,Rim,R);
+	vec3_mult(t_,Rim,t);
+	const int num_sol = getRfor2ndPose_V_Exact4(sol,v_,P,R_,t_,DB);
+	mat33_t Rim_tr;
+	mat33_transpose(Rim_tr,Rim);
+	for(int j=0; j<num_sol; j++)
+	{
+		vec3_t _t;
+		mat33_t _R;
+		vec3_mult(_t,Rim_tr,sol[j].t);
+		mat33_mult(_R,Rim_tr,sol[j].R);
+
+		vec3_copy(sol[j].t,_t);
+		mat33_copy(sol[j].R,_R);
+	}
+
+	return num_sol;
+}
+
+// =====================================================================================
+void robust_pose4(real_t &err, mat33_t &R, vec3_t &t,
+				  const vec3_array4 model, const vec3_array4 iprts,
+				  const options_t &_options)
+{
+	mat33_t Rlu_;
+	vec3_t tlu_;
+	unsigned int it1_;
+	real_t obj_err1_;
+	real_t img_err1_;
+
+	options_t options;
+	memcpy(&options,&_options,sizeof(options_t));
+
+	mat33_clear(Rlu_);
+	vec3_clear(tlu_);
+	it1_ = 0;
+	obj_err1_ = 0;
+	img_err1_ = 0;
+
+	objpose4(Rlu_, tlu_, it1_, obj_err1_, img_err1_, true, model, iprts, options);
+
+	pose_t sol[4];
+	const int num_sol = get2ndPose_Exact4(sol,iprts,model,Rlu_,tlu_,0);
+	int min_err_idx = (-1);
+	real_t min_err = MAX_FLOAT;
+	for(int i=0; i<num_sol; i++)
+	{
+		mat33_copy(options.initR,sol[i].R);
+		objpose4(Rlu_, tlu_, it1_, obj_err1_, img_err1_, true, model, iprts, options);
+		mat33_copy(sol[i].PoseLu_R,Rlu_);
+		vec3_copy(sol[i].PoseLu_t,tlu_);
+		sol[i].obj_err = obj_err1_;
+		if(sol[i].obj_err < min_err)
+		{
+			min_err = sol[i].obj_err;
+			min_err_idx = i;
+		}
+	}
+
+	if(min_err_idx >= 0)
+	{
+		mat33_copy(R,sol[min_err_idx].PoseLu_R);
+		vec3_copy(t,sol[min_err_idx].PoseLu_t);
+		err = sol[min_err_idx].obj_err;
+	}
+	else
+	{
+		mat33_clear(R);
+		vec3_clear(t);
+		err = MAX_FLOAT;
+	}
+}
+
 // ----------------------------------------
 } // namespace rpp
 
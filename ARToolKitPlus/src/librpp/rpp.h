@@ -73,6 +73,28 @@ void get2ndPose_Exact(pose_vec &sol, const vec3_array &v, const vec3_array &P,
 void robust_pose(real_t &err, mat33_t &R, vec3_t &t,
 				 const vec3_array &_model, const vec3_array &_iprts,
 				 const options_t _options);
+
+// ------------------------------------------------------------------------------------------
+// same as above for exactly four points, all arrays are fixed-size and nothing
+// is allocated on the heap. the functions return the number of solutions found.
+void xform4(vec3_array4 Q, const vec3_array4 P, const mat33_t &R, const vec3_t &t);
+void xformproj4(vec3_array4 Qp, const vec3_array4 P, const mat33_t &R, const vec3_t &t);
+void abskernel4(mat33_t &R, vec3_t &t, vec3_array4 Qout, real_t &err2,
+				const vec3_array4 _P, const vec3_array4 _Q,
+				const mat33_array4 F, const mat33_array4 IF, const mat33_t &G);
+void objpose4(mat33_t &R, vec3_t &t, unsigned int &it, real_t &obj_err, real_t &img_err,
+			  bool calc_img_err, const vec3_array4 _P, const vec3_array4 Qp, const options_t &options);
+int getRotationY_wrtT4(real_t al_ret[4], vec3_t tnew[4], const vec3_array4 v,
+					   const vec3_array4 p, const vec3_t &t, const real_t &DB,
+					   const mat33_t &Rz);
+int getRfor2ndPose_V_Exact4(pose_t sol[4], const vec3_array4 v, const vec3_array4 P,
+							const mat33_t &R, const vec3_t &t, const real_t DB);
+int get2ndPose_Exact4(pose_t sol[4], const vec3_array4 v, const vec3_array4 P,
+					  const mat33_t &R, const vec3_t &t, const real_t DB);
+
+void robust_pose4(real_t &err, mat33_t &R, vec3_t &t,
+				  const vec3_array4 model, const vec3_array4 iprts,
+				  const options_t &_options);
 // ------------------------------------------------------------------------------------------
 } // namespace rpp
 
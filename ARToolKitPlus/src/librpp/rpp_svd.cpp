@@ -47,18 +47,34 @@ namespace rpp {
 typedef double SVD_FLOAT;
 
 
-static SVD_FLOAT at,bt,ct;
-static SVD_FLOAT maxarg1,maxarg2;
+// the classic macros kept their temporaries in static variables, which
+// breaks when several trackers estimate poses in parallel.
+//
+inline SVD_FLOAT svd_pythag(SVD_FLOAT a, SVD_FLOAT b)
+{
+	SVD_FLOAT at=fabs(a), bt=fabs(b), ct;
+	if(at > bt) { ct=bt/at; return at*sqrt(SVD_FLOAT(1.0f)+ct*ct); }
+	if(bt) { ct=at/bt; return bt*sqrt(SVD_FLOAT(1.0f)+ct*ct); }
+	return SVD_FLOAT(0.0);
+}
 
-#define PYTHAG(a,b) ((at=fabs(a)) > (bt=fabs(b)) ? \
-    (ct=bt/at,at*sqrt(SVD_FLOAT(1.0f)+ct*ct)) : (bt ? (ct=at/bt,bt*sqrt(SVD_FLOAT(1.0f)+ct*ct)): SVD_FLOAT(0.0)))
+inline SVD_FLOAT svd_max(SVD_FLOAT a, SVD_FLOAT b)
+{
+	return a > b ? a : b;
+}
 
-#define MAX(a,b) (maxarg1=(a),maxarg2=(b),(maxarg1) > (maxarg2) ? (maxarg1) : (maxarg2))
+#define PYTHAG(a,b) svd_pythag(a,b)
+
+#define MAX(a,b) svd_max(a,b)
 
 #define SIGN(a,b) ((b) >= SVD_FLOAT(0.0f) ? fabs(a) : -fabs(a))
 
 
-int svdcmp( double **a, int m,int n, double *w,double **v)
+// written against a row accessor, so that the 3x3 version below can work
+// on plain arrays and have its loop bounds known at compile time.
+//
+template <typename MAT>
+inline int svdcmp_t( MAT a, int m,int n, double *w, MAT v)
 {
     int flag,i,its,j,jj,k,ii=0,nm=0;
     SVD_FLOAT c,f,h,s,x,y,z;
@@ -255,6 +271,16 @@ int svdcmp( double **a, int m,int n, double *w,double **v)
     return 0;
 }
 
+int svdcmp( double **a, int m,int n, double *w,double **v)
+{
+	return svdcmp_t<double**>(a,m,n,w,v);
+}
+
+int svdcmp3( double a[3][3], double w[3], double v[3][3])
+{
+	return svdcmp_t<double(*)[3]>(a,3,3,w,v);
+}
+
 #undef SIGN
 #undef MAX
 #undef PYTHAG
@@ -80,6 +80,10 @@ typedef std::vector<mat33_t>::const_iterator mat33_array_const_iter;
 
 typedef std::vector<real_t> scalar_array;
 
+// fixed-size arrays for the four corners of a marker, see robust_pose4()
+typedef vec3_t vec3_array4[4];
+typedef mat33_t mat33_array4[4];
+
 
 
 struct pose_t
@@ -44,12 +44,14 @@
 #include "rpp_vecmat.h"
 #include "math.h"
 #include "assert.h"
+#include <stdio.h>
 
 
 namespace rpp {
 
 
 int svdcmp( double **a, int m,int n, double *w, double **v);
+int svdcmp3( double a[3][3], double w[3], double v[3][3]);
 int quintic(double [], double [], double [], int*, double);
 int quartic(double[], double[], double[], int* );
 int cubic(double[], double[], int*);
@@ -728,30 +730,31 @@ void vec3_array_mult(vec3_array &va, const mat33_t &m, const vec3_array &vb)
 
 void mat33_svd2(mat33_t &u, mat33_t &s, mat33_t &v, const mat33_t &m)
 {
-	mat33_clear(u);
-	mat33_clear(v);
+	// this is called in every RPP iteration: use the fixed-size svdcmp
+	// on arrays on the stack instead of allocating row pointers
+	double a[3][3], v_rows[3][3];
+	double q[3] = { 0, 0, 0 };
 
-	double** m_ptr = mat33_to_double_pptr(m);
-	double** v_ptr = mat33_to_double_pptr(v);
-
-	vec3_t q;
-	vec3_clear(q);
-	double*  q_ptr = vec3_to_double_ptr(q);
+	for(int r=0; r<3; r++)
+		for(int c=0; c<3; c++)
+		{
+			a[r][c] = (double) m.m[r][c];
+			v_rows[r][c] = 0;
+		}
 
-	/*int ret =*/ svdcmp(m_ptr, 3, 3, q_ptr, v_ptr);
+	/*int ret =*/ svdcmp3(a, q, v_rows);
 
-	mat33_from_double_pptr(u,m_ptr);
-	mat33_from_double_pptr(v,v_ptr);
-	vec3_from_double_ptr(q,q_ptr);
+	for(int r=0; r<3; r++)
+		for(int c=0; c<3; c++)
+		{
+			u.m[r][c] = (real_t) a[r][c];
+			v.m[r][c] = (real_t) v_rows[r][c];
+		}
 
 	mat33_clear(s);
-	s.m[0][0] = (real_t)q_ptr[0];
-	s.m[1][1] = (real_t)q_ptr[1];
-	s.m[2][2] = (real_t)q_ptr[2];
-
-	free_double_pptr(&m_ptr);
-	free_double_pptr(&v_ptr);
-	free_double_ptr(&q_ptr);
+	s.m[0][0] = (real_t)q[0];
+	s.m[1][1] = (real_t)q[1];
+	s.m[2][2] = (real_t)q[2];
 }
 
 void quat_mult(quat_t &q, const real_t s)
@@ -52,7 +52,7 @@ real_t _atan2(real_t a, real_t b);
 real_t _abs(real_t a);
 real_t _acos(real_t a);
 real_t _sqrt(real_t a);
-real_t _pow(real_t a);
+real_t _pow(real_t a, real_t b);
 
 void mat33_from_double_pptr(mat33_t &mat, double** m_ptr);
 double ** mat33_to_double_pptr(const mat33_t &mat);
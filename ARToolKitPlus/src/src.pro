@@ -22,6 +22,7 @@ release {
 }
 
 SOURCES = MemoryManager.cpp \
+        MemoryManagerArena.cpp \
         DLL.cpp \
 	librpp/rpp.cpp \
 	librpp/rpp_quintic.cpp \
@@ -29,7 +30,9 @@ SOURCES = MemoryManager.cpp \
 	librpp/rpp_svd.cpp \
 	librpp/librpp.cpp \
         extra/Profiler.cpp \
-        extra/FixedPoint.cpp
+        extra/FixedPoint.cpp \
+        extra/ThreadPool.cpp \
+        UndistCache.cpp
 
 HEADERS = \
         ../include/ARToolKitPlus/ARToolKitPlus.h \
@@ -40,6 +43,7 @@ HEADERS = \
         ../include/ARToolKitPlus/ImageGrabber.h \
         ../include/ARToolKitPlus/Logger.h \
         ../include/ARToolKitPlus/MemoryManager.h \
+        ../include/ARToolKitPlus/MemoryManagerArena.h \
         ../include/ARToolKitPlus/MemoryManagerMemMap.h \
         ../include/ARToolKitPlus/Tracker.h \
         ../include/ARToolKitPlus/TrackerImpl.h \
@@ -47,6 +51,7 @@ HEADERS = \
         ../include/ARToolKitPlus/TrackerMultiMarkerImpl.h \
         ../include/ARToolKitPlus/TrackerSingleMarker.h \
         ../include/ARToolKitPlus/TrackerSingleMarkerImpl.h \
+        ../include/ARToolKitPlus/UndistCache.h \
         ../include/ARToolKitPlus/ar.h \
         ../include/ARToolKitPlus/arBitFieldPattern.h \
         ../include/ARToolKitPlus/arMulti.h \
@@ -60,7 +65,8 @@ HEADERS_EXTRA = \
         ../include/ARToolKitPlus/extra/BCH.h \
         ../include/ARToolKitPlus/extra/GPP.h \
         ../include/ARToolKitPlus/extra/Profiler.h \
-        ../include/ARToolKitPlus/extra/rpp.h
+        ../include/ARToolKitPlus/extra/rpp.h \
+        ../include/ARToolKitPlus/extra/ThreadPool.h
 
 target.path = ""/$$LIBDIR
 headers.path = ""/$$PREFIX/include/ARToolKitPlus
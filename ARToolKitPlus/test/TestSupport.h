@@ -0,0 +1,130 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#ifndef __ARTOOLKITPLUS_TESTSUPPORT_HEADERFILE__
+#define __ARTOOLKITPLUS_TESTSUPPORT_HEADERFILE__
+
+
+#include <ARToolKitPlus/TrackerSingleMarkerImpl.h>
+#include <stdio.h>
+
+
+// small self registering test and benchmark runner for ARToolKitPlus.
+//
+// tests return true on success and are all run by default. long tests
+// (minutes) and benchmarks, which print their timings, only run if
+// requested on the command line.
+//
+namespace ARToolKitPlusTest {
+
+
+typedef bool (*TestFunc)();
+
+
+enum TEST_KIND {
+	TEST_DEFAULT,
+	TEST_LONG,
+	TEST_BENCHMARK
+};
+
+
+struct TestEntry
+{
+	const char* name;
+	TestFunc func;
+	TEST_KIND kind;
+	TestEntry* next;
+};
+
+
+/// adds a test to the global list (used by the ARTKP_TEST macros)
+class TestRegistrar
+{
+public:
+	TestRegistrar(TestEntry& nEntry, const char* nName, TestFunc nFunc, TEST_KIND nKind);
+};
+
+
+/// the tracker type used by all tests
+typedef ARToolKitPlus::TrackerSingleMarkerImpl<6,6,6, 1, 8> TestTracker;
+
+
+/// returns the current time in seconds
+double getTime();
+
+/// returns the path of a file in ARToolKitPlus/data ($ARTKP/data or ../data)
+const char* getDataFile(const char* nName);
+
+/// reads a raw 8-bit image of nWidth x nHeight pixels from the data directory
+unsigned char* loadRawImage(const char* nName, int nWidth, int nHeight);
+
+/// copies a tile nCols x nRows times into a new image
+unsigned char* tileImage(const unsigned char* nTile, int nWidth, int nHeight, int nCols, int nRows);
+
+/// draws the id marker nID, nSize pixels wide, at nX,nY into an image nWidth pixels wide
+void drawIDMarker(unsigned char* nImage, int nWidth, int nX, int nY, int nSize, int nID, bool nBCH);
+
+/// creates a LUM tracker set up for the id marker test images
+TestTracker* createTestTracker(int nWidth, int nHeight, bool nBCH);
+
+
+}  // namespace ARToolKitPlusTest
+
+
+#define ARTKP_TEST_ENTRY(NAME, KIND) \
+	static bool NAME(); \
+	static ARToolKitPlusTest::TestEntry NAME##Entry; \
+	static ARToolKitPlusTest::TestRegistrar NAME##Registrar(NAME##Entry, #NAME, NAME, ARToolKitPlusTest::KIND); \
+	static bool NAME()
+
+#define ARTKP_TEST(NAME)  ARTKP_TEST_ENTRY(NAME, TEST_DEFAULT)
+#define ARTKP_LONG_TEST(NAME)  ARTKP_TEST_ENTRY(NAME, TEST_LONG)
+#define ARTKP_BENCHMARK(NAME)  ARTKP_TEST_ENTRY(NAME, TEST_BENCHMARK)
+
+#define ARTKP_CHECK(COND) \
+	do { \
+		if(!(COND)) { \
+			printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #COND); \
+			return false; \
+		} \
+	} while(0)
+
+
+#endif //__ARTOOLKITPLUS_TESTSUPPORT_HEADERFILE__
@@ -0,0 +1,270 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include "TestSupport.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+
+namespace ARToolKitPlusTest {
+
+
+static TestEntry* testList = NULL;
+
+
+TestRegistrar::TestRegistrar(TestEntry& nEntry, const char* nName, TestFunc nFunc, TEST_KIND nKind)
+{
+	// appended, so tests run in the order of the source files
+	TestEntry** last = &testList;
+	while(*last)
+		last = &(*last)->next;
+
+	nEntry.name = nName;
+	nEntry.func = nFunc;
+	nEntry.kind = nKind;
+	nEntry.next = NULL;
+	*last = &nEntry;
+}
+
+
+double
+getTime()
+{
+#if defined(WIN32) || defined(_WIN32_WCE)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec*1e-6;
+#endif
+}
+
+
+const char*
+getDataFile(const char* nName)
+{
+	static char path[1024];
+	const char* root = getenv("ARTKP");
+
+	if(root)
+		sprintf(path, "%.900s/data/%.100s", root, nName);
+	else
+		sprintf(path, "../data/%.100s", nName);
+	return path;
+}
+
+
+unsigned char*
+loadRawImage(const char* nName, int nWidth, int nHeight)
+{
+	FILE* fp = fopen(getDataFile(nName), "rb");
+	if(!fp)
+		return NULL;
+
+	unsigned char* image = new unsigned char[nWidth*nHeight];
+	size_t numRead = fread(image, 1, nWidth*nHeight, fp);
+	fclose(fp);
+
+	if(numRead!=(size_t)(nWidth*nHeight))
+	{
+		delete [] image;
+		return NULL;
+	}
+	return image;
+}
+
+
+unsigned char*
+tileImage(const unsigned char* nTile, int nWidth, int nHeight, int nCols, int nRows)
+{
+	int width = nWidth*nCols;
+	unsigned char* image = new unsigned char[width*nHeight*nRows];
+
+	for(int ty=0; ty<nRows; ty++)
+		for(int tx=0; tx<nCols; tx++)
+			for(int y=0; y<nHeight; y++)
+				memcpy(image + (ty*nHeight+y)*width + tx*nWidth, nTile + y*nWidth, nWidth);
+	return image;
+}
+
+
+void
+drawIDMarker(unsigned char* nImage, int nWidth, int nX, int nY, int nSize, int nID, bool nBCH)
+{
+	ARToolKitPlus::IDPATTERN pattern;
+	int border = (int)(nSize*(nBCH ? 0.125f : 0.250f) + 0.5f), cells = ARToolKitPlus::idPattWidth;
+
+	if(nBCH)
+		ARToolKitPlus::generatePatternBCH(nID, pattern);
+	else
+		ARToolKitPlus::generatePatternSimple(nID, pattern);
+
+	// the first cell is the highest bit, as in bitfield_check_simple/BCH()
+	for(int y=0; y<nSize; y++)
+		for(int x=0; x<nSize; x++)
+		{
+			unsigned char val = 0;
+			int cx = (x-border)*cells/(nSize-2*border), cy = (y-border)*cells/(nSize-2*border);
+
+			if(x>=border && y>=border && cx<cells && cy<cells)
+				val = ((pattern>>(ARToolKitPlus::pattBits-1-cy*cells-cx))&1) ? 255 : 0;
+			nImage[nX+x + (nY+y)*nWidth] = val;
+		}
+}
+
+
+TestTracker*
+createTestTracker(int nWidth, int nHeight, bool nBCH)
+{
+	TestTracker* tracker = new TestTracker(nWidth, nHeight);
+
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	if(!tracker->init(getDataFile("no_distortion.cal"), 1.0f, 1000.0f))
+	{
+		delete tracker;
+		return NULL;
+	}
+
+	tracker->setPatternWidth(80);
+	tracker->setBorderWidth(nBCH ? 0.125f : 0.250f);
+	tracker->setThreshold(150);
+	tracker->setUndistortionMode(ARToolKitPlus::UNDIST_NONE);
+	tracker->setMarkerMode(nBCH ? ARToolKitPlus::MARKER_ID_BCH : ARToolKitPlus::MARKER_ID_SIMPLE);
+	return tracker;
+}
+
+
+}  // namespace ARToolKitPlusTest
+
+
+using namespace ARToolKitPlusTest;
+
+
+// the library headers define non-template code (camera, BCH) and may only be
+// included by one translation unit, so the tests are compiled as part of this file
+//
+#include "testBinarization.cxx"
+#include "testThreadPool.cxx"
+#include "testUndistCache.cxx"
+#include "testAllocations.cxx"
+#include "testBCH.cxx"
+#include "testBitField.cxx"
+#include "testPatternSampler.cxx"
+#include "testPose.cxx"
+#include "testUndistModes.cxx"
+#include "testLabeling.cxx"
+#include "testManyMarkers.cxx"
+#include "testCandidates.cxx"
+#include "testLineFit.cxx"
+#include "testPatternMatch.cxx"
+#include "testAutoThreshold.cxx"
+#include "testPoseHistory.cxx"
+#include "testRpp.cxx"
+#include "testFloorHomography.cxx"
+
+
+static bool
+isSelected(const TestEntry* nEntry, int argc, char** argv)
+{
+	if(argc<2)
+		return nEntry->kind==TEST_DEFAULT;
+
+	for(int i=1; i<argc; i++)
+	{
+		if(!strcmp(argv[i], nEntry->name))
+			return true;
+		if(!strcmp(argv[i], "long") && nEntry->kind==TEST_LONG)
+			return true;
+		if(!strcmp(argv[i], "bench") && nEntry->kind==TEST_BENCHMARK)
+			return true;
+		if(!strcmp(argv[i], "all"))
+			return true;
+	}
+	return false;
+}
+
+
+// usage: artkptest                 runs all tests
+//        artkptest long            runs the long tests
+//        artkptest bench           runs all benchmarks
+//        artkptest all             runs everything
+//        artkptest <name> ...      runs the given tests or benchmarks
+//        artkptest list            lists all names
+//
+int
+main(int argc, char** argv)
+{
+	int numRun = 0, numFailed = 0;
+	TestEntry* entry;
+
+	if(argc==2 && !strcmp(argv[1], "list"))
+	{
+		for(entry=testList; entry; entry=entry->next)
+			printf("%s%s\n", entry->name, entry->kind==TEST_LONG ? " (long)" : (entry->kind==TEST_BENCHMARK ? " (benchmark)" : ""));
+		return 0;
+	}
+
+	for(entry=testList; entry; entry=entry->next)
+	{
+		if(!isSelected(entry, argc, argv))
+			continue;
+
+		printf("[ run  ] %s\n", entry->name);
+		fflush(stdout);
+
+		bool ok = entry->func();
+		printf("[ %s ] %s\n", ok ? " ok " : "FAIL", entry->name);
+		numRun++;
+		if(!ok)
+			numFailed++;
+	}
+
+	printf("%d run, %d failed\n", numRun, numFailed);
+	return (numFailed>0 || numRun==0) ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+################################
+#
+# QMake definitions for the test and benchmark runner
+#
+
+include ($$(ARTKP)/build/linux/options.pro)
+
+TEMPLATE = app
+
+TARGET   = artkptest
+
+DESTDIR  = $$(ARTKP)/bin
+
+INCLUDEPATH += ../include
+
+LIBS += -L$$(ARTKP)/lib -lARToolKitPlus
+
+unix {
+  LIBS += -lpthread -lrt
+}
+
+# testFloorHomography.cxx tests the floor localization of tdloc
+SOURCES = main.cpp \
+        ../../tdloc_win/tdloc_win/artag/FloorHomography.cpp
+
+# labelingManyComponents checks the 16-bit label limit by default, add
+# DEFINES += _USE_LABEL32_ here and to the library for the 32-bit labels
+
+# the test sources are included by main.cpp
+HEADERS = TestSupport.h \
+        testBinarization.cxx \
+        testThreadPool.cxx \
+        testUndistCache.cxx \
+        testAllocations.cxx \
+        testBCH.cxx \
+        testBitField.cxx \
+        testPatternSampler.cxx \
+        testPose.cxx \
+        testUndistModes.cxx \
+        testLabeling.cxx \
+        testManyMarkers.cxx \
+        testCandidates.cxx \
+        testLineFit.cxx \
+        testPatternMatch.cxx \
+        testAutoThreshold.cxx \
+        testPoseHistory.cxx \
+        testRpp.cxx \
+        testFloorHomography.cxx
+
+################################
@@ -0,0 +1,190 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <ARToolKitPlus/MemoryManager.h>
+#include <new>
+
+
+// heap allocations are counted while allocCounting is set: all of malloc
+// with glibc, operator new elsewhere, and everything that goes through
+// artkp_Alloc() via a counting MemoryManager.
+//
+static int allocCounting = 0;
+static long allocCount = 0;
+
+
+#ifdef __GLIBC__
+
+extern "C" void* __libc_malloc(size_t nSize);
+extern "C" void* __libc_calloc(size_t nNum, size_t nSize);
+extern "C" void* __libc_realloc(void* nPtr, size_t nSize);
+
+extern "C" void*
+malloc(size_t nSize)
+{
+	if(allocCounting)
+		allocCount++;
+	return __libc_malloc(nSize);
+}
+
+extern "C" void*
+calloc(size_t nNum, size_t nSize)
+{
+	if(allocCounting)
+		allocCount++;
+	return __libc_calloc(nNum, nSize);
+}
+
+extern "C" void*
+realloc(void* nPtr, size_t nSize)
+{
+	if(allocCounting)
+		allocCount++;
+	return __libc_realloc(nPtr, nSize);
+}
+
+#else
+
+void*
+operator new(size_t nSize)
+{
+	if(allocCounting)
+		allocCount++;
+	void* ptr = malloc(nSize ? nSize : 1);
+	if(!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t nSize)  {  return operator new(nSize);  }
+void operator delete(void* nPtr)  {  free(nPtr);  }
+void operator delete[](void* nPtr)  {  free(nPtr);  }
+
+#endif //__GLIBC__
+
+
+class CountingMemoryManager : public ARToolKitPlus::MemoryManager
+{
+public:
+	CountingMemoryManager() : count(0)  {}
+
+	bool init(size_t, size_t)  {  return true;  }
+	bool deinit()  {  return true;  }
+	bool didInit()  {  return true;  }
+
+	void* getMemory(size_t nNumBytes)
+	{
+		if(allocCounting)
+			count++;
+		return malloc(nNumBytes);
+	}
+
+	void releaseMemory(void* nMemoryBlock)  {  free(nMemoryBlock);  }
+	unsigned int getBytesAllocated()  {  return 0;  }
+
+	long count;
+};
+
+
+static const char* poseEstimatorNames[] = {  "ORIGINAL", "ORIGINAL_CONT", "RPP", "IPPE"  };
+
+
+// after a few warm-up frames, detection and pose estimation must not touch
+// the heap anymore: the per-frame scratch memory comes from the frame arena
+// and buffers only grow while the scene gets busier.
+//
+ARTKP_TEST(steadyStateAllocations)
+{
+	const int numFrames = 50, numMarkers = 16;
+
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_simple_nr031.raw", 320, 240);
+	ARTKP_CHECK(tile!=NULL);
+	unsigned char* image = tileImage(tile, 320, 240, 4, 4);
+	delete [] tile;
+
+	CountingMemoryManager memManager;
+	ARToolKitPlus::setMemoryManager(&memManager);
+
+	bool ok = true;
+	for(int estimator=ARToolKitPlus::POSE_ESTIMATOR_ORIGINAL; estimator<=ARToolKitPlus::POSE_ESTIMATOR_IPPE && ok; estimator++)
+	{
+		TestTracker* tracker = new TestTracker(1280, 960);
+		tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+		ARTKP_CHECK(tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f));
+		tracker->setPatternWidth(80);
+		tracker->setBorderWidth(0.250f);
+		tracker->setThreshold(150);
+		tracker->setUndistortionMode(ARToolKitPlus::UNDIST_STD);
+		tracker->setMarkerMode(ARToolKitPlus::MARKER_ID_SIMPLE);
+		tracker->setPoseEstimator((ARToolKitPlus::POSE_ESTIMATOR)estimator);
+
+		ARToolKitPlus::ARMarkerInfo* info;
+		ARFloat center[2] = {  0.0f, 0.0f  }, conv[3][4], matrices[numMarkers][16];
+		int num = 0, numPoses = 0;
+
+		for(int frame=0; frame<5+numFrames; frame++)
+		{
+			if(frame==5)
+			{
+				allocCount = memManager.count = 0;
+				allocCounting = 1;
+			}
+
+			tracker->calc(image, -1, false, &info, &num);
+			for(int i=0; i<num; i++)
+				if(info[i].id>=0)
+					tracker->executeSingleMarkerPoseEstimator(&info[i], center, 80.0f, conv);
+			numPoses = tracker->estimatePoses(info, num, center, 80.0f, matrices);
+		}
+		allocCounting = 0;
+
+		printf("  %-13s %2d markers, %d poses: %ld heap allocations, %ld artkp_Alloc calls in %d frames\n",
+			   poseEstimatorNames[estimator], num, numPoses, allocCount, memManager.count, numFrames);
+
+		ok = num==numMarkers && numPoses==numMarkers && allocCount==0 && memManager.count==0;
+		delete tracker;
+	}
+
+	ARToolKitPlus::setMemoryManager(NULL);
+	delete [] image;
+
+	ARTKP_CHECK(ok);
+	return true;
+}
@@ -0,0 +1,180 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// the histogram based retries of auto thresholding
+
+
+// gives access to the auto threshold state
+class ThresholdTestTracker : public TestTracker
+{
+public:
+	typedef TestTracker::AutoThreshold Threshold;
+
+	ThresholdTestTracker(int nWidth, int nHeight) : TestTracker(nWidth, nHeight)
+	{}
+};
+
+
+// the 320x240 simple id test image with its grey values mapped to nOffset + nGain*value
+static unsigned char*
+createDimImage(const unsigned char* nTile, float nGain, int nOffset)
+{
+	unsigned char* image = new unsigned char[320*240];
+
+	for(int i=0; i<320*240; i++)
+	{
+		int v = nOffset + (int)(nGain*nTile[i]);
+		image[i] = (unsigned char)(v>255 ? 255 : v);
+	}
+	return image;
+}
+
+
+// with a histogram of two classes the retries are the global Otsu threshold
+// and then Otsu of the dark and of the bright part. thresholds within
+// MIN_THRESH_DIST of one that already failed are skipped.
+//
+ARTKP_TEST(retryThresholdSkipsFailed)
+{
+	ThresholdTestTracker::Threshold at;
+	int i;
+
+	at.resetHistogram();
+	at.reset();
+	for(i=30; i<=50; i++)
+		at.histogram[i] = 100 + (i%3);
+	for(i=60; i<=70; i++)
+		at.histogram[i] = 40;
+	for(i=190; i<=210; i++)
+		at.histogram[i] = 300 - (i%5);
+	for(i=230; i<=240; i++)
+		at.histogram[i] = 20;
+
+	int otsu = at.calcOtsu(0, 255), dark = at.calcOtsu(0, otsu), bright = at.calcOtsu(otsu+1, 255);
+	printf("  Otsu %d, dark part %d, bright part %d\n", otsu, dark, bright);
+	ARTKP_CHECK(otsu>70 && otsu<190);
+	ARTKP_CHECK(dark>50 && dark<60 && bright>210 && bright<230);
+
+	// in order, skipping nothing
+	ARTKP_CHECK(at.getRetryThreshold(10)==otsu);
+	ARTKP_CHECK(at.getRetryThreshold(otsu)==dark);
+	ARTKP_CHECK(at.getRetryThreshold(dark)==bright);
+	ARTKP_CHECK(at.getRetryThreshold(bright)==-1);
+
+	// a first try close to the global threshold or the dark part skips them
+	at.reset();
+	ARTKP_CHECK(at.getRetryThreshold(otsu+ThresholdTestTracker::Threshold::MIN_THRESH_DIST-1)==dark);
+	ARTKP_CHECK(at.getRetryThreshold(dark)==bright);
+	ARTKP_CHECK(at.getRetryThreshold(bright)==-1);
+
+	at.reset();
+	ARTKP_CHECK(at.getRetryThreshold(dark-3)==otsu);
+	ARTKP_CHECK(at.getRetryThreshold(otsu)==bright);
+	ARTKP_CHECK(at.getRetryThreshold(bright)==-1);
+
+	// one class only
+	at.resetHistogram();
+	at.reset();
+	at.histogram[100] = 1000;
+	ARTKP_CHECK(at.getRetryThreshold(150)==-1);
+	return true;
+}
+
+
+// a bright, low contrast image (grey values 200 to 225) with a start threshold
+// of 150: the histogram retry finds the marker in the first frame and keeps it,
+// the random retries of the original code ((rand()%230)+10, two per frame) in
+// only a few frames
+//
+ARTKP_TEST(retryThresholdFindsDimMarker)
+{
+	const int numFrames = 200;
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_simple_nr031.raw", 320, 240);
+	ARTKP_CHECK(tile!=NULL);
+	unsigned char* image = createDimImage(tile, 0.1f, 200);
+	delete [] tile;
+
+	TestTracker* tracker = createTestTracker(320, 240, false);
+	ARTKP_CHECK(tracker!=NULL);
+
+	ARToolKitPlus::ARMarkerInfo* info;
+	int num, numRandom = 0, numOtsu = 0, firstOtsu = -1;
+
+	srand(5);
+	for(int frame=0; frame<numFrames; frame++)
+	{
+		bool found = false;
+		for(int pass=0; pass<3 && !found; pass++)
+		{
+			num = 0;
+			found = tracker->arDetectMarkerLite(image, pass==0 ? 150 : (rand()%230)+10, &info, &num)>=0 && num>0 && info[0].id>=0;
+		}
+		if(found)
+			numRandom++;
+	}
+
+	tracker->activateAutoThreshold(true);
+	tracker->setNumAutoThresholdRetries(2);
+	tracker->setThreshold(150);
+	for(int frame=0; frame<numFrames; frame++)
+	{
+		num = 0;
+		if(tracker->arDetectMarkerLite(image, tracker->getThreshold(), &info, &num)>=0 && num>0 && info[0].id>=0)
+		{
+			numOtsu++;
+			if(firstOtsu<0)
+				firstOtsu = frame;
+		}
+	}
+
+	printf("  %d frames: marker found in %d with random retries, in %d with histogram retries (first in frame %d)\n",
+		   numFrames, numRandom, numOtsu, firstOtsu);
+
+	delete tracker;
+	delete [] image;
+
+	ARTKP_CHECK(firstOtsu==0 && numOtsu==numFrames);
+	ARTKP_CHECK(numRandom<numFrames/2);
+	return true;
+}
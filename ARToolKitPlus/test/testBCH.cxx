@@ -0,0 +1,237 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+using ARToolKitPlus::_64bits;
+using ARToolKitPlus::BCH;
+using ARToolKitPlus::BCHCodebook;
+
+
+enum {
+	BCHTEST_NUM_IDS = 1<<BCH_DEFAULT_K,
+	BCHTEST_NUM_PATTERNS = 66712		// error patterns with at most BCH_DEFAULT_T bits, including 0
+};
+
+static const _64bits bchTestOne = 1;
+
+
+static int
+getBCHErrorPatterns(_64bits* nPatterns)
+{
+	int num = 0;
+
+	nPatterns[num++] = 0;
+	for(int i=0; i<BCH_DEFAULT_LENGTH; i++)
+	{
+		nPatterns[num++] = bchTestOne<<i;
+		for(int j=i+1; j<BCH_DEFAULT_LENGTH; j++)
+		{
+			nPatterns[num++] = (bchTestOne<<i) | (bchTestOne<<j);
+			for(int k=j+1; k<BCH_DEFAULT_LENGTH; k++)
+			{
+				nPatterns[num++] = (bchTestOne<<i) | (bchTestOne<<j) | (bchTestOne<<k);
+				for(int l=k+1; l<BCH_DEFAULT_LENGTH; l++)
+					nPatterns[num++] = (bchTestOne<<i) | (bchTestOne<<j) | (bchTestOne<<k) | (bchTestOne<<l);
+			}
+		}
+	}
+
+	return num;
+}
+
+
+static _64bits
+getRandomBCHWord()
+{
+	// rand() may only deliver 15 bits
+	_64bits word = 0;
+	for(int i=0; i<3; i++)
+		word = (word<<15) ^ (_64bits)rand();
+	return word & ((bchTestOne<<BCH_DEFAULT_LENGTH)-1);
+}
+
+
+// both decoders have to return nId with nNumErrors corrected bits
+static bool
+checkBCHDecode(BCH& nBCH, const BCHCodebook& nCodebook, _64bits nWord, int nNumErrors, int nId)
+{
+	int errBCH = -1, errCodebook = -1;
+	_64bits idBCH = 0, idCodebook = 0;
+
+	bool okBCH = nBCH.decode(errBCH, idBCH, nWord);
+	bool okCodebook = nCodebook.decode(errCodebook, idCodebook, nWord);
+
+	return okBCH && okCodebook && errBCH==nNumErrors && errCodebook==nNumErrors &&
+		   idBCH==(_64bits)nId && idCodebook==(_64bits)nId;
+}
+
+
+// every codeword is encoded identically and every correctable error pattern
+// (each on another codeword) is decoded identically. both decoders are linear,
+// so the result only depends on the pattern; bchCodebookExhaustive checks the
+// full product. words further than BCH_DEFAULT_T bits from every codeword are
+// rejected by the codebook, while BCH::decode() often reports them as
+// corrected, so for those only the codebook's bound is checked.
+//
+ARTKP_TEST(bchCodebookMatchesDecoder)
+{
+	BCH bch;
+	BCHCodebook* codebook = new BCHCodebook;
+	_64bits* codewords = new _64bits[BCHTEST_NUM_IDS];
+	_64bits* patterns = new _64bits[BCHTEST_NUM_PATTERNS];
+
+	for(int id=0; id<BCHTEST_NUM_IDS; id++)
+	{
+		bch.encode(codewords[id], id);
+		ARTKP_CHECK(BCHCodebook::encode(id)==codewords[id]);
+	}
+
+	ARTKP_CHECK(getBCHErrorPatterns(patterns)==BCHTEST_NUM_PATTERNS);
+	for(int i=0; i<BCHTEST_NUM_PATTERNS; i++)
+	{
+		int id = i%BCHTEST_NUM_IDS;
+		ARTKP_CHECK(checkBCHDecode(bch, *codebook, codewords[id]^patterns[i], ARToolKitPlus::_popCount(patterns[i]), id));
+	}
+
+	int numRejected = 0, numRejectedBCH = 0;
+	srand(1);
+	for(int i=0; i<20000; i++)
+	{
+		_64bits word = getRandomBCHWord(), idCodebook;
+		int errCodebook;
+
+		if(codebook->decode(errCodebook, idCodebook, word))
+		{
+			ARTKP_CHECK(checkBCHDecode(bch, *codebook, word, errCodebook, (int)idCodebook));
+			continue;
+		}
+
+		int minDist = BCH_DEFAULT_LENGTH;
+		for(int id=0; id<BCHTEST_NUM_IDS; id++)
+		{
+			int dist = ARToolKitPlus::_popCount(word^codewords[id]);
+			if(dist<minDist)
+				minDist = dist;
+		}
+		ARTKP_CHECK(minDist>BCH_DEFAULT_T);
+		ARTKP_CHECK(errCodebook==BCH_DEFAULT_T+1);
+
+		int errBCH;
+		_64bits idBCH;
+		numRejected++;
+		if(!bch.decode(errBCH, idBCH, word))
+			numRejectedBCH++;
+	}
+	printf("  random words: %d uncorrectable, BCH::decode rejected %d of them\n", numRejected, numRejectedBCH);
+
+	delete [] patterns;
+	delete [] codewords;
+	delete codebook;
+	return true;
+}
+
+
+// all 4096 codewords with all 66712 correctable error patterns
+// (about 7 minutes, BCH::decode() is the bottleneck)
+//
+ARTKP_LONG_TEST(bchCodebookExhaustive)
+{
+	BCH bch;
+	BCHCodebook* codebook = new BCHCodebook;
+	_64bits* patterns = new _64bits[BCHTEST_NUM_PATTERNS];
+
+	ARTKP_CHECK(getBCHErrorPatterns(patterns)==BCHTEST_NUM_PATTERNS);
+
+	for(int id=0; id<BCHTEST_NUM_IDS; id++)
+	{
+		_64bits codeword = BCHCodebook::encode(id);
+		for(int i=0; i<BCHTEST_NUM_PATTERNS; i++)
+			ARTKP_CHECK(checkBCHDecode(bch, *codebook, codeword^patterns[i], ARToolKitPlus::_popCount(patterns[i]), id));
+	}
+
+	delete [] patterns;
+	delete codebook;
+	return true;
+}
+
+
+// decode throughput for codewords with 0..5 random bit errors
+//
+ARTKP_BENCHMARK(benchBCHDecode)
+{
+	const int numWords = 1<<18;
+	BCH bch;
+	BCHCodebook* codebook = new BCHCodebook;
+	_64bits* words = new _64bits[numWords];
+
+	srand(1);
+	for(int i=0; i<numWords; i++)
+	{
+		words[i] = BCHCodebook::encode(rand()%BCHTEST_NUM_IDS);
+		for(int e=rand()%6; e>0; e--)
+			words[i] ^= bchTestOne<<(rand()%BCH_DEFAULT_LENGTH);
+	}
+
+	int err;
+	_64bits id, sum = 0;
+
+	double t0 = getTime();
+	for(int i=0; i<numWords; i++)
+		if(bch.decode(err, id, words[i]))
+			sum += id;
+	double timeBCH = getTime()-t0;
+
+	t0 = getTime();
+	for(int i=0; i<numWords; i++)
+		if(codebook->decode(err, id, words[i]))
+			sum += id;
+	double timeCodebook = getTime()-t0;
+
+	t0 = getTime();
+	BCHCodebook* codebook2 = new BCHCodebook;
+	double timeBuild = getTime()-t0;
+
+	printf("  BCH::decode %.2f M words/s, BCHCodebook::decode %.2f M words/s (x%.0f), codebook build %.2f ms [%d]\n",
+		   numWords/timeBCH*1e-6, numWords/timeCodebook*1e-6, timeBCH/timeCodebook, timeBuild*1000.0, (int)(sum&1));
+
+	delete codebook2;
+	delete [] words;
+	delete codebook;
+	return true;
+}
@@ -0,0 +1,183 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+// gives access to the labeling stage alone
+class LabelingTracker : public TestTracker
+{
+public:
+	LabelingTracker(int nWidth, int nHeight) : TestTracker(nWidth, nHeight)
+	{}
+
+	int label(ARToolKitPlus::ARUint8* nImage, int nThresh)
+	{
+		int labelNum = 0, *area, *clip, *labelRef;
+		ARFloat* pos;
+
+		this->arLabeling(this->defaultContext, nImage, nThresh, &labelNum, &area, &pos, &clip, &labelRef);
+		return labelNum;
+	}
+};
+
+
+struct LabelingFrame
+{
+	LabelingTracker* tracker;
+	unsigned char* image;
+	int width, height;
+};
+
+
+static bool
+setupFrame(LabelingFrame& nFrame, int nCols, int nRows)
+{
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_bch_nr0100.raw", 320, 240);
+	if(!tile)
+		return false;
+
+	nFrame.width = 320*nCols;
+	nFrame.height = 240*nRows;
+	nFrame.image = tileImage(tile, 320, 240, nCols, nRows);
+	delete [] tile;
+
+	nFrame.tracker = new LabelingTracker(nFrame.width, nFrame.height);
+	nFrame.tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	if(!nFrame.tracker->init(getDataFile("no_distortion.cal"), 1.0f, 1000.0f))
+		return false;
+	nFrame.tracker->setPatternWidth(80);
+	nFrame.tracker->setBorderWidth(0.125f);
+	nFrame.tracker->setUndistortionMode(ARToolKitPlus::UNDIST_NONE);
+	nFrame.tracker->setMarkerMode(ARToolKitPlus::MARKER_ID_BCH);
+	return true;
+}
+
+
+static void
+freeFrame(LabelingFrame& nFrame)
+{
+	delete nFrame.tracker;
+	delete [] nFrame.image;
+}
+
+
+static int
+detect(LabelingFrame& nFrame, int nThresh, ARToolKitPlus::ARMarkerInfo* nInfo, int nMaxNum)
+{
+	ARToolKitPlus::ARMarkerInfo* info;
+	int num = 0;
+
+	if(nFrame.tracker->arDetectMarkerLite(nFrame.image, nThresh, &info, &num)<0)
+		return -1;
+	if(num>nMaxNum)
+		num = nMaxNum;
+	memcpy(nInfo, info, num*sizeof(ARToolKitPlus::ARMarkerInfo));
+	return num;
+}
+
+
+// the binarization pass must not change the detection result, with and
+// without vignetting compensation (darkening and brightening, so that the
+// thresholds clamp at both ends) and over the whole threshold range
+//
+ARTKP_TEST(binarizationMatchesLUM)
+{
+	const int corrections[3][3] = {  {0, 0, 0}, {-60, -40, -20}, {60, 40, 20}  };
+	LabelingFrame frame;
+	ARToolKitPlus::ARMarkerInfo infoLUM[64], infoBIN[64];
+
+	ARTKP_CHECK(setupFrame(frame, 2, 2));
+
+	for(int vignetting=0; vignetting<3; vignetting++)
+	{
+		frame.tracker->activateVignettingCompensation(vignetting!=0, corrections[vignetting][0],
+													  corrections[vignetting][1], corrections[vignetting][2]);
+
+		for(int thresh=30; thresh<=230; thresh+=20)
+		{
+			frame.tracker->activateBinarization(false);
+			int numLUM = detect(frame, thresh, infoLUM, 64);
+			frame.tracker->activateBinarization(true);
+			int numBIN = detect(frame, thresh, infoBIN, 64);
+
+			ARTKP_CHECK(numLUM>=0 && numLUM==numBIN);
+			ARTKP_CHECK(memcmp(infoLUM, infoBIN, numLUM*sizeof(ARToolKitPlus::ARMarkerInfo))==0);
+		}
+	}
+
+	freeFrame(frame);
+	return true;
+}
+
+
+// labeling time per 640x480 frame (four 320x240 test images) with the
+// per-pixel LUM loop and with the packed binarization pass
+//
+ARTKP_BENCHMARK(benchBinarization)
+{
+	const int numReps = 200;
+	LabelingFrame frame;
+
+	ARTKP_CHECK(setupFrame(frame, 2, 2));
+
+	for(int vignetting=0; vignetting<2; vignetting++)
+	{
+		frame.tracker->activateVignettingCompensation(vignetting!=0, -60, -40, -20);
+
+		for(int useBin=0; useBin<2; useBin++)
+		{
+			frame.tracker->activateBinarization(useBin!=0);
+
+			double best = 1e9;
+			int numLabels = 0;
+			for(int i=0; i<numReps; i++)
+			{
+				double t0 = getTime();
+				numLabels = frame.tracker->label(frame.image, 150);
+				double dt = getTime()-t0;
+				if(dt<best)
+					best = dt;
+			}
+
+			printf("  %dx%d vignetting %-3s %-12s %3d labels  %.3f ms/frame\n", frame.width, frame.height,
+				   vignetting ? "on" : "off", useBin ? "binarized" : "per-pixel", numLabels, best*1000.0);
+		}
+	}
+
+	freeFrame(frame);
+	return true;
+}
@@ -0,0 +1,298 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+// the bit by bit rotation and voting the table driven
+// versions in arBitFieldPattern.cxx have to match
+//
+static void
+rotate90CWBitwise(ARToolKitPlus::IDPATTERN& nPattern)
+{
+	ARToolKitPlus::IDPATTERN one = 1, tmpPat = nPattern;
+	nPattern = 0;
+
+	for(int i=0; i<ARToolKitPlus::pattBits; i++)
+		if((tmpPat>>ARToolKitPlus::rotate90[i]) & 1)
+			nPattern |= (one<<i);
+}
+
+
+static void
+checkPatternSimpleBitwise(ARToolKitPlus::IDPATTERN nPattern, int& nID, float& nProp)
+{
+	static const float propForSum[5] = {  1.00f, 0.50f, 0.00f, 0.50f, 1.00f  };
+
+	nProp = 0.0f;
+	nID = 0;
+
+	ARToolKitPlus::applyMaskSimple(nPattern);
+
+	for(int i=0; i<ARToolKitPlus::idBits; i++)
+	{
+		int sum = (int)(nPattern>>(ARToolKitPlus::posMask0+i))&1;
+		sum += (int)(nPattern>>(ARToolKitPlus::posMask1+i))&1;
+		sum += (int)(nPattern>>(ARToolKitPlus::posMask2+i))&1;
+		sum += (int)(nPattern>>(ARToolKitPlus::posMask3+i))&1;
+
+		nProp += propForSum[sum];
+		if(sum>=3)
+			nID |= 1<<i;
+	}
+
+	nProp /= (float)ARToolKitPlus::idBits;
+	if(nProp<0.9f)
+		nProp = 0.0f;
+}
+
+
+static ARToolKitPlus::IDPATTERN
+getRandomIDPattern()
+{
+	ARToolKitPlus::IDPATTERN pattern = 0;
+	for(int i=0; i<3; i++)
+		pattern = (pattern<<15) ^ (ARToolKitPlus::IDPATTERN)rand();
+	return pattern & (((ARToolKitPlus::IDPATTERN)1<<ARToolKitPlus::pattBits)-1);
+}
+
+
+// gives access to the id pattern checks
+class BitFieldTracker : public TestTracker
+{
+public:
+	BitFieldTracker() : TestTracker(320, 240)
+	{
+		this->setMarkerMode(ARToolKitPlus::MARKER_ID_BCH);
+	}
+
+	int checkSimple(ARToolKitPlus::ARUint8* nData, int* nCode, int* nDir, ARFloat* nCF)
+	{
+		return this->bitfield_check_simple(nData, nCode, nDir, nCF, 128);
+	}
+
+	int checkBCH(ARToolKitPlus::ARUint8* nData, int* nCode, int* nDir, ARFloat* nCF)
+	{
+		return this->bitfield_check_BCH(nData, nCode, nDir, nCF, 128);
+	}
+};
+
+
+enum {
+	BITFIELDTEST_CANDIDATE_SIZE = 6*6*3
+};
+
+
+// renders a pattern as the 6x6 RGB image bitfield_check_*() get
+static void
+renderIDPattern(ARToolKitPlus::IDPATTERN nPattern, ARToolKitPlus::ARUint8* nImage)
+{
+	for(int i=0; i<ARToolKitPlus::pattBits; i++)
+	{
+		ARToolKitPlus::ARUint8 val = ((nPattern>>i)&1) ? 200 : 50;
+		ARToolKitPlus::ARUint8* pixel = nImage + (ARToolKitPlus::pattBits-1-i)*3;
+		pixel[0] = pixel[1] = pixel[2] = val;
+	}
+}
+
+
+// a mix of random patterns and simple and BCH markers in random
+// orientations with up to four flipped bits
+//
+static ARToolKitPlus::ARUint8*
+createIDCandidates(int nNum)
+{
+	ARToolKitPlus::ARUint8* images = new ARToolKitPlus::ARUint8[nNum*BITFIELDTEST_CANDIDATE_SIZE];
+	const ARToolKitPlus::IDPATTERN one = 1;
+
+	srand(7);
+	for(int k=0; k<nNum; k++)
+	{
+		ARToolKitPlus::IDPATTERN pattern;
+
+		if(k%4==0)
+			pattern = getRandomIDPattern();
+		else
+		{
+			if(k%4==1)
+				ARToolKitPlus::generatePatternSimple(rand()&ARToolKitPlus::idMask, pattern);
+			else
+				ARToolKitPlus::generatePatternBCH(rand()&(BCHTEST_NUM_IDS-1), pattern);
+
+			for(int r=rand()%4; r>0; r--)
+				rotate90CWBitwise(pattern);
+			for(int f=rand()%5; f>0; f--)
+				pattern ^= one<<(rand()%ARToolKitPlus::pattBits);
+		}
+
+		renderIDPattern(pattern, images + k*BITFIELDTEST_CANDIDATE_SIZE);
+	}
+
+	return images;
+}
+
+
+ARTKP_TEST(idPatternTablesMatchBitwise)
+{
+	srand(3);
+	for(int i=0; i<1000000; i++)
+	{
+		ARToolKitPlus::IDPATTERN pattern = getRandomIDPattern(), rotated = pattern;
+		int id, idBitwise;
+		float prop, propBitwise;
+
+		ARToolKitPlus::rotate90CW(rotated);
+		rotate90CWBitwise(pattern);
+		ARTKP_CHECK(rotated==pattern);
+
+		ARToolKitPlus::checkPatternSimple(pattern, id, prop);
+		checkPatternSimpleBitwise(pattern, idBitwise, propBitwise);
+		ARTKP_CHECK(id==idBitwise && prop==propBitwise);
+	}
+
+	// every marker is found in every orientation
+	BitFieldTracker tracker;
+	ARToolKitPlus::ARUint8 image[BITFIELDTEST_CANDIDATE_SIZE];
+	int code, dir, dir0 = -1;
+	ARFloat cf;
+
+	for(int id=0; id<=ARToolKitPlus::idMax; id+=7)
+		for(int r=0; r<4; r++)
+		{
+			ARToolKitPlus::IDPATTERN pattern;
+			ARToolKitPlus::generatePatternSimple(id, pattern);
+			for(int i=0; i<r; i++)
+				rotate90CWBitwise(pattern);
+			renderIDPattern(pattern, image);
+
+			tracker.checkSimple(image, &code, &dir, &cf);
+			ARTKP_CHECK(code==id && cf==1.0f);
+			if(r==0)
+				dir0 = dir;
+			ARTKP_CHECK(dir==(dir0+r)%4 || dir==(dir0+4-r)%4);
+		}
+
+	for(int id=0; id<BCHTEST_NUM_IDS; id+=13)
+		for(int r=0; r<4; r++)
+		{
+			ARToolKitPlus::IDPATTERN pattern;
+			ARToolKitPlus::generatePatternBCH(id, pattern);
+			for(int i=0; i<r; i++)
+				rotate90CWBitwise(pattern);
+			renderIDPattern(pattern, image);
+
+			tracker.checkBCH(image, &code, &dir, &cf);
+			ARTKP_CHECK(code==id && cf==1.0f);
+		}
+
+	return true;
+}
+
+
+// time per candidate for bitfield_check_simple() and bitfield_check_BCH(),
+// and for the rotation and voting steps alone against the bitwise versions
+//
+ARTKP_BENCHMARK(benchBitFieldCheck)
+{
+	const int numCandidates = 1<<16, numReps = 10;
+	ARToolKitPlus::ARUint8* images = createIDCandidates(numCandidates);
+	ARToolKitPlus::IDPATTERN* patterns = new ARToolKitPlus::IDPATTERN[numCandidates];
+	BitFieldTracker tracker;
+	int code, dir, sum = 0;
+	ARFloat cf;
+	double t0, timeSimple, timeBCH, timeTables, timeBitwise;
+
+	t0 = getTime();
+	for(int r=0; r<numReps; r++)
+		for(int k=0; k<numCandidates; k++)
+		{
+			tracker.checkSimple(images + k*BITFIELDTEST_CANDIDATE_SIZE, &code, &dir, &cf);
+			sum += code+dir;
+		}
+	timeSimple = (getTime()-t0) / (numReps*numCandidates);
+
+	t0 = getTime();
+	for(int r=0; r<numReps; r++)
+		for(int k=0; k<numCandidates; k++)
+		{
+			tracker.checkBCH(images + k*BITFIELDTEST_CANDIDATE_SIZE, &code, &dir, &cf);
+			sum += code+dir;
+		}
+	timeBCH = (getTime()-t0) / (numReps*numCandidates);
+
+	srand(5);
+	for(int k=0; k<numCandidates; k++)
+		patterns[k] = getRandomIDPattern();
+
+	// three rotations and four votes, as for one candidate
+	t0 = getTime();
+	for(int r=0; r<numReps; r++)
+		for(int k=0; k<numCandidates; k++)
+		{
+			ARToolKitPlus::IDPATTERN pattern = patterns[k];
+			float prop;
+			for(int i=0; i<4; i++)
+			{
+				ARToolKitPlus::checkPatternSimple(pattern, code, prop);
+				ARToolKitPlus::rotate90CW(pattern);
+				sum += code;
+			}
+		}
+	timeTables = (getTime()-t0) / (numReps*numCandidates);
+
+	t0 = getTime();
+	for(int r=0; r<numReps; r++)
+		for(int k=0; k<numCandidates; k++)
+		{
+			ARToolKitPlus::IDPATTERN pattern = patterns[k];
+			float prop;
+			for(int i=0; i<4; i++)
+			{
+				checkPatternSimpleBitwise(pattern, code, prop);
+				rotate90CWBitwise(pattern);
+				sum += code;
+			}
+		}
+	timeBitwise = (getTime()-t0) / (numReps*numCandidates);
+
+	printf("  bitfield_check_simple %.1f ns, bitfield_check_BCH %.1f ns per candidate\n", timeSimple*1e9, timeBCH*1e9);
+	printf("  rotate and vote 4 orientations: tables %.1f ns, bitwise %.1f ns [%d]\n", timeTables*1e9, timeBitwise*1e9, sum&1);
+
+	delete [] patterns;
+	delete [] images;
+	return true;
+}
@@ -0,0 +1,238 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <string.h>
+#include <stdlib.h>
+
+
+// removeNestedCandidates() against the double loop of the original
+// arDetectMarker2() on random candidate sets
+
+enum {
+	CANDTEST_MAX = 1024
+};
+
+
+// gives access to the candidate buffer of the default context
+class CandidateTestTracker : public TestTracker
+{
+public:
+	CandidateTestTracker() : TestTracker(640, 480)
+	{}
+
+	ARToolKitPlus::ARMarkerInfo2* getCandidates(int nNum)
+	{
+		this->defaultContext->growMarkerBuffers(nNum);
+		return this->defaultContext->marker_infoTWO;
+	}
+
+	int removeNested(int nNum)  {  return this->removeNestedCandidates(this->defaultContext, nNum);  }
+
+	static int getHashMin()  {  return NESTED_CANDIDATES_HASH_MIN;  }
+};
+
+
+// random areas and centers within nSpread pixels (0: a random spread up to
+// 620 pixels), some candidates copy the area of an earlier one or lie right
+// next to it. coord_num keeps the original index.
+static void
+createRandomCandidates(ARToolKitPlus::ARMarkerInfo2* nCand, int nNum, int nSpread)
+{
+	int spread = nSpread ? nSpread : 20 + rand()%600;
+
+	for(int i=0; i<nNum; i++)
+	{
+		ARToolKitPlus::ARMarkerInfo2& m = nCand[i];
+
+		m.area = 70 + rand()%(rand()%2 ? 200 : 20000);
+		if(rand()%5==0 && i)
+			m.area = nCand[rand()%i].area;
+		m.pos[0] = (rand()%(spread*100))/100.0f;
+		m.pos[1] = (rand()%(spread*100))/100.0f;
+		if(rand()%4==0 && i)
+		{
+			int k = rand()%i;
+			m.pos[0] = nCand[k].pos[0] + (rand()%200-100)/10.0f;
+			if(m.pos[0]<0)
+				m.pos[0] = 0;
+			m.pos[1] = nCand[k].pos[1];
+		}
+		m.coord_num = i;
+	}
+}
+
+
+// the suppression loop of the original arDetectMarker2(), sets the area of the dropped candidates to 0
+static void
+suppressNestedReference(ARToolKitPlus::ARMarkerInfo2* nCand, int nNum)
+{
+	for(int i=0; i<nNum; i++)
+		for(int j=i+1; j<nNum; j++)
+		{
+			ARFloat d = (nCand[i].pos[0]-nCand[j].pos[0])*(nCand[i].pos[0]-nCand[j].pos[0]) +
+						(nCand[i].pos[1]-nCand[j].pos[1])*(nCand[i].pos[1]-nCand[j].pos[1]);
+			if(nCand[i].area>nCand[j].area)
+			{
+				if(d<nCand[i].area/4)
+					nCand[j].area = 0;
+			}
+			else
+			{
+				if(d<nCand[j].area/4)
+					nCand[i].area = 0;
+			}
+		}
+}
+
+
+// the compaction loop of the original arDetectMarker2(), which does not
+// check the candidate that moves into a removed slot again
+static int
+compactNestedReference(ARToolKitPlus::ARMarkerInfo2* nCand, int nNum)
+{
+	for(int i=0; i<nNum; i++)
+		if(nCand[i].area==0)
+		{
+			for(int j=i+1; j<nNum; j++)
+				nCand[j-1] = nCand[j];
+			nNum--;
+		}
+	return nNum;
+}
+
+
+// the same candidates survive in the same order, below and above
+// NESTED_CANDIDATES_HASH_MIN. the original compaction kept some
+// suppressed candidates, those are counted but not compared.
+//
+ARTKP_TEST(nestedCandidatesMatchDoubleLoop)
+{
+	CandidateTestTracker tracker;
+	ARToolKitPlus::ARMarkerInfo2* ref = new ARToolKitPlus::ARMarkerInfo2[CANDTEST_MAX];
+	ARToolKitPlus::ARMarkerInfo2* old = new ARToolKitPlus::ARMarkerInfo2[CANDTEST_MAX];
+	int numMismatches = 0, numOldKept = 0, numHashed = 0;
+
+	srand(1);
+	for(int set=0; set<4000; set++)
+	{
+		int num = 2 + (set%2 ? rand()%100 : rand()%600);
+		ARToolKitPlus::ARMarkerInfo2* cand = tracker.getCandidates(num);
+
+		createRandomCandidates(ref, num, 0);
+		memcpy(cand, ref, num*sizeof(ARToolKitPlus::ARMarkerInfo2));
+
+		suppressNestedReference(ref, num);
+		memcpy(old, ref, num*sizeof(ARToolKitPlus::ARMarkerInfo2));
+		int numOld = compactNestedReference(old, num);
+
+		int numRef = 0;
+		for(int i=0; i<num; i++)
+			if(ref[i].area!=0)
+				ref[numRef++] = ref[i];
+
+		int numGot = tracker.removeNested(num);
+		cand = tracker.getCandidates(num);
+
+		bool same = numGot==numRef;
+		for(int i=0; same && i<numGot; i++)
+			same = cand[i].coord_num==ref[i].coord_num && cand[i].area==ref[i].area;
+
+		if(!same)
+			numMismatches++;
+		if(numOld!=numRef)
+			numOldKept++;
+		if(num>=CandidateTestTracker::getHashMin())
+			numHashed++;
+	}
+
+	printf("  4000 sets (%d hashed): %d mismatches, the original compaction kept suppressed candidates in %d\n",
+		   numHashed, numMismatches, numOldKept);
+
+	delete [] ref;
+	delete [] old;
+
+	ARTKP_CHECK(numMismatches==0);
+	return true;
+}
+
+
+// suppression time of the double loop and of removeNestedCandidates(), with
+// the candidates spread over a 2560x1920 frame and clustered in a few cells
+//
+ARTKP_BENCHMARK(benchNestedCandidates)
+{
+	CandidateTestTracker tracker;
+	ARToolKitPlus::ARMarkerInfo2* base = new ARToolKitPlus::ARMarkerInfo2[CANDTEST_MAX];
+	ARToolKitPlus::ARMarkerInfo2* ref = new ARToolKitPlus::ARMarkerInfo2[CANDTEST_MAX];
+
+	for(int spread=1920; spread>0; spread/=16)
+		for(int num=64; num<=CANDTEST_MAX; num*=2)
+		{
+			const int numRuns = 200;
+			double tRef = 0.0, tHash = 0.0;
+
+			srand(num);
+			for(int r=0; r<numRuns; r++)
+			{
+				createRandomCandidates(base, num, spread);
+
+				memcpy(ref, base, num*sizeof(ARToolKitPlus::ARMarkerInfo2));
+				double t0 = getTime();
+				suppressNestedReference(ref, num);
+				compactNestedReference(ref, num);
+				double t1 = getTime();
+
+				memcpy(tracker.getCandidates(num), base, num*sizeof(ARToolKitPlus::ARMarkerInfo2));
+				double t2 = getTime();
+				tracker.removeNested(num);
+				double t3 = getTime();
+
+				tRef += t1-t0;
+				tHash += t3-t2;
+			}
+
+			printf("  %4d candidates within %4d pixels: %7.1f us double loop, %6.1f us removeNestedCandidates()\n",
+				   num, spread, tRef*1e6/numRuns, tHash*1e6/numRuns);
+		}
+
+	delete [] base;
+	delete [] ref;
+	return true;
+}
@@ -0,0 +1,232 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../tdloc_win/tdloc_win/artag/FloorHomography.h"
+
+
+// the floor plane localization of tdloc's ARtagLocalizer: tags on a floor
+// seen through a known homography
+
+
+static const float floorTestH[9] = {  1.9f, 0.12f, -410.0f,   -0.08f, 2.05f, -260.0f,   0.00021f, -0.00014f, 1.0f  };
+
+
+static void
+invertFloorMatrix(const double nM[9], double nInv[9])
+{
+	double adj[9] = {  nM[4]*nM[8]-nM[5]*nM[7], nM[2]*nM[7]-nM[1]*nM[8], nM[1]*nM[5]-nM[2]*nM[4],
+					   nM[5]*nM[6]-nM[3]*nM[8], nM[0]*nM[8]-nM[2]*nM[6], nM[2]*nM[3]-nM[0]*nM[5],
+					   nM[3]*nM[7]-nM[4]*nM[6], nM[1]*nM[6]-nM[0]*nM[7], nM[0]*nM[4]-nM[1]*nM[3]  };
+	double det = nM[0]*adj[0] + nM[1]*adj[3] + nM[2]*adj[6];
+
+	for(int i=0; i<9; i++)
+		nInv[i] = adj[i]/det;
+}
+
+
+// a tag of nSize mm at nX,nY on the floor, turned by nHeading, seen through the
+// image to floor homography nH and detected with direction nDir. corner i of
+// the pattern, in the order of the pose estimators (model coordinates
+// (-w/2,w/2), (w/2,w/2), (w/2,-w/2), (-w/2,-w/2)), is vertex (4-dir+i)%4. the
+// tag faces the camera: its x axis is (cos,sin) and its y axis (sin,-cos)
+static void
+projectFloorTag(const float nH[9], float nX, float nY, float nHeading, float nSize, int nDir, ARToolKitPlus::ARMarkerInfo& nMarker)
+{
+	const float corners[4][2] = {  {-0.5f, 0.5f}, {0.5f, 0.5f}, {0.5f, -0.5f}, {-0.5f, -0.5f}  };
+	double H[9], G[9], c = cos(nHeading), s = sin(nHeading);
+
+	for(int i=0; i<9; i++)
+		H[i] = nH[i];
+	invertFloorMatrix(H, G);
+
+	memset(&nMarker, 0, sizeof(nMarker));
+	nMarker.dir = nDir;
+	for(int i=0; i<4; i++)
+	{
+		double mx = corners[i][0]*nSize, my = corners[i][1]*nSize,
+			   fx = nX + c*mx + s*my, fy = nY + s*mx - c*my,
+			   w = G[6]*fx + G[7]*fy + G[8];
+		ARFloat* vertex = nMarker.vertex[(4-nDir+i)%4];
+
+		vertex[0] = (ARFloat)((G[0]*fx + G[1]*fy + G[2])/w);
+		vertex[1] = (ARFloat)((G[3]*fx + G[4]*fy + G[5])/w);
+	}
+}
+
+
+static float
+getHeadingError(float nCos, float nSin, float nHeading)
+{
+	float d = (float)atan2(nSin, nCos) - nHeading;
+
+	return (float)fabs(atan2(sin(d), cos(d)));
+}
+
+
+// getFloorPose() puts the tag center and heading into the model view matrix
+// with z = 0, for every direction the tag can be detected in
+//
+ARTKP_TEST(floorPoseFromHomography)
+{
+	float maxPosErr = 0.0f, maxHeadingErr = 0.0f;
+
+	for(int t=0; t<200; t++)
+	{
+		float x = 200.0f + 15.0f*(t%40), y = 150.0f + 40.0f*(t/40), heading = -3.1f + 0.031f*t;
+
+		for(int dir=0; dir<4; dir++)
+		{
+			ARToolKitPlus::ARMarkerInfo marker;
+			float pose[16];
+
+			projectFloorTag(floorTestH, x, y, heading, 180.0f, dir, marker);
+			getFloorPose(floorTestH, marker, pose);
+
+			float posErr = (float)sqrt((pose[12]-x)*(pose[12]-x) + (pose[13]-y)*(pose[13]-y)),
+				  headingErr = getHeadingError(pose[0], pose[1], heading);
+
+			if(posErr>maxPosErr)
+				maxPosErr = posErr;
+			if(headingErr>maxHeadingErr)
+				maxHeadingErr = headingErr;
+
+			ARTKP_CHECK(pose[14]==0.0f && pose[15]==1.0f && pose[10]==-1.0f);
+			ARTKP_CHECK(pose[4]==pose[1] && pose[5]==-pose[0]);
+		}
+	}
+
+	printf("  max error %.4f mm %.5f deg\n", maxPosErr, maxHeadingErr*180.0f/3.14159265f);
+
+	ARTKP_CHECK(maxPosErr<0.01f);
+	ARTKP_CHECK(maxHeadingErr<0.001f);
+	return true;
+}
+
+
+// for a camera looking straight down the floor homography is the inverse of
+// K*diag(1,1,Z): getFloorPose() must then read the corners in the same order
+// as the tracker and give the heading and position of its IPPE pose
+//
+ARTKP_TEST(floorPoseMatchesTracker)
+{
+	const float distance = 2500.0f;
+	ARFloat center[2] = {  0.0f, 0.0f  }, conv[3][4];
+	float H[9], maxPosDiff = 0.0f, maxHeadingDiff = 0.0f;
+	double G[9], invG[9];
+
+	PoseTestTracker* tracker = new PoseTestTracker(640, 480);
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	ARTKP_CHECK(tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f));
+	tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_IPPE);
+
+	const ARFloat (*K)[4] = tracker->getCamera()->mat;
+	for(int r=0; r<3; r++)
+	{
+		G[r*3+0] = K[r][0];
+		G[r*3+1] = K[r][1];
+		G[r*3+2] = K[r][2]*distance;
+	}
+	invertFloorMatrix(G, invG);
+	for(int i=0; i<9; i++)
+		H[i] = (float)invG[i];
+
+	for(int t=0; t<100; t++)
+	{
+		float x = -600.0f + 12.0f*t, y = -400.0f + 8.0f*t, heading = -3.1f + 0.062f*t;
+
+		for(int dir=0; dir<4; dir++)
+		{
+			ARToolKitPlus::ARMarkerInfo marker;
+			float pose[16];
+
+			projectFloorTag(H, x, y, heading, 180.0f, dir, marker);
+			getFloorPose(H, marker, pose);
+			ARTKP_CHECK(tracker->executeSingleMarkerPoseEstimator(&marker, center, 180.0f, conv)>=0);
+
+			float posDiff = (float)sqrt((pose[12]-conv[0][3])*(pose[12]-conv[0][3]) + (pose[13]-conv[1][3])*(pose[13]-conv[1][3])),
+				  headingDiff = getHeadingError(pose[0], pose[1], (float)atan2(conv[1][0], conv[0][0]));
+
+			if(posDiff>maxPosDiff)
+				maxPosDiff = posDiff;
+			if(headingDiff>maxHeadingDiff)
+				maxHeadingDiff = headingDiff;
+			ARTKP_CHECK(fabs(conv[2][3]-distance)<1.0f);
+		}
+	}
+
+	printf("  max difference to IPPE %.4f mm %.5f deg\n", maxPosDiff, maxHeadingDiff*180.0f/3.14159265f);
+
+	delete tracker;
+
+	ARTKP_CHECK(maxPosDiff<0.1f);
+	ARTKP_CHECK(maxHeadingDiff<0.001f);
+	return true;
+}
+
+
+// readFloorHomography() takes nine whitespace separated numbers and refuses
+// shorter or missing files
+//
+ARTKP_TEST(floorHomographyFile)
+{
+	const char* name = "artkptest_floor.tmp";
+	float H[9];
+	FILE* fp;
+
+	fp = fopen(name, "w");
+	ARTKP_CHECK(fp);
+	fprintf(fp, "%.9g %.9g %.9g\n%.9g %.9g %.9g\n\t%.9g  %.9g %.9g\n", floorTestH[0], floorTestH[1], floorTestH[2],
+			floorTestH[3], floorTestH[4], floorTestH[5], floorTestH[6], floorTestH[7], floorTestH[8]);
+	fclose(fp);
+	ARTKP_CHECK(readFloorHomography(name, H));
+	ARTKP_CHECK(memcmp(H, floorTestH, sizeof(H))==0);
+
+	fp = fopen(name, "w");
+	ARTKP_CHECK(fp);
+	fprintf(fp, "1 0 0\n0 1 0\n0 0\n");
+	fclose(fp);
+	ARTKP_CHECK(!readFloorHomography(name, H));
+
+	remove(name);
+	ARTKP_CHECK(!readFloorHomography(name, H));
+	return true;
+}
@@ -0,0 +1,151 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <string.h>
+
+
+// a 640x480 frame with a 320x240 test image in the top left corner and
+// single black pixels on every other row and column everywhere else: at
+// full resolution about 57000 connected components, more than 16-bit
+// labels can hold
+//
+static unsigned char*
+createManyLabelsImage(const unsigned char* nTile)
+{
+	unsigned char* image = new unsigned char[640*480];
+
+	memset(image, 255, 640*480);
+	for(int y=0; y<240; y++)
+		memcpy(image+y*640, nTile+y*320, 320);
+
+	for(int y=2; y<478; y+=2)
+		for(int x=2; x<638; x+=2)
+			if(x>=324 || y>=244)
+				image[x+y*640] = 0;
+
+	return image;
+}
+
+
+// above AR_LABEL_MAX components labeling gives up for the frame, with
+// _USE_LABEL32_ the work tables keep growing and the marker is found
+//
+ARTKP_TEST(labelingManyComponents)
+{
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_simple_nr031.raw", 320, 240);
+	ARTKP_CHECK(tile!=NULL);
+	unsigned char* image = createManyLabelsImage(tile);
+	delete [] tile;
+
+	TestTracker* tracker = createTestTracker(640, 480, false);
+	ARTKP_CHECK(tracker!=NULL);
+	tracker->setImageProcessingMode(ARToolKitPlus::IMAGE_FULL_RES);
+
+	ARToolKitPlus::ARMarkerInfo* info;
+	ARToolKitPlus::LABELING_MODE modes[2] = {  ARToolKitPlus::LABELING_STD, ARToolKitPlus::LABELING_RLE  };
+	bool ok = true;
+
+	for(int m=0; m<2; m++)
+	{
+		int num = -1, numFound = 0;
+
+		tracker->setLabelingMode(modes[m]);
+		if(tracker->arDetectMarkerLite(image, 150, &info, &num)<0)
+			num = 0;
+		for(int i=0; i<num; i++)
+			if(info[i].id>=0)
+				numFound++;
+
+		printf("  %s labeling, %d bit labels: %d markers\n", m ? "RLE" : "STD", (int)sizeof(ARToolKitPlus::ARLabel)*8, numFound);
+#ifdef _USE_LABEL32_
+		ok = ok && numFound==1;
+#else
+		ok = ok && numFound==0;
+#endif
+	}
+
+	delete tracker;
+	delete [] image;
+
+	ARTKP_CHECK(ok);
+	return true;
+}
+
+
+// after changeCameraSize() the default context and a context created before
+// the change find the same markers as a tracker created at the new size
+//
+ARTKP_TEST(detectAfterChangeCameraSize)
+{
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_simple_nr031.raw", 320, 240);
+	ARTKP_CHECK(tile!=NULL);
+	unsigned char* image = tileImage(tile, 320, 240, 4, 4);
+
+	TestTracker* tracker = createTestTracker(320, 240, false);
+	TestTracker* reference = createTestTracker(1280, 960, false);
+	ARTKP_CHECK(tracker!=NULL && reference!=NULL);
+
+	ARToolKitPlus::DetectionContext* context = tracker->createDetectionContext();
+	ARToolKitPlus::ARMarkerInfo *info, expected[64];
+	int num = 0, numExpected = 0;
+	bool ok = true;
+
+	ok = ok && tracker->arDetectMarker(tile, 150, &info, &num)>=0 && num==1;
+	ok = ok && tracker->arDetectMarker(context, tile, 150, &info, &num)>=0 && num==1;
+
+	ok = ok && reference->arDetectMarker(image, 150, &info, &numExpected)>=0 && numExpected==16;
+	memcpy(expected, info, numExpected*sizeof(ARToolKitPlus::ARMarkerInfo));
+
+	tracker->changeCameraSize(1280, 960);
+
+	ok = ok && tracker->arDetectMarker(image, 150, &info, &num)>=0 && num==numExpected;
+	ok = ok && memcmp(expected, info, num*sizeof(ARToolKitPlus::ARMarkerInfo))==0;
+	ok = ok && tracker->arDetectMarker(context, image, 150, &info, &num)>=0 && num==numExpected;
+	ok = ok && memcmp(expected, info, num*sizeof(ARToolKitPlus::ARMarkerInfo))==0;
+
+	delete context;
+	delete reference;
+	delete tracker;
+	delete [] image;
+	delete [] tile;
+
+	ARTKP_CHECK(ok);
+	return true;
+}
@@ -0,0 +1,264 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <math.h>
+#include <stdlib.h>
+
+
+// the closed-form edge fit of arGetLine2() against the arMatrixPCA() fit
+// it replaced (_USE_PCA_LINE_FIT_), on the contours of random quads
+
+enum {
+	LINETEST_MAX_COORDS = 4*512+1
+};
+
+
+// gives access to the line fit and to arMatrixPCA()
+class LineTestTracker : public TestTracker
+{
+public:
+	LineTestTracker() : TestTracker(640, 480)
+	{}
+
+	int fitLines(int* nX, int* nY, int nNum, int nVertex[5], ARFloat nLine[4][3], ARFloat nV[4][2])
+	{
+		return this->arGetLine2(nX, nY, nNum, nVertex, nLine, nV, this->arCamera);
+	}
+
+	// the _USE_PCA_LINE_FIT_ branch of arGetLine2()
+	int fitLinesPCA(int* nX, int* nY, int nNum, int nVertex[5], ARFloat nLine[4][3], ARFloat nV[4][2])
+	{
+		ARToolKitPlus::ARMat *input, *evec;
+		ARToolKitPlus::ARVec *ev, *mean;
+		ARFloat w1;
+		int st, ed, n, i, j;
+
+		ev = ARToolKitPlus::Vector::alloc(2);
+		mean = ARToolKitPlus::Vector::alloc(2);
+		evec = ARToolKitPlus::Matrix::alloc(2, 2);
+		for(i=0; i<4; i++)
+		{
+			w1 = (ARFloat)(nVertex[i+1]-nVertex[i]+1) * (ARFloat)0.05 + (ARFloat)0.5;
+			st = (int)(nVertex[i] + w1);
+			ed = (int)(nVertex[i+1] - w1);
+			n = ed - st + 1;
+			input = ARToolKitPlus::Matrix::alloc(n, 2);
+			for(j=0; j<n; j++)
+				(this->*arParamObserv2Ideal_func)(this->arCamera, (ARFloat)nX[st+j], (ARFloat)nY[st+j], &input->m[j*2+0], &input->m[j*2+1]);
+
+			int ok = this->arMatrixPCA(input, evec, ev, mean);
+			ARToolKitPlus::Matrix::free(input);
+			if(ok<0)
+				break;
+
+			nLine[i][0] =  evec->m[1];
+			nLine[i][1] = -evec->m[0];
+			nLine[i][2] = -(nLine[i][0]*mean->v[0] + nLine[i][1]*mean->v[1]);
+		}
+		ARToolKitPlus::Matrix::free(evec);
+		ARToolKitPlus::Vector::free(mean);
+		ARToolKitPlus::Vector::free(ev);
+		if(i<4)
+			return -1;
+
+		for(i=0; i<4; i++)
+		{
+			const ARFloat *l0 = nLine[(i+3)%4], *l1 = nLine[i];
+			w1 = l0[0]*l1[1] - l1[0]*l0[1];
+			if(w1==0.0f)
+				return -1;
+			nV[i][0] = (l0[1]*l1[2] - l1[1]*l0[2]) / w1;
+			nV[i][1] = (l1[0]*l0[2] - l0[0]*l1[2]) / w1;
+		}
+		return 0;
+	}
+};
+
+
+// the contour of a random convex quad 30 to 300 pixels wide with up to
+// nNoise pixels of noise, walked pixel by pixel like arGetContour() does
+//
+static int
+createNoisyContour(int* nX, int* nY, int nVertex[5], ARFloat nNoise)
+{
+	ARFloat cx = 160.0f + rand()%320, cy = 120.0f + rand()%240, size = 15.0f + rand()%135,
+			angle = (ARFloat)(rand()%628)/100.0f, corners[4][2];
+	int num = 0;
+
+	for(int i=0; i<4; i++)
+	{
+		ARFloat a = angle + i*1.5708f + (rand()%40-20)/100.0f, r = size*(0.7f + (rand()%60)/100.0f);
+		corners[i][0] = cx + r*(ARFloat)cos(a);
+		corners[i][1] = cy + r*(ARFloat)sin(a);
+	}
+
+	for(int i=0; i<4; i++)
+	{
+		const ARFloat *p = corners[i], *q = corners[(i+1)%4];
+		int steps = (int)(fabs(q[0]-p[0])>fabs(q[1]-p[1]) ? fabs(q[0]-p[0]) : fabs(q[1]-p[1])) + 1;
+
+		nVertex[i] = num;
+		for(int s=0; s<steps && num<LINETEST_MAX_COORDS-1; s++)
+		{
+			ARFloat t = (ARFloat)s/steps;
+			nX[num] = (int)floor(p[0] + t*(q[0]-p[0]) + nNoise*(2.0f*rand()/RAND_MAX-1.0f) + 0.5f);
+			nY[num] = (int)floor(p[1] + t*(q[1]-p[1]) + nNoise*(2.0f*rand()/RAND_MAX-1.0f) + 0.5f);
+			num++;
+		}
+	}
+	nVertex[4] = num;
+	nX[num] = nX[0];
+	nY[num] = nY[0];
+	return num+1;
+}
+
+
+static LineTestTracker*
+createLineTestTracker()
+{
+	LineTestTracker* tracker = new LineTestTracker();
+
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	if(!tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f))
+	{
+		delete tracker;
+		return NULL;
+	}
+	tracker->setUndistortionMode(ARToolKitPlus::UNDIST_STD);
+	return tracker;
+}
+
+
+// both fits give the same lines (up to their sign) and vertices, with and
+// without noise on the contour pixels
+//
+ARTKP_TEST(lineFitMatchesPCA)
+{
+	static int x[LINETEST_MAX_COORDS], y[LINETEST_MAX_COORDS];
+	LineTestTracker* tracker = createLineTestTracker();
+	ARTKP_CHECK(tracker!=NULL);
+
+	double maxVertexDiff = 0.0, maxLineDiff = 0.0;
+	int numFailed = 0, numQuads = 0;
+
+	srand(3);
+	for(int q=0; q<3000; q++)
+	{
+		ARFloat line[4][3], v[4][2], linePCA[4][3], vPCA[4][2];
+		int vertex[5], num = createNoisyContour(x, y, vertex, q%3 ? 1.5f : 0.0f);
+
+		int res = tracker->fitLines(x, y, num, vertex, line, v), resPCA = tracker->fitLinesPCA(x, y, num, vertex, linePCA, vPCA);
+		if(res!=resPCA)
+			numFailed++;
+		if(res<0 || resPCA<0)
+			continue;
+
+		numQuads++;
+		for(int i=0; i<4; i++)
+		{
+			double sign = line[i][0]*linePCA[i][0] + line[i][1]*linePCA[i][1] < 0.0f ? -1.0 : 1.0;
+			for(int k=0; k<3; k++)
+			{
+				// the offset is relative to the distance from the origin
+				double d = fabs(line[i][k]-sign*linePCA[i][k]) / (k==2 ? 1.0+fabs(line[i][2]) : 1.0);
+				if(d>maxLineDiff)
+					maxLineDiff = d;
+			}
+
+			double dx = v[i][0]-vPCA[i][0], dy = v[i][1]-vPCA[i][1], d = sqrt(dx*dx+dy*dy);
+			if(d>maxVertexDiff)
+				maxVertexDiff = d;
+		}
+	}
+
+	printf("  %d quads: %d fail in only one fit, max line difference %g, max vertex difference %g px\n",
+		   numQuads, numFailed, maxLineDiff, maxVertexDiff);
+
+	delete tracker;
+
+	ARTKP_CHECK(numFailed==0);
+	ARTKP_CHECK(maxLineDiff<1e-3 && maxVertexDiff<1e-2);
+	return true;
+}
+
+
+// time per marker (four edges) of both fits, with UNDIST_STD as in the tracker
+//
+ARTKP_BENCHMARK(benchLineFit)
+{
+	static int x[64][LINETEST_MAX_COORDS], y[64][LINETEST_MAX_COORDS];
+	int vertex[64][5], num[64];
+	const int numRuns = 100;
+	ARFloat line[4][3], v[4][2];
+
+	LineTestTracker* tracker = createLineTestTracker();
+	ARTKP_CHECK(tracker!=NULL);
+
+	srand(5);
+	for(int q=0; q<64; q++)
+		num[q] = createNoisyContour(x[q], y[q], vertex[q], 1.0f);
+
+	double t0 = getTime();
+	for(int r=0; r<numRuns; r++)
+		for(int q=0; q<64; q++)
+			tracker->fitLines(x[q], y[q], num[q], vertex[q], line, v);
+	double t1 = getTime();
+	for(int r=0; r<numRuns; r++)
+		for(int q=0; q<64; q++)
+			tracker->fitLinesPCA(x[q], y[q], num[q], vertex[q], line, v);
+	double t2 = getTime();
+
+	tracker->setUndistortionMode(ARToolKitPlus::UNDIST_NONE);
+	double t3 = getTime();
+	for(int r=0; r<numRuns; r++)
+		for(int q=0; q<64; q++)
+			tracker->fitLines(x[q], y[q], num[q], vertex[q], line, v);
+	double t4 = getTime();
+	for(int r=0; r<numRuns; r++)
+		for(int q=0; q<64; q++)
+			tracker->fitLinesPCA(x[q], y[q], num[q], vertex[q], line, v);
+	double t5 = getTime();
+
+	printf("  UNDIST_STD:  %.2f us per marker closed form, %.2f us arMatrixPCA\n", (t1-t0)*1e6/numRuns/64, (t2-t1)*1e6/numRuns/64);
+	printf("  UNDIST_NONE: %.2f us per marker closed form, %.2f us arMatrixPCA\n", (t4-t3)*1e6/numRuns/64, (t5-t4)*1e6/numRuns/64);
+
+	delete tracker;
+	return true;
+}
@@ -0,0 +1,168 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <string.h>
+
+
+// frames with more markers than MAX_IMAGE_PATTERNS (8 for the TestTracker),
+// which the candidate buffers and the tracking history once stopped at
+
+enum {
+	MANYTEST_WIDTH = 1280,
+	MANYTEST_HEIGHT = 960,
+	MANYTEST_MAX_MARKERS = 64,
+	MANYTEST_MARKER_SIZE = 96
+};
+
+
+// nNum BCH markers with the ids nFirstID... on an 8x8 grid, the markers
+// of the ids set in nSkip are left out
+//
+static unsigned char*
+createManyMarkersImage(int nNum, int nFirstID, const bool* nSkip)
+{
+	unsigned char* image = new unsigned char[MANYTEST_WIDTH*MANYTEST_HEIGHT];
+	const int cellW = MANYTEST_WIDTH/8, cellH = MANYTEST_HEIGHT/8;
+
+	memset(image, 255, MANYTEST_WIDTH*MANYTEST_HEIGHT);
+	for(int i=0; i<nNum; i++)
+		if(!nSkip || !nSkip[i])
+			drawIDMarker(image, MANYTEST_WIDTH, (i%8)*cellW + (cellW-MANYTEST_MARKER_SIZE)/2,
+						 (i/8)*cellH + (cellH-MANYTEST_MARKER_SIZE)/2, MANYTEST_MARKER_SIZE, nFirstID+i, true);
+	return image;
+}
+
+
+// counts the markers with the ids nFirstID...nFirstID+nNum-1, each id once
+static int
+countManyMarkers(const ARToolKitPlus::ARMarkerInfo* nInfo, int nNumInfo, int nFirstID, int nNum)
+{
+	bool seen[MANYTEST_MAX_MARKERS];
+	int num = 0;
+
+	memset(seen, 0, sizeof(seen));
+	for(int i=0; i<nNumInfo; i++)
+	{
+		int k = nInfo[i].id-nFirstID;
+		if(k>=0 && k<nNum && !seen[k])
+		{
+			seen[k] = true;
+			num++;
+		}
+	}
+	return num;
+}
+
+
+// all 40 markers of a frame are found, and the 20 that then disappear are
+// still reported from the tracking history for the next two frames
+//
+ARTKP_TEST(detectMoreThanMaxImagePatterns)
+{
+	const int numMarkers = 40, firstID = 100;
+	bool skip[MANYTEST_MAX_MARKERS];
+
+	for(int i=0; i<numMarkers; i++)
+		skip[i] = (i%2)!=0;
+
+	unsigned char* full = createManyMarkersImage(numMarkers, firstID, NULL);
+	unsigned char* half = createManyMarkersImage(numMarkers, firstID, skip);
+
+	TestTracker* tracker = createTestTracker(MANYTEST_WIDTH, MANYTEST_HEIGHT, true);
+	ARTKP_CHECK(tracker!=NULL);
+
+	ARToolKitPlus::ARMarkerInfo* info;
+	int num = 0, found[5];
+
+	ARTKP_CHECK(tracker->arDetectMarkerLite(full, 150, &info, &num)>=0);
+	ARTKP_CHECK(countManyMarkers(info, num, firstID, numMarkers)==numMarkers);
+
+	// history: found in frame 0, missing from frame 1 on, kept while seen less than 4 frames ago
+	for(int frame=0; frame<5; frame++)
+	{
+		num = 0;
+		tracker->arDetectMarker(frame==0 ? full : half, 150, &info, &num);
+		found[frame] = countManyMarkers(info, num, firstID, numMarkers);
+	}
+
+	printf("  %d markers, then %d: found %d %d %d %d %d in frames 0-4\n", numMarkers, numMarkers/2,
+		   found[0], found[1], found[2], found[3], found[4]);
+
+	delete tracker;
+	delete [] full;
+	delete [] half;
+
+	ARTKP_CHECK(found[0]==numMarkers && found[1]==numMarkers && found[2]==numMarkers);
+	ARTKP_CHECK(found[3]==numMarkers/2 && found[4]==numMarkers/2);
+	return true;
+}
+
+
+// detection time per frame and per marker for 1 to 64 markers in a 1280x960 frame
+//
+ARTKP_BENCHMARK(benchManyMarkers)
+{
+	const int numRuns = 20;
+
+	TestTracker* tracker = createTestTracker(MANYTEST_WIDTH, MANYTEST_HEIGHT, true);
+	ARTKP_CHECK(tracker!=NULL);
+
+	for(int numMarkers=1; numMarkers<=MANYTEST_MAX_MARKERS; numMarkers*=2)
+	{
+		unsigned char* image = createManyMarkersImage(numMarkers, 0, NULL);
+		ARToolKitPlus::ARMarkerInfo* info;
+		int num = 0;
+
+		tracker->arDetectMarkerLite(image, 150, &info, &num);
+		int numFound = countManyMarkers(info, num, 0, numMarkers);
+
+		double t0 = getTime();
+		for(int r=0; r<numRuns; r++)
+			tracker->arDetectMarkerLite(image, 150, &info, &num);
+		double t1 = getTime();
+
+		printf("  %2d markers (%2d found): %.2f ms per frame, %.1f us per marker\n", numMarkers, numFound,
+			   (t1-t0)*1e3/numRuns, (t1-t0)*1e6/numRuns/numMarkers);
+		delete [] image;
+	}
+
+	delete tracker;
+	return true;
+}
@@ -0,0 +1,300 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// template matching with the pattern bank, with and without the PCA
+// pre-filter, against the exhaustive correlation of the original
+// pattern_match() on random 16x16 block patterns
+
+enum {
+	MATCHTEST_SIZE = 16,
+	MATCHTEST_MAX_PATTERNS = 64,
+	MATCHTEST_PIXELS = MATCHTEST_SIZE*MATCHTEST_SIZE*3
+};
+
+
+typedef ARToolKitPlus::TrackerSingleMarkerImpl<MATCHTEST_SIZE,MATCHTEST_SIZE,MATCHTEST_SIZE, MATCHTEST_MAX_PATTERNS, 8> MatchTestTrackerBase;
+
+// gives access to pattern_match() and to the loaded patterns
+class MatchTestTracker : public MatchTestTrackerBase
+{
+public:
+	MatchTestTracker() : MatchTestTrackerBase(320, 240)
+	{}
+
+	int match(ARToolKitPlus::ARUint8* nData, int* nCode, int* nDir, ARFloat* nCF)
+	{
+		return this->pattern_match(nData, nCode, nDir, nCF);
+	}
+
+	void setBW(bool nBW)  {  this->arTemplateMatchingMode = nBW ? AR_TEMPLATE_MATCHING_BW : AR_TEMPLATE_MATCHING_COLOR;  }
+
+	// the exhaustive correlation loops of the original pattern_match()
+	void matchReference(const ARToolKitPlus::ARUint8* nData, int* nCode, int* nDir, ARFloat* nCF)
+	{
+		int input[MATCHTEST_PIXELS], i, j, k, ave = 0, sum = 0, num;
+		bool bw = this->arTemplateMatchingMode==AR_TEMPLATE_MATCHING_BW;
+		ARFloat datapow, sum2, max = 0.0f;
+
+		for(i=0; i<MATCHTEST_PIXELS; i++)
+			ave += 255-nData[i];
+		ave /= MATCHTEST_PIXELS;
+
+		num = bw ? MATCHTEST_PIXELS/3 : MATCHTEST_PIXELS;
+		for(i=0; i<num; i++)
+		{
+			input[i] = bw ? ((255-nData[i*3+0]) + (255-nData[i*3+1]) + (255-nData[i*3+2]))/3 - ave : (255-nData[i]) - ave;
+			sum += input[i]*input[i];
+		}
+		datapow = (ARFloat)sqrt((ARFloat)sum);
+
+		*nCode = *nDir = -1;
+		for(k=0; k<MATCHTEST_MAX_PATTERNS; k++)
+		{
+			if(this->patf[k]!=1)
+				continue;
+			for(j=0; j<4; j++)
+			{
+				sum = 0;
+				for(i=0; i<num; i++)
+					sum += input[i]*(bw ? this->patBW[k][j][i] : this->pat[k][j][i]);
+				sum2 = sum / (bw ? this->patpowBW[k][j] : this->patpow[k][j]) / datapow;
+				if(sum2>max)
+				{
+					max = sum2;
+					*nCode = k;
+					*nDir = j;
+				}
+			}
+		}
+		*nCF = max;
+	}
+};
+
+
+// a pattern of 4x4 random colored blocks
+static void
+createBlockPattern(ARToolKitPlus::ARUint8* nPattern)
+{
+	for(int by=0; by<4; by++)
+		for(int bx=0; bx<4; bx++)
+		{
+			int c[3] = {  rand()%256, rand()%256, rand()%256  };
+			for(int y=by*4; y<by*4+4; y++)
+				for(int x=bx*4; x<bx*4+4; x++)
+					for(int ch=0; ch<3; ch++)
+						nPattern[(y*MATCHTEST_SIZE+x)*3+ch] = (ARToolKitPlus::ARUint8)c[ch];
+		}
+}
+
+
+// rotates a pattern by nRot times 90 degrees
+static void
+rotatePattern(const ARToolKitPlus::ARUint8* nSrc, int nRot, ARToolKitPlus::ARUint8* nDst)
+{
+	for(int y=0; y<MATCHTEST_SIZE; y++)
+		for(int x=0; x<MATCHTEST_SIZE; x++)
+		{
+			int sx = x, sy = y, t;
+			for(int r=0; r<nRot; r++)
+			{
+				t = sx;
+				sx = sy;
+				sy = MATCHTEST_SIZE-1-t;
+			}
+			memcpy(nDst + (y*MATCHTEST_SIZE+x)*3, nSrc + (sy*MATCHTEST_SIZE+sx)*3, 3);
+		}
+}
+
+
+// writes the pattern in the four rotations of an ARToolKit pattern file and loads it
+static bool
+loadBlockPattern(MatchTestTracker* nTracker, const ARToolKitPlus::ARUint8* nPattern)
+{
+	static char fileName[] = "artkptest_pattern.tmp";
+	ARToolKitPlus::ARUint8 rotated[MATCHTEST_PIXELS];
+	FILE* fp = fopen(fileName, "w");
+
+	if(!fp)
+		return false;
+
+	for(int r=0; r<4; r++)
+	{
+		rotatePattern(nPattern, r, rotated);
+		for(int ch=0; ch<3; ch++)
+			for(int y=0; y<MATCHTEST_SIZE; y++)
+			{
+				for(int x=0; x<MATCHTEST_SIZE; x++)
+					fprintf(fp, " %3d", rotated[(y*MATCHTEST_SIZE+x)*3+ch]);
+				fprintf(fp, "\n");
+			}
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+
+	bool ok = nTracker->arLoadPatt(fileName)>=0;
+	remove(fileName);
+	return ok;
+}
+
+
+// loads nNum random patterns and creates nNumQueries noisy, rotated queries.
+// every fourth query is made from a pattern that was not loaded.
+//
+static MatchTestTracker*
+createMatchTest(int nNum, ARToolKitPlus::ARUint8* nQueries, int nNumQueries)
+{
+	ARToolKitPlus::ARUint8 patterns[MATCHTEST_MAX_PATTERNS+1][MATCHTEST_PIXELS];
+	MatchTestTracker* tracker = new MatchTestTracker();
+
+	for(int i=0; i<=nNum; i++)
+	{
+		createBlockPattern(patterns[i]);
+		if(i<nNum && !loadBlockPattern(tracker, patterns[i]))
+		{
+			delete tracker;
+			return NULL;
+		}
+	}
+
+	for(int q=0; q<nNumQueries; q++)
+	{
+		ARToolKitPlus::ARUint8* query = nQueries + q*MATCHTEST_PIXELS;
+
+		rotatePattern(patterns[q%4==3 ? nNum : rand()%nNum], rand()%4, query);
+		for(int i=0; i<MATCHTEST_PIXELS; i++)
+		{
+			int v = query[i] + rand()%81-40;
+			query[i] = (ARToolKitPlus::ARUint8)(v<0 ? 0 : (v>255 ? 255 : v));
+		}
+	}
+
+	return tracker;
+}
+
+
+// code, dir and cf of the bank correlation, of the PCA bounded search and
+// of the original loops are the same, for color and BW matching
+//
+ARTKP_TEST(patternMatchMatchesExhaustive)
+{
+	const int numQueries = 500;
+	ARToolKitPlus::ARUint8* queries = new ARToolKitPlus::ARUint8[numQueries*MATCHTEST_PIXELS];
+	const int counts[3] = {  1, 16, 64  };
+	int numDiffer = 0, numRun = 0;
+
+	srand(11);
+	for(int c=0; c<3; c++)
+	{
+		MatchTestTracker* tracker = createMatchTest(counts[c], queries, numQueries);
+		ARTKP_CHECK(tracker!=NULL);
+
+		for(int mode=0; mode<3; mode++)
+		{
+			tracker->setBW(mode==2);
+			tracker->activatePCAMatching(mode==1);
+
+			for(int q=0; q<numQueries; q++)
+			{
+				int code, dir, refCode, refDir;
+				ARFloat cf, refCF;
+
+				tracker->match(queries + q*MATCHTEST_PIXELS, &code, &dir, &cf);
+				tracker->matchReference(queries + q*MATCHTEST_PIXELS, &refCode, &refDir, &refCF);
+				if(code!=refCode || dir!=refDir || fabs(cf-refCF)>1e-5f)
+					numDiffer++;
+				numRun++;
+			}
+		}
+		delete tracker;
+	}
+
+	printf("  %d matches (1, 16 and 64 patterns; color, color with PCA, BW): %d differ\n", numRun, numDiffer);
+	delete [] queries;
+
+	ARTKP_CHECK(numDiffer==0);
+	return true;
+}
+
+
+// time per match of the original loops, the bank and the bank with PCA bound
+//
+ARTKP_BENCHMARK(benchPatternMatch)
+{
+	const int numQueries = 500, numRuns = 10;
+	ARToolKitPlus::ARUint8* queries = new ARToolKitPlus::ARUint8[numQueries*MATCHTEST_PIXELS];
+	const int counts[3] = {  1, 16, 64  };
+	int code, dir;
+	ARFloat cf;
+
+	srand(12);
+	for(int c=0; c<3; c++)
+	{
+		MatchTestTracker* tracker = createMatchTest(counts[c], queries, numQueries);
+		ARTKP_CHECK(tracker!=NULL);
+		double t[4];
+
+		t[0] = getTime();
+		for(int r=0; r<numRuns; r++)
+			for(int q=0; q<numQueries; q++)
+				tracker->matchReference(queries + q*MATCHTEST_PIXELS, &code, &dir, &cf);
+		t[1] = getTime();
+		for(int r=0; r<numRuns; r++)
+			for(int q=0; q<numQueries; q++)
+				tracker->match(queries + q*MATCHTEST_PIXELS, &code, &dir, &cf);
+		t[2] = getTime();
+		tracker->activatePCAMatching(true);
+		for(int r=0; r<numRuns; r++)
+			for(int q=0; q<numQueries; q++)
+				tracker->match(queries + q*MATCHTEST_PIXELS, &code, &dir, &cf);
+		t[3] = getTime();
+
+		printf("  %2d patterns: %6.2f us original, %6.2f us bank, %6.2f us bank with PCA bound\n", counts[c],
+			   (t[1]-t[0])*1e6/numRuns/numQueries, (t[2]-t[1])*1e6/numRuns/numQueries, (t[3]-t[2])*1e6/numRuns/numQueries);
+		delete tracker;
+	}
+
+	delete [] queries;
+	return true;
+}
@@ -0,0 +1,417 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+// arGetPatt() before the row wise sampler (only the RGBA fall through into
+// the RGB case of the 1x1 path is fixed). used as the reference for ext_pat.
+//
+template <int PW, int PH, int PS>
+class PatternTracker : public ARToolKitPlus::TrackerSingleMarkerImpl<PW,PH,PS, 1, 8>
+{
+public:
+	typedef ARToolKitPlus::TrackerSingleMarkerImpl<PW,PH,PS, 1, 8> Base;
+	typedef ARToolKitPlus::ARUint8 ARUint8;
+	typedef ARToolKitPlus::ARUint32 ARUint32;
+
+	using Base::pixelFormat;
+	using Base::arImXsize;
+	using Base::arImYsize;
+	using Base::arImageProcMode;
+	using Base::relBorderWidth;
+	using Base::RGB565_to_LUM8_LUT;
+
+	PatternTracker(int nWidth, int nHeight) : Base(nWidth, nHeight)
+	{}
+
+	void prepare()  {  this->checkRGB565LUT();  }
+
+	int getPatt(ARUint8* nImage, int* nX, int* nY, int* nVertex, ARUint8 nPattern[PH][PW][3])
+	{
+		return this->arGetPatt(nImage, nX, nY, nVertex, nPattern);
+	}
+
+	int getPattReference(ARUint8 *image, int *x_coord, int *y_coord, int *vertex, ARUint8 ext_pat[PH][PW][3]);
+};
+
+
+template <int PW, int PH, int PS> int
+PatternTracker<PW,PH,PS>::getPattReference(ARUint8 *image, int *x_coord, int *y_coord, int *vertex, ARUint8 ext_pat[PH][PW][3])
+{
+	ARUint32  ext_pat2[PH][PW][3];
+	ARFloat   world[4][2];
+	ARFloat   local[4][2];
+	ARFloat   para[3][3];
+	ARFloat   d, xw, yw;
+	int       xc, yc;
+	int       xdiv, ydiv;
+	int       xdiv2, ydiv2;
+	int       lx1, lx2, ly1, ly2;
+	int       i, j;
+	ARUint8   col8;
+	int       lumaOffset = this->getLumaOffset();
+	unsigned short* image16 = (unsigned short*)image;
+
+	world[0][0] = 100.0;
+	world[0][1] = 100.0;
+	world[1][0] = 100.0 + 10.0;
+	world[1][1] = 100.0;
+	world[2][0] = 100.0 + 10.0;
+	world[2][1] = 100.0 + 10.0;
+	world[3][0] = 100.0;
+	world[3][1] = 100.0 + 10.0;
+	for( i = 0; i < 4; i++ ) {
+		local[i][0] = (ARFloat)x_coord[vertex[i]];
+		local[i][1] = (ARFloat)y_coord[vertex[i]];
+	}
+	ARToolKitPlus::get_cpara( world, local, para );
+
+	lx1 = (int)((local[0][0] - local[1][0])*(local[0][0] - local[1][0])
+			  + (local[0][1] - local[1][1])*(local[0][1] - local[1][1]));
+	lx2 = (int)((local[2][0] - local[3][0])*(local[2][0] - local[3][0])
+			  + (local[2][1] - local[3][1])*(local[2][1] - local[3][1]));
+	ly1 = (int)((local[1][0] - local[2][0])*(local[1][0] - local[2][0])
+			  + (local[1][1] - local[2][1])*(local[1][1] - local[2][1]));
+	ly2 = (int)((local[3][0] - local[0][0])*(local[3][0] - local[0][0])
+			  + (local[3][1] - local[0][1])*(local[3][1] - local[0][1]));
+	if( lx2 > lx1 ) lx1 = lx2;
+	if( ly2 > ly1 ) ly1 = ly2;
+	xdiv2 = PW;
+	ydiv2 = PH;
+	if( arImageProcMode == AR_IMAGE_PROC_IN_FULL ) {
+		while( xdiv2*xdiv2 < lx1/4 ) xdiv2*=2;
+		while( ydiv2*ydiv2 < ly1/4 ) ydiv2*=2;
+	}
+	else {
+		while( xdiv2*xdiv2*4 < lx1/4 ) xdiv2*=2;
+		while( ydiv2*ydiv2*4 < ly1/4 ) ydiv2*=2;
+	}
+	if( xdiv2 > PS ) xdiv2 = PS;
+	if( ydiv2 > PS ) ydiv2 = PS;
+
+	xdiv = xdiv2/PW;
+	ydiv = ydiv2/PH;
+
+	ARFloat border = relBorderWidth * 10.0f;
+	ARFloat xyFrom = 100.0f + border,
+			xyTo = 110.0f - border,
+			xyStep = xyTo-xyFrom;
+
+	if(xdiv==1 && ydiv==1)
+	{
+		ARFloat steps[PW];
+
+		for( i = 0; i < xdiv2; i++ )
+			steps[i] = xyFrom + xyStep * (ARFloat)(i+0.5f) / (ARFloat)xdiv2;
+
+		for( j = 0; j < ydiv2; j++ ) {
+			yw = steps[j];
+			for( i = 0; i < xdiv2; i++ ) {
+				xw = steps[i];
+				d = para[2][0]*xw + para[2][1]*yw + para[2][2];
+				if( d == 0 ) return(-1);
+				xc = (int)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
+				yc = (int)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
+
+				if( xc >= 0 && xc < arImXsize && yc >= 0 && yc < arImYsize )
+				{
+					int idx = yc*arImXsize+xc;
+					switch(pixelFormat)
+					{
+					case ARToolKitPlus::PIXEL_FORMAT_ABGR:
+						ext_pat[j][i][0] = image[idx*4+1];  ext_pat[j][i][1] = image[idx*4+2];  ext_pat[j][i][2] = image[idx*4+3];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_BGRA:
+						ext_pat[j][i][0] = image[idx*4+0];  ext_pat[j][i][1] = image[idx*4+1];  ext_pat[j][i][2] = image[idx*4+2];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_BGR:
+						ext_pat[j][i][0] = image[idx*3+0];  ext_pat[j][i][1] = image[idx*3+1];  ext_pat[j][i][2] = image[idx*3+2];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_RGBA:
+						ext_pat[j][i][0] = image[idx*4+2];  ext_pat[j][i][1] = image[idx*4+1];  ext_pat[j][i][2] = image[idx*4+0];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_RGB:
+						ext_pat[j][i][0] = image[idx*3+2];  ext_pat[j][i][1] = image[idx*3+1];  ext_pat[j][i][2] = image[idx*3+0];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_RGB565:
+						col8 = getLUM8_from_RGB565(image16+idx);
+						ext_pat[j][i][0] = ext_pat[j][i][1] = ext_pat[j][i][2] = col8;
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_LUM:
+						col8 = image[idx];
+						ext_pat[j][i][0] = ext_pat[j][i][1] = ext_pat[j][i][2] = col8;
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_UYVY:
+					case ARToolKitPlus::PIXEL_FORMAT_YUYV:
+						col8 = image[idx*2+lumaOffset];
+						ext_pat[j][i][0] = ext_pat[j][i][1] = ext_pat[j][i][2] = col8;
+						break;
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		memset(ext_pat2, 0, sizeof(ext_pat2));
+
+		for( j = 0; j < ydiv2; j++ ) {
+			yw = xyFrom + xyStep * (ARFloat)(j+0.5f) / (ARFloat)ydiv2;
+			for( i = 0; i < xdiv2; i++ ) {
+				xw = xyFrom + xyStep * (ARFloat)(i+0.5f) / (ARFloat)xdiv2;
+				d = para[2][0]*xw + para[2][1]*yw + para[2][2];
+				if( d == 0 ) return(-1);
+				xc = (int)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
+				yc = (int)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
+
+				if( xc >= 0 && xc < arImXsize && yc >= 0 && yc < arImYsize )
+				{
+					int idx = yc*arImXsize+xc;
+					ARUint32* dst = ext_pat2[j/ydiv][i/xdiv];
+					switch(pixelFormat)
+					{
+					case ARToolKitPlus::PIXEL_FORMAT_ABGR:
+						dst[0] += image[idx*4+1];  dst[1] += image[idx*4+2];  dst[2] += image[idx*4+3];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_BGRA:
+						dst[0] += image[idx*4+0];  dst[1] += image[idx*4+1];  dst[2] += image[idx*4+2];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_BGR:
+						dst[0] += image[idx*3+0];  dst[1] += image[idx*3+1];  dst[2] += image[idx*3+2];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_RGBA:
+						dst[0] += image[idx*4+2];  dst[1] += image[idx*4+1];  dst[2] += image[idx*4+0];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_RGB:
+						dst[0] += image[idx*3+2];  dst[1] += image[idx*3+1];  dst[2] += image[idx*3+0];
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_RGB565:
+						col8 = getLUM8_from_RGB565(image16+idx);
+						dst[0] += col8;  dst[1] += col8;  dst[2] += col8;
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_LUM:
+						col8 = image[idx];
+						dst[0] += col8;  dst[1] += col8;  dst[2] += col8;
+						break;
+					case ARToolKitPlus::PIXEL_FORMAT_UYVY:
+					case ARToolKitPlus::PIXEL_FORMAT_YUYV:
+						col8 = image[idx*2+lumaOffset];
+						dst[0] += col8;  dst[1] += col8;  dst[2] += col8;
+						break;
+					}
+				}
+			}
+		}
+
+		for( j = 0; j < PH; j++ ) {
+			for( i = 0; i < PW; i++ ) {
+				ext_pat[j][i][0] = (ARUint8)(ext_pat2[j][i][0] / (xdiv*ydiv));
+				ext_pat[j][i][1] = (ARUint8)(ext_pat2[j][i][1] / (xdiv*ydiv));
+				ext_pat[j][i][2] = (ARUint8)(ext_pat2[j][i][2] / (xdiv*ydiv));
+			}
+		}
+	}
+
+	return(0);
+}
+
+
+struct PatternTestFormat
+{
+	ARToolKitPlus::PIXEL_FORMAT format;
+	int bytesPerPixel;
+	const char* name;
+};
+
+static const PatternTestFormat patternTestFormats[] = {
+	{  ARToolKitPlus::PIXEL_FORMAT_LUM, 1, "LUM"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_ABGR, 4, "ABGR"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_BGRA, 4, "BGRA"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_BGR, 3, "BGR"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_RGBA, 4, "RGBA"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_RGB, 3, "RGB"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_RGB565, 2, "RGB565"  },
+	{  ARToolKitPlus::PIXEL_FORMAT_UYVY, 2, "UYVY"  }
+};
+
+enum {
+	PATTERNTEST_WIDTH = 640,
+	PATTERNTEST_HEIGHT = 480,
+	PATTERNTEST_NUM_FORMATS = sizeof(patternTestFormats)/sizeof(PatternTestFormat)
+};
+
+
+// a roughly square quad of random size and orientation, some partly outside the image
+static void
+getRandomQuad(int nMaxSize, int nX[4], int nY[4])
+{
+	int cx = rand()%PATTERNTEST_WIDTH, cy = rand()%PATTERNTEST_HEIGHT, size = 10+rand()%nMaxSize;
+	double angle = (rand()%628)/100.0;
+
+	for(int k=0; k<4; k++)
+	{
+		double a = angle + k*1.5708 + (rand()%20-10)/100.0;
+		nX[k] = cx + (int)(size*cos(a));
+		nY[k] = cy + (int)(size*sin(a));
+	}
+}
+
+
+template <int PW, int PH, int PS> static bool
+comparePatterns(const PatternTestFormat& nFormat, int nNumQuads)
+{
+	typedef ARToolKitPlus::ARUint8 ARUint8;
+	int numBytes = PATTERNTEST_WIDTH*PATTERNTEST_HEIGHT*nFormat.bytesPerPixel;
+	ARUint8* image = new ARUint8[numBytes];
+	ARUint8 pattern[PH][PW][3], reference[PH][PW][3];
+
+	srand(7);
+	for(int i=0; i<numBytes; i++)
+		image[i] = (ARUint8)rand();
+
+	PatternTracker<PW,PH,PS>* tracker = new PatternTracker<PW,PH,PS>(PATTERNTEST_WIDTH, PATTERNTEST_HEIGHT);
+	tracker->setPixelFormat(nFormat.format);
+	tracker->prepare();
+	ARTKP_CHECK(tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f));
+	tracker->setBorderWidth(0.125f);
+
+	int numMismatches = 0;
+	for(int n=0; n<nNumQuads; n++)
+	{
+		int x[4], y[4], vertex[4] = {  0, 1, 2, 3  };
+		getRandomQuad(300, x, y);
+
+		// samples outside the image leave ext_pat untouched
+		memset(pattern, 0xab, sizeof(pattern));
+		memset(reference, 0xab, sizeof(reference));
+
+		int ret = tracker->getPatt(image, x, y, vertex, pattern),
+			retReference = tracker->getPattReference(image, x, y, vertex, reference);
+
+		if(ret!=retReference || memcmp(pattern, reference, sizeof(pattern))!=0)
+			numMismatches++;
+	}
+
+	if(numMismatches)
+		printf("  %s <%d,%d,%d>: %d of %d patterns differ\n", nFormat.name, PW, PH, PS, numMismatches, nNumQuads);
+
+	delete tracker;
+	delete [] image;
+	return numMismatches==0;
+}
+
+
+template <int PW, int PH, int PS> static bool
+benchPatterns(const PatternTestFormat& nFormat, int nNumQuads)
+{
+	typedef ARToolKitPlus::ARUint8 ARUint8;
+	int numBytes = PATTERNTEST_WIDTH*PATTERNTEST_HEIGHT*nFormat.bytesPerPixel;
+	ARUint8* image = new ARUint8[numBytes];
+	ARUint8 pattern[PH][PW][3];
+	int (*quads)[2][4] = new int[nNumQuads][2][4];
+	int vertex[4] = {  0, 1, 2, 3  }, sum = 0;
+
+	srand(7);
+	for(int i=0; i<numBytes; i++)
+		image[i] = (ARUint8)rand();
+	for(int n=0; n<nNumQuads; n++)
+		getRandomQuad(60, quads[n][0], quads[n][1]);
+
+	PatternTracker<PW,PH,PS>* tracker = new PatternTracker<PW,PH,PS>(PATTERNTEST_WIDTH, PATTERNTEST_HEIGHT);
+	tracker->setPixelFormat(nFormat.format);
+	tracker->prepare();
+	ARTKP_CHECK(tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f));
+	tracker->setBorderWidth(0.125f);
+
+	double best = 1e9, bestReference = 1e9;
+	for(int r=0; r<5; r++)
+	{
+		double t0 = getTime();
+		for(int n=0; n<nNumQuads; n++)
+			sum += tracker->getPatt(image, quads[n][0], quads[n][1], vertex, pattern) + pattern[0][0][0];
+		double t1 = getTime();
+		for(int n=0; n<nNumQuads; n++)
+			sum += tracker->getPattReference(image, quads[n][0], quads[n][1], vertex, pattern) + pattern[0][0][0];
+		double t2 = getTime();
+
+		if(t1-t0<best)
+			best = t1-t0;
+		if(t2-t1<bestReference)
+			bestReference = t2-t1;
+	}
+
+	printf("  %-6s <%d,%d,%d>: %.2f us per candidate, previous sampler %.2f us [%d]\n", nFormat.name, PW, PH, PS,
+		   best*1e6/nNumQuads, bestReference*1e6/nNumQuads, sum&1);
+
+	delete tracker;
+	delete [] quads;
+	delete [] image;
+	return true;
+}
+
+
+// arGetPatt() gives the same ext_pat as the previous per sample code for all
+// pixel formats, for the 1x1 and the supersampled path
+//
+ARTKP_TEST(patternSamplerMatchesReference)
+{
+	bool ok = true;
+
+	for(int f=0; f<PATTERNTEST_NUM_FORMATS; f++)
+	{
+		ok &= comparePatterns<6,6,6>(patternTestFormats[f], 3000);
+		ok &= comparePatterns<16,16,64>(patternTestFormats[f], 3000);
+		ok &= comparePatterns<12,12,48>(patternTestFormats[f], 3000);
+	}
+
+	ARTKP_CHECK(ok);
+	return true;
+}
+
+
+ARTKP_BENCHMARK(benchPatternSampler)
+{
+	for(int f=0; f<4; f++)
+	{
+		benchPatterns<6,6,6>(patternTestFormats[f], 20000);
+		benchPatterns<16,16,64>(patternTestFormats[f], 20000);
+		benchPatterns<12,12,48>(patternTestFormats[f], 20000);
+	}
+
+	return true;
+}
@@ -0,0 +1,323 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+#include <math.h>
+#include <string.h>
+
+#include "../src/librpp/rpp.h"
+
+
+// a slowly moving marker tracked with and without the pose history (see
+// Tracker::activatePoseHistory()), and the fallback when it jumps
+
+
+enum {
+	HISTORYTEST_NUM_FRAMES = 300,
+	HISTORYTEST_MARKER_ID = 5
+};
+
+
+// the history of the default context is not part of the public tracker interface
+class HistoryTestTracker : public PoseTestTracker
+{
+public:
+	HistoryTestTracker(int nWidth, int nHeight) : PoseTestTracker(nWidth, nHeight)
+	{}
+
+	bool hasPose(const ARToolKitPlus::ARMarkerInfo& nMarker, ARFloat nCenter[2], ARFloat nWidth)
+	{
+		return this->defaultContext->findPose(&nMarker, nCenter, nWidth)!=NULL;
+	}
+};
+
+
+static HistoryTestTracker*
+createHistoryTestTracker(ARToolKitPlus::POSE_ESTIMATOR nEstimator, bool nHistory)
+{
+	HistoryTestTracker* tracker = new HistoryTestTracker(640, 480);
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	if(!tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f))
+	{
+		delete tracker;
+		return NULL;
+	}
+	tracker->setUndistortionMode(ARToolKitPlus::UNDIST_NONE);
+	tracker->setPoseEstimator(nEstimator);
+	tracker->activatePoseHistory(nHistory);
+	return tracker;
+}
+
+
+// the pose of frame nFrame: turning by less than a degree and moving by a few
+// millimeters per frame
+static void
+getSlowPose(int nFrame, double nPose[3][4])
+{
+	double t = 2.0*3.14159265*nFrame/HISTORYTEST_NUM_FRAMES;
+
+	setPoseRotation(3.14159265+0.6*sin(t), 0.4*cos(1.3*t), 0.5*sin(0.5*t), nPose);
+	nPose[0][3] = 60.0*sin(t);
+	nPose[1][3] = 40.0*cos(t);
+	nPose[2][3] = 500.0+150.0*sin(0.7*t);
+}
+
+
+// projectMarker() with the id and area the detection would give the marker
+static void
+projectHistoryMarker(HistoryTestTracker* nTracker, const double nPose[3][4], double nNoise, ARToolKitPlus::ARMarkerInfo& nMarker)
+{
+	const double noOffset[2] = {  0.0, 0.0  };
+	ARFloat area = 0.0f;
+
+	projectMarker(nTracker->getCamera()->mat, nPose, noOffset, nNoise, nMarker);
+	for(int i=0; i<4; i++)
+		area += nMarker.vertex[i][0]*nMarker.vertex[(i+1)%4][1] - nMarker.vertex[(i+1)%4][0]*nMarker.vertex[i][1];
+
+	nMarker.id = HISTORYTEST_MARKER_ID;
+	nMarker.dir = 0;
+	nMarker.area = (int)fabs(area/2.0f);
+}
+
+
+// the iterations of the first objpose4() run of rppGetTransMat(), started from
+// nRot or from its own estimate if nRot is NULL
+static unsigned int
+countRppIterations(const ARFloat nCamera[3][4], const ARToolKitPlus::ARMarkerInfo& nMarker, const ARFloat nRot[3][4], ARFloat nWidth)
+{
+	rpp::vec3_array4 model, iprts;
+	rpp::options_t options;
+	rpp::mat33_t R;
+	rpp::vec3_t t;
+	rpp::real_t objErr, imgErr;
+	unsigned int it = 0;
+	int i, j;
+
+	for(i=0; i<4; i++)
+	{
+		model[i].v[0] = (rpp::real_t)(poseTestCorners[i][0]*nWidth/80.0);
+		model[i].v[1] = (rpp::real_t)(poseTestCorners[i][1]*nWidth/80.0);
+		model[i].v[2] = 0;
+		iprts[i].v[0] = (rpp::real_t)((nMarker.vertex[i][0]-nCamera[0][2])/nCamera[0][0]);
+		iprts[i].v[1] = (rpp::real_t)((nMarker.vertex[i][1]-nCamera[1][2])/nCamera[1][1]);
+		iprts[i].v[2] = 1;
+	}
+
+	for(i=0; i<3; i++)
+		for(j=0; j<3; j++)
+			options.initR.m[i][j] = nRot ? (rpp::real_t)nRot[i][j] : 0;
+	options.tol = DEFAULT_TOL;
+	options.epsilon = DEFAULT_EPSILON;
+	options.max_iter = 0;
+
+	rpp::objpose4(R, t, it, objErr, imgErr, true, model, iprts, options);
+	return it;
+}
+
+
+// over a slowly moving marker with 0.3 pixels of corner noise: RPP started
+// from the previous rotation stays within 0.1 degrees and 0.1 mm of the cold
+// start and needs fewer iterations. ORIGINAL gives the cold pose wherever
+// arGetInitRot() finds a rotation and the history fills in the others.
+// estimatePoses() gives the poses of executeSingleMarkerPoseEstimator().
+//
+ARTKP_TEST(poseHistoryWarmStart)
+{
+	const ARToolKitPlus::POSE_ESTIMATOR estimators[2] = {  ARToolKitPlus::POSE_ESTIMATOR_ORIGINAL, ARToolKitPlus::POSE_ESTIMATOR_RPP  };
+	ARFloat center[2] = {  0.0f, 0.0f  };
+
+	for(int e=0; e<2; e++)
+	{
+		HistoryTestTracker* cold = createHistoryTestTracker(estimators[e], false);
+		HistoryTestTracker* warm = createHistoryTestTracker(estimators[e], true);
+		HistoryTestTracker* batch = createHistoryTestTracker(estimators[e], true);
+		ARTKP_CHECK(cold && warm && batch);
+
+		ARFloat coldConv[3][4], warmConv[3][4], prevConv[3][4], gl[16], batchErr;
+		double maxRotDiff = 0.0, maxTransDiff = 0.0, maxRotErr = 0.0, maxFilledErr = 0.0;
+		int numHits = 0, numColdFailed = 0, numWarmFailed = 0, numBatchDiffer = 0, numColdDiffer = 0;
+		unsigned int coldIt = 0, warmIt = 0;
+		bool havePrev = false;
+
+		srand(7);
+		for(int f=0; f<HISTORYTEST_NUM_FRAMES; f++)
+		{
+			ARToolKitPlus::ARMarkerInfo marker;
+			double pose[3][4], coldPose[3][4], rotDiff, transDiff, rotErr, transErr;
+
+			getSlowPose(f, pose);
+			projectHistoryMarker(warm, pose, 0.3, marker);
+
+			if(warm->hasPose(marker, center, 80.0f))
+				numHits++;
+
+			ARFloat coldErr = cold->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, coldConv);
+			ARFloat warmErr = warm->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, warmConv);
+
+			batch->estimatePoses(&marker, 1, center, 80.0f, &gl, &batchErr);
+			if(batchErr!=warmErr)
+				numBatchDiffer++;
+			else if(warmErr>=0)
+				for(int i=0; i<3; i++)
+					for(int j=0; j<4; j++)
+						if(gl[j*4+i]!=warmConv[i][j])
+						{
+							numBatchDiffer++;
+							i = 3;
+							break;
+						}
+
+			if(estimators[e]==ARToolKitPlus::POSE_ESTIMATOR_RPP)
+			{
+				coldIt += countRppIterations(warm->getCamera()->mat, marker, NULL, 80.0f);
+				warmIt += countRppIterations(warm->getCamera()->mat, marker, havePrev ? prevConv : NULL, 80.0f);
+			}
+
+			if(warmErr<0)
+			{
+				numWarmFailed++;
+				havePrev = false;
+				continue;
+			}
+			memcpy(prevConv, warmConv, sizeof(prevConv));
+			havePrev = true;
+
+			getPoseError(warmConv, pose, rotErr, transErr);
+			if(rotErr>maxRotErr)
+				maxRotErr = rotErr;
+
+			if(coldErr<0)
+			{
+				numColdFailed++;
+				if(rotErr>maxFilledErr)
+					maxFilledErr = rotErr;
+				continue;
+			}
+			if(coldErr==warmErr && memcmp(coldConv, warmConv, sizeof(coldConv))==0)
+				continue;
+			numColdDiffer++;
+			for(int i=0; i<3; i++)
+				for(int j=0; j<4; j++)
+					coldPose[i][j] = coldConv[i][j];
+			getPoseError(warmConv, coldPose, rotDiff, transDiff);
+			if(rotDiff>maxRotDiff)
+				maxRotDiff = rotDiff;
+			if(transDiff>maxTransDiff)
+				maxTransDiff = transDiff;
+		}
+
+		printf("  %-8s %d/%d differ from cold by max %.3f deg %.3f mm, max error %.3f deg, %d/%d history hits, %d/%d filled in (max error %.3f deg)",
+			   e ? "RPP" : "ORIGINAL", numColdDiffer, HISTORYTEST_NUM_FRAMES-numColdFailed, maxRotDiff, maxTransDiff, maxRotErr,
+			   numHits, HISTORYTEST_NUM_FRAMES, numColdFailed-numWarmFailed, numColdFailed, maxFilledErr);
+		if(coldIt)
+			printf(", %.1f iterations cold, %.1f warm", (double)coldIt/HISTORYTEST_NUM_FRAMES, (double)warmIt/HISTORYTEST_NUM_FRAMES);
+		printf("\n");
+
+		delete cold;
+		delete warm;
+		delete batch;
+
+		ARTKP_CHECK(numHits==HISTORYTEST_NUM_FRAMES-1);
+		ARTKP_CHECK(numWarmFailed==0);
+		ARTKP_CHECK(numBatchDiffer==0);
+		if(estimators[e]==ARToolKitPlus::POSE_ESTIMATOR_RPP)
+		{
+			ARTKP_CHECK(maxRotDiff<0.1 && maxTransDiff<0.1);
+			ARTKP_CHECK(warmIt<coldIt);
+		}
+		else
+		{
+			ARTKP_CHECK(numColdDiffer==0);
+			ARTKP_CHECK(maxFilledErr<5.0);
+		}
+	}
+	return true;
+}
+
+
+// a marker that jumps across the image is estimated from scratch. when it
+// flips its tilt in place RPP starts from the wrong side and still finds the
+// pose, ORIGINAL gives the cold pose
+//
+ARTKP_TEST(poseHistoryJump)
+{
+	const ARToolKitPlus::POSE_ESTIMATOR estimators[2] = {  ARToolKitPlus::POSE_ESTIMATOR_ORIGINAL, ARToolKitPlus::POSE_ESTIMATOR_RPP  };
+	ARFloat center[2] = {  0.0f, 0.0f  };
+
+	for(int e=0; e<2; e++)
+	{
+		HistoryTestTracker* cold = createHistoryTestTracker(estimators[e], false);
+		HistoryTestTracker* warm = createHistoryTestTracker(estimators[e], true);
+		ARTKP_CHECK(cold && warm);
+
+		ARToolKitPlus::ARMarkerInfo marker;
+		ARFloat coldConv[3][4], warmConv[3][4], coldErr, warmErr;
+		double pose[3][4], rotErr, transErr;
+
+		setPoseRotation(3.14159265+0.5, 0.0, 0.0, pose);
+		pose[0][3] = -80.0;  pose[1][3] = 0.0;  pose[2][3] = 500.0;
+		projectHistoryMarker(warm, pose, 0.0, marker);
+		ARTKP_CHECK(warm->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, warmConv)>=0);
+
+		// 160 mm to the right: too far for the history
+		pose[0][3] = 80.0;
+		projectHistoryMarker(warm, pose, 0.0, marker);
+		ARTKP_CHECK(!warm->hasPose(marker, center, 80.0f));
+		coldErr = cold->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, coldConv);
+		warmErr = warm->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, warmConv);
+		ARTKP_CHECK(coldErr>=0 && coldErr==warmErr && memcmp(coldConv, warmConv, sizeof(coldConv))==0);
+
+		// the tilt flipped in place: the history is used and starts from the wrong side
+		setPoseRotation(3.14159265-0.5, 0.0, 0.0, pose);
+		projectHistoryMarker(warm, pose, 0.0, marker);
+		ARTKP_CHECK(warm->hasPose(marker, center, 80.0f));
+		coldErr = cold->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, coldConv);
+		warmErr = warm->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, warmConv);
+		ARTKP_CHECK(coldErr>=0 && warmErr>=0);
+		getPoseError(warmConv, pose, rotErr, transErr);
+
+		printf("  %-8s error after the flip %.3f deg %.3f mm\n", e ? "RPP" : "ORIGINAL", rotErr, transErr);
+
+		if(estimators[e]==ARToolKitPlus::POSE_ESTIMATOR_ORIGINAL)
+			ARTKP_CHECK(coldErr==warmErr && memcmp(coldConv, warmConv, sizeof(coldConv))==0);
+		ARTKP_CHECK(rotErr<0.5 && transErr<1.0);
+
+		delete cold;
+		delete warm;
+	}
+	return true;
+}
@@ -0,0 +1,274 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+#include <math.h>
+#include <string.h>
+
+#include "../src/librpp/rpp.h"
+
+
+// the fixed-size robust_pose4() against the std::vector based robust_pose()
+
+
+enum {
+	RPPTEST_NUM_POSES = 20000,
+	RPPTEST_BENCH_POSES = 2000,
+	RPPTEST_BENCH_BATCH = 12
+};
+
+
+// the model and the normalized image points of a random 80mm marker pose with
+// nNoise pixels of corner noise at a focal length of 500 pixels
+static void
+getRppTestPoints(double nNoise, rpp::vec3_array4 nModel, rpp::vec3_array4 nIprts)
+{
+	double pose[3][4];
+
+	getRandomPose(300.0, 700.0, pose);
+	for(int i=0; i<4; i++)
+	{
+		double X[3];
+
+		for(int r=0; r<3; r++)
+			X[r] = pose[r][0]*poseTestCorners[i][0] + pose[r][1]*poseTestCorners[i][1] + pose[r][3];
+
+		nModel[i].v[0] = (rpp::real_t)poseTestCorners[i][0];
+		nModel[i].v[1] = (rpp::real_t)poseTestCorners[i][1];
+		nModel[i].v[2] = 0;
+		nIprts[i].v[0] = (rpp::real_t)(X[0]/X[2] + nNoise*poseTestRandom()/500.0);
+		nIprts[i].v[1] = (rpp::real_t)(X[1]/X[2] + nNoise*poseTestRandom()/500.0);
+		nIprts[i].v[2] = 1;
+	}
+}
+
+
+static void
+getRppTestOptions(rpp::options_t& nOptions)
+{
+	memset(&nOptions, 0, sizeof(nOptions));
+	nOptions.tol = DEFAULT_TOL;
+	nOptions.epsilon = DEFAULT_EPSILON;
+	nOptions.max_iter = 0;
+}
+
+
+// robust_pose4() is a term-for-term translation of robust_pose(): error,
+// rotation and translation must be bitwise equal, from an estimated as
+// well as from a given initial rotation, and robust_pose4() must not touch
+// the heap. both give no pose (MAX_FLOAT) when get2ndPose_Exact() finds no
+// solution, about 4% of these views
+//
+ARTKP_TEST(rppFixedSizeMatchesVector)
+{
+	rpp::vec3_array4 model, iprts;
+	rpp::vec3_array modelVec(4), iprtsVec(4);
+	rpp::options_t options;
+	rpp::mat33_t R, R4, prevR;
+	rpp::vec3_t t, t4;
+	rpp::real_t err, err4;
+	int numDiffer = 0, numFailed = 0;
+	long numAllocs = 0, numAllocs4 = 0;
+	bool havePrev = false;
+
+	srand(11);
+	for(int p=0; p<RPPTEST_NUM_POSES; p++)
+	{
+		getRppTestPoints(0.3, model, iprts);
+		for(int i=0; i<4; i++)
+		{
+			modelVec[i] = model[i];
+			iprtsVec[i] = iprts[i];
+		}
+
+		getRppTestOptions(options);
+		if(havePrev && (p&1))
+			options.initR = prevR;
+
+		allocCount = 0;
+		allocCounting = 1;
+		rpp::robust_pose(err, R, t, modelVec, iprtsVec, options);
+		numAllocs += allocCount;
+		allocCount = 0;
+		rpp::robust_pose4(err4, R4, t4, model, iprts, options);
+		numAllocs4 += allocCount;
+		allocCounting = 0;
+
+		if(err>=MAX_FLOAT)
+			numFailed++;
+		if(memcmp(&err, &err4, sizeof(err))!=0 || memcmp(&R, &R4, sizeof(R))!=0 || memcmp(&t, &t4, sizeof(t))!=0)
+			numDiffer++;
+
+		prevR = R;
+		havePrev = true;
+	}
+
+	printf("  %d poses, %d differ, %d without pose, %.1f heap allocations per robust_pose, %ld in robust_pose4\n",
+		   RPPTEST_NUM_POSES, numDiffer, numFailed, (double)numAllocs/RPPTEST_NUM_POSES, numAllocs4);
+
+	ARTKP_CHECK(numDiffer==0);
+	ARTKP_CHECK(numAllocs4==0);
+	return true;
+}
+
+
+// where robust_pose4() finds no pose POSE_ESTIMATOR_RPP must fail instead of
+// returning the zero matrix robust_pose4() leaves behind
+//
+ARTKP_TEST(rppNoPoseIsFailure)
+{
+	const double noOffset[2] = {  0.0, 0.0  };
+	ARFloat center[2] = {  0.0f, 0.0f  }, conv[3][4];
+	int numFailed = 0, numZero = 0;
+
+	PoseTestTracker* tracker = new PoseTestTracker(640, 480);
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	ARTKP_CHECK(tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f));
+	tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_RPP);
+
+	srand(7);
+	for(int v=0; v<RPPTEST_BENCH_POSES; v++)
+	{
+		ARToolKitPlus::ARMarkerInfo marker;
+		double pose[3][4];
+
+		getRandomPose(300.0, 700.0, pose);
+		projectMarker(tracker->getCamera()->mat, pose, noOffset, 0.3, marker);
+
+		if(tracker->executeSingleMarkerPoseEstimator(&marker, center, 80.0f, conv)<0)
+			numFailed++;
+		else if(conv[0][0]==0.0f && conv[1][1]==0.0f && conv[2][2]==0.0f)
+			numZero++;
+	}
+
+	printf("  %d/%d without pose, %d zero poses\n", numFailed, RPPTEST_BENCH_POSES, numZero);
+
+	delete tracker;
+
+	ARTKP_CHECK(numZero==0);
+	return true;
+}
+
+
+// robust_pose() and robust_pose4() on their own, and the pose estimators of
+// the tracker on the same 80mm markers (0.3 pixels of corner noise)
+//
+ARTKP_BENCHMARK(benchRpp)
+{
+	static rpp::vec3_array4 model[RPPTEST_BENCH_POSES], iprts[RPPTEST_BENCH_POSES];
+	static ARToolKitPlus::ARMarkerInfo markers[RPPTEST_BENCH_POSES];
+	static ARFloat gl[RPPTEST_BENCH_BATCH][16];
+	const double noOffset[2] = {  0.0, 0.0  };
+	ARFloat center[2] = {  0.0f, 0.0f  }, conv[3][4];
+	rpp::vec3_array modelVec(4), iprtsVec(4);
+	rpp::options_t options;
+	rpp::mat33_t R;
+	rpp::vec3_t t;
+	rpp::real_t err;
+	double pose[3][4], t0, tVec, t4, tOrig, tBatch, tRpp;
+	unsigned int it, sumIt = 0;
+	int p, i;
+
+	PoseTestTracker* tracker = new PoseTestTracker(640, 480);
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	ARTKP_CHECK(tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f));
+
+	srand(13);
+	for(p=0; p<RPPTEST_BENCH_POSES; p++)
+	{
+		getRppTestPoints(0.3, model[p], iprts[p]);
+		getRandomPose(300.0, 700.0, pose);
+		projectMarker(tracker->getCamera()->mat, pose, noOffset, 0.3, markers[p]);
+	}
+	getRppTestOptions(options);
+
+	t0 = getTime();
+	for(p=0; p<RPPTEST_BENCH_POSES; p++)
+	{
+		for(i=0; i<4; i++)
+		{
+			modelVec[i] = model[p][i];
+			iprtsVec[i] = iprts[p][i];
+		}
+		rpp::robust_pose(err, R, t, modelVec, iprtsVec, options);
+	}
+	tVec = getTime()-t0;
+
+	t0 = getTime();
+	for(p=0; p<RPPTEST_BENCH_POSES; p++)
+		rpp::robust_pose4(err, R, t, model[p], iprts[p], options);
+	t4 = getTime()-t0;
+
+	for(p=0; p<RPPTEST_BENCH_POSES; p++)
+	{
+		rpp::mat33_t Rp;
+		rpp::vec3_t tp;
+		rpp::real_t objErr, imgErr;
+
+		rpp::objpose4(Rp, tp, it, objErr, imgErr, true, model[p], iprts[p], options);
+		sumIt += it;
+	}
+
+	tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_ORIGINAL);
+	t0 = getTime();
+	for(p=0; p<RPPTEST_BENCH_POSES; p++)
+		tracker->executeSingleMarkerPoseEstimator(&markers[p], center, 80.0f, conv);
+	tOrig = getTime()-t0;
+
+	t0 = getTime();
+	for(p=0; p+RPPTEST_BENCH_BATCH<=RPPTEST_BENCH_POSES; p+=RPPTEST_BENCH_BATCH)
+		tracker->estimatePoses(markers+p, RPPTEST_BENCH_BATCH, center, 80.0f, gl);
+	tBatch = getTime()-t0;
+
+	tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_RPP);
+	t0 = getTime();
+	for(p=0; p<RPPTEST_BENCH_POSES; p++)
+		tracker->executeSingleMarkerPoseEstimator(&markers[p], center, 80.0f, conv);
+	tRpp = getTime()-t0;
+
+	delete tracker;
+
+	printf("  %d poses, %.1f objpose iterations per run (robust_pose runs it up to 3 times)\n",
+		   RPPTEST_BENCH_POSES, (double)sumIt/RPPTEST_BENCH_POSES);
+	printf("  robust_pose                  %7.2f us per pose\n", tVec*1e6/RPPTEST_BENCH_POSES);
+	printf("  robust_pose4                 %7.2f us per pose\n", t4*1e6/RPPTEST_BENCH_POSES);
+	printf("  POSE_ESTIMATOR_RPP           %7.2f us per marker\n", tRpp*1e6/RPPTEST_BENCH_POSES);
+	printf("  POSE_ESTIMATOR_ORIGINAL      %7.2f us per marker\n", tOrig*1e6/RPPTEST_BENCH_POSES);
+	printf("  ORIGINAL, estimatePoses(%d) %7.2f us per marker\n", RPPTEST_BENCH_BATCH,
+		   tBatch*1e6/(RPPTEST_BENCH_POSES/RPPTEST_BENCH_BATCH*RPPTEST_BENCH_BATCH));
+	return true;
+}
@@ -0,0 +1,114 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+static void
+countTask(void* nData, int nIndex)
+{
+	int* counts = (int*)nData;
+	counts[nIndex]++;
+}
+
+
+// every task of every batch runs exactly once, also after restarts
+//
+ARTKP_TEST(threadPoolRunsAllTasks)
+{
+	ARToolKitPlus::ThreadPool pool;
+	int counts[64];
+
+	ARTKP_CHECK(pool.getNumThreads()==1 && pool.getNumRequested()==1);
+
+	for(int numThreads=1; numThreads<=4; numThreads++)
+	{
+		ARTKP_CHECK(pool.start(numThreads));
+		ARTKP_CHECK(pool.getNumThreads()==numThreads && pool.getNumRequested()==numThreads);
+
+		memset(counts, 0, sizeof(counts));
+		for(int batch=0; batch<1000; batch++)
+			pool.run(countTask, counts, 1+batch%64);
+
+		for(int i=0; i<64; i++)
+		{
+			int expected = 0;
+			for(int batch=0; batch<1000; batch++)
+				if(i<1+batch%64)
+					expected++;
+			ARTKP_CHECK(counts[i]==expected);
+		}
+	}
+
+	pool.stop();
+	ARTKP_CHECK(pool.getNumThreads()==1 && pool.getNumRequested()==1);
+	return true;
+}
+
+
+// stripe parallel labeling finds the same markers as single threaded labeling
+//
+ARTKP_TEST(threadedLabelingMatchesSingle)
+{
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_bch_nr0100.raw", 320, 240);
+	ARTKP_CHECK(tile!=NULL);
+	unsigned char* image = tileImage(tile, 320, 240, 2, 2);
+	delete [] tile;
+
+	TestTracker* tracker = createTestTracker(640, 480, true);
+	ARTKP_CHECK(tracker!=NULL);
+
+	ARToolKitPlus::ARMarkerInfo *info, single[64];
+	int numSingle = 0, num = 0;
+
+	tracker->setLabelingMode(ARToolKitPlus::LABELING_RLE);
+	ARTKP_CHECK(tracker->arDetectMarkerLite(image, 150, &info, &numSingle)>=0);
+	ARTKP_CHECK(numSingle==4);
+	memcpy(single, info, numSingle*sizeof(ARToolKitPlus::ARMarkerInfo));
+
+	for(int numThreads=2; numThreads<=4; numThreads++)
+	{
+		tracker->setNumLabelingThreads(numThreads);
+		ARTKP_CHECK(tracker->arDetectMarkerLite(image, 150, &info, &num)>=0);
+		ARTKP_CHECK(num==numSingle);
+		ARTKP_CHECK(memcmp(single, info, num*sizeof(ARToolKitPlus::ARMarkerInfo))==0);
+	}
+
+	delete tracker;
+	delete [] image;
+	return true;
+}
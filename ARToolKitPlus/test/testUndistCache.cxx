@@ -0,0 +1,176 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+// the sharing of tables is tested on linux only, where
+// shm_open() objects can be listed in /dev/shm
+//
+#ifdef __linux__
+
+
+#include <ARToolKitPlus/UndistCache.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+enum {
+	UNDISTTEST_FORMAT = 0x7e57,
+	UNDISTTEST_WIDTH = 64,
+	UNDISTTEST_HEIGHT = 32
+};
+
+
+static void
+buildTestRows(void* nTable, int nRowBegin, int nRowEnd, void* nData)
+{
+	unsigned char* table = (unsigned char*)nTable;
+	for(int y=nRowBegin; y<nRowEnd; y++)
+		memset(table + y*UNDISTTEST_WIDTH, y, UNDISTTEST_WIDTH);
+
+	int* numRows = (int*)nData;
+	for(int y=nRowBegin; y<nRowEnd; y++)
+		__sync_fetch_and_add(numRows, 1);
+}
+
+
+static const unsigned char*
+acquireTestTable(int* nNumRowsBuilt)
+{
+	return (const unsigned char*)ARToolKitPlus::UndistCache::acquire(getDataFile("no_distortion.cal"), UNDISTTEST_FORMAT,
+						UNDISTTEST_WIDTH, UNDISTTEST_HEIGHT, UNDISTTEST_WIDTH*UNDISTTEST_HEIGHT,
+						UNDISTTEST_HEIGHT, buildTestRows, nNumRowsBuilt);
+}
+
+
+static bool
+checkTestTable(const unsigned char* nTable)
+{
+	for(int y=0; y<UNDISTTEST_HEIGHT; y++)
+		for(int x=0; x<UNDISTTEST_WIDTH; x++)
+			if(nTable[y*UNDISTTEST_WIDTH+x]!=y)
+				return false;
+	return true;
+}
+
+
+// returns the shm_open() name of the test table
+static bool
+findTestTable(char nName[300])
+{
+	DIR* dir = opendir("/dev/shm");
+	if(!dir)
+		return false;
+
+	char tag[32];
+	sprintf(tag, "_%x_%dx%d_", UNDISTTEST_FORMAT, UNDISTTEST_WIDTH, UNDISTTEST_HEIGHT);
+
+	struct dirent* ent;
+	bool found = false;
+	while(!found && (ent = readdir(dir))!=NULL)
+		if(!strncmp(ent->d_name, "ARToolKitPlus_", 14) && strstr(ent->d_name, tag))
+		{
+			sprintf(nName, "/%.250s", ent->d_name);
+			found = true;
+		}
+
+	closedir(dir);
+	return found;
+}
+
+
+// a table is built once and then shared. a creator that died before sizing
+// the object does not stall later callers for long, objects others can
+// write to are refused and removeTables() cleans up.
+//
+ARTKP_TEST(undistCacheSharing)
+{
+	int numBuilt = 0;
+	char name[300];
+
+	// left over from an earlier run?
+	if(findTestTable(name))
+		shm_unlink(name);
+
+	const unsigned char* table = acquireTestTable(&numBuilt);
+	ARTKP_CHECK(table && checkTestTable(table) && numBuilt==UNDISTTEST_HEIGHT);
+	ARTKP_CHECK(acquireTestTable(&numBuilt)==table && numBuilt==UNDISTTEST_HEIGHT);
+	ARTKP_CHECK(ARToolKitPlus::UndistCache::release(table) && ARToolKitPlus::UndistCache::release(table));
+
+	// mapped again from the shared memory file system, not rebuilt
+	table = acquireTestTable(&numBuilt);
+	ARTKP_CHECK(table && checkTestTable(table) && numBuilt==UNDISTTEST_HEIGHT);
+	ARTKP_CHECK(ARToolKitPlus::UndistCache::release(table));
+
+	// only the owner may access the table
+	ARTKP_CHECK(findTestTable(name));
+	int fd = shm_open(name, O_RDONLY, 0);
+	ARTKP_CHECK(fd>=0);
+	struct stat st;
+	ARTKP_CHECK(fstat(fd, &st)==0 && (st.st_mode & 0777)==0600);
+	close(fd);
+
+	// an empty object left behind by a crashed creator is replaced
+	ARTKP_CHECK(shm_unlink(name)==0);
+	fd = shm_open(name, O_CREAT|O_EXCL|O_RDWR, 0600);
+	ARTKP_CHECK(fd>=0);
+	close(fd);
+
+	numBuilt = 0;
+	double t0 = getTime();
+	table = acquireTestTable(&numBuilt);
+	ARTKP_CHECK(getTime()-t0 < 1.0);
+	ARTKP_CHECK(table && checkTestTable(table) && numBuilt==UNDISTTEST_HEIGHT);
+	ARTKP_CHECK(ARToolKitPlus::UndistCache::release(table));
+
+	// a table others may write to is not used
+	fd = shm_open(name, O_RDWR, 0);
+	ARTKP_CHECK(fd>=0);
+	ARTKP_CHECK(fchmod(fd, 0666)==0);
+	close(fd);
+	ARTKP_CHECK(acquireTestTable(&numBuilt)==NULL);
+
+	ARTKP_CHECK(ARToolKitPlus::UndistCache::removeTables()>=1);
+	ARTKP_CHECK(!findTestTable(name));
+	return true;
+}
+
+#endif //__linux__
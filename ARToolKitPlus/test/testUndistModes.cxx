@@ -0,0 +1,213 @@
+/* ========================================================================
+ * PROJECT: ARToolKitPlus
+ * ========================================================================
+ * This work is based on the original ARToolKit developed by
+ *   Hirokazu Kato
+ *   Mark Billinghurst
+ *   HITLab, University of Washington, Seattle
+ * http://www.hitl.washington.edu/artoolkit/
+ *
+ * Copyright of the derived and new portions of this work
+ *     (C) 2006 Graz University of Technology
+ *
+ * This framework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This framework is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this framework; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * For further information please contact 
+ *   Dieter Schmalstieg
+ *   <schmalstieg@icg.tu-graz.ac.at>
+ *   Graz University of Technology, 
+ *   Institut for Computer Graphics and Vision,
+ *   Inffeldgasse 16a, 8010 Graz, Austria.
+ * ========================================================================
+ *
+ * $Id$
+ * @file
+ * ======================================================================== */
+
+
+
+#include <math.h>
+#include <string.h>
+
+
+// the approximate undistortion modes against UNDIST_STD on the distorted
+// Logitech camera: corners of the same detected markers and the poses
+// estimated from them may only differ by a fraction of a pixel / degree
+
+enum {
+	UNDISTTEST_MAX_MARKERS = 32
+};
+
+
+static TestTracker*
+createUndistTestTracker(int nWidth, int nHeight, ARToolKitPlus::UNDIST_MODE nMode)
+{
+	TestTracker* tracker = new TestTracker(nWidth, nHeight);
+
+	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	if(!tracker->init(getDataFile("LogitechPro4000.dat"), 1.0f, 1000.0f))
+	{
+		delete tracker;
+		return NULL;
+	}
+
+	tracker->setPatternWidth(80);
+	tracker->setBorderWidth(0.250f);
+	tracker->setThreshold(150);
+	tracker->setUndistortionMode(nMode);
+	tracker->setMarkerMode(ARToolKitPlus::MARKER_ID_SIMPLE);
+	return tracker;
+}
+
+
+static int
+detectUndistTestMarkers(TestTracker* nTracker, const unsigned char* nImage, ARToolKitPlus::ARMarkerInfo* nMarkers)
+{
+	ARToolKitPlus::ARMarkerInfo* info;
+	int num = 0, numMarkers = 0;
+
+	if(nTracker->arDetectMarker(const_cast<unsigned char*>(nImage), 150, &info, &num)<0)
+		return 0;
+
+	for(int i=0; i<num && numMarkers<UNDISTTEST_MAX_MARKERS; i++)
+		if(info[i].id>=0)
+			nMarkers[numMarkers++] = info[i];
+	return numMarkers;
+}
+
+
+// rotation difference in degrees and translation difference in mm
+static void
+getUndistPoseDiff(const ARFloat nA[3][4], const ARFloat nB[3][4], double& nRotDiff, double& nTransDiff)
+{
+	double trace = 0.0, cosAngle, t = 0.0;
+
+	for(int i=0; i<3; i++)
+	{
+		for(int j=0; j<3; j++)
+			trace += nA[i][j]*nB[i][j];
+		t += (nA[i][3]-nB[i][3])*(nA[i][3]-nB[i][3]);
+	}
+
+	cosAngle = (trace-1.0)/2.0;
+	cosAngle = cosAngle>1.0 ? 1.0 : (cosAngle<-1.0 ? -1.0 : cosAngle);
+	nRotDiff = acos(cosAngle)*180.0/3.14159265;
+	nTransDiff = sqrt(t);
+}
+
+
+// detects the markers of a nCols x nRows tiled test image with nTracker and with
+// an UNDIST_STD tracker of the same size and compares their corners and poses.
+// both poses come from the UNDIST_STD tracker, so only the corners differ.
+//
+static bool
+compareUndistModes(TestTracker* nTracker, int nCols, int nRows, const char* nName,
+				   double nMaxVertexDiff, double nMaxRotDiff, double nMaxTransDiff)
+{
+	unsigned char* tile = loadRawImage("image_320_240_8_marker_id_simple_nr031.raw", 320, 240);
+	if(!tile)
+		return false;
+	unsigned char* image = tileImage(tile, 320, 240, nCols, nRows);
+	delete [] tile;
+
+	TestTracker* reference = createUndistTestTracker(320*nCols, 240*nRows, ARToolKitPlus::UNDIST_STD);
+	ARToolKitPlus::ARMarkerInfo stdMarkers[UNDISTTEST_MAX_MARKERS], markers[UNDISTTEST_MAX_MARKERS];
+	ARFloat center[2] = {  0.0f, 0.0f  }, stdConv[3][4], conv[3][4];
+	double maxVertexDiff = 0.0, maxRotDiff = 0.0, maxTransDiff = 0.0;
+	int numStd, num, numMatched = 0;
+
+	numStd = reference ? detectUndistTestMarkers(reference, image, stdMarkers) : 0;
+	num = detectUndistTestMarkers(nTracker, image, markers);
+
+	for(int i=0; i<numStd; i++)
+	{
+		int best = -1;
+		double bestDist = 1e10;
+
+		for(int j=0; j<num; j++)
+		{
+			double dx = markers[j].pos[0]-stdMarkers[i].pos[0], dy = markers[j].pos[1]-stdMarkers[i].pos[1];
+			if(markers[j].id==stdMarkers[i].id && dx*dx+dy*dy<bestDist)
+			{
+				best = j;
+				bestDist = dx*dx+dy*dy;
+			}
+		}
+		if(best<0 || markers[best].dir!=stdMarkers[i].dir)
+			continue;
+
+		numMatched++;
+		for(int k=0; k<4; k++)
+		{
+			double dx = markers[best].vertex[k][0]-stdMarkers[i].vertex[k][0],
+				   dy = markers[best].vertex[k][1]-stdMarkers[i].vertex[k][1], d = sqrt(dx*dx+dy*dy);
+			if(d>maxVertexDiff)
+				maxVertexDiff = d;
+		}
+
+		double rotDiff, transDiff;
+		if(reference->arGetTransMat(&stdMarkers[i], center, 80.0f, stdConv)<0 ||
+		   reference->arGetTransMat(&markers[best], center, 80.0f, conv)<0)
+			continue;
+		getUndistPoseDiff(stdConv, conv, rotDiff, transDiff);
+		if(rotDiff>maxRotDiff)
+			maxRotDiff = rotDiff;
+		if(transDiff>maxTransDiff)
+			maxTransDiff = transDiff;
+	}
+
+	printf("  %s %dx%d: %d of %d markers matched, max corner difference %.3f px, max pose difference %.3f deg %.3f mm\n",
+		   nName, 320*nCols, 240*nRows, numMatched, numStd, maxVertexDiff, maxRotDiff, maxTransDiff);
+
+	delete reference;
+	delete [] image;
+
+	return numStd==nCols*nRows && numMatched==numStd && maxVertexDiff<=nMaxVertexDiff &&
+		   maxRotDiff<=nMaxRotDiff && maxTransDiff<=nMaxTransDiff;
+}
+
+
+// UNDIST_GRID interpolates the offsets of nodes AR_UNDIST_GRID_STEP pixels apart,
+// also after the grid was rebuilt for a new camera size
+//
+ARTKP_TEST(undistGridMatchesStd)
+{
+	TestTracker* tracker = createUndistTestTracker(640, 480, ARToolKitPlus::UNDIST_GRID);
+	ARTKP_CHECK(tracker!=NULL);
+	ARTKP_CHECK(compareUndistModes(tracker, 2, 2, "UNDIST_GRID", 0.05, 0.1, 0.5));
+
+	tracker->changeCameraSize(1280, 720);
+	ARTKP_CHECK(compareUndistModes(tracker, 4, 3, "UNDIST_GRID", 0.05, 0.1, 0.5));
+
+	delete tracker;
+	return true;
+}
+
+
+// UNDIST_SAMPLED fits the edge lines to AR_UNDIST_EDGE_SAMPLES undistorted
+// points per edge instead of undistorting every contour pixel
+//
+ARTKP_TEST(undistSampledMatchesStd)
+{
+	TestTracker* tracker = createUndistTestTracker(640, 480, ARToolKitPlus::UNDIST_SAMPLED);
+	ARTKP_CHECK(tracker!=NULL);
+	ARTKP_CHECK(compareUndistModes(tracker, 2, 2, "UNDIST_SAMPLED", 0.1, 0.1, 1.0));
+
+	tracker->changeCameraSize(1280, 720);
+	ARTKP_CHECK(compareUndistModes(tracker, 4, 3, "UNDIST_SAMPLED", 0.1, 0.1, 1.0));
+
+	delete tracker;
+	return true;
+}
@@ -0,0 +1,55 @@
+function H = Floor_Homography(ImagePts,FloorPts,CameraId)
+%Floor_Homography Calibrate the floor homography of an overhead camera.
+%
+%  H = Floor_Homography(ImagePts,FloorPts,CameraId) returns
+%    * The 3 by 3 homography H mapping undistorted image pixels of camera
+%      CameraId to floor millimeters, [x y w]' = H*[u v 1]'
+%    * ImagePts should be an N by 2 matrix of the tag centers [u v] the
+%      tracker reports (ARMarkerInfo::pos, already undistorted)
+%    * FloorPts should be the N by 2 matrix of the measured floor positions
+%      [x y] of the same tags in millimeters
+%
+%  NOTE:
+%    * At least 4 tags are needed, no 3 of them on a line.  Spread them over
+%      the whole field of view of the camera.
+%    * H is written row by row to ARToolKitPlus/data/floor_cam<CameraId>.hom,
+%      tdloc loads it at startup and then localizes the tags of that camera
+%      on the floor instead of with the pose estimator.
+
+if nargin~=3
+    error('Overhead:Arguments','Need 3 arguments.  See help Floor_Homography');
+end
+N=size(ImagePts,1);
+if N<4 || size(FloorPts,1)~=N || size(ImagePts,2)~=2 || size(FloorPts,2)~=2
+    error('Overhead:Points','Need at least 4 matching point pairs.  See help Floor_Homography');
+end
+
+%normalize both point sets for a well conditioned DLT
+[Ti,pim]=normalize_points(ImagePts);
+[Tf,pf]=normalize_points(FloorPts);
+
+A=zeros(2*N,9);
+for k=1:N
+    u=pim(k,:); x=pf(k,1); y=pf(k,2);
+    A(2*k-1,:)=[u 1 0 0 0 -x*[u 1]];
+    A(2*k,:)  =[0 0 0 u 1 -y*[u 1]];
+end
+[~,~,V]=svd(A);
+H=Tf\reshape(V(:,9),3,3)'*Ti;
+H=H/H(3,3);
+
+%report the residual on the floor
+p=H*[ImagePts ones(N,1)]';
+err=sqrt(sum((p(1:2,:)./[p(3,:);p(3,:)]-FloorPts').^2));
+fprintf('Camera %d: mean error %.1f mm, max error %.1f mm\n',CameraId,mean(err),max(err));
+
+fid=fopen(sprintf('ARToolKitPlus/data/floor_cam%d.hom',CameraId),'w');
+fprintf(fid,'%.10g %.10g %.10g\n',H');
+fclose(fid);
+
+function [T,p]=normalize_points(P)
+%move the centroid to the origin and scale to a mean distance of sqrt(2)
+c=mean(P,1);
+s=sqrt(2)/mean(sqrt(sum((P-repmat(c,size(P,1),1)).^2,2)));
+T=[s 0 -s*c(1); 0 s -s*c(2); 0 0 1];
+p=(P-repmat(c,size(P,1),1))*s;
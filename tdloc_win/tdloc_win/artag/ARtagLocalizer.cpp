@@ -1,6 +1,6 @@
 #include "ARtagLocalizer.h"
+#include "FloorHomography.h"
 #include "ARToolKitPlus/TrackerSingleMarkerImpl.h"
-#define FUDGE_FACTOR 0.97
 
 using namespace std;
 
@@ -11,17 +11,43 @@ ARtag * ARtagLocalizer::tags[50];
 CRITICAL_SECTION ARtagLocalizer::tags_mutex;
 bool ARtagLocalizer::allStop = false;
 
+// all cameras detect with one tracker per image size, pixel format and marker
+// mode, so the camera file and the tracker's tables are loaded only once. each
+// camera brings its own DetectionContext, which lets them detect concurrently
+struct SharedTracker
+{
+	ARToolKitPlus::TrackerSingleMarker * tracker;
+	int width;
+	int height;
+	bool yuv422Input;
+	bool useBCH;
+	int users;
+};
+
+static struct SharedTrackers
+{
+	SharedTrackers() { InitializeCriticalSection(&mutex); }
+	~SharedTrackers() { DeleteCriticalSection(&mutex); }
+
+	CRITICAL_SECTION mutex;
+	std::vector<SharedTracker> list;
+} sharedTrackers;
+
 ARtagLocalizer::ARtagLocalizer()
 {
 	imgwidth = 640;
 	imgheight = 480;
 	init = false;
 	useBCH = true;
+	yuvInput = false;
 	patternCenter_[0] = patternCenter_[1] = 0.0;
 	patternWidth_ = 80.0;
 	xoffset = 0;
 	yoffset = 0;
 	fudge = 0.97;
+	useFloorH = false;
+	tracker = NULL;
+	context = NULL;
 	for (int n = 0; n < 50; ++n)
 	{
 		tags[n] = new ARtag();
@@ -38,24 +64,54 @@ ARtagLocalizer::~ARtagLocalizer()
 	DeleteCriticalSection (&tags_mutex);
 }
 
-int ARtagLocalizer::initARtagPose(int width, int height, float markerWidth, float x_offset, float y_offset, float yaw_offset, float ffactor)
+int ARtagLocalizer::initARtagPose(int width, int height, float markerWidth, float x_offset, float y_offset, float yaw_offset, float ffactor, bool yuv422Input)
 {
-	// create a tracker that does:
-    //  - 6x6 sized marker images
-    //  - samples at a maximum of 6x6
-    //  - works with luminance (gray) images
-    //  - can load a maximum of 1 pattern
-    //  - can detect a maximum of 8 patterns in one image
-    tracker = new ARToolKitPlus::TrackerSingleMarkerImpl<6,6,6, 1, 8>(width,height);
 	imgwidth = width;
 	imgheight = height;
 	patternCenter_[0] = patternCenter_[1] = 0.0;
+	patternWidth_ = markerWidth;
 	xoffset = x_offset;
 	yoffset = y_offset;
 	yawoffset = yaw_offset;
 	fudge = ffactor;
+	yuvInput = yuv422Input;
+
+	tracker = acquireTracker(width, height, yuvInput, useBCH);
+	if (tracker == NULL)
+	{
+		return -1;
+	}
+	context = tracker->createDetectionContext();
+
+	init = true;
+	return 0;
+}
+
+ARToolKitPlus::TrackerSingleMarker * ARtagLocalizer::acquireTracker(int width, int height, bool yuv422Input, bool useBCH)
+{
+	EnterCriticalSection(&sharedTrackers.mutex);
+	for (size_t n = 0; n < sharedTrackers.list.size(); ++n)
+	{
+		SharedTracker & shared = sharedTrackers.list[n];
+		if (shared.width == width && shared.height == height && shared.yuv422Input == yuv422Input && shared.useBCH == useBCH)
+		{
+			shared.users++;
+			LeaveCriticalSection(&sharedTrackers.mutex);
+			return shared.tracker;
+		}
+	}
 
-	tracker->setPixelFormat(ARToolKitPlus::PIXEL_FORMAT_LUM);
+	// create a tracker that does:
+    //  - 6x6 sized marker images
+    //  - samples at a maximum of 6x6
+    //  - works with luminance (gray) images
+    //  - can load a maximum of 1 pattern
+    //  - can detect a maximum of 8 patterns in one image
+    ARToolKitPlus::TrackerSingleMarker * tracker = new ARToolKitPlus::TrackerSingleMarkerImpl<6,6,6, 1, 8>(width,height);
+
+	// color cameras deliver YUV 4:2:2 (UYVY), the tracker reads the luminance
+	// directly from that buffer so no conversion to gray is needed
+	tracker->setPixelFormat(yuv422Input ? ARToolKitPlus::PIXEL_FORMAT_YUV422 : ARToolKitPlus::PIXEL_FORMAT_LUM);
 	// load a camera file. 
     //if(!tracker->init("..\\..\\ARToolKitPlus\\data\\Unibrain_640x480.cal", 1.0f, 1000.0f))
 	if(!tracker->init("..\\..\\ARToolKitPlus\\data\\Unibrain_640x4801.cal", 1.0f, 1000.0f))
@@ -63,12 +119,12 @@ int ARtagLocalizer::initARtagPose(int width, int height, float markerWidth, floa
 	{
 		printf("ERROR: init() failed\n");
 		delete tracker;
-		return -1;
+		LeaveCriticalSection(&sharedTrackers.mutex);
+		return NULL;
 	}
 
-	patternWidth_ = markerWidth;
-	// define size of the marker
-    tracker->setPatternWidth(patternWidth_);
+	// the marker width is passed to estimatePoses() by each camera
+    tracker->setPatternWidth(80.0);
 
 	// the marker in the BCH test image has a thin border...
 	tracker->setBorderWidth(THIN_PATTERN_BORDER);
@@ -76,21 +132,68 @@ int ARtagLocalizer::initARtagPose(int width, int height, float markerWidth, floa
     // set a threshold. alternatively we could also activate automatic thresholding
     tracker->setThreshold(150);
 
-    // let's use lookup-table undistortion for high-speed
-    // note: LUT only works with images up to 1024x1024
-    tracker->setUndistortionMode(ARToolKitPlus::UNDIST_LUT);
+	// the arena lighting is uneven, so compare each pixel against its local mean
+	// instead of the global threshold above
+	tracker->setThresholdMode(ARToolKitPlus::THRESH_ADAPTIVE_LOCAL);
 
-    // RPP is more robust than ARToolKit's standard pose estimator but uses more CPU resource
-	// so using standard pose estimator instead
+	// threshold the gray image into a bit mask (SSE2/AVX2) before labeling
+	tracker->activateBinarization(true);
+
+	// label runs of black pixels instead of single pixels
+	tracker->setLabelingMode(ARToolKitPlus::LABELING_RLE);
+
+	// the labeling threads belong to the detection context, so every camera
+	// gets two of them which is enough to stay at full resolution with four cameras
+	tracker->setNumLabelingThreads(2);
+	tracker->setImageProcessingMode(ARToolKitPlus::IMAGE_FULL_RES);
+
+    // only undistort a few averaged points per marker edge: this is as fast as
+    // the lookup table, independent of the marker size, and needs no LUT memory
+    tracker->setUndistortionMode(ARToolKitPlus::UNDIST_SAMPLED);
+
+    // the standard estimator runs batched for all tags of a frame (see
+	// estimatePoses() below). RPP is more accurate on small tags, but even the
+	// allocation-free version costs about ten times as much per tag (benchRpp
+	// in ARToolKitPlus/test) and finds no pose for about 4% of the views
     tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_ORIGINAL);
-	//tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_RPP);
+    //tracker->setPoseEstimator(ARToolKitPlus::POSE_ESTIMATOR_RPP);
+
+    // the tags move only a little between frames: start each pose estimation
+    // from the tag's pose in the previous frame (every camera's context keeps its own)
+    tracker->activatePoseHistory(true);
 
     // switch to simple ID based markers
     // use the tool in tools/IdPatGen to generate markers
     tracker->setMarkerMode(useBCH ? ARToolKitPlus::MARKER_ID_BCH : ARToolKitPlus::MARKER_ID_SIMPLE);
 
-	init = true;
-	return 0;
+	SharedTracker shared;
+	shared.tracker = tracker;
+	shared.width = width;
+	shared.height = height;
+	shared.yuv422Input = yuv422Input;
+	shared.useBCH = useBCH;
+	shared.users = 1;
+	sharedTrackers.list.push_back(shared);
+	LeaveCriticalSection(&sharedTrackers.mutex);
+	return tracker;
+}
+
+void ARtagLocalizer::releaseTracker(ARToolKitPlus::TrackerSingleMarker * tracker)
+{
+	EnterCriticalSection(&sharedTrackers.mutex);
+	for (size_t n = 0; n < sharedTrackers.list.size(); ++n)
+	{
+		if (sharedTrackers.list[n].tracker == tracker)
+		{
+			if (--sharedTrackers.list[n].users == 0)
+			{
+				delete tracker;
+				sharedTrackers.list.erase(sharedTrackers.list.begin() + n);
+			}
+			break;
+		}
+	}
+	LeaveCriticalSection(&sharedTrackers.mutex);
 }
 
 bool ARtagLocalizer::getARtagPose(IplImage* src, IplImage* dst, int camID)
@@ -105,73 +208,116 @@ bool ARtagLocalizer::getARtagPose(IplImage* src, IplImage* dst, int camID)
 		printf("Image passed in does not match initialized image size!!\n");
 		return NULL;
 	}
-	if (src->nChannels != 1)
+	if (src->nChannels != 1 || yuvInput)
 	{
 		printf("Please pass in grayscale image into ARtagLocalizer! \n");
 		return NULL;
 	}
-	
+
+	return detectARtags((unsigned char*)src->imageData, dst, camID);
+}
+
+bool ARtagLocalizer::getARtagPose(unsigned char* yuv422, IplImage* dst, int camID)
+{
+	if (!init)
+	{
+		printf("Did not initalize the ARtagLocalizer!!\n");
+		return NULL;
+	}
+	if (!yuvInput)
+	{
+		printf("ARtagLocalizer was not initialized for YUV422 input!!\n");
+		return NULL;
+	}
+
+	return detectARtags(yuv422, dst, camID);
+}
+
+bool ARtagLocalizer::detectARtags(unsigned char* data, IplImage* dst, int camID)
+{
 	int numMarkers = 0;
 	ARToolKitPlus::ARMarkerInfo* markers = NULL;
-	if (tracker->arDetectMarker(const_cast<unsigned char*>((unsigned char*)src->imageData), 150, &markers, &numMarkers) < 0) 
+	if (tracker->arDetectMarker(context, data, 150, &markers, &numMarkers) < 0) 
 	{
 		return false;
 	}
 
 	mytag.clear();
 
-	float modelViewMatrix_[16];
+	// estimate the poses of all confident markers in one go
+	std::vector<ARToolKitPlus::ARMarkerInfo> found;
 	for(int m = 0; m < numMarkers; ++m) {
-		if(markers[m].id != -1 && markers[m].cf >= 0.5) {
-			tracker->calcOpenGLMatrixFromMarker(&markers[m], patternCenter_, patternWidth_, modelViewMatrix_);
-
-			float x = modelViewMatrix_[12] / 1000.0;
-			float y = modelViewMatrix_[13] / 1000.0;
-			float z = modelViewMatrix_[14] / 1000.0;
-			float yaw = -atan2(modelViewMatrix_[1], modelViewMatrix_[0]);
-			if (yaw < 0)
-			{
-				yaw += 6.28;
-			}
+		if(markers[m].id != -1 && markers[m].cf >= 0.5)
+			found.push_back(markers[m]);
+	}
+	if (found.empty())
+	{
+		return true;
+	}
 
-			if ((x == 0.0 && y == 0.0 && yaw == 0.0) || (x > 10000.0 && y > 10000.0) || (x < -10000.0 && y < -10000.0) || (z <= 0.001))
-			{
-				// ARTKPlus bug that occurs sometimes
-				continue;
-			}
-			
-			/*printf("Id: %d\t Conf: %.2f\n", markers[m].id, markers[m].cf);
-			printf("x: %.2f \t y: %.2f \t z: %.2f \t yaw: %.2f\n", x,y,z,yaw);
-			printf("\n");*/
-
-			char str[30];
-			sprintf(str,"%d",markers[m].id);
-			cvPutText (dst,str,cvPoint( markers[m].pos[0]+25,markers[m].pos[1]+10),&cvFont(3,3),cvScalar(255,0,0));
-			sprintf(str,"(%.2f,%.2f,%.2f)", x*fudge + xoffset, -(y*fudge + yoffset), yaw + yawoffset);
-			cvPutText (dst,str,cvPoint( markers[m].pos[0]+25,markers[m].pos[1]+25),&cvFont(1,1),cvScalar(255,0,0));
-
-			cv::Mat PoseM(4, 4, CV_32F, modelViewMatrix_);
-			cv::transpose(PoseM,PoseM);
-			CvMat pose = PoseM;
-
-			// save artag struct for access later
-			if (markers[m].id >= 0 && markers[m].id < 50 && !allStop)
-			{
-				EnterCriticalSection(&tags_mutex);		
-				ARtag * ar = tags[markers[m].id];
-				ar->setId(markers[m].id);
-				ar->setPose(&pose);
-				ar->setPoseAge(0);
-				ar->setCamId(camID);
-
-				ARtag mt;
-				mt.setId(markers[m].id);
-				mt.setPose(&pose);
-				mt.setPoseAge(0);
-				mt.setCamId(camID);
-				LeaveCriticalSection(&tags_mutex);
-				mytag.push_back(mt);
-			}
+	std::vector<float> poses(found.size()*16);
+	if (useFloorH)
+	{
+		// the tags lie in the floor plane, so map their corners onto it
+		// instead of running the full 6-DOF pose estimation
+		for(size_t m = 0; m < found.size(); ++m)
+			getFloorPose(floorH, found[m], &poses[m*16]);
+	}
+	else
+		tracker->estimatePoses(context, &found[0], (int)found.size(), patternCenter_, patternWidth_, (float (*)[16])&poses[0]);
+
+	float scale = getPoseScale();
+	markers = &found[0];
+	numMarkers = (int)found.size();
+	for(int m = 0; m < numMarkers; ++m) {
+		float* modelViewMatrix_ = &poses[m*16];
+
+		float x = modelViewMatrix_[12] / 1000.0;
+		float y = modelViewMatrix_[13] / 1000.0;
+		float z = modelViewMatrix_[14] / 1000.0;
+		float yaw = -atan2(modelViewMatrix_[1], modelViewMatrix_[0]);
+		if (yaw < 0)
+		{
+			yaw += 6.28;
+		}
+
+		if ((x == 0.0 && y == 0.0 && yaw == 0.0) || (x > 10000.0 && y > 10000.0) || (x < -10000.0 && y < -10000.0) || (!useFloorH && z <= 0.001))
+		{
+			// ARTKPlus bug that occurs sometimes
+			continue;
+		}
+		
+		/*printf("Id: %d\t Conf: %.2f\n", markers[m].id, markers[m].cf);
+		printf("x: %.2f \t y: %.2f \t z: %.2f \t yaw: %.2f\n", x,y,z,yaw);
+		printf("\n");*/
+
+		char str[30];
+		sprintf(str,"%d",markers[m].id);
+		cvPutText (dst,str,cvPoint( markers[m].pos[0]+25,markers[m].pos[1]+10),&cvFont(3,3),cvScalar(255,0,0));
+		sprintf(str,"(%.2f,%.2f,%.2f)", x*scale + xoffset, -(y*scale + yoffset), yaw + yawoffset);
+		cvPutText (dst,str,cvPoint( markers[m].pos[0]+25,markers[m].pos[1]+25),&cvFont(1,1),cvScalar(255,0,0));
+
+		cv::Mat PoseM(4, 4, CV_32F, modelViewMatrix_);
+		cv::transpose(PoseM,PoseM);
+		CvMat pose = PoseM;
+
+		// save artag struct for access later
+		if (markers[m].id >= 0 && markers[m].id < 50 && !allStop)
+		{
+			EnterCriticalSection(&tags_mutex);		
+			ARtag * ar = tags[markers[m].id];
+			ar->setId(markers[m].id);
+			ar->setPose(&pose);
+			ar->setPoseAge(0);
+			ar->setCamId(camID);
+
+			ARtag mt;
+			mt.setId(markers[m].id);
+			mt.setPose(&pose);
+			mt.setPoseAge(0);
+			mt.setCamId(camID);
+			LeaveCriticalSection(&tags_mutex);
+			mytag.push_back(mt);
 		}
 	}
 
@@ -195,8 +341,50 @@ void ARtagLocalizer::setARtagOffset(float x_offset, float y_offset, float yaw_of
 	yawoffset = yaw_offset;
 }
 
+bool ARtagLocalizer::loadFloorHomography(const char * filename)
+{
+	float H[9];
+	if (!readFloorHomography(filename, H))
+	{
+		return false;
+	}
+
+	setFloorHomography(H);
+	return true;
+}
+
+void ARtagLocalizer::setFloorHomography(const float H[9])
+{
+	for (int i = 0; i < 9; ++i)
+	{
+		floorH[i] = H[i];
+	}
+	useFloorH = true;
+}
+
+bool ARtagLocalizer::hasFloorHomography() const
+{
+	return useFloorH;
+}
+
+float ARtagLocalizer::getPoseScale() const
+{
+	// the homography is metric already, only the 6-DOF poses need the fudge factor
+	return useFloorH ? 1.0f : fudge;
+}
+
 int ARtagLocalizer::cleanupARtagPose(void)
 {
-	delete tracker;
+	if (tracker == NULL)
+	{
+		return 0;
+	}
+
+	// the context goes before the tracker it was created by
+	delete context;
+	context = NULL;
+	releaseTracker(tracker);
+	tracker = NULL;
+	init = false;
 	return 0;
 }
\ No newline at end of file
@@ -1,24 +1,22 @@
 #pragma once
-#ifdef _DEBUG
-#pragma comment(lib,"ARToolKitPlusd.lib")
-#pragma comment(lib,"ARToolKitPlusDlld.lib")
-#else
-#pragma comment(lib,"ARToolKitPlus.lib")
-#pragma comment(lib,"ARToolKitPlusDll.lib")
-#endif
 
 #include "ARtag.h"
-#include <ARToolKitPlus/ARToolKitPlus.h>
+#include <ARToolKitPlus/TrackerSingleMarker.h>
 class ARtagLocalizer
 {
 public:
 	ARtagLocalizer();
 	~ARtagLocalizer();
-	int initARtagPose(int width, int height, float markerWidth, float x_offset, float y_offset, float yaw_offset, float ffactor = 0.97);
+	int initARtagPose(int width, int height, float markerWidth, float x_offset, float y_offset, float yaw_offset, float ffactor = 0.97, bool yuv422Input = false);
 	bool getARtagPose(IplImage * src, IplImage * dst, int camID);
+	bool getARtagPose(unsigned char * yuv422, IplImage * dst, int camID);
 	ARtag * getARtag(int index);
 	int getARtagSize();
 	void setARtagOffset(float x_offset, float y_offset, float yaw_offset);
+	bool loadFloorHomography(const char * filename);
+	void setFloorHomography(const float H[9]);
+	bool hasFloorHomography() const;
+	float getPoseScale() const;
 	int cleanupARtagPose(void);
 
 	static ARtag * tags[50];
@@ -34,9 +32,19 @@ private:
 	float yoffset;
 	float yawoffset;
 	float fudge;
+	bool yuvInput;
+
+	bool useFloorH;
+	float floorH[9];
+
+	static ARToolKitPlus::TrackerSingleMarker * acquireTracker(int width, int height, bool yuv422Input, bool useBCH);
+	static void releaseTracker(ARToolKitPlus::TrackerSingleMarker * tracker);
+
+	bool detectARtags(unsigned char * data, IplImage * dst, int camID);
 
 	std::vector<ARtag> mytag;
 	float patternWidth_;
 	float patternCenter_[2];
-	ARToolKitPlus::TrackerSingleMarker *tracker;
+	ARToolKitPlus::TrackerSingleMarker *tracker;	// shared by all cameras with the same image size, format and marker mode
+	ARToolKitPlus::DetectionContext *context;		// this camera's buffers, threads and pose history
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "FloorHomography.h"
+
+#include <math.h>
+#include <stdio.h>
+
+bool readFloorHomography(const char * filename, float H[9])
+{
+	FILE * fp = fopen(filename, "r");
+	if (fp == NULL)
+	{
+		return false;
+	}
+
+	int n = 0;
+	while (n < 9 && fscanf(fp, "%f", &H[n]) == 1)
+	{
+		++n;
+	}
+	fclose(fp);
+	if (n != 9)
+	{
+		printf("Floor homography %s needs 9 values, found %d!!\n", filename, n);
+		return false;
+	}
+	return true;
+}
+
+void getFloorPose(const float H[9], const ARToolKitPlus::ARMarkerInfo & marker, float pose[16])
+{
+	// corners in the order the pose estimator uses them:
+	// top left, top right, bottom right, bottom left
+	float fx[4], fy[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		const ARFloat * v = marker.vertex[(4 - marker.dir + i) % 4];
+		float w = H[6]*v[0] + H[7]*v[1] + H[8];
+		fx[i] = (H[0]*v[0] + H[1]*v[1] + H[2]) / w;
+		fy[i] = (H[3]*v[0] + H[4]*v[1] + H[5]) / w;
+	}
+
+	// the tag's x axis is the average of its top and bottom edge
+	float ex = (fx[1] - fx[0]) + (fx[2] - fx[3]);
+	float ey = (fy[1] - fy[0]) + (fy[2] - fy[3]);
+	float len = sqrt(ex*ex + ey*ey);
+	float c = len > 0.0f ? ex / len : 1.0f;
+	float s = len > 0.0f ? ey / len : 0.0f;
+
+	// rotation about the camera axis with the tag facing the camera
+	pose[0] = c;	pose[1] = s;	pose[2] = 0.0f;		pose[3] = 0.0f;
+	pose[4] = s;	pose[5] = -c;	pose[6] = 0.0f;		pose[7] = 0.0f;
+	pose[8] = 0.0f;	pose[9] = 0.0f;	pose[10] = -1.0f;	pose[11] = 0.0f;
+	pose[12] = 0.25f * (fx[0] + fx[1] + fx[2] + fx[3]);
+	pose[13] = 0.25f * (fy[0] + fy[1] + fy[2] + fy[3]);
+	pose[14] = 0.0f;
+	pose[15] = 1.0f;
+}
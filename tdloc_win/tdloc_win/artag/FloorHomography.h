@@ -0,0 +1,16 @@
+#pragma once
+
+#include <ARToolKitPlus/ar.h>
+
+// the floor homography maps undistorted image pixels to floor millimeters
+// (x along the image columns, y along the image rows). it is stored as nine
+// numbers, row by row, in ARToolKitPlus/data/floor_cam<camera id>.hom, see
+// Floor_Homography.m for the calibration
+
+// reads the nine numbers of a floor homography, false if there are fewer
+bool readFloorHomography(const char * filename, float H[9]);
+
+// the pose of a tag lying on the floor in the column-major layout of the
+// tracker's model view matrix: its center, its heading as a rotation about
+// the camera axis and z = 0
+void getFloorPose(const float H[9], const ARToolKitPlus::ARMarkerInfo & marker, float pose[16]);
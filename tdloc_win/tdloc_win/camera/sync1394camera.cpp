@@ -33,6 +33,7 @@ DWORD Sync1394Camera::CamThread ()
 		C1394Camera* camptr = &camera;
 		fcount++;
 		unsigned long dlength=0;			
+		unsigned char* raw = NULL;
 		int dFrames=0;
 
 		if (CAM_SUCCESS != camptr->AcquireImageEx(TRUE,&dFrames))
@@ -47,7 +48,12 @@ DWORD Sync1394Camera::CamThread ()
 
 		if (config.isColor)
 		{
-			camptr->getRGB(buf,config.height * config.width * 3); dlength=1;
+			// the raw YUV422 frame is used for detection, the RGB conversion
+			// is only needed for the preview
+			hasRGB = wantRGB;
+			if (hasRGB)
+				camptr->getRGB(buf,config.height * config.width * 3);
+			raw = camptr->GetRawData (&dlength);
 		}
 		else
 		{
@@ -69,10 +75,15 @@ DWORD Sync1394Camera::CamThread ()
 		undist_src->imageData = (char*) buf;
 		undist_src->imageDataOrigin = undist_src->imageData;
 
-		cvCvtColor( undist_src, gray, CV_BGR2GRAY );
 		if(!allStop)
 		{
-			artagLoc->getARtagPose(gray, undist_src, camId);
+			if (config.isColor)
+				artagLoc->getARtagPose(raw, undist_src, camId);
+			else
+			{
+				cvCvtColor( undist_src, gray, CV_BGR2GRAY );
+				artagLoc->getARtagPose(gray, undist_src, camId);
+			}
 		}
 
 		LeaveCriticalSection(&camgrab_cs);
@@ -96,6 +107,8 @@ Sync1394Camera::Sync1394Camera()
 	kp = AUTOGAIN_KP;
 	idealMedian = AUTOGAIN_MEDIAN_IDEAL;
 	curtimestamp  = 0;
+	wantRGB = true;
+	hasRGB = false;
 	cameraEvent = CreateEvent ( NULL , false , false , NULL);
 	artagLoc = new ARtagLocalizer();
 	
@@ -152,8 +165,16 @@ bool Sync1394Camera::InitCamera(int cameraID, SyncCamParams m_config, float x_of
 		start_tick = clock();
 	}
 	//artagLoc->initARtagPose(640, 480, 200.0, x_offset, y_offset, yaw_offset, fudge);
-	artagLoc->initARtagPose(640, 480, 180.0, x_offset, y_offset, yaw_offset, fudge);
+	artagLoc->initARtagPose(640, 480, 180.0, x_offset, y_offset, yaw_offset, fudge, config.isColor);
 	//artagLoc->initARtagPose(640, 480, 160.0, x_offset, y_offset, yaw_offset, fudge);
+	// with a floor homography calibrated for this camera, localize the tags
+	// directly in the floor plane instead of estimating their full 6-DOF pose
+	char homfile[128];
+	sprintf(homfile, "..\\..\\ARToolKitPlus\\data\\floor_cam%d.hom", cameraID);
+	if (artagLoc->loadFloorHomography(homfile))
+	{
+		printf("Camera %d: using floor homography %s\n", cameraID, homfile);
+	}
 	if(camptr->SelectCamera(cameraID)!=CAM_SUCCESS)	
 	{ 
 		printf("Could not select camera\n" ); 
@@ -175,6 +175,10 @@ public:
 	DWORD CamThread();
 	HANDLE cameraEvent;
 	unsigned char* buf;
+	// set by the main loop for the frames it shows, in color mode only those
+	// are converted to RGB. hasRGB tells if buf holds the current frame
+	bool wantRGB;
+	bool hasRGB;
 	double curtimestamp;
 	int lastMedian;
 	int lastMaxAcc;
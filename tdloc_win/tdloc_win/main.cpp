@@ -286,6 +286,7 @@ int main(int argc, const char* argv[])
 	cvResizeWindow(viewWindowName,200,0);
 	
 	bool display_image=0;
+	bool save_image=false;
 
 	//---------------------MAIN LOOP---------------------------------
 	//---------------------MAIN LOOP---------------------------------
@@ -324,12 +325,19 @@ int main(int argc, const char* argv[])
 			}
 			continue;
 		}
+		// in color mode the cameras convert to RGB only the frames shown,
+		// shared or saved, the others leave img as it is
+		bool need_image = SHARE_MEM_PROC || (DISPLAY_ON && display_image) || save_image;
+		bool new_image = true;
 		for (int n = 0; n < numCam; ++n)
 		{
 			EnterCriticalSection(&cam[n]->camgrab_cs);
+			new_image = new_image && cam[n]->hasRGB;
+			cam[n]->wantRGB = need_image;
 		}
+		new_image = !s.isColor || (need_image && new_image);
 		
-		if (s.isColor)
+		if (s.isColor && new_image)
 		{
 			// combine all 3 camera images
 			int col = 0;
@@ -368,9 +376,18 @@ int main(int argc, const char* argv[])
 		}
 
 		//dst src size
-		if (upsidedown)
+		if (upsidedown && new_image)
 			cvFlip (img,img,-1);
 
+		if (save_image && new_image)
+		{
+			sprintf(filename, "image%d.jpg", framecount);
+			cvSaveImage (filename,img);
+			printf("Current image saved to %s\n", filename);
+			framecount++;
+			save_image = false;
+		}
+
 		if (SHARE_MEM_PROC)
 		{
 			if (WaitForSingleObject(ghMutex,5000)!=WAIT_OBJECT_0)
@@ -418,11 +435,11 @@ int main(int argc, const char* argv[])
 								{
 									cv::Mat pose0 = cam[origin]->artagLoc->getARtag(j)->getPose();
 									cv::Mat pose1 = cam[n]->artagLoc->getARtag(i)->getPose();
-									float x0 = pose0.at<float>(0,3)/1000.0*FUDGE_FACTOR;
-									float x1 = pose1.at<float>(0,3)/1000.0*FUDGE_FACTOR;
+									float x0 = pose0.at<float>(0,3)/1000.0*cam[origin]->artagLoc->getPoseScale();
+									float x1 = pose1.at<float>(0,3)/1000.0*cam[n]->artagLoc->getPoseScale();
 									
-									float y0 = pose0.at<float>(1,3)/1000.0*FUDGE_FACTOR;
-									float y1 = pose1.at<float>(1,3)/1000.0*FUDGE_FACTOR;
+									float y0 = pose0.at<float>(1,3)/1000.0*cam[origin]->artagLoc->getPoseScale();
+									float y1 = pose1.at<float>(1,3)/1000.0*cam[n]->artagLoc->getPoseScale();
 
 									// find match ARtag ID
 									if (cam[origin]->artagLoc->getARtag(j)->getId() == cam[n]->artagLoc->getARtag(i)->getId())
@@ -515,8 +532,8 @@ int main(int argc, const char* argv[])
 					{
 						cv::Mat pose = ar->getPose();
 						int camId = ar->getCamId();
-						float x = pose.at<float>(0,3)/1000.0*FUDGE_FACTOR + coff[camId].xoffset - ooffset.xoffset;
-						float y = -(pose.at<float>(1,3)/1000.0*FUDGE_FACTOR + coff[camId].yoffset - ooffset.yoffset);
+						float x = pose.at<float>(0,3)/1000.0*cam[camId]->artagLoc->getPoseScale() + coff[camId].xoffset - ooffset.xoffset;
+						float y = -(pose.at<float>(1,3)/1000.0*cam[camId]->artagLoc->getPoseScale() + coff[camId].yoffset - ooffset.yoffset);
 						float z = pose.at<float>(2,3)/1000.0;
 						float yaw = -atan2(pose.at<float>(1,0), pose.at<float>(0,0));
 						if (yaw < 0)
@@ -633,10 +650,8 @@ int main(int argc, const char* argv[])
 				ARtagLocalizer::allStop = true;
 				break;
 			case 's':
-				sprintf(filename, "image%d.jpg", framecount);
-				cvSaveImage (filename,img);
-				printf("Current image saved to %s\n", filename);
-				framecount++;
+				// saved with the next converted frame
+				save_image = true;
 				break;
 			case 'c':
 				opmode = opmode_CALIB;